@@ -0,0 +1,330 @@
+// BatchFactorizer.cpp
+
+#include "BatchFactorizer.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "GField.h"
+#include "GFNumber.h"
+
+/**
+ * The reordering buffer: chunks finish in any order and are written in input order.
+ */
+class OrderedWriter
+{
+private:
+    std::ostream &_out; /** The output. */
+    std::mutex _mutex; /** Guards everything below. */
+    std::condition_variable _written; /** Signaled when chunks are written. */
+    std::map<size_t , std::string> _ready; /** Finished chunks waiting for earlier ones. */
+    size_t _nextChunk; /** The index of the next chunk to write. */
+    std::vector<float> _latencies; /** The latency of every number, in microseconds. */
+
+public:
+    explicit OrderedWriter(std::ostream &out) : _out(out) , _nextChunk(0)
+    {}
+
+    /**
+     * Hands over a finished chunk, writes it and every following ready chunk if it is next.
+     * @param index the index of the chunk.
+     * @param text the lines of the chunk.
+     * @param latencies the latency of every number of the chunk.
+     */
+    void put(size_t index , std::string &&text , const std::vector<float> &latencies)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _latencies.insert(_latencies.end() , latencies.begin() , latencies.end());
+        _ready.emplace(index , std::move(text));
+        bool wrote = false;
+        for (auto next = _ready.begin(); next != _ready.end() && next->first == _nextChunk;
+             next = _ready.erase(next))
+        {
+            _out.write(next->second.data() , (std::streamsize) next->second.size());
+            _nextChunk++;
+            wrote = true;
+        }
+        if (wrote)
+        {
+            _written.notify_all();
+        }
+    }
+
+    /**
+     * @param index the index of the chunk about to be submitted.
+     * @param limit the number of chunks allowed in flight.
+     * @return true if fewer than limit chunks before the given one are unwritten.
+     */
+    bool hasRoom(size_t index , size_t limit)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return index < _nextChunk + limit;
+    }
+
+    /**
+     * Blocks until fewer than limit chunks before the given one are unwritten.
+     * @param index the index of the chunk about to be submitted.
+     * @param limit the number of chunks allowed in flight.
+     */
+    void waitForRoom(size_t index , size_t limit)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _written.wait(lock , [&]()
+        { return index < _nextChunk + limit; });
+    }
+
+    /**
+     * Blocks until the given number of chunks are written.
+     * @param chunks the number of chunks.
+     */
+    void waitForAll(size_t chunks)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _written.wait(lock , [&]()
+        { return _nextChunk == chunks; });
+    }
+
+    /**
+     * @return the latencies of every number written so far (the writer is left empty).
+     */
+    std::vector<float> takeLatencies()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::move(_latencies);
+    }
+};
+
+/**
+ * The given percentile of the latencies.
+ * @param latencies the latencies, reordered.
+ * @param percentile in [0, 100].
+ * @return the latency.
+ */
+static double percentile(std::vector<float> &latencies , double percentile)
+{
+    if (latencies.empty())
+    {
+        return 0;
+    }
+    size_t rank = std::min(latencies.size() - 1 , (size_t) (percentile / 100 * latencies.size()));
+    std::nth_element(latencies.begin() , latencies.begin() + rank , latencies.end());
+    return latencies[rank];
+}
+
+/**
+ * Reads the next number of the input. A number below 2^128 is read as is, any other long
+ * (a negative one) is reduced into GF(BATCH_FIELD_CHAR) like GFNumber does.
+ * @param in the input.
+ * @param n output, the number.
+ * @return false at the end of the input or on a token which is not a number.
+ */
+static bool readNumber(std::istream &in , UInt128 &n)
+{
+    std::string token;
+    if (!(in >> token))
+    {
+        return false;
+    }
+    if (parseUInt128(token , n))
+    {
+        return true;
+    }
+    char *end;
+    errno = 0;
+    long value = std::strtol(token.c_str() , &end , 10);
+    if (errno != 0 || end == token.c_str() || *end != '\0')
+    {
+        return false;
+    }
+    value %= (long) BATCH_FIELD_CHAR;
+    n = (UInt128) ((value < 0) ? value + (long) BATCH_FIELD_CHAR : value);
+    return true;
+}
+
+/**
+ * Prints the prime factors of a number in the format of GFNumber::printFactors(). The numbers
+ * of the field are factored by GFNumber, the larger ones by GFNumber::factorWide, unless the
+ * cache already holds them.
+ * @param n the number.
+ * @param field the field of the smaller numbers.
+ * @param cache the cache of the factorizations (may be null).
+ * @param out ostream reference.
+ */
+static void printFactors(UInt128 n , const GField &field , FactorizationCache *cache ,
+                         std::ostream &out)
+{
+    WideFactorization factorization;
+    if (cache == nullptr || !cache->lookup(n , factorization))
+    {
+        if (n < BATCH_FIELD_CHAR)
+        {
+            // the batch caches on its own (or not at all), not in FactorizationCache::global()
+            factorization.addAll(GFNumber((long) n , field).getPrimeFactors(nullptr , nullptr));
+        }
+        else
+        {
+            factorization = GFNumber::factorWide(n);
+        }
+        if (cache != nullptr)
+        {
+            cache->insert(n , factorization);
+        }
+    }
+    out << toString(n) << "=";
+    // a prime (its own single factor, or none from GFNumber), 0 and 1 print as n*1
+    if (factorization.countWithMultiplicity() <= 1)
+    {
+        out << toString(n) << "*1\n";
+        return;
+    }
+    out << factorization << '\n';
+}
+
+/**
+ * A chunk of numbers, factored by whichever of its pool task and the reading thread claims
+ * it first, owned by both so that a task which only starts after the run can still read it.
+ */
+struct PendingChunk
+{
+    size_t index; /** The index of the chunk. */
+    std::vector<UInt128> numbers; /** The numbers. */
+    std::atomic<bool> claimed; /** Set by the thread which factors the chunk. */
+
+    PendingChunk(size_t index , std::vector<UInt128> &&numbers) :
+            index(index) , numbers(std::move(numbers)) , claimed(false)
+    {}
+};
+
+/**
+ * Factors a chunk and hands it to the writer.
+ * @param chunk the chunk, claimed by the caller.
+ * @param field the field of the smaller numbers.
+ * @param cache the cache of the factorizations (may be null).
+ * @param writer the writer.
+ */
+static void factorChunk(const PendingChunk &chunk , const GField &field ,
+                        FactorizationCache *cache , OrderedWriter &writer)
+{
+    std::ostringstream text;
+    std::vector<float> latencies;
+    latencies.reserve(chunk.numbers.size());
+    for (UInt128 number : chunk.numbers)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        printFactors(number , field , cache , text);
+        std::chrono::duration<float , std::micro> latency =
+                std::chrono::steady_clock::now() - begin;
+        latencies.push_back(latency.count());
+    }
+    writer.put(chunk.index , text.str() , latencies);
+}
+
+/**
+ * Factors the oldest submitted chunk which no task has claimed yet, on the calling thread.
+ * @param pending the submitted chunks, the claimed ones at its front are dropped.
+ * @param field the field of the smaller numbers.
+ * @param cache the cache of the factorizations (may be null).
+ * @param writer the writer.
+ * @return false if every submitted chunk is claimed.
+ */
+static bool factorUnclaimed(std::deque<std::shared_ptr<PendingChunk>> &pending ,
+                            const GField &field , FactorizationCache *cache ,
+                            OrderedWriter &writer)
+{
+    while (!pending.empty())
+    {
+        std::shared_ptr<PendingChunk> chunk = std::move(pending.front());
+        pending.pop_front();
+        if (!chunk->claimed.exchange(true))
+        {
+            factorChunk(*chunk , field , cache , writer);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Factors every number of the input, until the end of the input or the first token which
+ * is not a number. Waits for the chunks of this run only, so it may be called from a task
+ * of the same pool: the reading thread factors the chunks no task has started when it runs
+ * out of room and at the end.
+ * @param in the input.
+ * @param out the output, one line per number.
+ * @return the statistics of the run.
+ */
+BatchReport BatchFactorizer::run(std::istream &in , std::ostream &out)
+{
+    auto start = std::chrono::steady_clock::now();
+    GField field(BATCH_FIELD_CHAR);
+    OrderedWriter writer(out);
+    std::deque<std::shared_ptr<PendingChunk>> pending; // submitted, maybe not claimed yet
+    size_t count = 0 , chunks = 0;
+    bool more = true;
+    while (more)
+    {
+        std::vector<UInt128> numbers;
+        numbers.reserve(BATCH_CHUNK);
+        UInt128 n;
+        while (numbers.size() < BATCH_CHUNK && (more = readNumber(in , n)))
+        {
+            numbers.push_back(n);
+        }
+        if (numbers.empty())
+        {
+            break;
+        }
+        count += numbers.size();
+        size_t index = chunks++;
+        const size_t limit = BATCH_CHUNKS_IN_FLIGHT * _pool.size();
+        // make room by factoring the chunks no task has started, then wait for the started ones
+        while (!writer.hasRoom(index , limit) && factorUnclaimed(pending , field , _cache , writer))
+        {}
+        writer.waitForRoom(index , limit);
+        auto chunk = std::make_shared<PendingChunk>(index , std::move(numbers));
+        pending.push_back(chunk);
+        FactorizationCache *cache = _cache;
+        _pool.submit([chunk , &field , cache , &writer]()
+                     {
+                         // every chunk is claimed before the run ends, so field and
+                         // writer are only used while they live
+                         if (!chunk->claimed.exchange(true))
+                         {
+                             factorChunk(*chunk , field , cache , writer);
+                         }
+                     });
+    }
+    while (factorUnclaimed(pending , field , _cache , writer))
+    {}
+    writer.waitForAll(chunks);
+    out.flush();
+
+    std::vector<float> latencies = writer.takeLatencies();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BatchReport report = {count , elapsed.count() , 0 , 0};
+    report.p50Micros = percentile(latencies , 50);
+    report.p99Micros = percentile(latencies , 99);
+    return report;
+}
+
+/**
+ * Operator overloading of "<<", prints the statistics on one line.
+ * @param out ostream reference.
+ * @param report the statistics.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const BatchReport &report)
+{
+    return (out << "factored " << report.count << " numbers in " << report.seconds << "s ("
+                << (long) report.throughput() << " numbers/s), latency p50 "
+                << report.p50Micros << "us p99 " << report.p99Micros << "us");
+}
@@ -0,0 +1,80 @@
+// BatchFactorizer.h
+//----------- include guards------------
+#ifndef BATCHFACTORIZER_H
+#define BATCHFACTORIZER_H
+//-------------- includes --------------
+#include <cstddef>
+#include <iostream>
+#include "FactorizationCache.h"
+#include "ThreadPool.h"
+
+#define BATCH_FIELD_CHAR 9223372036854775783 /** the largest prime below 2^63 */
+#define BATCH_CHUNK 256 /** numbers factored by one task */
+#define BATCH_CHUNKS_IN_FLIGHT 8 /** chunks per worker read ahead of the output */
+
+//--------------------------------------
+
+/**
+ * The statistics of a batch run.
+ */
+struct BatchReport
+{
+    size_t count; /** The numbers factored. */
+    double seconds; /** The wall time of the run. */
+    double p50Micros; /** The median time to factor one number, in microseconds. */
+    double p99Micros; /** The 99th percentile time to factor one number, in microseconds. */
+
+    /**
+     * @return the numbers factored per second.
+     */
+    double throughput() const
+    { return (seconds > 0) ? count / seconds : 0; }
+};
+
+/**
+ *  A BatchFactorizer class.
+ *  Streams whitespace separated numbers from an input, factors them in chunks on a thread
+ *  pool and writes one printFactors line per number, in input order. Finished chunks wait in
+ *  a reordering buffer until every earlier chunk is written, and each chunk is written with a
+ *  single call. The numbers below BATCH_FIELD_CHAR are read into GF(BATCH_FIELD_CHAR) and
+ *  factored as is, the larger ones (up to 2^128 - 1) by GFNumber::factorWide, and a negative
+ *  number is reduced into the field. A number which repeats is looked up in the cache (the
+ *  process wide one by default) instead of being factored again.
+ */
+class BatchFactorizer
+{
+private:
+    ThreadPool &_pool; /** The pool the chunks run on. */
+    FactorizationCache *_cache; /** The factorizations of the numbers seen (may be null). */
+
+public:
+    /**
+     * A constructor.
+     * @param pool the pool the chunks run on.
+     * @param cache the cache of the factorizations, nullptr to factor every number.
+     */
+    explicit BatchFactorizer(ThreadPool &pool ,
+                             FactorizationCache *cache = &FactorizationCache::global()) :
+            _pool(pool) , _cache(cache)
+    {};
+
+    /**
+     * Factors every number of the input, until the end of the input or the first token which
+     * is not a number. Waits for the chunks of this run only, so it may be called from a task
+     * of the same pool.
+     * @param in the input.
+     * @param out the output, one line per number.
+     * @return the statistics of the run.
+     */
+    BatchReport run(std::istream &in , std::ostream &out);
+};
+
+/**
+ * Operator overloading of "<<", prints the statistics on one line.
+ * @param out ostream reference.
+ * @param report the statistics.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const BatchReport &report);
+
+#endif //BATCHFACTORIZER_H
@@ -0,0 +1,319 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "BatchFactorizer.h"
+#include "FactorizationCache.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "ThreadPool.h"
+
+TEST(ThreadPoolTest , RunsEveryTask)
+{
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size() , 4u);
+    std::atomic<long> sum(0);
+    for (long i = 1; i <= 1000; i++)
+    {
+        pool.submit([&sum , &pool , i]()
+                    {
+                        sum += i;
+                        if (i % 100 == 0)
+                        {
+                            pool.submit([&sum]()
+                                        { sum += 1; }); // from a worker, onto its own deque
+                        }
+                    });
+    }
+    pool.wait();
+    EXPECT_EQ(sum , 500500 + 10);
+}
+
+TEST(BatchFactorizerTest , OutputInInputOrder)
+{
+    std::mt19937_64 generator(67320);
+    std::ostringstream input , expected;
+    GField field(BATCH_FIELD_CHAR);
+    for (int i = 0; i < 3000; i++)
+    {
+        // mostly small numbers with a few large ones, so the chunks finish out of order
+        long n = (i % 97 == 0) ? (long) (generator() >> 2) : (long) (generator() % 100000);
+        input << n << ((i % 10 == 0) ? "\n" : " ");
+        GFNumber(n , field).printFactors(expected);
+    }
+    ThreadPool pool(4);
+    BatchFactorizer factorizer(pool);
+    std::istringstream in(input.str());
+    std::ostringstream out;
+    BatchReport report = factorizer.run(in , out);
+    EXPECT_EQ(out.str() , expected.str());
+    EXPECT_EQ(report.count , 3000u);
+    EXPECT_LE(report.p50Micros , report.p99Micros);
+
+    std::istringstream empty("");
+    std::ostringstream nothing;
+    EXPECT_EQ(factorizer.run(empty , nothing).count , 0u);
+    EXPECT_EQ(nothing.str() , "");
+}
+
+TEST(BatchFactorizerTest , WideAndNegativeNumbers)
+{
+    ThreadPool pool(2);
+    BatchFactorizer factorizer(pool);
+    std::istringstream in("-5 9223372036854775783\n18446744073709551617 "
+                          "340282366920938463463374607431768211297 12 stop 7");
+    std::ostringstream out;
+    EXPECT_EQ(factorizer.run(in , out).count , 5u);
+    EXPECT_EQ(out.str() , "9223372036854775778=2*11*137*547*5594472617641\n"
+                          "9223372036854775783=9223372036854775783*1\n"
+                          "18446744073709551617=274177*67280421310721\n"
+                          "340282366920938463463374607431768211297="
+                          "340282366920938463463374607431768211297*1\n"
+                          "12=2*2*3\n");
+}
+
+TEST(BatchFactorizerTest , RepeatedNumbersHitTheCache)
+{
+    std::mt19937_64 generator(67320);
+    std::ostringstream input;
+    for (int i = 0; i < 2000; i++)
+    {
+        // a few numbers repeat most of the time
+        input << ((i % 4 == 0) ? generator() >> 2 : 1000003 + generator() % 50) << " ";
+    }
+    ThreadPool pool(4);
+    FactorizationCache cache(1024);
+    std::istringstream cachedIn(input.str()) , uncachedIn(input.str());
+    std::ostringstream cached , uncached;
+    BatchFactorizer(pool , &cache).run(cachedIn , cached);
+    BatchFactorizer(pool , nullptr).run(uncachedIn , uncached);
+    EXPECT_EQ(cached.str() , uncached.str());
+    CacheStatistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.hits + statistics.misses , 2000u);
+    EXPECT_EQ(statistics.misses , statistics.size);
+    EXPECT_GE(statistics.hits , 1500u - 50u);
+}
+
+TEST(BatchFactorizerTest , RunsFromAPoolTask)
+{
+    // the only worker runs the batch, so every chunk is factored by the reading thread
+    std::ostringstream input;
+    for (long n = 1000; n < 4000; n++)
+    {
+        input << n << " ";
+    }
+    std::istringstream expectedIn(input.str());
+    std::ostringstream expected;
+    ThreadPool helper(2);
+    BatchFactorizer(helper , nullptr).run(expectedIn , expected);
+    ThreadPool pool(1);
+    auto done = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> result = done->get_future();
+    std::string text = input.str();
+    pool.submit([&pool , done , text]()
+                {
+                    std::istringstream in(text);
+                    std::ostringstream out;
+                    BatchFactorizer(pool , nullptr).run(in , out);
+                    done->set_value(out.str());
+                });
+    ASSERT_EQ(result.wait_for(std::chrono::minutes(1)) , std::future_status::ready);
+    EXPECT_EQ(result.get() , expected.str());
+}
+
+TEST(BatchFactorizerTest , GFNumberUsesTheGlobalCache)
+{
+    FactorizationCache &cache = FactorizationCache::global();
+    cache.clear();
+    cache.resetStatistics();
+    GField field(2 , 62);
+    std::ostringstream first , second;
+    GFNumber(36360 , field).printFactors(first);
+    GFNumber(36360 , field).printFactors(second);
+    GFNumber(17 , field).printFactors(second); // primes are not looked up
+    EXPECT_EQ(first.str() , "36360=2*2*2*3*3*5*101\n");
+    EXPECT_EQ(second.str() , first.str() + "17=17*1\n");
+    CacheStatistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.hits , 1u);
+    EXPECT_EQ(statistics.misses , 1u);
+    // a cache of its own, or none, leaves the global one alone
+    FactorizationCache own(64);
+    EXPECT_EQ(GFNumber(36360 , field).getPrimeFactors(nullptr , &own).countWithMultiplicity() , 7);
+    EXPECT_EQ(GFNumber(36360 , field).getPrimeFactors(nullptr , nullptr).countWithMultiplicity() ,
+              7);
+    EXPECT_EQ(own.getStatistics().misses , 1u);
+    EXPECT_EQ(cache.getStatistics().hits , 1u);
+    cache.clear();
+    cache.resetStatistics();
+}
+
+/**
+ * @param factorization a factorization.
+ * @return the factorization as printed.
+ */
+static std::string toString(const WideFactorization &factorization)
+{
+    std::ostringstream out;
+    out << factorization;
+    return out.str();
+}
+
+TEST(FactorizationCacheTest , RebuildsTheFactorizations)
+{
+    const UInt128 wide = ((UInt128) 1 << 64) + 13; // a prime
+    const UInt128 numbers[] = {0 , 1 , 2 , 12 , 1000003 , 1000003ull * 1000003 ,
+                               1000003ull * 999983 , (UInt128) 1 << 100 , wide * 3 * 3 * 5 ,
+                               wide , 2 * wide * 7};
+    FactorizationCache cache(64);
+    for (UInt128 n : numbers)
+    {
+        cache.insert(n , GFNumber::factorWide(n));
+    }
+    for (UInt128 n : numbers)
+    {
+        WideFactorization factorization;
+        ASSERT_TRUE(cache.lookup(n , factorization)) << toString(n);
+        EXPECT_EQ(toString(factorization) , toString(GFNumber::factorWide(n))) << toString(n);
+    }
+    // a prime may be cached as an empty factorization, the way GFNumber returns it
+    cache.insert(7 , WideFactorization());
+    WideFactorization seven;
+    EXPECT_TRUE(cache.lookup(7 , seven));
+    EXPECT_EQ(toString(seven) , "7");
+    CacheStatistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.hits , 12u);
+    EXPECT_EQ(statistics.misses , 0u);
+}
+
+TEST(FactorizationCacheTest , EvictsTheLeastRecentlyUsed)
+{
+    FactorizationCache cache(2 * FACTORIZATION_CACHE_SHARDS);
+    EXPECT_EQ(cache.getCapacity() , 2u * FACTORIZATION_CACHE_SHARDS);
+    WideFactorization factorization;
+    cache.insert(6 , GFNumber::factorWide(6));
+    cache.insert(10 , GFNumber::factorWide(10));
+    for (UInt128 n = 1000; n < 2000; n++)
+    {
+        cache.insert(n , GFNumber::factorWide(n));
+        EXPECT_TRUE(cache.lookup(6 , factorization)); // always the most recent of its shard
+    }
+    EXPECT_EQ(toString(factorization) , "2*3");
+    EXPECT_FALSE(cache.lookup(10 , factorization));
+    CacheStatistics statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.size , cache.getCapacity());
+    EXPECT_EQ(statistics.evictions , 1002u - cache.getCapacity());
+    EXPECT_EQ(statistics.misses , 1u);
+    cache.clear();
+    EXPECT_FALSE(cache.lookup(6 , factorization));
+    EXPECT_EQ(cache.getStatistics().size , 0u);
+    cache.resetStatistics();
+    EXPECT_EQ(cache.getStatistics().hits , 0u);
+
+    FactorizationCache disabled(0);
+    disabled.insert(6 , GFNumber::factorWide(6));
+    EXPECT_FALSE(disabled.lookup(6 , factorization));
+}
+
+TEST(FactorizationCacheTest , SavesAndLoads)
+{
+    std::mt19937_64 generator(67320);
+    FactorizationCache cache(256);
+    std::vector<UInt128> numbers;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 100; i++)
+    {
+        numbers.push_back(((UInt128) generator() << (i % 20)) + 1);
+        WideFactorization factorization = GFNumber::factorWide(numbers.back());
+        expected.push_back(toString(factorization));
+        cache.insert(numbers.back() , factorization);
+    }
+    std::string path = testing::TempDir() + "factorization_cache_test.bin";
+    ASSERT_TRUE(cache.save(path));
+    FactorizationCache restored(256);
+    ASSERT_TRUE(restored.load(path));
+    EXPECT_EQ(restored.getStatistics().size , 100u);
+    for (size_t i = 0; i < numbers.size(); i++)
+    {
+        WideFactorization factorization;
+        ASSERT_TRUE(restored.lookup(numbers[i] , factorization));
+        EXPECT_EQ(toString(factorization) , expected[i]);
+    }
+
+    // a prime which does not divide its number is rejected
+    std::ofstream corrupt(path , std::ios::binary | std::ios::trunc);
+    corrupt << "GFFC" << (char) 1 << (char) 15 << (char) 1 << (char) 2;
+    corrupt.close();
+    FactorizationCache rejected(256);
+    EXPECT_FALSE(rejected.load(path));
+    EXPECT_FALSE(rejected.load(path + ".missing"));
+    std::remove(path.c_str());
+}
+
+/**
+ * @param factorization a factorization.
+ * @return the factorization as printed.
+ */
+static std::string toString(const PrimeFactorization &factorization)
+{
+    std::ostringstream out;
+    out << factorization;
+    return out.str();
+}
+
+TEST(RhoRaceTest , MatchesSingleWalk)
+{
+    std::mt19937_64 generator(67320);
+    GField field(2 , 62);
+    ThreadPool pool(4);
+    int semiprimes = 0;
+    while (semiprimes < 50)
+    {
+        long p = (long) ((generator() >> 33) | (1ul << 30) | 1);
+        long q = (long) ((generator() >> 33) | (1ul << 30) | 1);
+        if (!GField::isPrime(p) || !GField::isPrime(q))
+        {
+            continue;
+        }
+        semiprimes++;
+        GFNumber number(p * q , field);
+        PrimeFactorization factorization = number.getPrimeFactors(pool);
+        EXPECT_EQ(toString(factorization) , toString(number.getPrimeFactors()));
+        EXPECT_EQ(factorization.countWithMultiplicity() , 2);
+    }
+    for (int i = 0; i < 200; i++)
+    {
+        GFNumber number((long) (generator() >> 2) , field);
+        EXPECT_EQ(toString(number.getPrimeFactors(pool)) , toString(number.getPrimeFactors()));
+    }
+}
+
+TEST(RhoRaceTest , RacesFromInsideThePool)
+{
+    // every worker races its own number on the pool it runs on
+    GField field(2 , 62);
+    ThreadPool pool(2);
+    std::atomic<int> correct(0);
+    const long semiprime = 1000000007L * 2147483647L;
+    for (int i = 0; i < 8; i++)
+    {
+        pool.submit([&]()
+                    {
+                        PrimeFactorization factorization = GFNumber(semiprime , field)
+                                .getPrimeFactors(pool);
+                        if (factorization.countWithMultiplicity() == 2 &&
+                            factorization[0].prime == 1000000007L)
+                        {
+                            correct++;
+                        }
+                    });
+    }
+    pool.wait();
+    EXPECT_EQ(correct , 8);
+}
@@ -0,0 +1,195 @@
+// EllipticCurveMethod.cpp
+
+#include "EllipticCurveMethod.h"
+#include <cassert>
+#include "PrimeSieve.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class EllipticCurveMethod.
+// --------------------------------------------------------------------------------------
+
+/**
+ * A constructor, precomputes the primes of both stages.
+ * @param b1 the stage 1 bound, at least ECM_STAGE2_D / 2.
+ * @param b2 the stage 2 bound, below 2^32.
+ */
+EllipticCurveMethod::EllipticCurveMethod(uint64_t b1 , uint64_t b2) : _b1(b1) , _b2(b2)
+{
+    assert(b1 >= ECM_STAGE2_D / 2 && b2 >= b1 && b2 <= UINT32_MAX);
+    PrimeSieve primes;
+    uint64_t prime = primes.next() , product = 1;
+    for (; prime <= b1; prime = primes.next())
+    {
+        uint64_t power = prime;
+        while (power <= b1 / prime)
+        {
+            power *= prime;
+        }
+        if ((unsigned __int128) product * power > UINT64_MAX)
+        {
+            _stage1Multipliers.push_back(product);
+            product = 1;
+        }
+        product *= power;
+    }
+    _stage1Multipliers.push_back(product);
+    for (; prime <= b2; prime = primes.next())
+    {
+        _stage2Primes.push_back((uint32_t) prime);
+    }
+}
+
+/**
+ * Doubles a point, the curve constant (A + 2) / 4 is given as a fraction.
+ * The usual X' = (X + Z)^2 (X - Z)^2 and Z' = 4XZ ((X - Z)^2 + a24 4XZ) are both scaled by
+ * the denominator, so the constant is never inverted.
+ * @param reducer Montgomery context modulo n.
+ * @param point the point.
+ * @param a24 the numerator of (A + 2) / 4.
+ * @param denominator the denominator of (A + 2) / 4.
+ * @return 2 * point.
+ */
+CurvePoint EllipticCurveMethod::_double(const Montgomery128 &reducer , const CurvePoint &point ,
+                                        UInt128 a24 , UInt128 denominator)
+{
+    UInt128 sum = reducer.addMod(point.x , point.z);
+    UInt128 difference = reducer.subMod(point.x , point.z);
+    UInt128 sumSquare = reducer.mul(sum , sum);
+    UInt128 differenceSquare = reducer.mul(difference , difference);
+    UInt128 product = reducer.subMod(sumSquare , differenceSquare); // 4XZ
+    UInt128 scaled = reducer.mul(differenceSquare , denominator);
+    return CurvePoint{reducer.mul(sumSquare , scaled) ,
+                      reducer.mul(product , reducer.addMod(scaled , reducer.mul(a24 , product)))};
+}
+
+/**
+ * Differential addition.
+ * @param reducer Montgomery context modulo n.
+ * @param p a point.
+ * @param q a point.
+ * @param difference p - q.
+ * @return p + q.
+ */
+CurvePoint EllipticCurveMethod::_add(const Montgomery128 &reducer , const CurvePoint &p ,
+                                     const CurvePoint &q , const CurvePoint &difference)
+{
+    UInt128 u = reducer.mul(reducer.subMod(p.x , p.z) , reducer.addMod(q.x , q.z));
+    UInt128 v = reducer.mul(reducer.addMod(p.x , p.z) , reducer.subMod(q.x , q.z));
+    UInt128 sum = reducer.addMod(u , v) , subtraction = reducer.subMod(u , v);
+    return CurvePoint{reducer.mul(difference.z , reducer.mul(sum , sum)) ,
+                      reducer.mul(difference.x , reducer.mul(subtraction , subtraction))};
+}
+
+/**
+ * The Montgomery ladder.
+ * @param reducer Montgomery context modulo n.
+ * @param point the point.
+ * @param k the multiplier, at least 1.
+ * @param a24 the numerator of (A + 2) / 4.
+ * @param denominator the denominator of (A + 2) / 4.
+ * @return k * point.
+ */
+CurvePoint EllipticCurveMethod::_multiply(const Montgomery128 &reducer , const CurvePoint &point ,
+                                          uint64_t k , UInt128 a24 , UInt128 denominator)
+{
+    // invariant: high - low = point
+    CurvePoint low = point , high = _double(reducer , point , a24 , denominator);
+    for (int bit = 62 - __builtin_clzll(k); bit >= 0; bit--)
+    {
+        if ((k >> bit) & 1)
+        {
+            low = _add(reducer , high , low , point);
+            high = _double(reducer , high , a24 , denominator);
+        }
+        else
+        {
+            high = _add(reducer , high , low , point);
+            low = _double(reducer , low , a24 , denominator);
+        }
+    }
+    return low;
+}
+
+/**
+ * Stage 2: accumulates the cross differences of the giant steps m * D * q and the baby
+ * steps j * q for every prime m * D +- j of (B1, B2]. Two points have the same x coordinate
+ * exactly when X1 Z2 - X2 Z1 = 0, and m * D * q = +-j * q mod p when (m * D -+ j) * q is the
+ * point at infinity mod p.
+ * @param reducer Montgomery context modulo n.
+ * @param q the point after stage 1.
+ * @param a24 the numerator of (A + 2) / 4.
+ * @param denominator the denominator of (A + 2) / 4.
+ * @return the product of the differences (Montgomery form).
+ */
+UInt128 EllipticCurveMethod::_stage2(const Montgomery128 &reducer , const CurvePoint &q ,
+                                     UInt128 a24 , UInt128 denominator) const
+{
+    const uint64_t half = ECM_STAGE2_D / 2;
+    // the baby steps j * q for the odd j up to D / 2
+    std::vector<CurvePoint> baby(half + 1);
+    CurvePoint twice = _double(reducer , q , a24 , denominator);
+    baby[1] = q;
+    baby[3] = _add(reducer , twice , q , q);
+    for (uint64_t j = 5; j <= half; j += 2)
+    {
+        baby[j] = _add(reducer , baby[j - 2] , twice , baby[j - 4]);
+    }
+    // the giant steps m * D * q, from the one nearest to B1
+    uint64_t m = (_b1 + half) / ECM_STAGE2_D;
+    m = (m == 0) ? 1 : m;
+    CurvePoint giant = _multiply(reducer , q , ECM_STAGE2_D , a24 , denominator);
+    CurvePoint current = _multiply(reducer , q , m * ECM_STAGE2_D , a24 , denominator);
+    CurvePoint next = _multiply(reducer , q , (m + 1) * ECM_STAGE2_D , a24 , denominator);
+    UInt128 accumulator = reducer.one();
+    for (uint32_t prime : _stage2Primes)
+    {
+        uint64_t target = (prime + half) / ECM_STAGE2_D;
+        while (m < target)
+        {
+            CurvePoint after = _add(reducer , next , giant , current);
+            current = next;
+            next = after;
+            m++;
+        }
+        uint64_t center = m * ECM_STAGE2_D;
+        const CurvePoint &step = baby[(prime > center) ? prime - center : center - prime];
+        accumulator = reducer.mul(accumulator ,
+                                  reducer.subMod(reducer.mul(current.x , step.z) ,
+                                                 reducer.mul(step.x , current.z)));
+    }
+    return accumulator;
+}
+
+/**
+ * Runs stage 1 and stage 2 on one curve.
+ * Suyama's parametrization: u = sigma^2 - 5, v = 4 sigma, the starting point is
+ * (u^3 : v^3) and (A + 2) / 4 = (v - u)^3 (3u + v) / (16 u^3 v).
+ * @param reducer Montgomery context modulo the odd composite n.
+ * @param sigma the Suyama parameter of the curve, at least ECM_MIN_SIGMA.
+ * @return a non trivial factor of n, or 0 if the curve found none.
+ */
+UInt128 EllipticCurveMethod::tryCurve(const Montgomery128 &reducer , uint64_t sigma) const
+{
+    const UInt128 n = reducer.getModulus();
+    UInt128 s = reducer.toMontgomery(sigma);
+    UInt128 u = reducer.subMod(reducer.mul(s , s) , reducer.toMontgomery(5));
+    UInt128 v = reducer.toMontgomery(4 * (UInt128) sigma);
+    UInt128 uCube = reducer.mul(reducer.mul(u , u) , u);
+    UInt128 vMinusU = reducer.subMod(v , u);
+    UInt128 a24 = reducer.mul(reducer.mul(reducer.mul(vMinusU , vMinusU) , vMinusU) ,
+                              reducer.addMod(reducer.addMod(reducer.addMod(u , u) , u) , v));
+    UInt128 denominator = reducer.mul(reducer.mul(reducer.toMontgomery(16) , uCube) , v);
+    CurvePoint point{uCube , reducer.mul(reducer.mul(v , v) , v)};
+
+    for (uint64_t multiplier : _stage1Multipliers)
+    {
+        point = _multiply(reducer , point , multiplier , a24 , denominator);
+    }
+    UInt128 g = gcd128(point.z , n);
+    if (g != 1)
+    {
+        return (g == n) ? 0 : g;
+    }
+    g = gcd128(_stage2(reducer , point , a24 , denominator) , n);
+    return (g == 1 || g == n) ? 0 : g;
+}
@@ -0,0 +1,121 @@
+// EllipticCurveMethod.h
+//----------- include guards------------
+#ifndef ELLIPTICCURVEMETHOD_H
+#define ELLIPTICCURVEMETHOD_H
+//-------------- includes --------------
+#include <cstdint>
+#include <vector>
+#include "Montgomery128.h"
+
+#define ECM_STAGE2_D 2310 /** the giant step of stage 2, 2 * 3 * 5 * 7 * 11 */
+#define ECM_STAGE2_FACTOR 100 /** the stage 2 bound is ECM_STAGE2_FACTOR times the stage 1 bound */
+#define ECM_MIN_SIGMA 6 /** the smallest Suyama parameter */
+
+//--------------------------------------
+
+/**
+ * A point of a Montgomery curve in projective x and z coordinates (Montgomery forms),
+ * the y coordinate is never needed.
+ */
+struct CurvePoint
+{
+    UInt128 x; /** The X coordinate. */
+    UInt128 z; /** The Z coordinate, 0 for the point at infinity. */
+};
+
+/**
+ *  An EllipticCurveMethod class.
+ *  Lenstra's elliptic curve factorization with fixed bounds B1 and B2. Each curve is a
+ *  Montgomery curve By^2 = x^3 + Ax^2 + x from Suyama's parametrization (so its group order
+ *  is divisible by 12), a random point is multiplied by every prime power up to B1 with the
+ *  Montgomery ladder (stage 1), then by every prime of (B1, B2] with the baby step giant
+ *  step continuation (stage 2). A prime p of n is found when the order of the curve mod p
+ *  is B1 smooth but for one prime below B2.
+ *  The primes are precomputed once, so one instance serves any number of curves and threads.
+ */
+class EllipticCurveMethod
+{
+private:
+    uint64_t _b1; /** The stage 1 bound. */
+    uint64_t _b2; /** The stage 2 bound. */
+    std::vector<uint64_t> _stage1Multipliers; /** The prime powers up to B1, in 64 bit products. */
+    std::vector<uint32_t> _stage2Primes; /** The primes of (B1, B2]. */
+
+    /**
+     * Doubles a point, the curve constant (A + 2) / 4 is given as a fraction.
+     * @param reducer Montgomery context modulo n.
+     * @param point the point.
+     * @param a24 the numerator of (A + 2) / 4.
+     * @param denominator the denominator of (A + 2) / 4.
+     * @return 2 * point.
+     */
+    static CurvePoint _double(const Montgomery128 &reducer , const CurvePoint &point ,
+                              UInt128 a24 , UInt128 denominator);
+
+    /**
+     * Differential addition.
+     * @param reducer Montgomery context modulo n.
+     * @param p a point.
+     * @param q a point.
+     * @param difference p - q.
+     * @return p + q.
+     */
+    static CurvePoint _add(const Montgomery128 &reducer , const CurvePoint &p ,
+                           const CurvePoint &q , const CurvePoint &difference);
+
+    /**
+     * The Montgomery ladder.
+     * @param reducer Montgomery context modulo n.
+     * @param point the point.
+     * @param k the multiplier, at least 1.
+     * @param a24 the numerator of (A + 2) / 4.
+     * @param denominator the denominator of (A + 2) / 4.
+     * @return k * point.
+     */
+    static CurvePoint _multiply(const Montgomery128 &reducer , const CurvePoint &point ,
+                                uint64_t k , UInt128 a24 , UInt128 denominator);
+
+    /**
+     * Stage 2: accumulates the cross differences of the giant steps m * D * q and the baby
+     * steps j * q for every prime m * D +- j of (B1, B2].
+     * @param reducer Montgomery context modulo n.
+     * @param q the point after stage 1.
+     * @param a24 the numerator of (A + 2) / 4.
+     * @param denominator the denominator of (A + 2) / 4.
+     * @return the product of the differences (Montgomery form).
+     */
+    UInt128 _stage2(const Montgomery128 &reducer , const CurvePoint &q , UInt128 a24 ,
+                    UInt128 denominator) const;
+
+public:
+    /**
+     * A constructor, precomputes the primes of both stages.
+     * @param b1 the stage 1 bound, at least ECM_STAGE2_D / 2.
+     * @param b2 the stage 2 bound, below 2^32.
+     */
+    EllipticCurveMethod(uint64_t b1 , uint64_t b2);
+
+    /**
+     * Getter for the stage 1 bound.
+     * @return B1.
+     */
+    uint64_t getB1() const
+    { return _b1; }
+
+    /**
+     * Getter for the stage 2 bound.
+     * @return B2.
+     */
+    uint64_t getB2() const
+    { return _b2; }
+
+    /**
+     * Runs stage 1 and stage 2 on one curve.
+     * @param reducer Montgomery context modulo the odd composite n.
+     * @param sigma the Suyama parameter of the curve, at least ECM_MIN_SIGMA.
+     * @return a non trivial factor of n, or 0 if the curve found none.
+     */
+    UInt128 tryCurve(const Montgomery128 &reducer , uint64_t sigma) const;
+};
+
+#endif //ELLIPTICCURVEMETHOD_H
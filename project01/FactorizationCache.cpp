@@ -0,0 +1,364 @@
+// FactorizationCache.cpp
+
+#include "FactorizationCache.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#define CACHE_FILE_MAGIC "GFFC" /** the first bytes of a cache file */
+#define CACHE_FILE_VERSION 1 /** the format of the records which follow the magic */
+#define VARINT_BITS 7 /** the payload bits of every byte of a variable length integer */
+#define VARINT_MORE 0x80 /** the flag of a byte which is followed by another one */
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class FactorizationCache.
+// --------------------------------------------------------------------------------------
+
+/**
+ * Appends a number as a variable length integer, 7 bits per byte from the lowest ones.
+ * @param n the number.
+ * @param out the bytes.
+ */
+static void writeVarint(UInt128 n , std::string &out)
+{
+    while (n >= VARINT_MORE)
+    {
+        out.push_back((char) ((n & (VARINT_MORE - 1)) | VARINT_MORE));
+        n >>= VARINT_BITS;
+    }
+    out.push_back((char) n);
+}
+
+/**
+ * Reads a variable length integer written by writeVarint.
+ * @param in the input.
+ * @param n output, the number.
+ * @return false at the end of the input or if the number does not fit 128 bits.
+ */
+static bool readVarint(std::istream &in , UInt128 &n)
+{
+    n = 0;
+    for (int shift = 0; shift < 128; shift += VARINT_BITS)
+    {
+        int byte = in.get();
+        if (byte == EOF || (shift == 126 && byte > 3))
+        {
+            return false;
+        }
+        n |= (UInt128) (byte & (VARINT_MORE - 1)) << shift;
+        if ((byte & VARINT_MORE) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Rebuilds the factorization of a number from the primes kept by the cache: every prime is
+ * divided out as often as it divides the number, and what is left is the largest prime.
+ * @param n the number.
+ * @param primes the primes kept by the cache.
+ * @return the prime factorization of n, sorted by prime.
+ */
+template<class Primes>
+static WideFactorization expand(UInt128 n , const Primes &primes)
+{
+    WideFactorization factorization;
+    if (n <= 1)
+    {
+        return factorization;
+    }
+    for (uint64_t prime : primes)
+    {
+        int exponent = 0;
+        for (; n % prime == 0; n /= prime)
+        {
+            exponent++;
+        }
+        factorization.addPrime(prime , exponent);
+    }
+    if (n > 1)
+    {
+        factorization.addPrime(n);
+    }
+    return factorization;
+}
+
+/**
+ * Spreads the numbers over the buckets and the shards (the splitmix64 finalizer of both
+ * halves).
+ * @param n a number.
+ * @return the hash of n.
+ */
+size_t FactorizationCache::Hash::operator()(UInt128 n) const
+{
+    uint64_t h = (uint64_t) n ^ ((uint64_t) (n >> 64) * 0x9E3779B97F4A7C15ull);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return (size_t) (h ^ (h >> 31));
+}
+
+/**
+ * A constructor.
+ * @param capacity the number of factorizations kept (rounded up to a multiple of the
+ * number of shards), 0 disables the cache.
+ */
+FactorizationCache::FactorizationCache(size_t capacity) :
+        _shardCapacity((capacity + FACTORIZATION_CACHE_SHARDS - 1) / FACTORIZATION_CACHE_SHARDS) ,
+        _shards(new Shard[FACTORIZATION_CACHE_SHARDS])
+{
+    for (size_t i = 0; i < FACTORIZATION_CACHE_SHARDS; i++)
+    {
+        _shards[i].index.reserve(_shardCapacity);
+        _shards[i].hits = _shards[i].misses = _shards[i].evictions = 0;
+    }
+}
+
+/**
+ * @param n a number.
+ * @return the shard of n.
+ */
+FactorizationCache::Shard &FactorizationCache::_shardOf(UInt128 n) const
+{
+    // the buckets use the low bits of the hash, the shards the high ones
+    return _shards[(Hash()(n) >> 32) % FACTORIZATION_CACHE_SHARDS];
+}
+
+/**
+ * Adds an entry to a locked shard as the most recently used one, evicting the least
+ * recently used entry if the shard is full. An entry of the same number is replaced.
+ * @param shard the shard, locked by the caller.
+ * @param n the number.
+ * @param primes its primes in the form kept by the cache.
+ */
+void FactorizationCache::_insert(Shard &shard , UInt128 n , Primes &&primes)
+{
+    auto found = shard.index.find(n);
+    if (found != shard.index.end())
+    {
+        found->second->primes = std::move(primes);
+        shard.entries.splice(shard.entries.begin() , shard.entries , found->second);
+        return;
+    }
+    if (shard.entries.size() == _shardCapacity)
+    {
+        // the least recently used node is reused for the new entry
+        shard.index.erase(shard.entries.back().number);
+        shard.entries.splice(shard.entries.begin() , shard.entries ,
+                             std::prev(shard.entries.end()));
+        shard.evictions++;
+    }
+    else
+    {
+        shard.entries.emplace_front();
+    }
+    shard.entries.front().number = n;
+    shard.entries.front().primes = std::move(primes);
+    shard.index.emplace(n , shard.entries.begin());
+}
+
+/**
+ * Looks a number up and marks it as the most recently used one.
+ * @param n the number.
+ * @param factorization output, the prime factorization of n sorted by prime (a prime is
+ * its own factor), set only on a hit.
+ * @return true if the number is cached.
+ */
+bool FactorizationCache::lookup(UInt128 n , WideFactorization &factorization)
+{
+    Shard &shard = _shardOf(n);
+    Primes primes;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(n);
+        if (found == shard.index.end())
+        {
+            shard.misses++;
+            return false;
+        }
+        shard.hits++;
+        shard.entries.splice(shard.entries.begin() , shard.entries , found->second);
+        primes = found->second->primes;
+    }
+    factorization = expand(n , primes);
+    return true;
+}
+
+/**
+ * Caches the factorization of a number.
+ * @param n the number.
+ * @param factorization the prime factorization of n sorted by prime, a prime may be given
+ * as its own factor or as an empty factorization.
+ */
+void FactorizationCache::insert(UInt128 n , const WideFactorization &factorization)
+{
+    if (_shardCapacity == 0)
+    {
+        return;
+    }
+    Primes primes;
+    for (size_t i = 0; i < factorization.size(); i++)
+    {
+        const WidePrimeFactor &factor = factorization[i];
+        if (i + 1 == factorization.size() && factor.exponent == 1)
+        {
+            break; // recovered as the cofactor
+        }
+        assert((factor.prime >> 64) == 0 && (i == 0 || factorization[i - 1].prime < factor.prime));
+        primes.push_back((uint64_t) factor.prime);
+    }
+    Shard &shard = _shardOf(n);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    _insert(shard , n , std::move(primes));
+}
+
+/**
+ * Drops every entry, the counters are kept.
+ */
+void FactorizationCache::clear()
+{
+    for (size_t i = 0; i < FACTORIZATION_CACHE_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        _shards[i].entries.clear();
+        _shards[i].index.clear();
+    }
+}
+
+/**
+ * Getter for the counters.
+ * @return a snapshot of the counters of every shard, summed.
+ */
+CacheStatistics FactorizationCache::getStatistics() const
+{
+    CacheStatistics statistics = {0 , 0 , 0 , 0};
+    for (size_t i = 0; i < FACTORIZATION_CACHE_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        statistics.hits += _shards[i].hits;
+        statistics.misses += _shards[i].misses;
+        statistics.evictions += _shards[i].evictions;
+        statistics.size += _shards[i].entries.size();
+    }
+    return statistics;
+}
+
+/**
+ * Zeroes the counters of every shard.
+ */
+void FactorizationCache::resetStatistics()
+{
+    for (size_t i = 0; i < FACTORIZATION_CACHE_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        _shards[i].hits = _shards[i].misses = _shards[i].evictions = 0;
+    }
+}
+
+/**
+ * Writes every entry to a file, which is replaced only once it is complete.
+ * A record is the number, the count of its primes and the first prime followed by the
+ * differences of the next ones, all variable length integers.
+ * @param path the file.
+ * @return false if the file could not be written.
+ */
+bool FactorizationCache::save(const std::string &path) const
+{
+    std::string bytes(CACHE_FILE_MAGIC);
+    bytes.push_back((char) CACHE_FILE_VERSION);
+    for (size_t i = 0; i < FACTORIZATION_CACHE_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        for (auto entry = _shards[i].entries.rbegin(); entry != _shards[i].entries.rend(); ++entry)
+        {
+            writeVarint(entry->number , bytes);
+            writeVarint(entry->primes.size() , bytes);
+            uint64_t previous = 0;
+            for (uint64_t prime : entry->primes)
+            {
+                writeVarint(prime - previous , bytes);
+                previous = prime;
+            }
+        }
+    }
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary , std::ios::binary | std::ios::trunc);
+        if (!out.write(bytes.data() , (std::streamsize) bytes.size()) || !out.flush())
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str() , path.c_str()) == 0;
+}
+
+/**
+ * Adds the entries of a file written by save(), the ones read last are the most recently
+ * used ones. Every prime is checked to divide its number.
+ * @param path the file.
+ * @return false if the file could not be read or is not a valid cache file (the entries
+ * read before the error are kept).
+ */
+bool FactorizationCache::load(const std::string &path)
+{
+    std::ifstream in(path , std::ios::binary);
+    char header[sizeof(CACHE_FILE_MAGIC)];
+    if (!in.read(header , sizeof(header)) ||
+        std::string(header , sizeof(header) - 1) != CACHE_FILE_MAGIC ||
+        header[sizeof(header) - 1] != CACHE_FILE_VERSION)
+    {
+        return false;
+    }
+    while (in.peek() != EOF)
+    {
+        // a number below 2^128 has fewer than 128 prime factors
+        UInt128 n , count , prime = 0 , difference;
+        if (!readVarint(in , n) || !readVarint(in , count) || count >= 128)
+        {
+            return false;
+        }
+        Primes primes;
+        for (UInt128 i = 0; i < count; i++)
+        {
+            if (!readVarint(in , difference) || difference == 0 || (prime += difference) < 2 ||
+                (prime >> 64) != 0 || n % prime != 0)
+            {
+                return false;
+            }
+            primes.push_back((uint64_t) prime);
+        }
+        if (_shardCapacity > 0)
+        {
+            Shard &shard = _shardOf(n);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            _insert(shard , n , std::move(primes));
+        }
+    }
+    return true;
+}
+
+/**
+ * The cache of the whole process, used by the batch mode and by GFNumber::getPrimeFactors.
+ * @return the shared cache.
+ */
+FactorizationCache &FactorizationCache::global()
+{
+    static FactorizationCache cache;
+    return cache;
+}
+
+/**
+ * Operator overloading of "<<", prints the counters on one line.
+ * @param out ostream reference.
+ * @param statistics the counters.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const CacheStatistics &statistics)
+{
+    return (out << "factorization cache: " << statistics.hits << " hits, " << statistics.misses
+                << " misses (" << statistics.hitRate() * 100 << "%), " << statistics.evictions
+                << " evictions, " << statistics.size << " entries");
+}
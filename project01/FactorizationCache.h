@@ -0,0 +1,186 @@
+// FactorizationCache.h
+//----------- include guards------------
+#ifndef FACTORIZATIONCACHE_H
+#define FACTORIZATIONCACHE_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Montgomery128.h"
+#include "SmallVector.hpp"
+#include "WideFactorization.h"
+
+#define FACTORIZATION_CACHE_CAPACITY 65536 /** default number of cached factorizations */
+#define FACTORIZATION_CACHE_SHARDS 16 /** independently locked parts of the cache */
+#define CACHE_INLINE_PRIMES 2 /** primes kept inline by an entry (a semiprime needs one) */
+#define CACHE_FILE_ENV "GF_FACTOR_CACHE" /** environment variable naming the cache file */
+
+//--------------------------------------
+
+/**
+ * The counters of a cache, summed over its shards.
+ */
+struct CacheStatistics
+{
+    uint64_t hits; /** The lookups which found the number. */
+    uint64_t misses; /** The lookups which did not. */
+    uint64_t evictions; /** The entries dropped to make room for newer ones. */
+    size_t size; /** The entries held. */
+
+    /**
+     * @return the fraction of the lookups which found the number.
+     */
+    double hitRate() const
+    { return (hits + misses > 0) ? (double) hits / (hits + misses) : 0; }
+};
+
+/**
+ *  A FactorizationCache class.
+ *  A bounded map from a number of up to 128 bits to its prime factorization, which drops the
+ *  least recently used entry when it is full. The numbers are spread by a hash over
+ *  FACTORIZATION_CACHE_SHARDS shards, each with its own lock, list and index, so threads
+ *  looking up different numbers rarely wait for each other.
+ *  An entry keeps the distinct primes of the number but the largest one when its exponent is
+ *  1, the exponents and that prime are recovered by dividing them out of the number. A prime
+ *  costs no storage and a semiprime a single word, both inline. Every prime kept is below 2^64,
+ *  since only a prime which appears once can be larger.
+ *  The cache can be saved to and loaded from a compact binary file: the numbers and the
+ *  differences of their primes as variable length integers, least recently used first.
+ */
+class FactorizationCache
+{
+private:
+    /** Inline storage of the primes of an entry. */
+    typedef SmallVector<uint64_t , CACHE_INLINE_PRIMES> Primes;
+
+    /** One cached factorization. */
+    struct Entry
+    {
+        UInt128 number; /** The number. */
+        Primes primes; /** Its primes, without the largest one when its exponent is 1. */
+    };
+
+    /** Spreads the numbers over the buckets and the shards. */
+    struct Hash
+    {
+        size_t operator()(UInt128 n) const;
+    };
+
+    /** A part of the cache. */
+    struct Shard
+    {
+        std::mutex mutex; /** Guards everything below. */
+        std::list<Entry> entries; /** The entries, the most recently used first. */
+        std::unordered_map<UInt128 , std::list<Entry>::iterator , Hash> index; /** By number. */
+        uint64_t hits; /** The lookups which found the number. */
+        uint64_t misses; /** The lookups which did not. */
+        uint64_t evictions; /** The entries dropped. */
+    };
+
+    size_t _shardCapacity; /** The number of entries of every shard. */
+    std::unique_ptr<Shard[]> _shards; /** The shards. */
+
+    /**
+     * @param n a number.
+     * @return the shard of n.
+     */
+    Shard &_shardOf(UInt128 n) const;
+
+    /**
+     * Adds an entry to a locked shard as the most recently used one, evicting the least
+     * recently used entry if the shard is full. An entry of the same number is replaced.
+     * @param shard the shard, locked by the caller.
+     * @param n the number.
+     * @param primes its primes in the form kept by the cache.
+     */
+    void _insert(Shard &shard , UInt128 n , Primes &&primes);
+
+public:
+    /**
+     * A constructor.
+     * @param capacity the number of factorizations kept (rounded up to a multiple of the
+     * number of shards), 0 disables the cache.
+     */
+    explicit FactorizationCache(size_t capacity = FACTORIZATION_CACHE_CAPACITY);
+
+    FactorizationCache(const FactorizationCache &) = delete;
+
+    FactorizationCache &operator=(const FactorizationCache &) = delete;
+
+    /**
+     * Looks a number up and marks it as the most recently used one.
+     * @param n the number.
+     * @param factorization output, the prime factorization of n sorted by prime (a prime is
+     * its own factor), set only on a hit.
+     * @return true if the number is cached.
+     */
+    bool lookup(UInt128 n , WideFactorization &factorization);
+
+    /**
+     * Caches the factorization of a number.
+     * @param n the number.
+     * @param factorization the prime factorization of n sorted by prime, a prime may be given
+     * as its own factor or as an empty factorization.
+     */
+    void insert(UInt128 n , const WideFactorization &factorization);
+
+    /**
+     * Drops every entry, the counters are kept.
+     */
+    void clear();
+
+    /**
+     * Getter for the capacity.
+     * @return the number of factorizations kept.
+     */
+    size_t getCapacity() const
+    { return _shardCapacity * FACTORIZATION_CACHE_SHARDS; }
+
+    /**
+     * Getter for the counters.
+     * @return a snapshot of the counters of every shard, summed.
+     */
+    CacheStatistics getStatistics() const;
+
+    /**
+     * Zeroes the counters of every shard.
+     */
+    void resetStatistics();
+
+    /**
+     * Writes every entry to a file, which is replaced only once it is complete.
+     * @param path the file.
+     * @return false if the file could not be written.
+     */
+    bool save(const std::string &path) const;
+
+    /**
+     * Adds the entries of a file written by save(), the ones read last are the most recently
+     * used ones.
+     * @param path the file.
+     * @return false if the file could not be read or is not a valid cache file (the entries
+     * read before the error are kept).
+     */
+    bool load(const std::string &path);
+
+    /**
+     * The cache of the whole process, used by the batch mode and by GFNumber::getPrimeFactors.
+     * @return the shared cache.
+     */
+    static FactorizationCache &global();
+};
+
+/**
+ * Operator overloading of "<<", prints the counters on one line.
+ * @param out ostream reference.
+ * @param statistics the counters.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const CacheStatistics &statistics);
+
+#endif //FACTORIZATIONCACHE_H
@@ -0,0 +1,752 @@
+// FactorizationPipeline.cpp
+
+#include "FactorizationPipeline.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include "EllipticCurveMethod.h"
+#include "GField.h"
+#include "ModReducer.h"
+#include "PrimeSieve.h"
+#include "QuadraticSieve.h"
+#include "RandomSource.h"
+
+/** The multipliers of SQUFOF, the square free products of 3, 5, 7 and 11. */
+static const uint64_t SQUFOF_MULTIPLIERS[] = {1 , 3 , 5 , 7 , 11 , 3 * 5 , 3 * 7 , 3 * 11 , 5 * 7 ,
+                                              5 * 11 , 7 * 11 , 3 * 5 * 7 , 3 * 5 * 11 ,
+                                              3 * 7 * 11 , 5 * 7 * 11 , 3 * 5 * 7 * 11};
+
+/** Bit r is set when r is a square mod 64. */
+#define SQUARES_MOD_64 0x202021202030213ull
+
+/** The primes below the first one of the trial division table. */
+static const uint64_t WHEEL_PRIMES[] = {2 , 3 , 5 , 7};
+
+/** The Miller-Rabin bases of isProbablePrime, the first 16 primes. */
+static const uint64_t WIDE_WITNESSES[] = {2 , 3 , 5 , 7 , 11 , 13 , 17 , 19 , 23 , 29 , 31 , 37 ,
+                                          41 , 43 , 47 , 53};
+
+/** Below 2^81 Miller-Rabin to WIDE_WITNESSES alone is deterministic, above it BPSW. */
+#define DETERMINISTIC_WITNESS_BITS 81
+
+/** The stage 1 bounds of the elliptic curve stage. */
+static const uint64_t ECM_B1[ECM_LEVELS] = {2000 , 11000 , 50000 , 250000};
+
+/** The curves run at each bound, the last one runs until a factor is found. */
+static const int ECM_CURVES[ECM_LEVELS] = {25 , 90 , 300 , 0};
+
+/**
+ * @return the steady clock time in nanoseconds.
+ */
+static uint64_t now()
+{
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * The i'th prime, 2, 3, 5 and 7 followed by the trial division table.
+ * @param i the index, below 4 + the size of the table.
+ * @return the prime.
+ */
+static uint64_t primeAt(size_t i)
+{
+    return (i < 4) ? WHEEL_PRIMES[i] : PrimeSieve::trialPrimes()[i - 4].prime;
+}
+
+/**
+ * The largest power of a prime which does not exceed the bound.
+ * @param prime the prime, at most bound.
+ * @param bound the bound.
+ * @return the power.
+ */
+static uint64_t primePower(uint64_t prime , uint64_t bound)
+{
+    uint64_t power = prime;
+    while (power <= bound / prime)
+    {
+        power *= prime;
+    }
+    return power;
+}
+
+/**
+ * The curves of one level of the elliptic curve stage, built on first use (the last level
+ * holds the 1.4 million primes below 2.5 * 10^7).
+ * @param level the level.
+ * @return the curves.
+ */
+static const EllipticCurveMethod &ecmLevel(int level)
+{
+    static std::unique_ptr<EllipticCurveMethod> levels[ECM_LEVELS];
+    static std::once_flag built[ECM_LEVELS];
+    std::call_once(built[level] , [level]()
+    {
+        levels[level].reset(new EllipticCurveMethod(ECM_B1[level] ,
+                                                    ECM_B1[level] * ECM_STAGE2_FACTOR));
+    });
+    return *levels[level];
+}
+
+/**
+ * A constructor, every stage but SQUFOF is enabled with the default bounds.
+ */
+FactorizationPipeline::FactorizationPipeline() : _trialBound(PIPELINE_TRIAL_BOUND) ,
+                                                 _pm1Bound(PIPELINE_PM1_BOUND)
+{
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        // SQUFOF divides on every step, it takes about 1.5 times the time of the Rho walk
+        _enabled[stage] = stage != SQUFOF_STAGE;
+    }
+    resetStatistics();
+}
+
+/**
+ * Factors a number into primes and adds them to the factorization (not sorted).
+ * @param n the number, 0 and 1 have no factors.
+ * @param factorization the factorization to add the primes to.
+ * @param rho the splitter of the Rho stage.
+ */
+void FactorizationPipeline::factor(long n , PrimeFactorization &factorization ,
+                                   const Splitter &rho)
+{
+    if (n <= 1)
+    {
+        return;
+    }
+    uint64_t m = (uint64_t) n;
+    if (_enabled[TRIAL_STAGE])
+    {
+        uint64_t start = now();
+        m = trialDivision(m , _trialBound , factorization);
+        _count(TRIAL_STAGE , start , m != (uint64_t) n);
+    }
+    else
+    {
+        int twos = __builtin_ctzll(m);
+        if (twos > 0)
+        {
+            factorization.addPrime(2 , twos);
+            m >>= twos;
+        }
+    }
+    _factorCofactor(m , factorization , rho);
+}
+
+/**
+ * Factors a number of up to 128 bits into primes and adds them to the factorization
+ * (not sorted).
+ * @param n the number, 0 and 1 have no factors.
+ * @param factorization the factorization to add the primes to.
+ * @param rho the splitter of the Rho stage.
+ * @param pool the pool the quadratic sieve runs on (may be null), the caller sieves too
+ * and never waits on it.
+ */
+void FactorizationPipeline::factorWide(UInt128 n , WideFactorization &factorization ,
+                                       const Splitter &rho , ThreadPool *pool)
+{
+    if ((n >> 63) == 0)
+    {
+        PrimeFactorization narrow;
+        factor((long) n , narrow , rho);
+        factorization.addAll(narrow);
+        return;
+    }
+    UInt128 m = n;
+    int twos = ctz128(m);
+    if (twos > 0)
+    {
+        factorization.addPrime(2 , twos);
+        m >>= twos;
+    }
+    if (_enabled[TRIAL_STAGE])
+    {
+        // only while the cofactor is wide, the narrow path divides faster
+        uint64_t start = now();
+        const size_t primes = 4 + PrimeSieve::trialPrimes().size();
+        for (size_t i = 1; i < primes && primeAt(i) <= _trialBound && (m >> 63) != 0; i++)
+        {
+            while (m % primeAt(i) == 0)
+            {
+                factorization.addPrime((long) primeAt(i));
+                m /= primeAt(i);
+            }
+        }
+        _count(TRIAL_STAGE , start , m != n >> twos);
+    }
+    _factorWideCofactor(m , factorization , rho , pool);
+}
+
+/**
+ * Factors a cofactor of up to 128 bits which has no prime factor below the trial bound.
+ * @param m odd number.
+ * @param factorization the factorization to add the primes to.
+ * @param rho the splitter of the Rho stage.
+ * @param pool the pool the quadratic sieve runs on (may be null).
+ */
+void FactorizationPipeline::_factorWideCofactor(UInt128 m , WideFactorization &factorization ,
+                                                const Splitter &rho , ThreadPool *pool)
+{
+    if ((m >> 63) == 0)
+    {
+        PrimeFactorization narrow;
+        factor((long) m , narrow , rho);
+        factorization.addAll(narrow);
+        return;
+    }
+    if (isProbablePrime(m))
+    {
+        factorization.addPrime(m);
+        return;
+    }
+    UInt128 factor = NO_FACTOR;
+    if (_enabled[SIQS_STAGE])
+    {
+        uint64_t start = now();
+        factor = QuadraticSieve(m).factor(pool);
+        _count(SIQS_STAGE , start , factor != NO_FACTOR);
+    }
+    if (factor == NO_FACTOR && _enabled[ECM_STAGE])
+    {
+        uint64_t start = now();
+        factor = ellipticCurveMethod(m);
+        _count(ECM_STAGE , start , factor != NO_FACTOR);
+    }
+    if (factor == NO_FACTOR)
+    {
+        // every wide stage is disabled, the curves still run (uncounted) until they split m
+        factor = ellipticCurveMethod(m);
+    }
+    _factorWideCofactor(factor , factorization , rho , pool);
+    _factorWideCofactor(m / factor , factorization , rho , pool);
+}
+
+/**
+ * Factors a cofactor which has no prime factor below the trial bound.
+ * @param m odd number.
+ * @param factorization the factorization to add the primes to.
+ * @param rho the splitter of the Rho stage.
+ */
+void FactorizationPipeline::_factorCofactor(uint64_t m , PrimeFactorization &factorization ,
+                                            const Splitter &rho)
+{
+    if (m == 1)
+    {
+        return;
+    }
+    if (GField::isPrime((long) m))
+    {
+        factorization.addPrime((long) m);
+        return;
+    }
+    uint64_t factor = _split(m , rho);
+    if (factor == NO_FACTOR)
+    {
+        // every stage failed, fall back to the complete trial division
+        m = trialDivision(m , UINT64_MAX , factorization);
+        if (m > 1)
+        {
+            factorization.addPrime((long) m);
+        }
+        return;
+    }
+    _factorCofactor(factor , factorization , rho);
+    _factorCofactor(m / factor , factorization , rho);
+}
+
+/**
+ * Runs the splitting stages on an odd composite until one of them succeeds.
+ * @param m odd composite number.
+ * @param rho the splitter of the Rho stage.
+ * @return a non trivial factor, or NO_FACTOR if every stage failed.
+ */
+uint64_t FactorizationPipeline::_split(uint64_t m , const Splitter &rho)
+{
+    uint64_t factor = NO_FACTOR;
+    if (_enabled[PM1_STAGE])
+    {
+        uint64_t start = now();
+        factor = pollardPm1(m , _pm1Bound);
+        _count(PM1_STAGE , start , factor != NO_FACTOR);
+        if (factor != NO_FACTOR)
+        {
+            return factor;
+        }
+    }
+    if (_enabled[SQUFOF_STAGE] && (m >> SQUFOF_BITS) == 0)
+    {
+        uint64_t start = now();
+        factor = squfof(m);
+        _count(SQUFOF_STAGE , start , factor != NO_FACTOR);
+        if (factor != NO_FACTOR)
+        {
+            return factor;
+        }
+    }
+    if (_enabled[RHO_STAGE])
+    {
+        uint64_t start = now();
+        long split = rho((long) m);
+        bool success = split > 1 && (uint64_t) split < m;
+        _count(RHO_STAGE , start , success);
+        if (success)
+        {
+            return (uint64_t) split;
+        }
+    }
+    return NO_FACTOR;
+}
+
+/**
+ * Adds the time since start to the counters of a stage.
+ * @param stage the stage.
+ * @param start the steady clock time the stage started (nanoseconds).
+ * @param success whether the stage succeeded.
+ */
+void FactorizationPipeline::_count(FactorizationStage stage , uint64_t start , bool success)
+{
+    Counters &counters = _counters[stage];
+    counters.nanoseconds.fetch_add(now() - start , std::memory_order_relaxed);
+    counters.attempts.fetch_add(1 , std::memory_order_relaxed);
+    if (success)
+    {
+        counters.successes.fetch_add(1 , std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Getter for the counters of a stage.
+ * @param stage the stage.
+ * @return a snapshot of the counters.
+ */
+StageStatistics FactorizationPipeline::getStatistics(FactorizationStage stage) const
+{
+    const Counters &counters = _counters[stage];
+    StageStatistics statistics = {counters.attempts.load() , counters.successes.load() ,
+                                  counters.nanoseconds.load() * 1e-9};
+    return statistics;
+}
+
+/**
+ * Zeroes the counters of every stage.
+ */
+void FactorizationPipeline::resetStatistics()
+{
+    for (Counters &counters : _counters)
+    {
+        counters.attempts = 0;
+        counters.successes = 0;
+        counters.nanoseconds = 0;
+    }
+}
+
+/**
+ * @param stage a stage.
+ * @return the name of the stage.
+ */
+const char *FactorizationPipeline::stageName(FactorizationStage stage)
+{
+    static const char *const names[STAGE_COUNT] = {"trial" , "p-1" , "squfof" , "rho" , "siqs" ,
+                                                    "ecm"};
+    return names[stage];
+}
+
+/**
+ * The pipeline used by GFNumber::getPrimeFactors().
+ * @return the shared pipeline.
+ */
+FactorizationPipeline &FactorizationPipeline::global()
+{
+    static FactorizationPipeline pipeline;
+    return pipeline;
+}
+
+/**
+ * Divides out every prime up to bound (and below the square root of the cofactor).
+ * @param m the number to divide.
+ * @param bound the largest prime tried, UINT64_MAX for a complete factorization.
+ * @param factorization the factorization to add the primes to.
+ * @return the cofactor, which is prime or 1 when every prime up to its root was tried.
+ */
+uint64_t FactorizationPipeline::trialDivision(uint64_t m , uint64_t bound ,
+                                              PrimeFactorization &factorization)
+{
+    if (m == 0)
+    {
+        return m;
+    }
+    int twos = __builtin_ctzll(m);
+    if (twos > 0)
+    {
+        factorization.addPrime(2 , twos);
+        m >>= twos;
+    }
+    for (uint64_t prime : {3 , 5 , 7})
+    {
+        while (prime <= bound && m % prime == 0)
+        {
+            factorization.addPrime((long) prime);
+            m /= prime;
+        }
+    }
+    for (const TrialPrime &trial : PrimeSieve::trialPrimes())
+    {
+        if (trial.prime > bound || trial.prime * trial.prime > m)
+        {
+            return m;
+        }
+        while (m * trial.inverse <= trial.limit)
+        {
+            factorization.addPrime((long) trial.prime);
+            m *= trial.inverse; // the exact quotient
+        }
+    }
+    if (bound >= TRIAL_PRIME_LIMIT && m >= (uint64_t) TRIAL_PRIME_LIMIT * TRIAL_PRIME_LIMIT)
+    {
+        PrimeSieve primes(TRIAL_PRIME_LIMIT);
+        for (uint64_t prime = primes.next(); prime <= bound && prime * prime <= m;
+             prime = primes.next())
+        {
+            while (m % prime == 0)
+            {
+                factorization.addPrime((long) prime);
+                m /= prime;
+            }
+        }
+    }
+    return m;
+}
+
+/**
+ * Pollard's p - 1, stage 1: computes gcd(2^E - 1, n) where E is the product of the
+ * largest powers of the primes up to bound, which splits n when p - 1 is bound smooth
+ * for one of its prime factors p.
+ * The gcd is taken every PM1_GCD_INTERVAL primes, and when it collapses to n the last
+ * interval is walked again one prime at a time. The bound is capped by the trial table.
+ * @param n odd composite number.
+ * @param bound the stage 1 bound.
+ * @return a non trivial factor, or NO_FACTOR.
+ */
+uint64_t FactorizationPipeline::pollardPm1(uint64_t n , uint64_t bound)
+{
+    const size_t primes = 4 + PrimeSieve::trialPrimes().size();
+    const ModReducer reducer(n);
+    const uint64_t one = reducer.toMontgomery(1);
+    uint64_t a = reducer.toMontgomery(2) , saved = a;
+    size_t checked = 0;
+    for (size_t i = 0; i < primes && primeAt(i) <= bound; i++)
+    {
+        a = reducer.powMontgomery(a , primePower(primeAt(i) , bound));
+        bool last = i + 1 == primes || primeAt(i + 1) > bound;
+        if ((i + 1) % PM1_GCD_INTERVAL != 0 && !last)
+        {
+            continue;
+        }
+        uint64_t g = GField::binaryGcd(reducer.subMod(a , one) , n);
+        if (g == 1)
+        {
+            saved = a;
+            checked = i + 1;
+            continue;
+        }
+        if (g != n)
+        {
+            return g;
+        }
+        // every prime factor was found in the same interval, walk it one prime at a time
+        a = saved;
+        for (size_t j = checked; j <= i; j++)
+        {
+            a = reducer.powMontgomery(a , primePower(primeAt(j) , bound));
+            g = GField::binaryGcd(reducer.subMod(a , one) , n);
+            if (g != 1)
+            {
+                return (g == n) ? NO_FACTOR : g;
+            }
+        }
+        return NO_FACTOR;
+    }
+    return NO_FACTOR;
+}
+
+/**
+ * One step of the continued fraction expansion of sqrt(d), on the (P, Q) pairs.
+ * @param p0 floor(sqrt(d)).
+ * @param p the current P, updated.
+ * @param q the current Q, updated.
+ * @param previousQ the Q before it, updated.
+ * @return the P before the step.
+ */
+template<class Word>
+static inline Word squfofStep(Word p0 , Word &p , Word &q , Word &previousQ)
+{
+    Word b = (p0 + p) / q;
+    Word previousP = p;
+    p = b * q - p;
+    Word nextQ = previousQ + b * (previousP - p); // the subtraction may wrap, the sum does not
+    previousQ = q;
+    q = nextQ;
+    return previousP;
+}
+
+/**
+ * SQUFOF with one multiplier: walks the continued fraction of sqrt(d) until a square form
+ * appears at an even step, then walks the reverse cycle of its root until P repeats, where
+ * the Q holds a factor of d.
+ * @param n the number.
+ * @param d the multiplier times n, every P and Q (below 2 * sqrt(d)) fits a Word.
+ * @param iterations the bound of each cycle.
+ * @return a non trivial factor of n, or NO_FACTOR.
+ */
+template<class Word>
+static uint64_t squfofWalk(uint64_t n , uint64_t d , uint64_t iterations)
+{
+    const Word p0 = (Word) integerSqrt128(d);
+    Word p = p0 , previousQ = 1 , q = (Word) (d - (uint64_t) p0 * p0) , r = 0;
+    if (q == 0)
+    {
+        return NO_FACTOR;
+    }
+    // the forward cycle, most non squares are rejected by their residue mod 64
+    uint64_t i;
+    for (i = 2; i < iterations; i += 2)
+    {
+        squfofStep(p0 , p , q , previousQ);
+        if ((SQUARES_MOD_64 >> (q & 63)) & 1)
+        {
+            r = (Word) (sqrt((double) q) + 0.5);
+            if ((uint64_t) r * r == q)
+            {
+                break;
+            }
+        }
+        squfofStep(p0 , p , q , previousQ);
+    }
+    if (i >= iterations)
+    {
+        return NO_FACTOR;
+    }
+    // the reverse cycle, from the square root of the form
+    p += (p0 - p) / r * r;
+    previousQ = r;
+    q = (Word) ((d - (uint64_t) p * p) / r);
+    for (i = 0; i < iterations && squfofStep(p0 , p , q , previousQ) != p; i++)
+    {
+    }
+    uint64_t factor = GField::binaryGcd(n , previousQ);
+    return (i >= iterations || factor == 1 || factor == n) ? NO_FACTOR : factor;
+}
+
+/**
+ * Shanks' square forms factorization, tried with the multipliers of 3 * 5 * 7 * 11.
+ * The walks run on 32 bit words when the multiplier times n is below 2^62, which makes
+ * every division cheaper.
+ * @param n odd composite number below 2^SQUFOF_BITS.
+ * @return a non trivial factor, or NO_FACTOR.
+ */
+uint64_t FactorizationPipeline::squfof(uint64_t n)
+{
+    uint64_t root = (uint64_t) integerSqrt128(n);
+    if (root * root == n)
+    {
+        return root;
+    }
+    const uint64_t iterations = 3 * (uint64_t) (2 * sqrt(2 * (double) root));
+    for (uint64_t multiplier : SQUFOF_MULTIPLIERS)
+    {
+        if (n > UINT64_MAX / multiplier)
+        {
+            break;
+        }
+        uint64_t d = multiplier * n;
+        uint64_t factor = ((d >> 62) == 0) ? squfofWalk<uint32_t>(n , d , iterations)
+                                           : squfofWalk<uint64_t>(n , d , iterations);
+        if (factor != NO_FACTOR)
+        {
+            return factor;
+        }
+    }
+    return NO_FACTOR;
+}
+
+/**
+ * Splits an odd composite of up to 128 bits with elliptic curves, through ECM_LEVELS
+ * bounds with the usual number of curves for factors of 15, 20 and 25 digits, then as
+ * many curves as it takes at the last bound (for 30 digits).
+ * @param n odd composite number, not a prime power of a prime below the trial bound.
+ * @return a non trivial factor.
+ */
+UInt128 FactorizationPipeline::ellipticCurveMethod(UInt128 n)
+{
+    const Montgomery128 reducer(n);
+    for (int level = 0; level < ECM_LEVELS; level++)
+    {
+        const EllipticCurveMethod &curves = ecmLevel(level);
+        bool last = level == ECM_LEVELS - 1;
+        for (int curve = 0; last || curve < ECM_CURVES[level]; curve++)
+        {
+            UInt128 factor = curves.tryCurve(reducer ,
+                                             RandomSource::nextInRange(ECM_MIN_SIGMA , UINT32_MAX));
+            if (factor != NO_FACTOR)
+            {
+                return factor;
+            }
+        }
+    }
+    return NO_FACTOR;
+}
+
+/**
+ * Halves a residue (or Montgomery form) modulo an odd number, without overflowing.
+ * @param x residue.
+ * @param n odd modulus.
+ * @return x / 2 mod n.
+ */
+static UInt128 halveMod(UInt128 x , UInt128 n)
+{
+    return (x & 1) ? (x >> 1) + (n >> 1) + 1 : x >> 1;
+}
+
+/**
+ * Miller-Rabin to the bases of the first 16 primes, which is deterministic below 2^81, and
+ * above 2^81 also the strong Lucas test, which together are the Baillie-PSW test (no
+ * composite is known to pass it). n below 2^63 goes through GField::isPrime.
+ * @param n a number.
+ * @return true if n is a (probable) prime.
+ */
+bool FactorizationPipeline::isProbablePrime(UInt128 n)
+{
+    if ((n >> 63) == 0)
+    {
+        return GField::isPrime((long) n);
+    }
+    for (uint64_t prime : WIDE_WITNESSES)
+    {
+        if (n % prime == 0)
+        {
+            return false;
+        }
+    }
+    const Montgomery128 reducer(n);
+    const UInt128 minusOne = reducer.subMod(0 , reducer.one());
+    UInt128 d = n - 1;
+    int twos = ctz128(d);
+    d >>= twos;
+    for (uint64_t witness : WIDE_WITNESSES)
+    {
+        UInt128 x = reducer.pow(reducer.toMontgomery(witness) , d);
+        if (x == reducer.one() || x == minusOne)
+        {
+            continue;
+        }
+        int i = 1;
+        for (; i < twos && x != minusOne; i++)
+        {
+            x = reducer.mul(x , x);
+        }
+        if (x != minusOne)
+        {
+            return false;
+        }
+    }
+    return (n >> DETERMINISTIC_WITNESS_BITS) == 0 || isStrongLucasProbablePrime(n);
+}
+
+/**
+ * The strong Lucas probable prime test with Selfridge's parameters: the first D of 5, -7,
+ * 9, -11, ... with (D / n) = -1, P = 1 and Q = (1 - D) / 4. With n + 1 = d * 2^s, d odd,
+ * a prime n has U_d = 0 or V_(d * 2^r) = 0 mod n for some r < s.
+ * @param n a number.
+ * @return true if n is a strong Lucas probable prime (primes always are).
+ */
+bool FactorizationPipeline::isStrongLucasProbablePrime(UInt128 n)
+{
+    if (n < 3 || (n & 1) == 0 || n + 1 == 0) // 2^128 - 1 is divisible by 3
+    {
+        return n == 2;
+    }
+    UInt128 root = integerSqrt128(n);
+    if (root * root == n) // no D would have (D / n) = -1
+    {
+        return false;
+    }
+    long d = 5;
+    for (;; d = (d > 0) ? -d - 2 : -d + 2)
+    {
+        UInt128 magnitude = (UInt128) ((d > 0) ? d : -d);
+        int symbol = jacobi128((d > 0) ? magnitude : n - magnitude % n , n);
+        if (symbol == -1)
+        {
+            break;
+        }
+        if (symbol == 0 && magnitude % n != 0)
+        {
+            return false; // |D| shares a factor with n
+        }
+    }
+    const Montgomery128 reducer(n);
+    auto toResidue = [&reducer](long a)
+    {
+        UInt128 form = reducer.toMontgomery((UInt128) ((a > 0) ? a : -a));
+        return (a > 0) ? form : reducer.subMod(0 , form);
+    };
+    const UInt128 dForm = toResidue(d) , qForm = toResidue((1 - d) / 4);
+    UInt128 exponent = n + 1;
+    int twos = ctz128(exponent);
+    exponent >>= twos;
+    // U_k, V_k and Q^k from the top bit of the exponent down, starting at k = 1
+    UInt128 u = reducer.one() , v = reducer.one() , qPower = qForm;
+    const uint64_t high = (uint64_t) (exponent >> 64);
+    const int top = (high != 0) ? 127 - __builtin_clzll(high) :
+                    63 - __builtin_clzll((uint64_t) exponent);
+    for (int bit = top - 1; bit >= 0; bit--)
+    {
+        u = reducer.mul(u , v);
+        v = reducer.subMod(reducer.mul(v , v) , reducer.addMod(qPower , qPower));
+        qPower = reducer.mul(qPower , qPower);
+        if ((exponent >> bit) & 1)
+        {
+            UInt128 nextU = halveMod(reducer.addMod(u , v) , n);
+            v = halveMod(reducer.addMod(reducer.mul(dForm , u) , v) , n);
+            u = nextU;
+            qPower = reducer.mul(qPower , qForm);
+        }
+    }
+    if (u == 0 || v == 0)
+    {
+        return true;
+    }
+    for (int r = 1; r < twos; r++)
+    {
+        v = reducer.subMod(reducer.mul(v , v) , reducer.addMod(qPower , qPower));
+        if (v == 0)
+        {
+            return true;
+        }
+        qPower = reducer.mul(qPower , qPower);
+    }
+    return false;
+}
+
+/**
+ * Operator overloading of "<<", prints the counters of every stage, one line per stage.
+ * @param out ostream reference.
+ * @param pipeline the pipeline.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const FactorizationPipeline &pipeline)
+{
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        StageStatistics statistics = pipeline.getStatistics((FactorizationStage) stage);
+        out << FactorizationPipeline::stageName((FactorizationStage) stage) << ": "
+            << statistics.successes << "/" << statistics.attempts << " split, "
+            << statistics.seconds << "s"
+            << (pipeline.isStageEnabled((FactorizationStage) stage) ? "" : " (disabled)")
+            << '\n';
+    }
+    return out;
+}
@@ -0,0 +1,280 @@
+// FactorizationPipeline.h
+//----------- include guards------------
+#ifndef FACTORIZATIONPIPELINE_H
+#define FACTORIZATIONPIPELINE_H
+//-------------- includes --------------
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "Montgomery128.h"
+#include "PrimeFactorization.h"
+#include "WideFactorization.h"
+
+class ThreadPool;
+
+#define PIPELINE_TRIAL_BOUND 1024 /** default bound of the trial division stage */
+#define PIPELINE_PM1_BOUND 2000 /** default stage 1 bound of Pollard's p - 1 */
+#define PM1_GCD_INTERVAL 32 /** primes of p - 1 between two gcds */
+#define SQUFOF_BITS 62 /** SQUFOF only attacks composites below 2^SQUFOF_BITS */
+#define NO_FACTOR 0 /** returned by a stage which found no factor */
+#define ECM_LEVELS 4 /** the number of bounds of the elliptic curve stage */
+
+//--------------------------------------
+
+/**
+ * The stages of the pipeline, in the order they attack a number.
+ */
+enum FactorizationStage
+{
+    TRIAL_STAGE , /** Trial division by the primes up to the trial bound. */
+    PM1_STAGE , /** Pollard's p - 1, stage 1. */
+    SQUFOF_STAGE , /** Shanks' square forms factorization. */
+    RHO_STAGE , /** Pollard's Rho (supplied by the caller). */
+    SIQS_STAGE , /** The self initializing quadratic sieve, for cofactors of 63 bits or more. */
+    ECM_STAGE , /** Lenstra's elliptic curve method, for the cofactors the sieve fails on. */
+    STAGE_COUNT
+};
+
+/**
+ * The counters of one stage.
+ */
+struct StageStatistics
+{
+    uint64_t attempts; /** The numbers the stage ran on. */
+    uint64_t successes; /** The runs which split the number. */
+    double seconds; /** The time spent in the stage. */
+};
+
+/**
+ *  A FactorizationPipeline class.
+ *  Factors a number by a sequence of stages, from the cheapest to the most general one:
+ *  trial division by the small primes, then every composite cofactor is split by Pollard's
+ *  p - 1, SQUFOF (below 2^SQUFOF_BITS) or Pollard's Rho, whichever succeeds first, and the
+ *  parts are factored again. A cofactor which is prime is never handed to a stage.
+ *  Every stage counts its attempts, successes and time, so its bound can be tuned.
+ *  SQUFOF is disabled by default, on 32 to 62 bit semiprimes it takes about 1.5 times the
+ *  time of the Rho walk.
+ *  Numbers of up to 128 bits go through factorWide: trial division, then the cofactors of 63
+ *  bits or more are split by the quadratic sieve (ECM with growing bounds if the sieve is
+ *  disabled or fails) and the smaller ones take the path above. The sieve takes the same time
+ *  whatever the size of the factors, on 128 bit semiprimes it is about 7 times faster than
+ *  ECM and still 2 times faster on 80 bit ones.
+ *  The configuration must not change while the pipeline is in use, the counters may be
+ *  updated by many threads.
+ */
+class FactorizationPipeline
+{
+public:
+    /** Splits an odd composite number, returns a non trivial factor or a value <= 1. */
+    typedef std::function<long(long)> Splitter;
+
+private:
+    /** The counters of one stage. */
+    struct Counters
+    {
+        std::atomic<uint64_t> attempts;
+        std::atomic<uint64_t> successes;
+        std::atomic<uint64_t> nanoseconds;
+    };
+
+    uint64_t _trialBound; /** The largest prime tried by the trial division stage. */
+    uint64_t _pm1Bound; /** The stage 1 bound of Pollard's p - 1. */
+    bool _enabled[STAGE_COUNT]; /** Which stages run. */
+    Counters _counters[STAGE_COUNT]; /** The counters of every stage. */
+
+    /**
+     * Factors a cofactor which has no prime factor below the trial bound.
+     * @param m odd number.
+     * @param factorization the factorization to add the primes to.
+     * @param rho the splitter of the Rho stage.
+     */
+    void _factorCofactor(uint64_t m , PrimeFactorization &factorization , const Splitter &rho);
+
+    /**
+     * Runs the splitting stages on an odd composite until one of them succeeds.
+     * @param m odd composite number.
+     * @param rho the splitter of the Rho stage.
+     * @return a non trivial factor, or NO_FACTOR if every stage failed.
+     */
+    uint64_t _split(uint64_t m , const Splitter &rho);
+
+    /**
+     * Factors a cofactor of up to 128 bits which has no prime factor below the trial bound.
+     * @param m odd number.
+     * @param factorization the factorization to add the primes to.
+     * @param rho the splitter of the Rho stage.
+     * @param pool the pool the quadratic sieve runs on (may be null).
+     */
+    void _factorWideCofactor(UInt128 m , WideFactorization &factorization , const Splitter &rho ,
+                             ThreadPool *pool);
+
+    /**
+     * Adds the time since start to the counters of a stage.
+     * @param stage the stage.
+     * @param start the steady clock time the stage started (nanoseconds).
+     * @param success whether the stage succeeded.
+     */
+    void _count(FactorizationStage stage , uint64_t start , bool success);
+
+public:
+    /**
+     * A constructor, every stage but SQUFOF is enabled with the default bounds.
+     */
+    FactorizationPipeline();
+
+    FactorizationPipeline(const FactorizationPipeline &) = delete;
+
+    FactorizationPipeline &operator=(const FactorizationPipeline &) = delete;
+
+    /**
+     * Factors a number into primes and adds them to the factorization (not sorted).
+     * @param n the number, 0 and 1 have no factors.
+     * @param factorization the factorization to add the primes to.
+     * @param rho the splitter of the Rho stage.
+     */
+    void factor(long n , PrimeFactorization &factorization , const Splitter &rho);
+
+    /**
+     * Factors a number of up to 128 bits into primes and adds them to the factorization
+     * (not sorted). The primes above 2^81 are Baillie-PSW probable primes, see
+     * isProbablePrime().
+     * @param n the number, 0 and 1 have no factors.
+     * @param factorization the factorization to add the primes to.
+     * @param rho the splitter of the Rho stage.
+     * @param pool the pool the quadratic sieve runs on (may be null), the caller sieves too
+     * and never waits on it.
+     */
+    void factorWide(UInt128 n , WideFactorization &factorization , const Splitter &rho ,
+                    ThreadPool *pool = nullptr);
+
+    /**
+     * Getter for the bound of the trial division stage.
+     * @return the largest prime tried.
+     */
+    uint64_t getTrialBound() const
+    { return _trialBound; }
+
+    /**
+     * Setter for the bound of the trial division stage.
+     * @param bound the largest prime tried.
+     */
+    void setTrialBound(uint64_t bound)
+    { _trialBound = bound; }
+
+    /**
+     * Getter for the stage 1 bound of Pollard's p - 1.
+     * @return the bound.
+     */
+    uint64_t getPm1Bound() const
+    { return _pm1Bound; }
+
+    /**
+     * Setter for the stage 1 bound of Pollard's p - 1.
+     * @param bound the bound.
+     */
+    void setPm1Bound(uint64_t bound)
+    { _pm1Bound = bound; }
+
+    /**
+     * Enables or disables a stage. With both wide stages disabled, a wide composite is still
+     * split by the elliptic curve method, without counting it.
+     * @param stage the stage.
+     * @param enabled whether it runs.
+     */
+    void setStageEnabled(FactorizationStage stage , bool enabled)
+    { _enabled[stage] = enabled; }
+
+    /**
+     * @param stage the stage.
+     * @return whether the stage runs.
+     */
+    bool isStageEnabled(FactorizationStage stage) const
+    { return _enabled[stage]; }
+
+    /**
+     * Getter for the counters of a stage.
+     * @param stage the stage.
+     * @return a snapshot of the counters.
+     */
+    StageStatistics getStatistics(FactorizationStage stage) const;
+
+    /**
+     * Zeroes the counters of every stage.
+     */
+    void resetStatistics();
+
+    /**
+     * @param stage a stage.
+     * @return the name of the stage.
+     */
+    static const char *stageName(FactorizationStage stage);
+
+    /**
+     * The pipeline used by GFNumber::getPrimeFactors().
+     * @return the shared pipeline.
+     */
+    static FactorizationPipeline &global();
+
+    /**
+     * Divides out every prime up to bound (and below the square root of the cofactor).
+     * @param m the number to divide.
+     * @param bound the largest prime tried, UINT64_MAX for a complete factorization.
+     * @param factorization the factorization to add the primes to.
+     * @return the cofactor, which is prime or 1 when every prime up to its root was tried.
+     */
+    static uint64_t trialDivision(uint64_t m , uint64_t bound , PrimeFactorization &factorization);
+
+    /**
+     * Pollard's p - 1, stage 1: computes gcd(2^E - 1, n) where E is the product of the
+     * largest powers of the primes up to bound, which splits n when p - 1 is bound smooth
+     * for one of its prime factors p.
+     * @param n odd composite number.
+     * @param bound the stage 1 bound.
+     * @return a non trivial factor, or NO_FACTOR.
+     */
+    static uint64_t pollardPm1(uint64_t n , uint64_t bound);
+
+    /**
+     * Shanks' square forms factorization, tried with the multipliers of 3 * 5 * 7 * 11.
+     * @param n odd composite number below 2^SQUFOF_BITS.
+     * @return a non trivial factor, or NO_FACTOR.
+     */
+    static uint64_t squfof(uint64_t n);
+
+    /**
+     * Splits an odd composite of up to 128 bits with elliptic curves, through ECM_LEVELS
+     * bounds with the usual number of curves for factors of 15, 20 and 25 digits, then as
+     * many curves as it takes at the last bound (for 30 digits).
+     * @param n odd composite number, not a prime power of a prime below the trial bound.
+     * @return a non trivial factor.
+     */
+    static UInt128 ellipticCurveMethod(UInt128 n);
+
+    /**
+     * Miller-Rabin to the bases of the first 16 primes, which is deterministic below 2^81, and
+     * above 2^81 also the strong Lucas test, which together are the Baillie-PSW test (no
+     * composite is known to pass it). n below 2^63 goes through GField::isPrime.
+     * @param n a number.
+     * @return true if n is a (probable) prime.
+     */
+    static bool isProbablePrime(UInt128 n);
+
+    /**
+     * The strong Lucas probable prime test with Selfridge's parameters: the first D of 5, -7,
+     * 9, -11, ... with (D / n) = -1, P = 1 and Q = (1 - D) / 4. With n + 1 = d * 2^s, d odd,
+     * a prime n has U_d = 0 or V_(d * 2^r) = 0 mod n for some r < s.
+     * @param n a number.
+     * @return true if n is a strong Lucas probable prime (primes always are).
+     */
+    static bool isStrongLucasProbablePrime(UInt128 n);
+};
+
+/**
+ * Operator overloading of "<<", prints the counters of every stage, one line per stage.
+ * @param out ostream reference.
+ * @param pipeline the pipeline.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const FactorizationPipeline &pipeline);
+
+#endif //FACTORIZATIONPIPELINE_H
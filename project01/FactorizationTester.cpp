@@ -0,0 +1,627 @@
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include "gtest/gtest.h"
+#include "FactorizationCache.h"
+#include "FactorizationPipeline.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "ModReducer.h"
+#include "PrimeFactorization.h"
+#include "PrimeSieve.h"
+#include "QuadraticSieve.h"
+#include "RandomSource.h"
+#include "ThreadPool.h"
+
+/**
+ * Reference primality test by plain trial division.
+ */
+static bool isPrimeByTrialDivision(long n)
+{
+    if (n < 2)
+    {
+        return false;
+    }
+    for (long i = 2; i * i <= n; i++)
+    {
+        if (n % i == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(PrimalityTest , MatchesTrialDivision)
+{
+    for (long n = -10; n < 200000; n++)
+    {
+        ASSERT_EQ(GField::isPrime(n) , isPrimeByTrialDivision(std::labs(n))) << n;
+    }
+}
+
+TEST(PrimalityTest , HardCases)
+{
+    // Carmichael numbers and strong pseudoprimes to several small bases
+    EXPECT_FALSE(GField::isPrime(561));
+    EXPECT_FALSE(GField::isPrime(3215031751));
+    EXPECT_FALSE(GField::isPrime(3825123056546413051));
+    EXPECT_FALSE(GField::isPrime(341550071728321L));
+    EXPECT_FALSE(GField::isPrime(4611686014132420609L)); // (2^31 - 1)^2
+    EXPECT_FALSE(GField::isPrime(INT64_MIN));
+
+    EXPECT_TRUE(GField::isPrime(2147482801));
+    EXPECT_TRUE(GField::isPrime(2305843009213693951L)); // 2^61 - 1
+    EXPECT_TRUE(GField::isPrime(9223372036854775783L)); // largest prime below 2^63
+    EXPECT_TRUE(GField::isPrime(-9223372036854775783L));
+    EXPECT_TRUE(GField::isPrime(29498690791));
+}
+
+TEST(PrimalityTest , BatchMatchesSingle)
+{
+    std::mt19937_64 generator(67320);
+    const size_t count = 4096;
+    long numbers[count];
+    bool results[count];
+    for (size_t i = 0; i < count; i++)
+    {
+        numbers[i] = (long) (generator() >> 1) | 1;
+    }
+    GField::isPrime(numbers , count , results);
+    for (size_t i = 0; i < count; i++)
+    {
+        ASSERT_EQ(results[i] , GField::isPrime(numbers[i])) << numbers[i];
+    }
+}
+
+/**
+ * Reference gcd by Euclid's algorithm.
+ */
+static uint64_t euclidGcd(uint64_t a , uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+TEST(GcdTest , BinaryGcdMatchesEuclid)
+{
+    EXPECT_EQ(GField::binaryGcd(0 , 0) , 0u);
+    EXPECT_EQ(GField::binaryGcd(0 , 12) , 12u);
+    EXPECT_EQ(GField::binaryGcd(1000000000000 , 1) , 1u);
+    EXPECT_EQ(GField::binaryGcd(UINT64_MAX , UINT64_MAX - 1) , 1u);
+    std::mt19937_64 generator(67320);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t common = generator() >> (generator() % 64);
+        uint64_t a = (generator() >> (generator() % 64)) * (common | 1);
+        uint64_t b = (generator() >> (generator() % 64)) * (common | 1);
+        ASSERT_EQ(GField::binaryGcd(a , b) , euclidGcd(a , b)) << a << " " << b;
+    }
+}
+
+TEST(GcdTest , ExtendedGcdAndInverse)
+{
+    std::mt19937_64 generator(67320);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t a = (generator() >> (generator() % 64)) | 1;
+        uint64_t b = (generator() >> (generator() % 64)) + 1;
+        __int128 x , y;
+        uint64_t g = GField::extendedBinaryGcd(a , b , &x , &y);
+        ASSERT_EQ(g , euclidGcd(a , b));
+        ASSERT_TRUE((__int128) a * x + (__int128) b * y == (__int128) g) << a << " " << b;
+    }
+    for (uint64_t m : {2ul , 121ul , 1024ul , 1000003ul , 4611686014132420609ul})
+    {
+        for (uint64_t a = 1; a < 2000; a++)
+        {
+            uint64_t inverse = GField::modInverse(a , m);
+            if (euclidGcd(a % m , m) != 1)
+            {
+                ASSERT_EQ(inverse , 0u);
+            }
+            else
+            {
+                ASSERT_EQ((uint64_t) ((unsigned __int128) a * inverse % m) , 1 % m) << a << " " << m;
+            }
+        }
+    }
+}
+
+TEST(GcdTest , GFieldGcd)
+{
+    GField field(2 , 42);
+    EXPECT_EQ(field.gcd(field.createNumber(1000000000000) , field.createNumber(1)).getNumber() , 1);
+    EXPECT_EQ(field.gcd(field.createNumber(0) , field.createNumber(77)).getNumber() , 77);
+    EXPECT_EQ(field.gcd(field.createNumber(84) , field.createNumber(36)).getNumber() , 12);
+}
+
+/**
+ * Factorizes n inside a big field and checks that the factors are primes whose product is n.
+ */
+static void expectValidFactorization(long n)
+{
+    GFNumber number(n , GField(2 , 62));
+    int count = 0;
+    GFNumber *factors = number.getPrimeFactors(&count);
+    if (count == 0)
+    {
+        EXPECT_TRUE(n <= 1 || GField::isPrime(n)) << n;
+    }
+    long product = 1;
+    for (int i = 0; i < count; i++)
+    {
+        EXPECT_TRUE(GField::isPrime(factors[i].getNumber())) << n << ": " << factors[i];
+        product *= factors[i].getNumber();
+    }
+    if (count > 0)
+    {
+        EXPECT_EQ(product , n);
+    }
+    delete[] factors;
+}
+
+TEST(FactorizationTest , SmallNumbers)
+{
+    for (long n = 0; n < 5000; n++)
+    {
+        expectValidFactorization(n);
+    }
+}
+
+TEST(FactorizationTest , PrimePowersAndSemiprimes)
+{
+    expectValidFactorization(3L * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3 * 3);
+    expectValidFactorization(1000003L * 1000003L);
+    expectValidFactorization(2147483647L * 2147483629L); // two 31 bit primes
+    expectValidFactorization(4611686014132420609L); // (2^31 - 1)^2
+    expectValidFactorization(2979367769891L);
+    expectValidFactorization(999999999989L * 4099L);
+}
+
+TEST(FactorizationTest , RandomNumbers)
+{
+    std::mt19937_64 generator(67320);
+    for (int i = 0; i < 300; i++)
+    {
+        expectValidFactorization((long) (generator() >> 2));
+    }
+}
+
+/**
+ * A plugged in generator for the RandomSource test.
+ */
+static uint64_t constantRandom()
+{
+    return 1ull << 63;
+}
+
+TEST(RandomSourceTest , SeedReplaysSequence)
+{
+    RandomSource::setSeed(67320);
+    uint64_t first[16];
+    for (uint64_t &value : first)
+    {
+        value = RandomSource::next();
+    }
+    RandomSource::setSeed(67320);
+    for (uint64_t value : first)
+    {
+        ASSERT_EQ(RandomSource::next() , value);
+    }
+    EXPECT_EQ(RandomSource::getSeed() , 67320u);
+    for (int i = 0; i < 10000; i++)
+    {
+        uint64_t value = RandomSource::nextInRange(5 , 9);
+        ASSERT_TRUE(value >= 5 && value <= 9);
+    }
+}
+
+TEST(RandomSourceTest , PluggableFunction)
+{
+    RandomSource::setRandomFunction(constantRandom);
+    EXPECT_EQ(RandomSource::next() , 1ull << 63);
+    EXPECT_EQ(RandomSource::nextInRange(0 , 9) , 5u);
+    RandomSource::setRandomFunction(nullptr);
+    EXPECT_NE(RandomSource::next() , RandomSource::next());
+}
+
+TEST(FactorizationTest , ValueResult)
+{
+    // 2^3 * 3^2 * 5 * 101
+    PrimeFactorization factorization = GFNumber(36360 , GField(2 , 42)).getPrimeFactors();
+    ASSERT_EQ(factorization.size() , 4u);
+    EXPECT_EQ(factorization.countWithMultiplicity() , 7);
+    long primes[] = {2 , 3 , 5 , 101};
+    int exponents[] = {3 , 2 , 1 , 1};
+    for (size_t i = 0; i < factorization.size(); i++)
+    {
+        EXPECT_EQ(factorization[i].prime , primes[i]);
+        EXPECT_EQ(factorization[i].exponent , exponents[i]);
+    }
+    std::ostringstream out;
+    out << factorization;
+    EXPECT_EQ(out.str() , "2*2*2*3*3*5*101");
+
+    EXPECT_TRUE(GFNumber(17 , GField(2 , 42)).getPrimeFactors().empty());
+    EXPECT_TRUE(GFNumber(1 , GField(2 , 42)).getPrimeFactors().empty());
+}
+
+TEST(FactorizationTest , PrintFactors)
+{
+    std::ostringstream out;
+    std::streambuf *original = std::cout.rdbuf(out.rdbuf());
+    GFNumber(36360 , GField(2 , 42)).printFactors();
+    GFNumber(17 , GField(2 , 42)).printFactors();
+    std::cout.rdbuf(original);
+    EXPECT_EQ(out.str() , "36360=2*2*2*3*3*5*101\n17=17*1\n");
+}
+
+TEST(SmallVectorTest , SpillsToHeap)
+{
+    SmallVector<long , 4> vector;
+    for (long i = 0; i < 4; i++)
+    {
+        vector.push_back(i);
+    }
+    EXPECT_TRUE(vector.isInline());
+    vector.push_back(4);
+    EXPECT_FALSE(vector.isInline());
+    SmallVector<long , 4> copy(vector);
+    SmallVector<long , 4> moved(std::move(vector));
+    ASSERT_EQ(copy.size() , 5u);
+    ASSERT_EQ(moved.size() , 5u);
+    for (long i = 0; i < 5; i++)
+    {
+        EXPECT_EQ(copy[i] , i);
+        EXPECT_EQ(moved[i] , i);
+    }
+}
+
+TEST(PrimeSieveTest , StreamMatchesIsPrime)
+{
+    PrimeSieve sieve;
+    uint64_t prime = sieve.next();
+    for (long n = 0; n < 1000000; n++)
+    {
+        if (GField::isPrime(n))
+        {
+            ASSERT_EQ(prime , (uint64_t) n);
+            prime = sieve.next();
+        }
+    }
+    // segments above 2^32 sieve with primes beyond the shared table
+    uint64_t starts[] = {1 , 4294967296 - 1000 , 1000000000000 , 1000000000000000};
+    for (uint64_t start : starts)
+    {
+        PrimeSieve large(start);
+        prime = large.next();
+        for (uint64_t n = start; n < start + 3 * SIEVE_SEGMENT_SIZE; n++)
+        {
+            if (GField::isPrime((long) n))
+            {
+                ASSERT_EQ(prime , n) << start;
+                prime = large.next();
+            }
+        }
+    }
+}
+
+TEST(PrimeSieveTest , TrialTableReciprocals)
+{
+    const std::vector<TrialPrime> &table = PrimeSieve::trialPrimes();
+    EXPECT_EQ(table.front().prime , 11u);
+    EXPECT_EQ(table.back().prime , 65521u);
+    std::mt19937_64 generator(67320);
+    for (const TrialPrime &trial : table)
+    {
+        uint64_t multiple = (generator() >> 1) / trial.prime * trial.prime;
+        uint64_t other = multiple + 1 + generator() % (trial.prime - 1);
+        ASSERT_LE(multiple * trial.inverse , trial.limit) << trial.prime;
+        ASSERT_EQ(multiple * trial.inverse , multiple / trial.prime);
+        ASSERT_GT(other * trial.inverse , trial.limit) << trial.prime;
+    }
+}
+
+/**
+ * A random prime of the given size.
+ * @param generator the generator.
+ * @param bits the size of the prime.
+ * @return the prime.
+ */
+static uint64_t randomPrime(std::mt19937_64 &generator , int bits)
+{
+    while (true)
+    {
+        uint64_t p = (generator() >> (64 - bits)) | (1ull << (bits - 1)) | 1;
+        if (GField::isPrime((long) p))
+        {
+            return p;
+        }
+    }
+}
+
+TEST(FactorizationPipelineTest , SqufofSplitsSemiprimes)
+{
+    std::mt19937_64 generator(67320);
+    int split = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        int bits = 10 + i % 21; // semiprimes of 20 to 60 bits
+        uint64_t p = randomPrime(generator , bits) , q = randomPrime(generator , bits + i % 2);
+        uint64_t factor = FactorizationPipeline::squfof(p * q);
+        if (factor != NO_FACTOR)
+        {
+            ASSERT_TRUE(factor == p || factor == q) << p << "*" << q;
+            split++;
+        }
+    }
+    EXPECT_GE(split , 190); // every multiplier fails only very rarely
+    EXPECT_EQ(FactorizationPipeline::squfof(1000003ull * 1000003) , 1000003u);
+}
+
+TEST(FactorizationPipelineTest , PollardPm1FindsSmoothFactors)
+{
+    // 1000003 - 1 = 2 * 3 * 166667 and 4000037 - 1 = 2^2 * 293 * 3413 are not 2000 smooth,
+    // smooth - 1 = 2^3 * 3 * 1993 * 1997 * 1999 is
+    uint64_t smooth = 190945487497;
+    ASSERT_TRUE(GField::isPrime((long) smooth));
+    EXPECT_EQ(FactorizationPipeline::pollardPm1(smooth * 1000003 , 2000) , smooth);
+    EXPECT_EQ(FactorizationPipeline::pollardPm1(smooth * 1000003 , 1990) , (uint64_t) NO_FACTOR);
+    EXPECT_EQ(FactorizationPipeline::pollardPm1(1000003ull * 4000037 , 2000) ,
+              (uint64_t) NO_FACTOR);
+    EXPECT_EQ(FactorizationPipeline::pollardPm1(1000003ull * 4000037 , 3413) , 4000037u);
+    // 11959 - 1 = 2 * 3 * 1993, both factors appear in the last gcd interval
+    EXPECT_EQ(FactorizationPipeline::pollardPm1(smooth * 11959 , 2000) , 11959u);
+}
+
+TEST(FactorizationPipelineTest , TrialDivisionBound)
+{
+    PrimeFactorization factorization;
+    EXPECT_EQ(FactorizationPipeline::trialDivision(8L * 9 * 1031 * 1000003 , 1024 ,
+                                                   factorization) , 1031u * 1000003);
+    std::ostringstream out;
+    out << factorization;
+    EXPECT_EQ(out.str() , "2*2*2*3*3");
+    EXPECT_EQ(FactorizationPipeline::trialDivision(1031L * 1000003 , UINT64_MAX ,
+                                                   factorization) , 1000003u);
+}
+
+TEST(FactorizationPipelineTest , StageConfigurationsMatch)
+{
+    std::mt19937_64 generator(67320);
+    std::vector<long> numbers;
+    for (int i = 0; i < 100; i++)
+    {
+        numbers.push_back((long) (generator() >> 2) | 1);
+        numbers.push_back((long) (randomPrime(generator , 30) * randomPrime(generator , 31)));
+    }
+    std::vector<std::string> expected;
+    uint64_t composites = 0;
+    for (long n : numbers)
+    {
+        std::ostringstream out;
+        GFNumber(n , GField(2 , 62)).printFactors(out);
+        expected.push_back(out.str());
+        composites += !GField::isPrime(n);
+    }
+    // every configuration ends with Rho, a number which every stage fails to split falls
+    // back to the (very slow) complete trial division
+    FactorizationPipeline &pipeline = FactorizationPipeline::global();
+    const FactorizationStage stages[] = {PM1_STAGE , SQUFOF_STAGE , RHO_STAGE};
+    const bool configurations[][3] = {{false , true , true} , {false , false , true} ,
+                                      {true , false , true} , {true , true , true}};
+    for (const bool *enabled : configurations)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            pipeline.setStageEnabled(stages[i] , enabled[i]);
+        }
+        pipeline.resetStatistics();
+        FactorizationCache::global().clear(); // every configuration factors every number
+        for (size_t i = 0; i < numbers.size(); i++)
+        {
+            std::ostringstream out;
+            GFNumber(numbers[i] , GField(2 , 62)).printFactors(out);
+            EXPECT_EQ(out.str() , expected[i]);
+        }
+        EXPECT_EQ(pipeline.getStatistics(TRIAL_STAGE).attempts , composites);
+        for (int i = 0; i < 3; i++)
+        {
+            StageStatistics statistics = pipeline.getStatistics(stages[i]);
+            EXPECT_EQ(statistics.attempts > 0 , enabled[i]);
+            EXPECT_LE(statistics.successes , statistics.attempts);
+        }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        pipeline.setStageEnabled(stages[i] , stages[i] != SQUFOF_STAGE);
+    }
+    pipeline.resetStatistics();
+}
+
+TEST(WideFactorizationTest , Montgomery128MatchesRemainder)
+{
+    std::mt19937_64 generator(67320);
+    for (int i = 0; i < 10000; i++)
+    {
+        // products of 64 bit numbers fit in 128 bits, so % is an exact reference
+        UInt128 n = ((((UInt128) generator() << 64) | generator()) >> (i % 127)) | 1;
+        if (n == 1)
+        {
+            continue;
+        }
+        Montgomery128 reducer(n);
+        UInt128 a = generator() % n , b = generator() % n;
+        UInt128 product = reducer.mul(reducer.toMontgomery(a) , reducer.toMontgomery(b));
+        ASSERT_EQ(toString(reducer.fromMontgomery(product)) , toString(a * b % n));
+    }
+    UInt128 n = ~(UInt128) 0 - 158; // 2^128 - 159 is prime
+    Montgomery128 reducer(n);
+    EXPECT_TRUE(reducer.fromMontgomery(reducer.pow(reducer.toMontgomery(3) , n - 1)) == 1);
+}
+
+TEST(WideFactorizationTest , ParseAndPrint)
+{
+    UInt128 n;
+    ASSERT_TRUE(parseUInt128("340282366920938463463374607431768211455" , n));
+    EXPECT_TRUE(n == ~(UInt128) 0);
+    EXPECT_EQ(toString(n) , "340282366920938463463374607431768211455");
+    EXPECT_FALSE(parseUInt128("340282366920938463463374607431768211456" , n));
+    EXPECT_FALSE(parseUInt128("12a" , n));
+    EXPECT_FALSE(parseUInt128("" , n));
+    EXPECT_EQ(toString(0) , "0");
+}
+
+TEST(WideFactorizationTest , ProbablePrimes)
+{
+    const UInt128 one = 1;
+    EXPECT_TRUE(FactorizationPipeline::isProbablePrime((one << 127) - 1));
+    EXPECT_TRUE(FactorizationPipeline::isProbablePrime((one << 89) - 1));
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime((one << 67) - 1));
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime(((one << 61) - 1) * ((one << 61) - 1)));
+    // a strong pseudoprime to the bases 2 to 23, below 2^63
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime(3825123056546413051ull));
+    EXPECT_TRUE(FactorizationPipeline::isProbablePrime(2147483647));
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime(1));
+    // above 2^81 the Lucas half of BPSW runs too: primes, a prime square, and a product
+    EXPECT_TRUE(FactorizationPipeline::isProbablePrime((one << 107) - 1));
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime(((one << 61) - 1) * ((one << 31) - 1)));
+    EXPECT_FALSE(FactorizationPipeline::isProbablePrime(((one << 89) - 1) * 170141183));
+}
+
+TEST(WideFactorizationTest , StrongLucasProbablePrimes)
+{
+    // the first strong Lucas pseudoprimes (Selfridge's parameters), which Miller-Rabin rejects
+    for (uint64_t n : {5459 , 5777 , 10877 , 16109 , 18971 , 22499 , 24569 , 25199 , 40309})
+    {
+        EXPECT_TRUE(FactorizationPipeline::isStrongLucasProbablePrime(n)) << n;
+        EXPECT_FALSE(FactorizationPipeline::isProbablePrime(n)) << n;
+    }
+    // every other odd number below 50000 passes exactly when it is prime
+    const uint64_t pseudoprimes[] = {5459 , 5777 , 10877 , 16109 , 18971 , 22499 , 24569 ,
+                                     25199 , 40309};
+    for (uint64_t n = 3; n < 50000; n += 2)
+    {
+        if (std::find(std::begin(pseudoprimes) , std::end(pseudoprimes) , n) ==
+            std::end(pseudoprimes))
+        {
+            ASSERT_EQ(FactorizationPipeline::isStrongLucasProbablePrime(n) ,
+                      GField::isPrime((long) n)) << n;
+        }
+    }
+    const UInt128 one = 1;
+    EXPECT_TRUE(FactorizationPipeline::isStrongLucasProbablePrime((one << 127) - 1));
+    EXPECT_FALSE(FactorizationPipeline::isStrongLucasProbablePrime(((one << 63) - 25) *
+                                                                   ((one << 61) - 1)));
+    EXPECT_FALSE(FactorizationPipeline::isStrongLucasProbablePrime(49));
+    EXPECT_TRUE(FactorizationPipeline::isStrongLucasProbablePrime(2));
+}
+
+TEST(WideFactorizationTest , FactorsSemiprimes)
+{
+    std::mt19937_64 generator(67320);
+    for (int bits = 40; bits <= 48; bits += 4)
+    {
+        UInt128 p = randomPrime(generator , bits) , q = randomPrime(generator , bits + 1);
+        WideFactorization factorization = GFNumber::factorWide(p * q);
+        ASSERT_EQ(factorization.size() , 2u) << toString(p * q);
+        EXPECT_TRUE(factorization[0].prime == p) << toString(p * q);
+        EXPECT_TRUE(factorization[1].prime == q) << toString(p * q);
+    }
+    // 2^67 - 1 = 193707721 * 761838257287
+    WideFactorization mersenne = GFNumber::factorWide(((UInt128) 1 << 67) - 1);
+    std::ostringstream out;
+    out << mersenne;
+    EXPECT_EQ(out.str() , "193707721*761838257287");
+    // small primes, a prime power and a 64 bit cofactor
+    UInt128 n = (UInt128) 8 * 1000003 * 1000003 * 9223372036854775783ull;
+    out.str("");
+    out << GFNumber::factorWide(n);
+    EXPECT_EQ(out.str() , "2*2*2*1000003*1000003*9223372036854775783");
+    out.str("");
+    out << GFNumber::factorWide(1);
+    EXPECT_EQ(out.str() , "1");
+}
+
+TEST(QuadraticSieveTest , ModularSquareRoots)
+{
+    std::mt19937_64 generator(67320);
+    // 998244353 - 1 = 2^23 * 7 * 17 runs the whole Tonelli-Shanks loop
+    const uint64_t primes[] = {3 , 5 , 7 , 17 , 41 , 1009 , 65537 , 998244353 , 2147483647};
+    for (uint64_t p : primes)
+    {
+        int residues = 0;
+        for (int i = 0; i < 200; i++)
+        {
+            uint64_t a = generator() % p , root = GField::modSqrt(a , p);
+            if (root != 0)
+            {
+                ASSERT_EQ(root * root % p , a) << a << " mod " << p;
+                residues++;
+            }
+            else if (a != 0)
+            {
+                // Euler's criterion says a is not a square
+                EXPECT_EQ(ModReducer(p).powMod(a , (p - 1) / 2) , p - 1);
+            }
+        }
+        EXPECT_GT(residues , 0);
+    }
+}
+
+TEST(QuadraticSieveTest , FactorsBalancedSemiprimes)
+{
+    std::mt19937_64 generator(67320);
+    ThreadPool pool(2);
+    for (int bits = 36; bits <= 48; bits += 6)
+    {
+        UInt128 p = randomPrime(generator , bits) , q = randomPrime(generator , bits);
+        QuadraticSieve sieve(p * q);
+        UInt128 factor = sieve.factor((bits == 42) ? &pool : nullptr);
+        EXPECT_TRUE(factor == p || factor == q) << toString(p * q);
+        const SiqsStatistics &statistics = sieve.getStatistics();
+        EXPECT_GE(statistics.fullRelations + statistics.combinedRelations ,
+                  sieve.getFactorBaseSize());
+        EXPECT_LE(statistics.combinedRelations , statistics.partialRelations);
+    }
+    // a square has no relation to split it
+    UInt128 p = randomPrime(generator , 50);
+    EXPECT_TRUE(QuadraticSieve(p * p).factor() == p);
+}
+
+TEST(QuadraticSieveTest , PipelineFallsBackToEcm)
+{
+    std::mt19937_64 generator(67320);
+    UInt128 p = randomPrime(generator , 40) , q = randomPrime(generator , 44);
+    FactorizationPipeline &pipeline = FactorizationPipeline::global();
+    pipeline.resetStatistics();
+    std::ostringstream sieved , curves;
+    sieved << GFNumber::factorWide(p * q);
+    EXPECT_EQ(pipeline.getStatistics(SIQS_STAGE).successes , 1u);
+    EXPECT_EQ(pipeline.getStatistics(ECM_STAGE).attempts , 0u);
+    pipeline.setStageEnabled(SIQS_STAGE , false);
+    curves << GFNumber::factorWide(p * q);
+    pipeline.setStageEnabled(SIQS_STAGE , true);
+    EXPECT_EQ(pipeline.getStatistics(ECM_STAGE).successes , 1u);
+    EXPECT_EQ(sieved.str() , curves.str());
+    EXPECT_EQ(sieved.str() , toString(p) + "*" + toString(q));
+    // with every wide stage disabled the curves still run, uncounted
+    pipeline.resetStatistics();
+    pipeline.setStageEnabled(SIQS_STAGE , false);
+    pipeline.setStageEnabled(ECM_STAGE , false);
+    std::ostringstream fallback;
+    fallback << GFNumber::factorWide(p * q);
+    pipeline.setStageEnabled(SIQS_STAGE , true);
+    pipeline.setStageEnabled(ECM_STAGE , true);
+    EXPECT_EQ(fallback.str() , sieved.str());
+    EXPECT_EQ(pipeline.getStatistics(ECM_STAGE).attempts , 0u);
+    pipeline.resetStatistics();
+}
@@ -0,0 +1,652 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFExpr.hpp"
+#include "GFNumberT.hpp"
+#include "GFieldRegistry.h"
+#include "GFVector.h"
+
+#define RANDOM_PAIRS 20000
+
+/**
+ * A minimal arbitrary precision unsigned number (little endian base 2^32 limbs).
+ * It is the reference the field arithmetic is checked against, so it deliberately uses
+ * nothing but 32 bit limbs and bit-by-bit long division.
+ */
+class RefBigNum
+{
+private:
+    std::vector<uint32_t> _limbs;
+public:
+    explicit RefBigNum(uint64_t value) : _limbs{(uint32_t) value , (uint32_t) (value >> 32)}
+    {}
+
+    RefBigNum operator+(const RefBigNum &other) const
+    {
+        RefBigNum result(0);
+        size_t size = std::max(_limbs.size() , other._limbs.size()) + 1;
+        result._limbs.assign(size , 0);
+        uint64_t carry = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            uint64_t sum = carry;
+            sum += (i < _limbs.size()) ? _limbs[i] : 0;
+            sum += (i < other._limbs.size()) ? other._limbs[i] : 0;
+            result._limbs[i] = (uint32_t) sum;
+            carry = sum >> 32;
+        }
+        return result;
+    }
+
+    RefBigNum operator*(const RefBigNum &other) const
+    {
+        RefBigNum result(0);
+        result._limbs.assign(_limbs.size() + other._limbs.size() , 0);
+        for (size_t i = 0; i < _limbs.size(); i++)
+        {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < other._limbs.size(); j++)
+            {
+                uint64_t cur = (uint64_t) _limbs[i] * other._limbs[j] + result._limbs[i + j] + carry;
+                result._limbs[i + j] = (uint32_t) cur;
+                carry = cur >> 32;
+            }
+            result._limbs[i + other._limbs.size()] += (uint32_t) carry;
+        }
+        return result;
+    }
+
+    /**
+     * @param m modulus below 2^63.
+     * @return this mod m.
+     */
+    uint64_t mod(uint64_t m) const
+    {
+        uint64_t r = 0;
+        for (size_t i = _limbs.size(); i-- > 0;)
+        {
+            for (int bit = 31; bit >= 0; bit--)
+            {
+                r = (r << 1) | ((_limbs[i] >> bit) & 1);
+                if (r >= m)
+                {
+                    r -= m;
+                }
+            }
+        }
+        return r;
+    }
+};
+
+/**
+ * Checks +, - and * of a and b in the given field against the reference implementation.
+ */
+static void expectMatchesReference(const GField &field , long a , long b)
+{
+    uint64_t order = (uint64_t) field.getOrder();
+    GFNumber x(a , field) , y(b , field);
+    RefBigNum refA((uint64_t) a) , refB((uint64_t) b);
+
+    ASSERT_EQ((uint64_t) (x * y).getNumber() , (refA * refB).mod(order)) << a << "*" << b;
+    ASSERT_EQ((uint64_t) (x + y).getNumber() , (refA + refB).mod(order)) << a << "+" << b;
+    ASSERT_EQ((uint64_t) (x - y).getNumber() , (refA + RefBigNum(order - b)).mod(order))
+                                << a << "-" << b;
+    GFNumber z(x);
+    z *= y;
+    ASSERT_EQ(z.getNumber() , (x * y).getNumber());
+    z = x;
+    z *= b;
+    ASSERT_EQ(z.getNumber() , (x * y).getNumber());
+}
+
+TEST(GFArithmeticTest , ExhaustiveSmallFields)
+{
+    GField fields[] = {GField(2 , 1) , GField(2 , 5) , GField(3 , 3) , GField(5 , 2) ,
+                       GField(7 , 2) , GField(13) , GField(31)};
+    for (const GField &field : fields)
+    {
+        for (long a = 0; a < field.getOrder(); a++)
+        {
+            for (long b = 0; b < field.getOrder(); b++)
+            {
+                expectMatchesReference(field , a , b);
+            }
+        }
+    }
+}
+
+TEST(GFArithmeticTest , RandomizedLargeFields)
+{
+    // power of two, odd prime powers and the largest orders that still fit in a long
+    GField fields[] = {GField(2 , 62) , GField(3 , 39) , GField(5 , 27) , GField(1000003 , 3) ,
+                       GField(2147483647 , 2) , GField(65537 , 2)};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : fields)
+    {
+        std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+        expectMatchesReference(field , field.getOrder() - 1 , field.getOrder() - 1);
+        expectMatchesReference(field , 0 , field.getOrder() - 1);
+        for (int i = 0; i < RANDOM_PAIRS; i++)
+        {
+            expectMatchesReference(field , distribution(generator) , distribution(generator));
+        }
+    }
+}
+
+TEST(GFArithmeticTest , NegativeLongOperands)
+{
+    GField field(3 , 39);
+    long order = field.getOrder();
+    GFNumber x(order - 2 , field);
+    EXPECT_EQ((x * -1).getNumber() , 2);
+    EXPECT_EQ((x + (-order + 5)).getNumber() , 3);
+    EXPECT_EQ((x - order).getNumber() , order - 2);
+}
+
+TEST(GFieldRegistryTest , InternsFields)
+{
+    GField a(11 , 2) , b(11 , 2) , c(11 , 3);
+    EXPECT_EQ(a.getId() , b.getId());
+    EXPECT_NE(a.getId() , c.getId());
+    EXPECT_EQ(GField().getId() , GField(2 , 1).getId());
+    EXPECT_EQ(GFieldRegistry::get(c.getId()).getOrder() , 1331);
+    EXPECT_EQ(GFieldRegistry::get(GField().getId()).getOrder() , 2);
+
+    GField d;
+    std::istringstream in("13 2");
+    in >> d;
+    EXPECT_EQ(d.getId() , GField(13 , 2).getId());
+    EXPECT_LE(sizeof(GFNumber) , 2 * sizeof(long));
+}
+
+TEST(GFieldRegistryTest , CopiesArePlainBytes)
+{
+    static_assert(std::is_trivially_copyable<GFNumberT<3 , 39>>::value , "GFNumberT");
+    GField field(3 , 39);
+    std::vector<GFNumber> numbers;
+    for (long i = 0; i < 100; i++)
+    {
+        numbers.push_back(GFNumber(field.getOrder() - i , field));
+    }
+    std::vector<GFNumber> copies(numbers.size());
+    memcpy((void *) copies.data() , numbers.data() , numbers.size() * sizeof(GFNumber));
+    for (size_t i = 0; i < numbers.size(); i++)
+    {
+        EXPECT_EQ(copies[i].getNumber() , numbers[i].getNumber());
+        EXPECT_EQ(copies[i].getField() , field);
+    }
+    GField copy;
+    memcpy((void *) &copy , &field , sizeof(GField));
+    EXPECT_EQ(copy , field);
+    EXPECT_EQ(copy.getReducer().mulMod(2 , 3) , 6u);
+}
+
+TEST(GFElementTest , CompactArithmetic)
+{
+    GField field(11 , 2);
+    std::vector<GFElement> elements{field.element(9) , field.element(120) , field.element(-1)};
+    EXPECT_EQ(elements[2].getResidue() , 120u);
+    EXPECT_EQ(field.add(elements[0] , elements[1]).getResidue() , 8u);
+    EXPECT_EQ(field.sub(elements[0] , elements[1]).getResidue() , 10u);
+    EXPECT_EQ(field.mul(elements[0] , elements[1]).getResidue() , 112u);
+    EXPECT_EQ(field.neg(elements[0]).getResidue() , 112u);
+    EXPECT_EQ(field.neg(GFElement()).getResidue() , 0u);
+    EXPECT_EQ(GFNumber(130 , field).getElement() , elements[0]);
+    EXPECT_EQ((const void *) elements.data() , (const void *) &elements[0]);
+}
+
+/**
+ * Checks the operators of GFNumberT<P, L> against GFNumber on random operands.
+ */
+template<long P , long L>
+static void expectMatchesRuntime()
+{
+    typedef GFNumberT<P , L> Number;
+    const GField &field = Number::getField();
+    std::mt19937_64 generator(67320);
+    std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+    for (int i = 0; i < RANDOM_PAIRS; i++)
+    {
+        long a = distribution(generator) , b = distribution(generator);
+        GFNumber x(a , field) , y(b , field);
+        Number u(a) , v(b);
+        ASSERT_EQ((u * v).getNumber() , (x * y).getNumber()) << a << "*" << b;
+        ASSERT_EQ((u + v).getNumber() , (x + y).getNumber()) << a << "+" << b;
+        ASSERT_EQ((u - v).getNumber() , (x - y).getNumber()) << a << "-" << b;
+        ASSERT_EQ((u * -b).getNumber() , (x * -b).getNumber()) << a << "*-" << b;
+        ASSERT_EQ(GFNumber(u * v) , x * y);
+        ASSERT_EQ(Number(x * y) , u * v);
+    }
+}
+
+TEST(GFNumberTTest , MatchesRuntimeFields)
+{
+    expectMatchesRuntime<998244353 , 1>(); // small order
+    expectMatchesRuntime<2305843009213693951 , 1>(); // Mersenne 2^61 - 1
+    expectMatchesRuntime<2 , 62>(); // power of two
+    expectMatchesRuntime<3 , 39>(); // Montgomery
+}
+
+TEST(GFNumberTTest , CompileTimeArithmetic)
+{
+    static_assert(GFNumberT<7>::ORDER == 7 , "order");
+    static_assert(GFNumberT<3 , 4>::ORDER == 81 , "order");
+    static_assert((GFNumberT<7>(5) * GFNumberT<7>(3)).getNumber() == 1 , "mul");
+    static_assert((GFNumberT<7>(-1) + 2).getNumber() == 1 , "add");
+    static_assert(sizeof(GFNumberT<3 , 39>) == sizeof(uint64_t) , "no field handle");
+
+    GFNumberT<13 , 2> x(200);
+    x *= 2;
+    x -= 400;
+    EXPECT_EQ(x.getNumber() , 0);
+    x += 160;
+    x %= 100;
+    EXPECT_EQ(x.getNumber() , 60);
+    std::ostringstream out;
+    out << x;
+    EXPECT_EQ(out.str() , "60 GF(13**2)");
+    std::istringstream in("-5 13 2");
+    in >> x;
+    EXPECT_EQ(x.getNumber() , 164);
+}
+
+/**
+ * Plain right-to-left square-and-multiply, the reference of the windowed exponentiation.
+ */
+static long referencePow(const GFNumber &base , uint64_t exponent)
+{
+    GFNumber result(1 , base.getField()) , square(base);
+    for (; exponent > 0; exponent >>= 1)
+    {
+        if (exponent & 1)
+        {
+            result *= square;
+        }
+        square *= square;
+    }
+    return result.getNumber();
+}
+
+TEST(GFDivisionTest , PowMatchesReference)
+{
+    GField fields[] = {GField(2 , 62) , GField(3 , 39) , GField(1000003) , GField(13 , 2)};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : fields)
+    {
+        std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+        for (int i = 0; i < 2000; i++)
+        {
+            GFNumber x(distribution(generator) , field);
+            uint64_t exponent = generator() >> (i % 64);
+            ASSERT_EQ(x.pow((long) (exponent >> 1)).getNumber() , referencePow(x , exponent >> 1));
+        }
+        EXPECT_EQ(GFNumber(0 , field).pow(0).getNumber() , 1);
+    }
+    // Fermat and Euler: the order of the group of units divides the exponent
+    EXPECT_EQ(GFNumber(123456789 , GField(2305843009213693951)).pow(2305843009213693950).getNumber() , 1);
+    EXPECT_EQ(GFNumber(2 , GField(3 , 39)).pow(2 * 1350851717672992089).getNumber() , 1);
+    EXPECT_EQ(GFNumber(5 , GField(7)).pow(-1).getNumber() , 3);
+    EXPECT_EQ(GFNumber(5 , GField(7)).pow(-2).getNumber() , 2);
+}
+
+TEST(GFDivisionTest , InverseAndDivision)
+{
+    GField fields[] = {GField(2 , 62) , GField(3 , 39) , GField(1000003) , GField(7 , 2)};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : fields)
+    {
+        std::uniform_int_distribution<long> distribution(1 , field.getOrder() - 1);
+        for (int i = 0; i < 2000; i++)
+        {
+            GFNumber x(distribution(generator) , field) , y(distribution(generator) , field);
+            if (GField::binaryGcd((uint64_t) y.getNumber() , (uint64_t) field.getOrder()) != 1)
+            {
+                continue;
+            }
+            ASSERT_EQ((y * y.inverse()).getNumber() , 1) << y;
+            ASSERT_EQ(((x / y) * y).getNumber() , x.getNumber()) << x << " / " << y;
+            GFNumber z(x);
+            z /= y.getNumber();
+            ASSERT_EQ(z.getNumber() , (x / y).getNumber());
+        }
+    }
+}
+
+TEST(GFDivisionTest , BatchInverseMatchesSingle)
+{
+    GField field(1000003);
+    std::vector<GFNumber> numbers , results(1000);
+    for (long i = 1; i <= 1000; i++)
+    {
+        numbers.push_back(GFNumber(i * i + 7 , field));
+    }
+    GFNumber::batchInverse(numbers.data() , numbers.size() , results.data());
+    for (size_t i = 0; i < numbers.size(); i++)
+    {
+        ASSERT_EQ(results[i].getNumber() , numbers[i].inverse().getNumber()) << i;
+    }
+    GFNumber::batchInverse(numbers.data() , numbers.size() , numbers.data()); // in place
+    for (size_t i = 0; i < numbers.size(); i++)
+    {
+        ASSERT_EQ(numbers[i].getNumber() , results[i].getNumber()) << i;
+    }
+
+    GFNumberT<998244353> t(3);
+    EXPECT_EQ((t * t.inverse()).getNumber() , 1);
+    EXPECT_EQ(t.pow(998244352).getNumber() , 1);
+    EXPECT_EQ((t / 3).getNumber() , 1);
+    EXPECT_EQ(t.pow(-1) , t.inverse());
+}
+
+TEST(GFExprTest , MatchesEagerOperators)
+{
+    GField fields[] = {GField(2 , 62) , GField(3 , 39) , GField(2305843009213693951) ,
+                       GField(1000003) , GField(7 , 2)};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : fields)
+    {
+        std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+        for (int i = 0; i < 2000; i++)
+        {
+            GFNumber a(distribution(generator) , field) , b(distribution(generator) , field) ,
+                    c(distribution(generator) , field) , d(distribution(generator) , field) ,
+                    e(distribution(generator) , field);
+            if (i == 0)
+            {
+                a = b = c = d = e = GFNumber(field.getOrder() - 1 , field);
+            }
+            long k = (long) generator();
+            GFNumber lazyResult = lazy(a) * b + lazy(c) * d - e;
+            ASSERT_EQ(lazyResult.getNumber() , (a * b + c * d - e).getNumber()) << field;
+            GFNumber mixed = lazy(a) * b + c * d; // c * d is an eager GFNumber operand
+            ASSERT_EQ(mixed.getNumber() , (a * b + c * d).getNumber());
+            // deep sums force the operands to be reduced in the middle of the expression
+            GFNumber deep = lazy(a) * b + lazy(c) * d + lazy(a) * c + lazy(b) * d + lazy(e) * e -
+                            lazy(a) * e - k;
+            ASSERT_EQ(deep.getNumber() ,
+                      (a * b + c * d + a * c + b * d + e * e - a * e - k).getNumber());
+            GFNumber nested = (lazy(a) + b + c) * (lazy(d) - e - k) * (lazy(a) * b - c);
+            ASSERT_EQ(nested.getNumber() , ((a + b + c) * (d - e - k) * (a * b - c)).getNumber());
+            ASSERT_EQ((3 * lazy(a) - e * 2).evaluate().getNumber() , (a * 3 - e * 2).getNumber());
+        }
+    }
+}
+
+/**
+ * Multiplies two packed elements of GF(p^l) by the schoolbook product of their digits and
+ * a long division by the modulus, the reference of the extension arithmetic.
+ */
+static uint64_t referenceExtensionMul(uint64_t p , int l , uint64_t modulus , uint64_t a ,
+                                      uint64_t b)
+{
+    std::vector<uint64_t> x(l) , y(l) , f(l + 1) , product(2 * l - 1 , 0);
+    for (int i = 0; i < l; i++ , a /= p , b /= p , modulus /= p)
+    {
+        x[i] = a % p;
+        y[i] = b % p;
+        f[i] = modulus % p;
+    }
+    f[l] = 1;
+    for (int i = 0; i < l; i++)
+    {
+        for (int j = 0; j < l; j++)
+        {
+            product[i + j] = (product[i + j] + x[i] * y[j]) % p;
+        }
+    }
+    for (int k = 2 * l - 2; k >= l; k--)
+    {
+        for (int j = 0; j <= l; j++)
+        {
+            product[k - l + j] = (product[k - l + j] + (p - product[k]) * f[j]) % p;
+        }
+    }
+    uint64_t result = 0;
+    for (int i = l - 1; i >= 0; i--)
+    {
+        result = result * p + product[i];
+    }
+    return result;
+}
+
+TEST(GFExtensionTest , AesField)
+{
+    EXPECT_EQ(GFExtension::findIrreducible(2 , 8) , 0x1Bu);
+    GField aes(2 , 8 , (uint64_t) 0x1B);
+    EXPECT_EQ(aes.getArithmetic() , POLYNOMIAL_ARITHMETIC);
+    EXPECT_EQ(aes , GField(2 , 8 , POLYNOMIAL_ARITHMETIC));
+    EXPECT_NE(aes , GField(2 , 8));
+    EXPECT_EQ(GField(5 , 1 , POLYNOMIAL_ARITHMETIC) , GField(5));
+    EXPECT_EQ(GField(2 , 8).getModulus() , 0u);
+    GFNumber a(0x57 , aes) , b(0x83 , aes);
+    EXPECT_EQ((a * b).getNumber() , 0xC1);
+    EXPECT_EQ((a + b).getNumber() , 0xD4);
+    EXPECT_EQ(GFNumber(0x53 , aes).inverse().getNumber() , 0xCA);
+    EXPECT_EQ((a / b * b).getNumber() , 0x57);
+    EXPECT_EQ((a * 0x02).getNumber() , 0xAE);
+}
+
+TEST(GFExtensionTest , IrreducibleModuli)
+{
+    EXPECT_TRUE(GFExtension::isIrreducible(3 , 2 , 1)); // x^2 + 1
+    EXPECT_FALSE(GFExtension::isIrreducible(5 , 2 , 1)); // (x - 2)(x + 2)
+    EXPECT_TRUE(GFExtension::isIrreducible(2 , 4 , 0x3)); // x^4 + x + 1
+    EXPECT_FALSE(GFExtension::isIrreducible(2 , 4 , 0x5)); // (x^2 + x + 1)^2
+    EXPECT_FALSE(GFExtension::isIrreducible(2 , 6 , 0x6)); // x divides it
+    EXPECT_TRUE(GFExtension::isIrreducible(2 , 8 , 0x1B));
+    EXPECT_FALSE(GFExtension::isIrreducible(2 , 8 , 0x11)); // (x^4 + x^2 + 1)^2
+    EXPECT_EQ(GFExtension::get(5 , 2 , 1) , nullptr);
+    EXPECT_EQ(GFExtension::get(2 , 8 , 0x11) , nullptr); // would have had log tables
+    EXPECT_NE(GFExtension::get(2 , 8 , 0x1B) , nullptr);
+    for (uint64_t p : {2 , 3 , 5 , 257})
+    {
+        for (int l = 2; l <= 6; l++)
+        {
+            EXPECT_TRUE(GFExtension::isIrreducible(p , l , GFExtension::findIrreducible(p , l)));
+        }
+    }
+}
+
+TEST(GFExtensionTest , ExhaustiveSmallFields)
+{
+    const GFieldArithmetic polynomial = POLYNOMIAL_ARITHMETIC;
+    GField fields[] = {GField(2 , 4 , polynomial) , GField(3 , 3 , polynomial) ,
+                       GField(5 , 2 , polynomial) , GField(7 , 2 , polynomial)};
+    for (const GField &field : fields)
+    {
+        const uint64_t p = (uint64_t) field.getChar() , modulus = field.getModulus();
+        const long order = field.getOrder();
+        const int l = (int) field.getDegree();
+        const GFNumber one(1 , field) , zero(0 , field);
+        for (long a = 0; a < order; a++)
+        {
+            GFNumber x(a , field);
+            EXPECT_EQ(x + (zero - x) , zero) << field << " " << a;
+            EXPECT_EQ(x * one , x);
+            GFNumber multiple(zero);
+            for (uint64_t i = 0; i < p; i++)
+            {
+                multiple += x;
+            }
+            EXPECT_EQ(multiple , zero); // the characteristic is p
+            if (a != 0)
+            {
+                EXPECT_EQ(x * x.inverse() , one) << field << " " << a;
+                EXPECT_EQ(x.pow(order - 1) , one) << field << " " << a;
+            }
+            for (long b = 0; b < order; b++)
+            {
+                GFNumber y(b , field);
+                ASSERT_EQ((uint64_t) (x * y).getNumber() ,
+                          referenceExtensionMul(p , l , modulus , a , b)) << field << a << "*" << b;
+                ASSERT_EQ(x * y , y * x);
+                ASSERT_EQ(x + y - y , x);
+                GFNumber z(a ^ b , field);
+                ASSERT_EQ(x * (y + z) , x * y + x * z);
+                ASSERT_EQ((x * y) * z , x * (y * z));
+            }
+        }
+    }
+}
+
+TEST(GFExtensionTest , RandomizedLargeFields)
+{
+    // binary fields on both product widths, Karatsuba (l >= 12) and a large characteristic
+    const GFieldArithmetic polynomial = POLYNOMIAL_ARITHMETIC;
+    GField fields[] = {GField(2 , 20 , polynomial) , GField(2 , 62 , polynomial) ,
+                       GField(3 , 39 , polynomial) , GField(5 , 27 , polynomial) ,
+                       GField(3 , 13 , polynomial) , GField(1000003 , 3 , polynomial)};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : fields)
+    {
+        const uint64_t p = (uint64_t) field.getChar() , modulus = field.getModulus();
+        const int l = (int) field.getDegree();
+        std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+        for (int i = 0; i < RANDOM_PAIRS / 10; i++)
+        {
+            long a = (i == 0) ? field.getOrder() - 1 : distribution(generator);
+            long b = (i == 0) ? field.getOrder() - 1 : distribution(generator);
+            GFNumber x(a , field) , y(b , field);
+            ASSERT_EQ((uint64_t) (x * y).getNumber() ,
+                      referenceExtensionMul(p , l , modulus , a , b)) << field << a << "*" << b;
+            ASSERT_EQ(x - y + y , x);
+        }
+        GFNumber x(distribution(generator) | 1 , field);
+        EXPECT_EQ(x.pow(field.getOrder() - 1).getNumber() , 1) << field;
+        EXPECT_EQ((x * x.inverse()).getNumber() , 1) << field;
+    }
+}
+
+TEST(GFExtensionTest , LogTablesMatchPolynomialArithmetic)
+{
+    // the shared extensions of small orders have log tables, a private one never has
+    const uint64_t fields[][2] = {{2 , 8} , {3 , 5} , {5 , 3} , {2 , 16} , {251 , 2} , {3 , 10}};
+    std::mt19937_64 generator(67320);
+    for (const uint64_t *field : fields)
+    {
+        const GFExtension *tables = GFExtension::get(field[0] , (int) field[1]);
+        GFExtension polynomial(field[0] , (int) field[1] , tables->getModulus());
+        ASSERT_TRUE(tables->hasLogTables());
+        ASSERT_FALSE(polynomial.hasLogTables());
+        const uint64_t order = tables->getOrder();
+        const bool exhaustive = order <= 256;
+        std::uniform_int_distribution<uint64_t> distribution(0 , order - 1);
+        for (uint64_t i = 0; i < (exhaustive ? order * order : RANDOM_PAIRS / 10); i++)
+        {
+            uint64_t a = exhaustive ? i / order : distribution(generator);
+            uint64_t b = exhaustive ? i % order : distribution(generator);
+            ASSERT_EQ(tables->mul(a , b) , polynomial.mul(a , b)) << order << " " << a << "*" << b;
+            ASSERT_EQ(tables->add(a , b) , polynomial.add(a , b)) << order << " " << a << "+" << b;
+            ASSERT_EQ(tables->sub(a , b) , polynomial.sub(a , b)) << order << " " << a << "-" << b;
+            if (!exhaustive || b == 0)
+            {
+                ASSERT_EQ(tables->neg(a) , polynomial.neg(a));
+                ASSERT_EQ(tables->inverse(a) , polynomial.inverse(a)) << order << " " << a;
+                ASSERT_EQ(tables->pow(a , i * 977) , polynomial.pow(a , i * 977));
+            }
+        }
+    }
+    EXPECT_FALSE(GFExtension::get(2 , 17)->hasLogTables());
+    EXPECT_TRUE(GField(2 , 8 , POLYNOMIAL_ARITHMETIC).getExtension()->hasLogTables());
+}
+
+TEST(GFExtensionTest , BinaryKernelsMatchReference)
+{
+    // both product widths of the scalar kernels, and both of their scaleAdd paths
+    const int degrees[] = {17 , 32 , 33 , 62};
+    const char *kernels[] = {"pclmul" , "scalar"};
+    std::mt19937_64 generator(67320);
+    for (const char *name : kernels)
+    {
+        if (!GFExtension::selectBinaryKernels(name))
+        {
+            continue; // no PCLMULQDQ on this cpu
+        }
+        ASSERT_STREQ(GFExtension::binaryKernelName() , name);
+        for (int l : degrees)
+        {
+            const GFExtension *field = GFExtension::get(2 , l);
+            const uint64_t modulus = field->getModulus() , mask = field->getOrder() - 1;
+            const size_t n = 200;
+            std::vector<uint64_t> a(n) , b(n) , sum(n) , scaled(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                a[i] = (i == 0) ? mask : generator() & mask;
+                b[i] = (i == 0) ? mask : generator() & mask;
+                sum[i] = scaled[i] = generator() & mask;
+            }
+            std::vector<uint64_t> expectedSum(sum) , expectedScaled(scaled);
+            for (size_t i = 0; i < n; i++)
+            {
+                ASSERT_EQ(field->mul(a[i] , b[i]) , referenceExtensionMul(2 , l , modulus , a[i] ,
+                                                                          b[i])) << name << l;
+                expectedSum[i] ^= referenceExtensionMul(2 , l , modulus , a[i] , b[i]);
+                expectedScaled[i] ^= referenceExtensionMul(2 , l , modulus , b[0] , a[i]);
+            }
+            field->mulAdd(a.data() , b.data() , sum.data() , n);
+            EXPECT_EQ(sum , expectedSum) << name << l;
+            field->scaleAdd(b[0] , a.data() , scaled.data() , n);
+            EXPECT_EQ(scaled , expectedScaled) << name << l;
+            field->scaleAdd(b[0] , a.data() , scaled.data() , 3); // shorter than the tables
+            for (size_t i = 0; i < 3; i++)
+            {
+                EXPECT_EQ(scaled[i] , expectedScaled[i] ^
+                                      referenceExtensionMul(2 , l , modulus , b[0] , a[i]));
+            }
+        }
+        GField wide(2 , 62 , POLYNOMIAL_ARITHMETIC);
+        GFVector x(wide , 5) , y(wide , 5);
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            x.set(i , (long) (generator() >> 2));
+            y.set(i , (long) (generator() >> 2));
+        }
+        GFVector product(x);
+        product.fma(x , y);
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            EXPECT_EQ(product.get(i) , x.get(i) * y.get(i) + x.get(i)) << name;
+        }
+    }
+    GFExtension::selectBinaryKernels(nullptr);
+    EXPECT_FALSE(GFExtension::selectBinaryKernels("avx512"));
+}
+
+TEST(GFExtensionTest , VectorsExpressionsAndLongs)
+{
+    GField field(3 , 13 , POLYNOMIAL_ARITHMETIC);
+    long order = field.getOrder();
+    EXPECT_EQ(GFNumber(-1 , field) , GFNumber(0 , field) - GFNumber(1 , field));
+    EXPECT_EQ(GFNumber(-1 , field).getNumber() , 2);
+    EXPECT_EQ(GFNumber(order + 4 , field).getNumber() , 4);
+    EXPECT_EQ((GFNumber(5 , field) * -1).getNumber() , 7); // -(x + 2) = 2x + 1
+    std::mt19937_64 generator(67320);
+    std::uniform_int_distribution<long> distribution(0 , order - 1);
+    std::vector<long> left , right;
+    for (int i = 0; i < 100; i++)
+    {
+        left.push_back(distribution(generator));
+        right.push_back(distribution(generator));
+    }
+    GFVector a(field , left) , b(field , right);
+    GFVector sum = a + b , product = a * b , scaled = a * 5 , fused(field , right);
+    fused.fma(a , b);
+    GFNumber dot(0 , field);
+    for (size_t i = 0; i < left.size(); i++)
+    {
+        GFNumber x(left[i] , field) , y(right[i] , field);
+        ASSERT_EQ(sum.get(i) , x + y);
+        ASSERT_EQ(product.get(i) , x * y);
+        ASSERT_EQ(scaled.get(i) , x * 5);
+        ASSERT_EQ(fused.get(i) , x * y + y);
+        GFNumber lazyResult = lazy(x) * y + lazy(y) * 7 - x;
+        ASSERT_EQ(lazyResult , x * y + y * 7 - x);
+        dot += x * y;
+    }
+    EXPECT_EQ(a.dot(b) , dot);
+}
@@ -0,0 +1,552 @@
+// GFBenchmark.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BatchFactorizer.h"
+#include "FactorizationCache.h"
+#include "FactorizationPipeline.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFExpr.hpp"
+#include "GFNumberT.hpp"
+#include "GFPolynomial.h"
+#include "GFVector.h"
+#include "PrimeSieve.h"
+#include "SubproductTree.h"
+#include "ThreadPool.h"
+
+#define ITERATIONS 5000000
+#define SEMIPRIMES 200
+#define WIDE_SEMIPRIMES 8
+#define VECTOR_LENGTH 4096
+#define SIEVE_BENCHMARK_LIMIT 100000000
+#define REPEATED_STREAM 20000
+#define POLYNOMIAL_LENGTH 1024
+#define MULTIPOINT_LENGTH 16384
+
+// --------------------------------------------------------------------------------------
+// This file contains micro benchmarks of the field arithmetic, it prints the number of
+// operations per second of every benchmarked operation.
+// --------------------------------------------------------------------------------------
+
+/**
+ * The reduction GFNumber used before the order was cached: three floating point
+ * pow calls for every reduced number.
+ * @param n long number.
+ * @param field the field to reduce into.
+ * @return n as a number from the field.
+ */
+static long legacyConvertNumberToField(long n , const GField &field)
+{
+    long p = field.getChar() , l = field.getDegree();
+    if (n > 0)
+    {
+        return n % (long) ceil(pow(p , l));
+    }
+    return (((n % (long) ceil(pow(p , l))) + (long) ceil(pow(p , l))) % (long) ceil(pow(p , l)));
+}
+
+/**
+ * The Pollard rho GFNumber used before Brent's variant: Floyd's cycle detection with three
+ * polynomial evaluations and a gcd on every step (kept overflow free for the comparison).
+ * @param n odd composite number.
+ * @return a divisor of n, possibly n itself.
+ */
+static long legacyFloydRho(long n)
+{
+    ModReducer reducer((uint64_t) n);
+    uint64_t x = 2 , y = 2 , p = 1;
+    while (p == 1)
+    {
+        x = reducer.addMod(reducer.mulMod(x , x) , 1);
+        y = reducer.addMod(reducer.mulMod(y , y) , 1);
+        y = reducer.addMod(reducer.mulMod(y , y) , 1);
+        p = GField::binaryGcd((x > y) ? x - y : y - x , (uint64_t) n);
+    }
+    return (long) p;
+}
+
+/**
+ * Generates semiprimes which are products of two random primes of the given size.
+ * @param bits the size of each prime.
+ * @return SEMIPRIMES semiprimes.
+ */
+static std::vector<long> generateSemiprimes(int bits)
+{
+    std::mt19937_64 generator(67320);
+    std::vector<long> semiprimes;
+    while (semiprimes.size() < SEMIPRIMES)
+    {
+        long p = (long) ((generator() >> (64 - bits)) | (1ul << (bits - 1)) | 1);
+        long q = (long) ((generator() >> (64 - bits)) | (1ul << (bits - 1)) | 1);
+        if (GField::isPrime(p) && GField::isPrime(q))
+        {
+            semiprimes.push_back(p * q);
+        }
+    }
+    return semiprimes;
+}
+
+/**
+ * Generates semiprimes of up to 128 bits which are products of two random primes of the
+ * given size.
+ * @param bits the size of each prime, at most 64.
+ * @return WIDE_SEMIPRIMES semiprimes.
+ */
+static std::vector<UInt128> generateWideSemiprimes(int bits)
+{
+    std::mt19937_64 generator(67320);
+    std::vector<UInt128> semiprimes;
+    UInt128 p = 0;
+    while (semiprimes.size() < WIDE_SEMIPRIMES)
+    {
+        UInt128 q = (generator() >> (64 - bits)) | (1ull << (bits - 1)) | 1;
+        if (!FactorizationPipeline::isProbablePrime(q))
+        {
+            continue;
+        }
+        if (p != 0)
+        {
+            semiprimes.push_back(p * q);
+            q = 0;
+        }
+        p = q;
+    }
+    return semiprimes;
+}
+
+/**
+ * Runs the given operation ITERATIONS times and prints its throughput.
+ * @param name the name of the benchmark.
+ * @param op the benchmarked operation, gets the iteration index.
+ */
+template<typename Operation>
+static void runBenchmark(const char *name , Operation op)
+{
+    auto start = std::chrono::steady_clock::now();
+    long sink = 0;
+    for (long i = 0; i < ITERATIONS; i++)
+    {
+        sink += op(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << (long) (ITERATIONS / elapsed.count()) << " ops/sec"
+              << " (checksum " << sink << ")" << std::endl;
+}
+
+/**
+ * Main function, runs all the benchmarks.
+ * @return 0.
+ */
+int main()
+{
+    GField field(1000003 , 1);
+    GFNumber a(123456 , field) , b(654321 , field);
+
+    runBenchmark("legacy add (pow reduction)" , [&](long i)
+    {
+        return legacyConvertNumberToField(a.getNumber() + b.getNumber() + i , field);
+    });
+    runBenchmark("GFNumber add" , [&](long i)
+    {
+        return (a + (b + i)).getNumber();
+    });
+    runBenchmark("legacy mul (pow reduction)" , [&](long i)
+    {
+        return legacyConvertNumberToField(a.getNumber() * ((b.getNumber() + i) % 1000003) ,
+                                          field);
+    });
+    runBenchmark("GFNumber mul" , [&](long i)
+    {
+        return (a * (b + i)).getNumber();
+    });
+
+    std::vector<GFElement> elements(1024);
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        elements[i] = field.element((long) i * 7919);
+    }
+    runBenchmark("GFElement mul (compact array)" , [&](long i)
+    {
+        return (long) field.mul(elements[i & 1023] , elements[(i + 1) & 1023]).getResidue();
+    });
+
+    GField wideField(3 , 39);
+    GFNumber c(wideField.getOrder() - 12345 , wideField) , d(wideField.getOrder() / 3 , wideField);
+    runBenchmark("GFNumber mul (62 bit order)" , [&](long i)
+    {
+        return (c * (d + i)).getNumber();
+    });
+    GFNumber e3(wideField.getOrder() - 777 , wideField);
+    runBenchmark("GFNumber a*b + c*d - e (62 bit order)" , [&](long i)
+    {
+        GFNumber x(i , wideField);
+        return (c * x + d * c - e3).getNumber();
+    });
+    runBenchmark("GFExpr a*b + c*d - e (62 bit order)" , [&](long i)
+    {
+        GFNumber x(i , wideField);
+        GFNumber result = lazy(c) * x + lazy(d) * c - e3;
+        return result.getNumber();
+    });
+
+    GFNumberT<3 , 39> ct(wideField.getOrder() - 12345) , dt(wideField.getOrder() / 3);
+    runBenchmark("GFNumberT mul (62 bit order)" , [&](long i)
+    {
+        return (ct * (dt + i)).getNumber();
+    });
+
+    GField nttField(998244353);
+    GFNumber e(123456789 , nttField) , f(987654321 , nttField);
+    runBenchmark("GFNumber mul (998244353)" , [&](long i)
+    {
+        return (e * (f + i)).getNumber();
+    });
+    GFNumberT<998244353> et(123456789) , ft(987654321);
+    runBenchmark("GFNumberT mul (998244353)" , [&](long i)
+    {
+        return (et * (ft + i)).getNumber();
+    });
+    GFNumberT<2305843009213693951> mt(1234567890123) , nt(9876543210987);
+    runBenchmark("GFNumberT mul (2^61 - 1)" , [&](long i)
+    {
+        return (mt * (nt + i)).getNumber();
+    });
+
+    std::vector<GFNumber> units , inverses(1024);
+    for (long i = 0; i < 1024; i++)
+    {
+        units.push_back(GFNumber(3 * i + 1 , wideField));
+    }
+    runBenchmark("GFNumber pow (62 bit exponent)" , [&](long i)
+    {
+        return units[i & 1023].pow(wideField.getOrder() - i).getNumber();
+    });
+    runBenchmark("GFNumber inverse" , [&](long i)
+    {
+        return units[i & 1023].inverse().getNumber();
+    });
+    runBenchmark("GFNumber batchInverse (per number)" , [&](long i)
+    {
+        if ((i & 1023) == 0)
+        {
+            GFNumber::batchInverse(units.data() , units.size() , inverses.data());
+        }
+        return inverses[i & 1023].getNumber();
+    });
+
+    const GField extensionFields[] = {GField(2 , 8 , POLYNOMIAL_ARITHMETIC) ,
+                                      GField(2 , 16 , POLYNOMIAL_ARITHMETIC) ,
+                                      GField(2 , 62 , POLYNOMIAL_ARITHMETIC) ,
+                                      GField(3 , 10 , POLYNOMIAL_ARITHMETIC) ,
+                                      GField(3 , 13 , POLYNOMIAL_ARITHMETIC) ,
+                                      GField(3 , 39 , POLYNOMIAL_ARITHMETIC)};
+    for (const GField &extensionField : extensionFields)
+    {
+        std::ostringstream name;
+        name << "GFElement mul " << extensionField << " (polynomial)";
+        std::vector<GFElement> extensionElements(1024);
+        for (size_t i = 0; i < extensionElements.size(); i++)
+        {
+            extensionElements[i] = extensionField.element((long) (i * 0x9E3779B97F4A7C15ull >> 2));
+        }
+        runBenchmark(name.str().c_str() , [&](long i)
+        {
+            return (long) extensionField.mul(extensionElements[i & 1023] ,
+                                             extensionElements[(i + 1) & 1023]).getResidue();
+        });
+    }
+    // the shared GF(3**10) adds by its Zech logarithms, a private one adds the digits
+    const GFExtension *zech = GFExtension::get(3 , 10);
+    GFExtension digits(3 , 10 , zech->getModulus());
+    for (const GFExtension *extension : {zech , (const GFExtension *) &digits})
+    {
+        runBenchmark(extension->hasLogTables() ? "GFExtension add GF(3**10) (Zech logarithms)" :
+                     "GFExtension add GF(3**10) (digits)" , [&](long i)
+        {
+            return (long) extension->add((uint64_t) i % 59049 , (uint64_t) (i * 7) % 59049);
+        });
+    }
+    GField aes(2 , 8 , (uint64_t) 0x1B);
+    runBenchmark("GFNumber inverse GF(2**8) (polynomial)" , [&](long i)
+    {
+        return GFNumber(i % 255 + 1 , aes).inverse().getNumber();
+    });
+
+    const char *binaryKernels[] = {"scalar" , "pclmul"};
+    for (const char *kernel : binaryKernels)
+    {
+        if (!GFExtension::selectBinaryKernels(kernel))
+        {
+            continue;
+        }
+        for (int l : {32 , 62})
+        {
+            const GFExtension *binary = GFExtension::get(2 , l);
+            const uint64_t mask = binary->getOrder() - 1;
+            std::vector<uint64_t> left(VECTOR_LENGTH) , right(VECTOR_LENGTH) ,
+                    accumulator(VECTOR_LENGTH);
+            for (long i = 0; i < VECTOR_LENGTH; i++)
+            {
+                left[i] = (i * 0x9E3779B97F4A7C15ull) & mask;
+                right[i] = (i * 0xC2B2AE3D27D4EB4Full) & mask;
+            }
+            std::ostringstream name;
+            name << "GFExtension mul GF(2**" << l << "), " << kernel;
+            runBenchmark(name.str().c_str() , [&](long i)
+            {
+                return (long) binary->mul(left[i % VECTOR_LENGTH] , right[i % VECTOR_LENGTH]);
+            });
+            name.str("");
+            name << "GFExtension mulAdd GF(2**" << l << "), " << kernel << " (per element)";
+            runBenchmark(name.str().c_str() , [&](long i)
+            {
+                if (i % VECTOR_LENGTH == 0)
+                {
+                    binary->mulAdd(left.data() , right.data() , accumulator.data() , VECTOR_LENGTH);
+                }
+                return (long) accumulator[i % VECTOR_LENGTH];
+            });
+            name.str("");
+            name << "GFExtension scaleAdd GF(2**" << l << "), " << kernel << " (per element)";
+            runBenchmark(name.str().c_str() , [&](long i)
+            {
+                if (i % VECTOR_LENGTH == 0)
+                {
+                    binary->scaleAdd(right[i / VECTOR_LENGTH % VECTOR_LENGTH] , left.data() ,
+                                     accumulator.data() , VECTOR_LENGTH);
+                }
+                return (long) accumulator[i % VECTOR_LENGTH];
+            });
+        }
+    }
+    GFExtension::selectBinaryKernels(nullptr);
+
+    // one transform, the CRT on one and on three primes, and Karatsuba over GF(2**62)
+    const GField polynomialFields[] = {GField(998244353) , GField(1000003) ,
+                                       GField(9223372036854775783) ,
+                                       GField(2 , 62 , POLYNOMIAL_ARITHMETIC)};
+    for (const GField &polynomialField : polynomialFields)
+    {
+        std::vector<uint64_t> left(POLYNOMIAL_LENGTH) , right(POLYNOMIAL_LENGTH) ,
+                polynomialProduct(2 * POLYNOMIAL_LENGTH - 1);
+        for (long i = 0; i < POLYNOMIAL_LENGTH; i++)
+        {
+            long a = (long) (i * 0x9E3779B97F4A7C15ull >> 2);
+            long b = (long) (i * 0xC2B2AE3D27D4EB4Full >> 2);
+            left[i] = polynomialField.element(a).getResidue();
+            right[i] = polynomialField.element(b).getResidue();
+        }
+        std::ostringstream name;
+        name << "GFPolynomial multiply " << POLYNOMIAL_LENGTH << "x" << POLYNOMIAL_LENGTH << " "
+             << polynomialField << " (per product coefficient)";
+        runBenchmark(name.str().c_str() , [&](long i)
+        {
+            if (i % polynomialProduct.size() == 0)
+            {
+                GFPolynomial::multiply(polynomialField , left.data() , POLYNOMIAL_LENGTH ,
+                                       right.data() , POLYNOMIAL_LENGTH , polynomialProduct.data());
+            }
+            return (long) polynomialProduct[i % polynomialProduct.size()];
+        });
+    }
+
+    // a tree against Horner at every point, the levels serial and on a pool
+    ThreadPool treePool;
+    for (const GField &treeField : {GField(998244353) , GField(9223372036854775783)})
+    {
+        std::vector<uint64_t> points(MULTIPOINT_LENGTH) , coefficients(MULTIPOINT_LENGTH) ,
+                values(MULTIPOINT_LENGTH) , interpolated(MULTIPOINT_LENGTH);
+        for (long i = 0; i < MULTIPOINT_LENGTH; i++)
+        {
+            points[i] = treeField.element((long) (i * 0x9E3779B97F4A7C15ull >> 2)).getResidue();
+            coefficients[i] = treeField.element(i * 7919 + 1).getResidue();
+        }
+        for (ThreadPool *treeRun : {(ThreadPool *) nullptr , &treePool})
+        {
+            auto begin = std::chrono::steady_clock::now();
+            SubproductTree tree(treeField , points.data() , MULTIPOINT_LENGTH , treeRun);
+            tree.evaluate(coefficients.data() , MULTIPOINT_LENGTH , values.data() , treeRun);
+            std::chrono::duration<double> evaluation = std::chrono::steady_clock::now() - begin;
+            begin = std::chrono::steady_clock::now();
+            tree.interpolate(values.data() , interpolated.data() , treeRun);
+            std::chrono::duration<double> interpolation = std::chrono::steady_clock::now() - begin;
+            std::cout << "SubproductTree " << MULTIPOINT_LENGTH << " points " << treeField
+                      << ((treeRun == nullptr) ? "" : " on the pool") << ": evaluate "
+                      << (long) (MULTIPOINT_LENGTH / evaluation.count())
+                      << " points/sec, interpolate "
+                      << (long) (MULTIPOINT_LENGTH / interpolation.count()) << " points/sec"
+                      << ((interpolated == coefficients) ? "" : " (MISMATCH)") << std::endl;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < MULTIPOINT_LENGTH; i++)
+        {
+            GFElement value(0);
+            for (long j = MULTIPOINT_LENGTH - 1; j >= 0; j--)
+            {
+                value = treeField.add(treeField.mul(value , GFElement(points[i])) ,
+                                      GFElement(coefficients[j]));
+            }
+            values[i] = value.getResidue();
+        }
+        std::chrono::duration<double> horner = std::chrono::steady_clock::now() - begin;
+        std::cout << "Horner at " << MULTIPOINT_LENGTH << " points " << treeField << ": "
+                  << (long) (MULTIPOINT_LENGTH / horner.count()) << " points/sec" << std::endl;
+    }
+
+    std::vector<long> numbers(VECTOR_LENGTH);
+    for (long i = 0; i < VECTOR_LENGTH; i++)
+    {
+        numbers[i] = i * 7919 + 1;
+    }
+    std::vector<GFNumber> scalars , products(VECTOR_LENGTH);
+    for (long n : numbers)
+    {
+        scalars.push_back(GFNumber(n , field));
+    }
+    runBenchmark("GFNumber::operator* loop (per number)" , [&](long i)
+    {
+        if (i % VECTOR_LENGTH == 0)
+        {
+            for (long j = 0; j < VECTOR_LENGTH; j++)
+            {
+                products[j] = scalars[j] * scalars[VECTOR_LENGTH - 1 - j];
+            }
+        }
+        return products[i % VECTOR_LENGTH].getNumber();
+    });
+    GFVector vector(field , numbers) , reversed(field , std::vector<long>(numbers.rbegin() ,
+                                                                          numbers.rend()));
+    GFVector product(field , VECTOR_LENGTH);
+    const char *kernels[] = {"scalar" , "sse4.1" , "avx2"};
+    for (const char *kernel : kernels)
+    {
+        if (!GFVector::selectKernels(kernel))
+        {
+            continue;
+        }
+        std::string name = std::string("GFVector mul, ") + kernel + " (per number)";
+        runBenchmark(name.c_str() , [&](long i)
+        {
+            if (i % VECTOR_LENGTH == 0)
+            {
+                product = vector * reversed;
+            }
+            return (long) product.data()[i % VECTOR_LENGTH];
+        });
+    }
+    GFVector::selectKernels(nullptr);
+
+    std::vector<long> candidates(ITERATIONS);
+    std::unique_ptr<bool[]> results(new bool[ITERATIONS]);
+    std::mt19937_64 generator(67320);
+    for (long &candidate : candidates)
+    {
+        candidate = (long) (generator() >> 1) | 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    GField::isPrime(candidates.data() , candidates.size() , results.get());
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "isPrime batch (63 bit odd): " << (long) (ITERATIONS / elapsed.count())
+              << " numbers/sec" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    PrimeSieve sieve;
+    long primeCount = 0;
+    for (uint64_t prime = sieve.next(); prime < SIEVE_BENCHMARK_LIMIT; prime = sieve.next())
+    {
+        primeCount++;
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "PrimeSieve stream (" << primeCount << " primes below 10^8): "
+              << (long) (primeCount / elapsed.count()) << " primes/sec" << std::endl;
+
+    std::vector<long> semiprimes = generateSemiprimes(30);
+    start = std::chrono::steady_clock::now();
+    for (long n : semiprimes)
+    {
+        legacyFloydRho(n);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "legacy Floyd rho (60 bit semiprimes): " << (long) (SEMIPRIMES / elapsed.count())
+              << " numbers/sec" << std::endl;
+    FactorizationPipeline &pipeline = FactorizationPipeline::global();
+    pipeline.resetStatistics();
+    FactorizationCache::global().clear();
+    start = std::chrono::steady_clock::now();
+    for (long n : semiprimes)
+    {
+        GFNumber(n , GField(2 , 62)).getPrimeFactors();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "getPrimeFactors (60 bit semiprimes): " << (long) (SEMIPRIMES / elapsed.count())
+              << " numbers/sec" << std::endl << pipeline;
+    ThreadPool pool;
+    double worst = 0;
+    FactorizationCache::global().clear();
+    start = std::chrono::steady_clock::now();
+    for (long n : semiprimes)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        GFNumber(n , GField(2 , 62)).getPrimeFactors(pool);
+        std::chrono::duration<double> latency = std::chrono::steady_clock::now() - begin;
+        worst = std::max(worst , latency.count());
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "getPrimeFactors, rho raced on " << pool.size() << " threads (60 bit semiprimes): "
+              << (long) (SEMIPRIMES / elapsed.count()) << " numbers/sec, worst "
+              << (long) (worst * 1e6) << "us" << std::endl;
+    const char *wideMethods[] = {"siqs" , "siqs on the pool" , "ecm"};
+    for (int bits = 40; bits <= 64; bits += 8)
+    {
+        std::vector<UInt128> wideSemiprimes = generateWideSemiprimes(bits);
+        for (int method = 0; method < 3; method++)
+        {
+            pipeline.setStageEnabled(SIQS_STAGE , method != 2);
+            pipeline.resetStatistics();
+            start = std::chrono::steady_clock::now();
+            for (UInt128 n : wideSemiprimes)
+            {
+                (method == 1) ? GFNumber::factorWide(n , pool) : GFNumber::factorWide(n);
+            }
+            elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "factorWide, " << wideMethods[method] << " (" << 2 * bits
+                      << " bit semiprimes): " << elapsed.count() / WIDE_SEMIPRIMES * 1e3
+                      << "ms per number" << std::endl;
+        }
+    }
+    pipeline.setStageEnabled(SIQS_STAGE , true);
+
+    // a stream with a heavy tailed repeat distribution: the i-th semiprime is drawn with a
+    // probability proportional to 1 / (i + 1)
+    std::ostringstream stream;
+    std::vector<double> weights;
+    for (size_t i = 0; i < semiprimes.size(); i++)
+    {
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::discrete_distribution<size_t> draw(weights.begin() , weights.end());
+    for (int i = 0; i < REPEATED_STREAM; i++)
+    {
+        stream << semiprimes[draw(generator)] << '\n';
+    }
+    FactorizationCache cache;
+    const char *batchMethods[] = {"uncached" , "cached"};
+    for (int method = 0; method < 2; method++)
+    {
+        std::istringstream in(stream.str());
+        std::ostringstream out;
+        BatchReport report = BatchFactorizer(pool , (method == 1) ? &cache : nullptr).run(in , out);
+        std::cout << "batch, " << batchMethods[method] << " (60 bit semiprimes, repeated): "
+                  << (long) report.throughput() << " numbers/sec" << std::endl;
+    }
+    std::cout << cache.getStatistics() << std::endl;
+    return 0;
+}
\ No newline at end of file
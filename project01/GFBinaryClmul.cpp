@@ -0,0 +1,90 @@
+// GFBinaryClmul.cpp
+
+#include "GFBinaryKernels.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the PCLMULQDQ kernels of the binary extension fields. They are
+// compiled with target attributes, so the rest of the project keeps the baseline
+// instruction set and GFExtension only calls them after checking the cpu.
+// An element has at most 62 bits, so a product has at most 123 bits and every operand of
+// the Barrett reduction (c >> l, mu, q and f) fits in one 64 bit half of a register.
+// --------------------------------------------------------------------------------------
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define CLMUL __attribute__((target("pclmul,sse4.1")))
+
+/**
+ * The carry-less product of two 64 bit vectors.
+ */
+CLMUL static inline __m128i clmul(uint64_t a , uint64_t b)
+{
+    return _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long) a) ,
+                                _mm_cvtsi64_si128((long long) b) , 0x00);
+}
+
+/**
+ * Shifts a carry-less product right by l bits, the result must fit in 64 bits.
+ */
+CLMUL static inline uint64_t shiftDown(__m128i product , int l)
+{
+    uint64_t low = (uint64_t) _mm_cvtsi128_si64(product);
+    uint64_t high = (uint64_t) _mm_extract_epi64(product , 1);
+    return (low >> l) | (high << (64 - l));
+}
+
+/**
+ * Barrett reduction of a product of two elements.
+ * @param product the carry-less product, of degree below 2l.
+ * @return product mod f.
+ */
+CLMUL static inline uint64_t clmulReduce(__m128i product , const BinaryModulus &m)
+{
+    uint64_t q = shiftDown(clmul(shiftDown(product , m.l) , m.mu) , m.l);
+    uint64_t r = (uint64_t) _mm_cvtsi128_si64(_mm_xor_si128(product , clmul(q , m.f)));
+    return r & ((1ull << m.l) - 1);
+}
+
+CLMUL static uint64_t clmulMul(uint64_t a , uint64_t b , const BinaryModulus &m)
+{
+    return clmulReduce(clmul(a , b) , m);
+}
+
+CLMUL static void clmulMulAdd(const uint64_t *a , const uint64_t *b , uint64_t *accumulator ,
+                              size_t n , const BinaryModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        accumulator[i] ^= clmulReduce(clmul(a[i] , b[i]) , m);
+    }
+}
+
+CLMUL static void clmulScaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator ,
+                                size_t n , const BinaryModulus &m)
+{
+    const __m128i s = _mm_cvtsi64_si128((long long) scalar);
+    for (size_t i = 0; i < n; i++)
+    {
+        __m128i product = _mm_clmulepi64_si128(s , _mm_cvtsi64_si128((long long) a[i]) , 0x00);
+        accumulator[i] ^= clmulReduce(product , m);
+    }
+}
+
+/**
+ * The PCLMULQDQ kernels.
+ * @return the table.
+ */
+const GFBinaryKernels *clmulBinaryKernels()
+{
+    static const GFBinaryKernels kernels = {"pclmul" , clmulMul , clmulMulAdd , clmulScaleAdd};
+    return &kernels;
+}
+
+#else
+
+const GFBinaryKernels *clmulBinaryKernels()
+{ return nullptr; }
+
+#endif
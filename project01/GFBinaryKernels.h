@@ -0,0 +1,56 @@
+// GFBinaryKernels.h
+//----------- include guards------------
+#ifndef GFBINARYKERNELS_H
+#define GFBINARYKERNELS_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+
+//--------------------------------------
+
+/**
+ * The constants of the arithmetic of GF(2^l), l <= 62, modulo a polynomial f of degree l.
+ * A product c of degree below 2l is reduced exactly by Barrett's method without a
+ * correction step: q = ((c >> l) * mu) >> l and c mod f is the low l bits of c + q * f.
+ */
+struct BinaryModulus
+{
+    int l; /** The degree. */
+    uint64_t f; /** The bit vector of the modulus, x^l included. */
+    uint64_t mu; /** The Barrett constant, the quotient of x^(2l) by f (degree l). */
+    const uint64_t *table; /** The byte reduction tables of the scalar kernels. */
+};
+
+/**
+ * The kernels of the binary extension fields, every instruction set fills one table.
+ * Elements are bit vectors below 2^l, accumulator may alias any input.
+ */
+struct GFBinaryKernels
+{
+    const char *name; /** The instruction set of the table. */
+
+    /** a * b mod f. */
+    uint64_t (*mul)(uint64_t a , uint64_t b , const BinaryModulus &m);
+
+    /** accumulator[i] = accumulator[i] + a[i] * b[i] mod f. */
+    void (*mulAdd)(const uint64_t *a , const uint64_t *b , uint64_t *accumulator , size_t n ,
+                   const BinaryModulus &m);
+
+    /** accumulator[i] = accumulator[i] + scalar * a[i] mod f. */
+    void (*scaleAdd)(uint64_t scalar , const uint64_t *a , uint64_t *accumulator , size_t n ,
+                     const BinaryModulus &m);
+};
+
+/**
+ * The portable kernels.
+ * @return the table.
+ */
+const GFBinaryKernels *scalarBinaryKernels();
+
+/**
+ * The PCLMULQDQ kernels.
+ * @return the table, or nullptr if they are not compiled for this architecture.
+ */
+const GFBinaryKernels *clmulBinaryKernels();
+
+#endif //GFBINARYKERNELS_H
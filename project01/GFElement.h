@@ -0,0 +1,63 @@
+// GFElement.h
+//----------- include guards------------
+#ifndef GFELEMENT_H
+#define GFELEMENT_H
+//-------------- includes --------------
+#include <cstdint>
+#include <type_traits>
+
+//--------------------------------------
+
+/**
+ *  A GFElement class.
+ *  The compact form of a field element: just its residue, 8 bytes. The field is not stored,
+ *  the arithmetic is done by the GField the element belongs to (GField::add, GField::mul...),
+ *  so a std::vector<GFElement> is a plain contiguous array of uint64_t.
+ */
+class GFElement
+{
+private:
+    uint64_t _residue; /** The residue, in [0, order). */
+public:
+    /**
+     * A constructor.
+     * Default ctor, the zero element.
+     */
+    constexpr GFElement() : _residue(0)
+    {};
+
+    /**
+     * A constructor.
+     * @param residue an already reduced residue.
+     */
+    constexpr explicit GFElement(uint64_t residue) : _residue(residue)
+    {};
+
+    /**
+     * Getter for the residue.
+     * @return the residue.
+     */
+    constexpr uint64_t getResidue() const
+    { return _residue; }
+
+    /**
+     * Equal operator, for elements of the same field.
+     * @param other GFElement.
+     * @return true if the residues are equal.
+     */
+    constexpr bool operator==(GFElement other) const
+    { return _residue == other._residue; }
+
+    /**
+     * Not equal operator, for elements of the same field.
+     * @param other GFElement.
+     * @return true if the residues differ.
+     */
+    constexpr bool operator!=(GFElement other) const
+    { return _residue != other._residue; }
+};
+
+static_assert(sizeof(GFElement) == sizeof(uint64_t) , "GFElement must stay a bare residue");
+static_assert(std::is_trivially_copyable<GFElement>::value , "GFElement must stay trivial");
+
+#endif //GFELEMENT_H
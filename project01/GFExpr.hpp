@@ -0,0 +1,419 @@
+// GFExpr.hpp
+//----------- include guards------------
+#ifndef GFEXPR_HPP
+#define GFEXPR_HPP
+//-------------- includes --------------
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "GFNumber.h"
+#include "GFieldRegistry.h"
+
+#define LAZY_PRODUCTS 4 /** products of two residues (each < 2^126) a 128 bit sum can hold */
+
+//--------------------------------------
+
+// --------------------------------------------------------------------------------------
+// This file contains an opt-in expression template layer over GFNumber. Wrapping a
+// GFNumber with lazy() makes + - * on it build an expression instead of a GFNumber, e.g.
+//     GFNumber r = lazy(a) * b + lazy(c) * d - e;
+// (c * d alone is still a plain GFNumber product, C++ evaluates it before the +).
+// The expression is evaluated in a single pass when it is converted to a GFNumber: sums and
+// products are kept unreduced in 128 bits and reduced once at the end. Every node knows at
+// compile time a bound on its value (WEIGHT * order^DEGREE) and only reduces its operands
+// when the bound would not fit. GFNumber's own operators are left untouched.
+// A field with the polynomial arithmetic has no such lazy form, its expressions are
+// evaluated node by node with the element operations of the field.
+// --------------------------------------------------------------------------------------
+
+/**
+ * The base of every expression (CRTP).
+ * An expression E has the constants DEGREE and WEIGHT (its unreduced value is smaller than
+ * WEIGHT * order^DEGREE), HAS_FIELD, and the methods field(), lazy(reducer) and
+ * eager(field), which evaluates it in a field with the polynomial arithmetic.
+ * @tparam E the expression type.
+ */
+template<class E>
+class GFExpr
+{
+public:
+    /**
+     * @return this as the concrete expression.
+     */
+    const E &self() const
+    { return static_cast<const E &>(*this); }
+
+    /**
+     * Evaluates the expression with a single final reduction.
+     * @return the value of the expression.
+     */
+    GFNumber evaluate() const
+    {
+        GFieldId field = self().field();
+        const GField &gField = GFieldRegistry::get(field);
+        if (gField.getExtension() != nullptr)
+        {
+            return GFNumber((long) self().eager(gField).getResidue() , field , GFNumber::Reduced());
+        }
+        const ModReducer &reducer = gField.getReducer();
+        unsigned __int128 value = self().lazy(reducer);
+        bool reduced = (E::DEGREE == 1 && E::WEIGHT == 1);
+        uint64_t n = reduced ? (uint64_t) value : reducer.reduceWide(value);
+        return GFNumber((long) n , field , GFNumber::Reduced());
+    }
+
+    /**
+     * Conversion to a GFNumber, evaluates the expression.
+     * @return the value of the expression.
+     */
+    operator GFNumber() const
+    { return evaluate(); }
+};
+
+/**
+ * A GFNumber operand (a copy of its residue and field id).
+ */
+class GFLeafExpr : public GFExpr<GFLeafExpr>
+{
+private:
+    uint64_t _n; /** The residue. */
+    GFieldId _field; /** The id of the field. */
+public:
+    static constexpr int DEGREE = 1; /** The degree in the order of the bound of the value. */
+    static constexpr int WEIGHT = 1; /** The multiple of order^DEGREE bounding the value. */
+    static constexpr bool HAS_FIELD = true; /** True if the operand carries a field. */
+
+    /**
+     * A constructor.
+     * @param number the operand.
+     */
+    explicit GFLeafExpr(const GFNumber &number) : _n((uint64_t) number._n) , _field(number._field)
+    {}
+
+    /**
+     * @return the id of the field of the expression (0 if it has no field).
+     */
+    GFieldId field() const
+    { return _field; }
+
+    /**
+     * The unreduced value of the expression.
+     * @param reducer the reducer of the field, with the integer arithmetic.
+     * @return a value below WEIGHT * order^DEGREE, congruent to the expression.
+     */
+    unsigned __int128 lazy(const ModReducer &) const
+    { return _n; }
+
+    /**
+     * The value of the expression, computed node by node.
+     * @param field the field of the expression, with the polynomial arithmetic.
+     * @return the element.
+     */
+    GFElement eager(const GField &) const
+    { return GFElement(_n); }
+};
+
+/**
+ * A long operand, reduced into the field of the expression when it is evaluated.
+ */
+class GFScalarExpr : public GFExpr<GFScalarExpr>
+{
+private:
+    long _n; /** The number. */
+public:
+    static constexpr int DEGREE = 1; /** The degree in the order of the bound of the value. */
+    static constexpr int WEIGHT = 1; /** The multiple of order^DEGREE bounding the value. */
+    static constexpr bool HAS_FIELD = false; /** True if the operand carries a field. */
+
+    /**
+     * A constructor.
+     * @param n the operand.
+     */
+    explicit GFScalarExpr(long n) : _n(n)
+    {}
+
+    /**
+     * @return the id of the field of the expression (0 if it has no field).
+     */
+    GFieldId field() const
+    { return 0; }
+
+    /**
+     * The unreduced value of the expression.
+     * @param reducer the reducer of the field, with the integer arithmetic.
+     * @return a value below WEIGHT * order^DEGREE, congruent to the expression.
+     */
+    unsigned __int128 lazy(const ModReducer &reducer) const
+    { return reducer.reduceSigned(_n); }
+
+    /**
+     * The value of the expression, computed node by node.
+     * @param field the field of the expression, with the polynomial arithmetic.
+     * @return the element.
+     */
+    GFElement eager(const GField &field) const
+    { return field.element(_n); }
+};
+
+/**
+ * The field of a binary expression, checks that both operands agree.
+ * @param left the left operand.
+ * @param right the right operand.
+ * @return the id of the field.
+ */
+template<class L , class R>
+GFieldId commonField(const L &left , const R &right)
+{
+    if (!L::HAS_FIELD)
+    {
+        return right.field();
+    }
+    if (!R::HAS_FIELD)
+    {
+        return left.field();
+    }
+    assert(left.field() == right.field()); // numbers from different fields
+    return left.field();
+}
+
+/**
+ * left + right, or left - right when SUBTRACT.
+ * A subtraction adds the multiple of the order which bounds right, so it stays non negative.
+ * When the bound of the sum would not fit in 128 bits both operands are reduced first.
+ */
+template<class L , class R , bool SUBTRACT>
+class GFSumExpr : public GFExpr<GFSumExpr<L , R , SUBTRACT>>
+{
+private:
+    L _left; /** The left operand. */
+    R _right; /** The right operand. */
+    /** The degree of the sum of the unreduced operands. */
+    static constexpr int LAZY_DEGREE = (L::DEGREE > R::DEGREE) ? L::DEGREE : R::DEGREE;
+    /** The sum of the unreduced operands could overflow, they are reduced first. */
+    static constexpr bool REDUCE_OPERANDS = (LAZY_DEGREE == 2 &&
+                                             L::WEIGHT + R::WEIGHT > LAZY_PRODUCTS);
+public:
+    /** The degree in the order of the bound of the value. */
+    static constexpr int DEGREE = REDUCE_OPERANDS ? 1 : LAZY_DEGREE;
+    /** The multiple of order^DEGREE bounding the value. */
+    static constexpr int WEIGHT = REDUCE_OPERANDS ? 2 : L::WEIGHT + R::WEIGHT;
+    /** True if one of the operands carries a field. */
+    static constexpr bool HAS_FIELD = L::HAS_FIELD || R::HAS_FIELD;
+
+    /**
+     * A constructor.
+     * @param left the left operand.
+     * @param right the right operand.
+     */
+    GFSumExpr(const L &left , const R &right) : _left(left) , _right(right)
+    {}
+
+    /**
+     * @return the id of the field of the expression (0 if it has no field).
+     */
+    GFieldId field() const
+    { return commonField(_left , _right); }
+
+    /**
+     * The unreduced value of the expression.
+     * @param reducer the reducer of the field, with the integer arithmetic.
+     * @return a value below WEIGHT * order^DEGREE, congruent to the expression.
+     */
+    unsigned __int128 lazy(const ModReducer &reducer) const
+    {
+        unsigned __int128 left = _left.lazy(reducer) , right = _right.lazy(reducer);
+        unsigned __int128 q = reducer.getModulus() , bound = q;
+        if (REDUCE_OPERANDS)
+        {
+            left = reducer.reduceWide(left);
+            right = reducer.reduceWide(right);
+        }
+        else
+        {
+            bound = (R::DEGREE == 2) ? R::WEIGHT * q * q : R::WEIGHT * q;
+        }
+        return SUBTRACT ? left + bound - right : left + right;
+    }
+
+    /**
+     * The value of the expression, computed node by node.
+     * @param field the field of the expression, with the polynomial arithmetic.
+     * @return the element.
+     */
+    GFElement eager(const GField &field) const
+    {
+        GFElement left = _left.eager(field) , right = _right.eager(field);
+        return SUBTRACT ? field.sub(left , right) : field.add(left , right);
+    }
+};
+
+/**
+ * left * right. An operand is kept unreduced when it fits in 64 bits (below 2 * order),
+ * otherwise it is reduced first, so the product is always below 4 * order^2.
+ */
+template<class L , class R>
+class GFProductExpr : public GFExpr<GFProductExpr<L , R>>
+{
+private:
+    L _left; /** The left operand. */
+    R _right; /** The right operand. */
+    /** The left operand is below 2 * order, it is multiplied unreduced. */
+    static constexpr bool LAZY_LEFT = (L::DEGREE == 1 && L::WEIGHT <= 2);
+    /** The right operand is below 2 * order, it is multiplied unreduced. */
+    static constexpr bool LAZY_RIGHT = (R::DEGREE == 1 && R::WEIGHT <= 2);
+public:
+    /** The degree in the order of the bound of the value. */
+    static constexpr int DEGREE = 2;
+    /** The multiple of order^DEGREE bounding the value. */
+    static constexpr int WEIGHT = (LAZY_LEFT ? L::WEIGHT : 1) * (LAZY_RIGHT ? R::WEIGHT : 1);
+    /** True if one of the operands carries a field. */
+    static constexpr bool HAS_FIELD = L::HAS_FIELD || R::HAS_FIELD;
+
+    /**
+     * A constructor.
+     * @param left the left operand.
+     * @param right the right operand.
+     */
+    GFProductExpr(const L &left , const R &right) : _left(left) , _right(right)
+    {}
+
+    /**
+     * @return the id of the field of the expression (0 if it has no field).
+     */
+    GFieldId field() const
+    { return commonField(_left , _right); }
+
+    /**
+     * The unreduced value of the expression.
+     * @param reducer the reducer of the field, with the integer arithmetic.
+     * @return a value below WEIGHT * order^DEGREE, congruent to the expression.
+     */
+    unsigned __int128 lazy(const ModReducer &reducer) const
+    {
+        unsigned __int128 left = _left.lazy(reducer) , right = _right.lazy(reducer);
+        uint64_t a = LAZY_LEFT ? (uint64_t) left : reducer.reduceWide(left);
+        uint64_t b = LAZY_RIGHT ? (uint64_t) right : reducer.reduceWide(right);
+        return (unsigned __int128) a * b;
+    }
+
+    /**
+     * The value of the expression, computed node by node.
+     * @param field the field of the expression, with the polynomial arithmetic.
+     * @return the element.
+     */
+    GFElement eager(const GField &field) const
+    { return field.mul(_left.eager(field) , _right.eager(field)); }
+};
+
+/**
+ * Maps an operand type to its expression type: expressions stay as they are, GFNumbers
+ * become leaves and integers become scalars.
+ */
+template<class T , class Enable = void>
+struct GFExprOf
+{
+};
+
+/**
+ * An expression operand is its own expression.
+ */
+template<class T>
+struct GFExprOf<T , typename std::enable_if<std::is_base_of<GFExpr<T> , T>::value>::type>
+{
+    typedef T type; /** The expression type. */
+
+    /**
+     * @param expr an expression.
+     * @return the expression itself.
+     */
+    static const T &wrap(const T &expr)
+    { return expr; }
+};
+
+/**
+ * A GFNumber operand becomes a leaf.
+ */
+template<>
+struct GFExprOf<GFNumber>
+{
+    typedef GFLeafExpr type; /** The expression type. */
+
+    /**
+     * @param number a GFNumber.
+     * @return the leaf of the number.
+     */
+    static GFLeafExpr wrap(const GFNumber &number)
+    { return GFLeafExpr(number); }
+};
+
+/**
+ * An integer operand becomes a scalar.
+ */
+template<class T>
+struct GFExprOf<T , typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    typedef GFScalarExpr type; /** The expression type. */
+
+    /**
+     * @param n an integer.
+     * @return the scalar of the integer.
+     */
+    static GFScalarExpr wrap(T n)
+    { return GFScalarExpr((long) n); }
+};
+
+/** The operators are only enabled when one of the operands is an expression. */
+template<class A , class B>
+using GFExprEnable = typename std::enable_if<std::is_base_of<GFExpr<A> , A>::value ||
+                                             std::is_base_of<GFExpr<B> , B>::value>::type;
+
+/**
+ * Starts an expression.
+ * @param number a GFNumber.
+ * @return the number as an expression, its operators record instead of computing.
+ */
+inline GFLeafExpr lazy(const GFNumber &number)
+{
+    return GFLeafExpr(number);
+}
+
+/**
+ * Records a + b.
+ * @param a an expression, a GFNumber or an integer.
+ * @param b an expression, a GFNumber or an integer (one of a and b is an expression).
+ * @return the expression of a + b, evaluated when it is converted to a GFNumber.
+ */
+template<class A , class B , class = GFExprEnable<A , B>>
+GFSumExpr<typename GFExprOf<A>::type , typename GFExprOf<B>::type , false>
+operator+(const A &a , const B &b)
+{
+    return {GFExprOf<A>::wrap(a) , GFExprOf<B>::wrap(b)};
+}
+
+/**
+ * Records a - b.
+ * @param a an expression, a GFNumber or an integer.
+ * @param b an expression, a GFNumber or an integer (one of a and b is an expression).
+ * @return the expression of a - b, evaluated when it is converted to a GFNumber.
+ */
+template<class A , class B , class = GFExprEnable<A , B>>
+GFSumExpr<typename GFExprOf<A>::type , typename GFExprOf<B>::type , true>
+operator-(const A &a , const B &b)
+{
+    return {GFExprOf<A>::wrap(a) , GFExprOf<B>::wrap(b)};
+}
+
+/**
+ * Records a * b.
+ * @param a an expression, a GFNumber or an integer.
+ * @param b an expression, a GFNumber or an integer (one of a and b is an expression).
+ * @return the expression of a * b, evaluated when it is converted to a GFNumber.
+ */
+template<class A , class B , class = GFExprEnable<A , B>>
+GFProductExpr<typename GFExprOf<A>::type , typename GFExprOf<B>::type>
+operator*(const A &a , const B &b)
+{
+    return {GFExprOf<A>::wrap(a) , GFExprOf<B>::wrap(b)};
+}
+
+#endif //GFEXPR_HPP
@@ -0,0 +1,772 @@
+// GFExtension.cpp
+
+#include "GFExtension.h"
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "GField.h"
+
+#define NIBBLE_BITS 4 /** the bits of the multiplier handled by one carry-less step */
+#define NARROW_BINARY_DEGREE 32 /** binary products of smaller degrees fit in 64 bits */
+#define SPLIT_TABLE_LENGTH 64 /** scaleAdd builds the byte tables of the scalar from this length */
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class GFExtension.
+// --------------------------------------------------------------------------------------
+
+/** Guards the shared extensions. */
+static std::mutex extensionsMutex;
+
+/**
+ * @return the shared extensions by (p, l, modulus), the modulus 0 stands for the one found by
+ * findIrreducible().
+ */
+static std::map<std::tuple<uint64_t , int , uint64_t> , const GFExtension *> &extensions()
+{
+    static std::map<std::tuple<uint64_t , int , uint64_t> , const GFExtension *> shared;
+    return shared;
+}
+
+/**
+ * Carry-less multiplication of two bit vectors, four bits of b at a time against the
+ * multiples of a by every polynomial of degree below 4.
+ * @tparam Word an unsigned type wide enough for the product.
+ * @param a a bit vector of at most bits bits.
+ * @param b a bit vector of at most bits bits.
+ * @param bits the length of a and b, at most 62.
+ * @return the bit vector of the polynomial product a * b.
+ */
+template<class Word>
+static Word carrylessMultiply(uint64_t a , uint64_t b , int bits)
+{
+    Word multiples[1 << NIBBLE_BITS];
+    multiples[0] = 0;
+    multiples[1] = a;
+    for (int k = 2; k < (1 << NIBBLE_BITS); k += 2)
+    {
+        multiples[k] = multiples[k / 2] << 1;
+        multiples[k + 1] = multiples[k] ^ a;
+    }
+    Word product = 0;
+    for (int shift = (bits - 1) & ~(NIBBLE_BITS - 1); shift >= 0; shift -= NIBBLE_BITS)
+    {
+        product = (product << NIBBLE_BITS) ^ multiples[(b >> shift) & ((1 << NIBBLE_BITS) - 1)];
+    }
+    return product;
+}
+
+// ------------------------------- binary kernels -------------------------------
+
+/**
+ * Reduces a carry-less product by the byte reduction tables.
+ * @param product the bit vector of the product, of degree at most 2l - 2.
+ * @return the product mod f.
+ */
+static uint64_t tableReduce(unsigned __int128 product , const BinaryModulus &m)
+{
+    uint64_t result = (uint64_t) product & ((1ull << m.l) - 1);
+    const uint64_t *table = m.table;
+    for (uint64_t high = (uint64_t) (product >> m.l); high != 0; high >>= GF_REDUCTION_BITS)
+    {
+        result ^= table[high & ((1u << GF_REDUCTION_BITS) - 1)];
+        table += 1u << GF_REDUCTION_BITS;
+    }
+    return result;
+}
+
+/**
+ * The portable product of two elements of GF(2^l): a carry-less multiplication in 64 bits
+ * (128 bits above NARROW_BINARY_DEGREE) reduced by the byte tables.
+ * @param a element, a bit vector of degree below l.
+ * @param b element, a bit vector of degree below l.
+ * @return a * b mod f, of degree below l.
+ */
+static uint64_t scalarMul(uint64_t a , uint64_t b , const BinaryModulus &m)
+{
+    return tableReduce((m.l <= NARROW_BINARY_DEGREE) ? carrylessMultiply<uint64_t>(a , b , m.l) :
+                       carrylessMultiply<unsigned __int128>(a , b , m.l) , m);
+}
+
+/**
+ * The portable accumulator[i] += a[i] * b[i] (an exclusive or in characteristic 2).
+ * @param a elements of degree below l.
+ * @param b elements of degree below l.
+ * @param accumulator elements of degree below l, they stay below l.
+ * @param n the number of elements.
+ */
+static void scalarMulAdd(const uint64_t *a , const uint64_t *b , uint64_t *accumulator ,
+                         size_t n , const BinaryModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        accumulator[i] ^= scalarMul(a[i] , b[i] , m);
+    }
+}
+
+/**
+ * Multiplying by a fixed scalar is linear over GF(2), so a long buffer is multiplied by
+ * tables of the scalar times every byte at every position: s * a is the sum of
+ * split[j][byte j of a]. Building them costs 8 products per byte of an element.
+ */
+static void scalarScaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator ,
+                           size_t n , const BinaryModulus &m)
+{
+    if (n < SPLIT_TABLE_LENGTH)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            accumulator[i] ^= scalarMul(scalar , a[i] , m);
+        }
+        return;
+    }
+    const int bytes = (m.l + 7) / 8;
+    uint64_t split[8][256];
+    for (int j = 0; j < bytes; j++)
+    {
+        split[j][0] = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            int shift = 8 * j + bit;
+            uint64_t product = (shift < m.l) ? scalarMul(scalar , 1ull << shift , m) : 0;
+            for (int v = 0; v < (1 << bit); v++)
+            {
+                split[j][(1 << bit) + v] = split[j][v] ^ product;
+            }
+        }
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t product = 0;
+        for (int j = 0; j < bytes; j++)
+        {
+            product ^= split[j][(a[i] >> (8 * j)) & 0xFF];
+        }
+        accumulator[i] ^= product;
+    }
+}
+
+/**
+ * The portable kernels.
+ * @return the table.
+ */
+const GFBinaryKernels *scalarBinaryKernels()
+{
+    static const GFBinaryKernels kernels = {"scalar" , scalarMul , scalarMulAdd , scalarScaleAdd};
+    return &kernels;
+}
+
+/**
+ * Looks up the binary kernels of an instruction set.
+ * @param name "pclmul", "scalar" or nullptr for the best one the cpu supports.
+ * @return the kernels, or nullptr if the cpu does not support them.
+ */
+static const GFBinaryKernels *findBinaryKernels(const char *name)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool hasClmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1") &&
+                    clmulBinaryKernels() != nullptr;
+#else
+    bool hasClmul = false;
+#endif
+    if (name == nullptr)
+    {
+        return hasClmul ? clmulBinaryKernels() : scalarBinaryKernels();
+    }
+    if (strcmp(name , "pclmul") == 0)
+    {
+        return hasClmul ? clmulBinaryKernels() : nullptr;
+    }
+    return (strcmp(name , "scalar") == 0) ? scalarBinaryKernels() : nullptr;
+}
+
+/**
+ * The binary kernels in use, the best ones the cpu supports unless selectBinaryKernels was
+ * called (a function so that fields built during static initialization find them).
+ * @return a reference to the kernels.
+ */
+static const GFBinaryKernels *&activeBinaryKernels()
+{
+    static const GFBinaryKernels *kernels = findBinaryKernels(nullptr);
+    return kernels;
+}
+
+/**
+ * The name of the instruction set of the binary kernels in use ("pclmul" or "scalar").
+ * @return the name.
+ */
+const char *GFExtension::binaryKernelName()
+{
+    return activeBinaryKernels()->name;
+}
+
+/**
+ * Forces the binary kernels of the given instruction set, for tests and benchmarks.
+ * Not thread safe, call it before using the binary fields.
+ * @param name "pclmul", "scalar" or nullptr for the best one the cpu supports.
+ * @return false if the cpu does not support it (the kernels are left unchanged).
+ */
+bool GFExtension::selectBinaryKernels(const char *name)
+{
+    const GFBinaryKernels *kernels = findBinaryKernels(name);
+    if (kernels == nullptr)
+    {
+        return false;
+    }
+    activeBinaryKernels() = kernels;
+    return true;
+}
+
+// ------------------------------- GFExtension -------------------------------
+
+/**
+ * Removes the zero leading coefficients of a polynomial.
+ * @param polynomial the coefficients, the constant first.
+ */
+static void trim(std::vector<uint64_t> &polynomial)
+{
+    while (!polynomial.empty() && polynomial.back() == 0)
+    {
+        polynomial.pop_back();
+    }
+}
+
+/**
+ * Euclid's algorithm on two polynomials over GF(p).
+ * @param u the coefficients of a polynomial, the constant first.
+ * @param v the coefficients of a polynomial, the constant first.
+ * @param reducer reduction modulo p.
+ * @return true if gcd(u, v) = 1.
+ */
+static bool coprime(std::vector<uint64_t> u , std::vector<uint64_t> v , const ModReducer &reducer)
+{
+    trim(u);
+    trim(v);
+    while (!u.empty())
+    {
+        // v = v mod u
+        uint64_t leadInverse = GField::modInverse(u.back() , reducer.getModulus());
+        while (v.size() >= u.size())
+        {
+            uint64_t factor = reducer.mulMod(v.back() , leadInverse);
+            size_t shift = v.size() - u.size();
+            for (size_t i = 0; i < u.size(); i++)
+            {
+                v[shift + i] = reducer.subMod(v[shift + i] , reducer.mulMod(factor , u[i]));
+            }
+            trim(v);
+        }
+        std::swap(u , v);
+    }
+    return v.size() == 1;
+}
+
+/**
+ * A constructor, builds the reduction table (the modulus does not have to be
+ * irreducible, the elements then form a ring and get() refuses it).
+ * @param p a prime.
+ * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+ * @param modulus f - x^l, packed like an element, with a non zero constant coefficient.
+ */
+GFExtension::GFExtension(uint64_t p , int l , uint64_t modulus) :
+        _p(p) , _l(l) , _modulus(modulus) , _order(1) , _binary(p == 2) ,
+        _pInverse(UINT64_MAX / p) , _reducer(p) , _binaryModulus() , _group(0)
+{
+    assert(l >= 2 && l <= GF_MAX_DEGREE);
+    for (int i = 0; i < l; i++)
+    {
+        bool overflow = __builtin_mul_overflow(_order , p , &_order) || _order > INT64_MAX;
+        assert(!overflow && "the order of the field must fit in a long");
+        (void) overflow;
+    }
+    assert(modulus < _order && modulus % p != 0);
+    _orderReducer = ModReducer(_order);
+    _initReduction();
+}
+
+/**
+ * Builds the reduction table of the modulus.
+ */
+void GFExtension::_initReduction()
+{
+    if (_binary)
+    {
+        // table j holds v * x^(l + 8j) mod f for every byte v
+        const unsigned __int128 f = ((unsigned __int128) 1 << _l) | _modulus;
+        int chunks = (_l - 1 + GF_REDUCTION_BITS - 1) / GF_REDUCTION_BITS;
+        _reduction.resize((size_t) chunks << GF_REDUCTION_BITS);
+        for (int j = 0; j < chunks; j++)
+        {
+            for (uint64_t v = 0; v < (1u << GF_REDUCTION_BITS); v++)
+            {
+                unsigned __int128 r = (unsigned __int128) v << (_l + GF_REDUCTION_BITS * j);
+                for (int bit = _l + GF_REDUCTION_BITS * (j + 1) - 1; bit >= _l; bit--)
+                {
+                    if ((r >> bit) & 1)
+                    {
+                        r ^= f << (bit - _l);
+                    }
+                }
+                _reduction[((size_t) j << GF_REDUCTION_BITS) + v] = (uint64_t) r;
+            }
+        }
+        // mu = x^(2l) / f by long division
+        unsigned __int128 rest = (unsigned __int128) 1 << (2 * _l);
+        uint64_t mu = 0;
+        for (int bit = _l; bit >= 0; bit--)
+        {
+            if ((rest >> (_l + bit)) & 1)
+            {
+                rest ^= f << bit;
+                mu |= 1ull << bit;
+            }
+        }
+        _binaryModulus = BinaryModulus{_l , (uint64_t) f , mu , _reduction.data()};
+        return;
+    }
+    // x^l = -(f - x^l), up to the highest non zero coefficient of f - x^l
+    uint64_t g[GF_MAX_DEGREE] = {};
+    _unpack(_modulus , g);
+    int degree = _l - 1;
+    while (degree > 0 && g[degree] == 0)
+    {
+        degree--;
+    }
+    for (int j = 0; j <= degree; j++)
+    {
+        _reduction.push_back(_reducer.subMod(0 , g[j]));
+    }
+}
+
+/**
+ * Divides by p without a division instruction or a branch.
+ * @param a a number.
+ * @param remainder output, a mod p.
+ * @return a / p.
+ */
+uint64_t GFExtension::_divideByChar(uint64_t a , uint64_t *remainder) const
+{
+    // the estimated quotient is at most 2 below the real one
+    uint64_t q = (uint64_t) (((unsigned __int128) a * _pInverse) >> 64);
+    uint64_t r = a - q * _p;
+    for (int i = 0; i < 2; i++)
+    {
+        uint64_t carry = (r >= _p);
+        q += carry;
+        r -= carry * _p;
+    }
+    *remainder = r;
+    return q;
+}
+
+/**
+ * Splits an element into its coefficients.
+ * @param a an element.
+ * @param coefficients output, the l coefficients of a, the constant first.
+ */
+void GFExtension::_unpack(uint64_t a , uint64_t *coefficients) const
+{
+    for (int i = 0; i < _l; i++)
+    {
+        a = _divideByChar(a , &coefficients[i]);
+    }
+}
+
+/**
+ * Packs coefficients into an element.
+ * @param coefficients l coefficients in [0, p), the constant first.
+ * @return the element.
+ */
+uint64_t GFExtension::_pack(const uint64_t *coefficients) const
+{
+    uint64_t a = 0;
+    for (int i = _l - 1; i >= 0; i--)
+    {
+        a = a * _p + coefficients[i];
+    }
+    return a;
+}
+
+/**
+ * Multiplies two coefficient vectors over the integers, by Karatsuba for
+ * GF_KARATSUBA_DEGREE coefficients or more and by the schoolbook method below. Nothing is
+ * reduced modulo p: Karatsuba only runs when p^32 < 2^63 (so p = 3) and the exact
+ * coefficients stay far below 2^64, the schoolbook ones are below l (p - 1)^2 < 2^64.
+ * @param a n coefficients.
+ * @param b n coefficients.
+ * @param n the length of a and b.
+ * @param product output, the 2n - 1 coefficients of a * b.
+ */
+void GFExtension::_multiplyCoefficients(const uint64_t *a , const uint64_t *b , int n ,
+                                        uint64_t *product) const
+{
+    for (int k = 0; k < 2 * n - 1; k++)
+    {
+        product[k] = 0;
+    }
+    if (n < GF_KARATSUBA_DEGREE)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                product[i + j] += a[i] * b[j];
+            }
+        }
+        return;
+    }
+    // a = a0 + x^half a1, a * b = P0 + x^half ((a0 + a1)(b0 + b1) - P0 - P2) + x^2half P2
+    const int half = n / 2 , high = n - half;
+    uint64_t sumA[GF_MAX_DEGREE] , sumB[GF_MAX_DEGREE];
+    uint64_t low[2 * GF_MAX_DEGREE] , middle[2 * GF_MAX_DEGREE] , top[2 * GF_MAX_DEGREE];
+    for (int i = 0; i < high; i++)
+    {
+        sumA[i] = ((i < half) ? a[i] : 0) + a[half + i];
+        sumB[i] = ((i < half) ? b[i] : 0) + b[half + i];
+    }
+    _multiplyCoefficients(a , b , half , low);
+    _multiplyCoefficients(a + half , b + half , high , top);
+    _multiplyCoefficients(sumA , sumB , high , middle);
+    for (int k = 0; k < 2 * half - 1; k++)
+    {
+        product[k] += low[k];
+        middle[k] -= low[k];
+    }
+    for (int k = 0; k < 2 * high - 1; k++)
+    {
+        product[half + k] += middle[k] - top[k];
+        product[2 * half + k] += top[k];
+    }
+}
+
+/**
+ * Reduces a product of two elements by x^l mod f (p odd): from the highest coefficient
+ * down, the coefficient c of x^k, k >= l, is replaced by c x^(k - l) (x^l mod f). Only the
+ * non zero part of x^l mod f is used, which is short for the moduli findIrreducible finds.
+ * @param product the 2l - 1 coefficients of the product (over the integers), overwritten.
+ * @return the product mod f, packed.
+ */
+uint64_t GFExtension::_reduceCoefficients(uint64_t *product) const
+{
+    // a coefficient then gets at most l - 1 products of two residues, which fit in 64 bits
+    for (int k = 0; k < 2 * _l - 1; k++)
+    {
+        product[k] = _reducer.reduce(product[k]);
+    }
+    const uint64_t *tail = _reduction.data();
+    const int terms = (int) _reduction.size();
+    for (int k = 2 * _l - 2; k >= _l; k--)
+    {
+        uint64_t c = _reducer.reduce(product[k]);
+        for (int j = 0; j < terms; j++)
+        {
+            product[k - _l + j] += c * tail[j];
+        }
+    }
+    for (int j = 0; j < _l; j++)
+    {
+        product[j] = _reducer.reduce(product[j]);
+    }
+    return _pack(product);
+}
+
+/**
+ * Adds or subtracts two elements coefficient by coefficient (p odd).
+ * @param a an element.
+ * @param b an element.
+ * @param subtract whether to compute a - b instead of a + b.
+ * @return a + b or a - b.
+ */
+uint64_t GFExtension::_addDigits(uint64_t a , uint64_t b , bool subtract) const
+{
+    uint64_t result = 0 , power = 1;
+    for (int i = 0; i < _l && (a | b) != 0; i++)
+    {
+        uint64_t ra , rb;
+        a = _divideByChar(a , &ra);
+        b = _divideByChar(b , &rb);
+        result += (subtract ? _reducer.subMod(ra , rb) : _reducer.addMod(ra , rb)) * power;
+        power *= _p;
+    }
+    return result;
+}
+
+/**
+ * Converts a number to an element: a non negative number is read as the digits of its
+ * coefficients (modulo p^l), a negative one is the negation of the element of -n.
+ * @param n long number.
+ * @return the element.
+ */
+uint64_t GFExtension::element(long n) const
+{
+    if (n >= 0)
+    {
+        return _orderReducer.reduce((uint64_t) n);
+    }
+    return neg(_orderReducer.reduce(0 - (uint64_t) n));
+}
+
+/**
+ * Multiplies two elements as polynomials.
+ * @param a an element.
+ * @param b an element.
+ * @return a * b mod f.
+ */
+uint64_t GFExtension::_mulPolynomial(uint64_t a , uint64_t b) const
+{
+    if (_binary)
+    {
+        return activeBinaryKernels()->mul(a , b , _binaryModulus);
+    }
+    uint64_t x[GF_MAX_DEGREE] , y[GF_MAX_DEGREE] , product[2 * GF_MAX_DEGREE];
+    _unpack(a , x);
+    _unpack(b , y);
+    _multiplyCoefficients(x , y , _l , product);
+    return _reduceCoefficients(product);
+}
+
+/**
+ * Multiply-accumulate over buffers, by the binary kernels for p = 2.
+ * @param a n elements.
+ * @param b n elements.
+ * @param accumulator n elements, accumulator[i] += a[i] * b[i] (may alias a or b).
+ * @param n the length of the buffers.
+ */
+void GFExtension::mulAdd(const uint64_t *a , const uint64_t *b , uint64_t *accumulator ,
+                         size_t n) const
+{
+    if (_binary && _group == 0)
+    {
+        activeBinaryKernels()->mulAdd(a , b , accumulator , n , _binaryModulus);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        accumulator[i] = add(accumulator[i] , mul(a[i] , b[i]));
+    }
+}
+
+/**
+ * Scaled accumulate over a buffer, by the binary kernels for p = 2.
+ * @param scalar an element.
+ * @param a n elements.
+ * @param accumulator n elements, accumulator[i] += scalar * a[i] (may alias a).
+ * @param n the length of the buffers.
+ */
+void GFExtension::scaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator ,
+                           size_t n) const
+{
+    if (_binary && _group == 0)
+    {
+        activeBinaryKernels()->scaleAdd(scalar , a , accumulator , n , _binaryModulus);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        accumulator[i] = add(accumulator[i] , mul(scalar , a[i]));
+    }
+}
+
+/**
+ * Square-and-multiply exponentiation (g^(log(a) exponent) with the log tables).
+ * @param a an element.
+ * @param exponent the exponent.
+ * @return a^exponent (1 for a zero exponent).
+ */
+uint64_t GFExtension::pow(uint64_t a , uint64_t exponent) const
+{
+    if (_group != 0 && a != 0)
+    {
+        return _exp[(uint64_t) (((unsigned __int128) _log[a] * exponent) % _group)];
+    }
+    uint64_t result = 1;
+    for (; exponent != 0; exponent >>= 1)
+    {
+        if (exponent & 1)
+        {
+            result = mul(result , a);
+        }
+        a = mul(a , a);
+    }
+    return result;
+}
+
+/**
+ * The multiplicative inverse, a^(p^l - 2) (g^-log(a) with the log tables).
+ * @param a an element.
+ * @return the inverse of a, or 0 if a is 0.
+ */
+uint64_t GFExtension::inverse(uint64_t a) const
+{
+    if (_group != 0 && a != 0)
+    {
+        return _exp[(_log[a] == 0) ? 0 : _group - _log[a]];
+    }
+    return (a == 0) ? 0 : pow(a , _order - 2);
+}
+
+/**
+ * Builds the log, antilog and Zech logarithm tables, the modulus must be irreducible.
+ */
+void GFExtension::_initLogTables()
+{
+    // g generates the multiplicative group when g^((q - 1) / r) != 1 for every prime r | q - 1
+    const uint32_t group = (uint32_t) (_order - 1);
+    std::vector<uint32_t> primes;
+    uint32_t rest = group;
+    for (uint32_t r = 2; r * r <= rest; r++)
+    {
+        if (rest % r == 0)
+        {
+            primes.push_back(r);
+            while (rest % r == 0)
+            {
+                rest /= r;
+            }
+        }
+    }
+    if (rest > 1)
+    {
+        primes.push_back(rest);
+    }
+    uint64_t g = 2;
+    for (;; g++)
+    {
+        bool generator = true;
+        for (uint32_t r : primes)
+        {
+            generator = generator && pow(g , group / r) != 1;
+        }
+        if (generator)
+        {
+            break;
+        }
+    }
+    _exp.resize(group);
+    _log.resize(_order);
+    _log[0] = (uint16_t) group;
+    uint64_t power = 1;
+    for (uint32_t n = 0; n < group; n++)
+    {
+        _exp[n] = (uint16_t) power;
+        _log[power] = (uint16_t) n;
+        power = _mulPolynomial(power , g);
+    }
+    if (!_binary)
+    {
+        _zech.resize(group);
+        for (uint32_t n = 0; n < group; n++)
+        {
+            uint64_t sum = _addDigits(1 , _exp[n] , false);
+            _zech[n] = (sum == 0) ? (uint16_t) group : _log[sum];
+        }
+    }
+    _group = group;
+}
+
+/**
+ * Ben-Or's irreducibility test: f is irreducible when gcd(x^(p^i) - x, f) = 1 for every
+ * i up to l / 2.
+ * @param p a prime.
+ * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+ * @param modulus f - x^l, packed like an element.
+ * @return true if f is irreducible over GF(p).
+ */
+bool GFExtension::isIrreducible(uint64_t p , int l , uint64_t modulus)
+{
+    if (modulus % p == 0)
+    {
+        return false; // x divides f
+    }
+    GFExtension ring(p , l , modulus);
+    std::vector<uint64_t> f(l + 1) , g(l);
+    ring._unpack(modulus , f.data());
+    f[l] = 1;
+    // the element x is the packed number p, x^(p^i) is x^(p^(i - 1)) to the power p
+    uint64_t power = p;
+    for (int i = 1; i <= l / 2; i++)
+    {
+        power = ring.pow(power , p);
+        ring._unpack(ring.sub(power , p) , g.data());
+        if (!coprime(g , f , ring._reducer))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The irreducible polynomial of degree l whose packed form is the smallest one
+ * (x^8 + x^4 + x^3 + x + 1 for GF(2^8), the modulus of AES).
+ * @param p a prime.
+ * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+ * @return f - x^l, packed like an element.
+ */
+uint64_t GFExtension::findIrreducible(uint64_t p , int l)
+{
+    // one polynomial in about l is irreducible, so the search ends quickly
+    for (uint64_t modulus = 1;; modulus++)
+    {
+        if (modulus % p != 0 && isIrreducible(p , l , modulus))
+        {
+            return modulus;
+        }
+    }
+}
+
+/**
+ * The shared extension of a modulus, built on first use (with its log tables when the
+ * order is at most GF_LOG_TABLE_ORDER). The modulus is checked by isIrreducible when the
+ * extension is built.
+ * @param p a prime.
+ * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+ * @param modulus f - x^l, packed like an element.
+ * @return the extension, valid until the end of the program, or nullptr if f is reducible.
+ */
+const GFExtension *GFExtension::get(uint64_t p , int l , uint64_t modulus)
+{
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    const GFExtension *&extension = extensions()[std::make_tuple(p , l , modulus)];
+    if (extension == nullptr)
+    {
+        // a reducible f has zero divisors, the generator search of the log tables never ends
+        if (!isIrreducible(p , l , modulus))
+        {
+            extensions().erase(std::make_tuple(p , l , modulus));
+            return nullptr;
+        }
+        GFExtension *built = new GFExtension(p , l , modulus);
+        if (built->_order <= GF_LOG_TABLE_ORDER)
+        {
+            built->_initLogTables();
+        }
+        extension = built;
+    }
+    return extension;
+}
+
+/**
+ * The shared extension of the irreducible polynomial found by findIrreducible(), which
+ * is only searched once for every p and l.
+ * @param p a prime.
+ * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+ * @return the extension, valid until the end of the program.
+ */
+const GFExtension *GFExtension::get(uint64_t p , int l)
+{
+    {
+        std::lock_guard<std::mutex> lock(extensionsMutex);
+        auto found = extensions().find(std::make_tuple(p , l , (uint64_t) 0));
+        if (found != extensions().end())
+        {
+            return found->second;
+        }
+    }
+    const GFExtension *extension = get(p , l , findIrreducible(p , l));
+    std::lock_guard<std::mutex> lock(extensionsMutex);
+    extensions()[std::make_tuple(p , l , (uint64_t) 0)] = extension;
+    return extension;
+}
@@ -0,0 +1,368 @@
+// GFExtension.h
+//----------- include guards------------
+#ifndef GFEXTENSION_H
+#define GFEXTENSION_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GFBinaryKernels.h"
+#include "ModReducer.h"
+
+#define GF_MAX_DEGREE 62 /** the largest degree whose order p^l fits in a long */
+#define GF_KARATSUBA_DEGREE 32 /** coefficient vectors at least this long are split in halves */
+#define GF_REDUCTION_BITS 8 /** the bits of a binary product reduced by one table lookup */
+#define GF_LOG_TABLE_ORDER 65536 /** fields up to this order use log and antilog tables */
+
+//--------------------------------------
+
+/**
+ *  A GFExtension class.
+ *  The arithmetic of the field GF(p^l), l >= 2: the polynomials of degree below l over GF(p)
+ *  modulo a monic irreducible polynomial f of degree l. An element is packed into a single
+ *  integer, the coefficient of x^i being its i-th digit in base p, so the elements are the
+ *  numbers of [0, p^l) and for p = 2 an element is the bit vector of its coefficients
+ *  (0x53 is x^6 + x^4 + x + 1). The modulus is given in the same form, without its x^l term.
+ *  A product of degree up to 2l - 2 is reduced with a table precomputed from the modulus: for
+ *  p = 2 the high part is reduced GF_REDUCTION_BITS bits at a time by the values of those bits
+ *  times x^(l + 8j) mod f, otherwise the coefficients of x^k, k >= l, are folded down from the
+ *  highest one by x^l mod f, kept up to its highest non zero coefficient (a few terms for the
+ *  moduli findIrreducible finds). Binary products are carry-less multiplications of the bit
+ *  vectors (PCLMULQDQ with a Barrett reduction when the cpu has it, see GFBinaryKernels.h,
+ *  otherwise a 4 bit window and the byte tables), the others multiply the coefficient vectors
+ *  over the integers, by Karatsuba once they have GF_KARATSUBA_DEGREE coefficients, and
+ *  reduce them modulo p once at the end.
+ *  The shared extensions of order up to GF_LOG_TABLE_ORDER also get log and antilog tables
+ *  of a generator g of the multiplicative group (16 bit entries, at most 128KB each, so they
+ *  stay in L2): a * b = g^(log a + log b) and the inverse and powers are single lookups too.
+ *  For p odd, where adding the digits is a loop, sums use the Zech logarithms Z(n), defined
+ *  by g^Z(n) = 1 + g^n, so g^m + g^n = g^(m + Z(n - m)).
+ *  Extensions are built once per modulus and shared (see get()), they are never freed.
+ */
+class GFExtension
+{
+private:
+    uint64_t _p; /** The characteristic. */
+    int _l; /** The degree. */
+    uint64_t _modulus; /** f - x^l, packed like an element. */
+    uint64_t _order; /** p^l. */
+    bool _binary; /** p = 2, an element is the bit vector of its coefficients. */
+    uint64_t _pInverse; /** floor((2^64 - 1) / p), to extract the digits. */
+    ModReducer _reducer; /** Reduction modulo p. */
+    ModReducer _orderReducer; /** Reduction modulo p^l, of the numbers converted to elements. */
+    std::vector<uint64_t> _reduction; /** The reduction table, see the class comment. */
+    BinaryModulus _binaryModulus; /** The constants of the binary kernels (p = 2). */
+    uint32_t _group; /** p^l - 1 when the field has log tables, 0 otherwise. */
+    std::vector<uint16_t> _log; /** log_g of every element, _log[0] = _group. */
+    std::vector<uint16_t> _exp; /** g^n for n in [0, _group). */
+    std::vector<uint16_t> _zech; /** Z(n) for n in [0, _group), _group where 1 + g^n = 0. */
+
+    /**
+     * Multiplies two elements as polynomials.
+     * @param a an element.
+     * @param b an element.
+     * @return a * b mod f.
+     */
+    uint64_t _mulPolynomial(uint64_t a , uint64_t b) const;
+
+    /**
+     * Multiplies two elements by the log tables.
+     * @param a an element.
+     * @param b an element.
+     * @return a * b.
+     */
+    uint64_t _mulLog(uint64_t a , uint64_t b) const
+    {
+        if (a == 0 || b == 0)
+        {
+            return 0;
+        }
+        uint32_t n = (uint32_t) _log[a] + _log[b];
+        return _exp[(n >= _group) ? n - _group : n];
+    }
+
+    /**
+     * Adds two elements by the Zech logarithms (p odd).
+     * @param a an element.
+     * @param b an element.
+     * @return a + b.
+     */
+    uint64_t _addZech(uint64_t a , uint64_t b) const
+    {
+        if (a == 0 || b == 0)
+        {
+            return a + b;
+        }
+        uint32_t m = _log[a] , n = _log[b];
+        uint32_t z = _zech[(n >= m) ? n - m : n + _group - m];
+        if (z == _group)
+        {
+            return 0; // b = -a
+        }
+        m += z;
+        return _exp[(m >= _group) ? m - _group : m];
+    }
+
+    /**
+     * Negates an element by the log tables (p odd), -1 = g^(_group / 2).
+     * @param a an element.
+     * @return -a.
+     */
+    uint64_t _negLog(uint64_t a) const
+    {
+        if (a == 0)
+        {
+            return 0;
+        }
+        uint32_t n = _log[a] + _group / 2;
+        return _exp[(n >= _group) ? n - _group : n];
+    }
+
+    /**
+     * Builds the log, antilog and Zech logarithm tables, the modulus must be irreducible.
+     */
+    void _initLogTables();
+
+    /**
+     * Divides by p without a division instruction or a branch.
+     * @param a a number.
+     * @param remainder output, a mod p.
+     * @return a / p.
+     */
+    uint64_t _divideByChar(uint64_t a , uint64_t *remainder) const;
+
+    /**
+     * Splits an element into its coefficients.
+     * @param a an element.
+     * @param coefficients output, the l coefficients of a, the constant first.
+     */
+    void _unpack(uint64_t a , uint64_t *coefficients) const;
+
+    /**
+     * Packs coefficients into an element.
+     * @param coefficients l coefficients in [0, p), the constant first.
+     * @return the element.
+     */
+    uint64_t _pack(const uint64_t *coefficients) const;
+
+    /**
+     * Multiplies two coefficient vectors over the integers, by Karatsuba for
+     * GF_KARATSUBA_DEGREE coefficients or more and by the schoolbook method below.
+     * @param a n coefficients.
+     * @param b n coefficients.
+     * @param n the length of a and b.
+     * @param product output, the 2n - 1 coefficients of a * b.
+     */
+    void _multiplyCoefficients(const uint64_t *a , const uint64_t *b , int n ,
+                               uint64_t *product) const;
+
+    /**
+     * Reduces a product of two elements by x^l mod f (p odd).
+     * @param product the 2l - 1 coefficients of the product (over the integers), overwritten.
+     * @return the product mod f, packed.
+     */
+    uint64_t _reduceCoefficients(uint64_t *product) const;
+
+    /**
+     * Adds or subtracts two elements coefficient by coefficient (p odd).
+     * @param a an element.
+     * @param b an element.
+     * @param subtract whether to compute a - b instead of a + b.
+     * @return a + b or a - b.
+     */
+    uint64_t _addDigits(uint64_t a , uint64_t b , bool subtract) const;
+
+    /**
+     * Builds the reduction table of the modulus.
+     */
+    void _initReduction();
+
+public:
+    /**
+     * A constructor, builds the reduction table (the modulus does not have to be
+     * irreducible, the elements then form a ring and get() refuses it).
+     * @param p a prime.
+     * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+     * @param modulus f - x^l, packed like an element, with a non zero constant coefficient.
+     */
+    GFExtension(uint64_t p , int l , uint64_t modulus);
+
+    /**
+     * Extensions are not copied, the binary kernels point into their reduction table.
+     */
+    GFExtension(const GFExtension &other) = delete;
+
+    /**
+     * Extensions are not assigned, see the copy constructor.
+     */
+    GFExtension &operator=(const GFExtension &other) = delete;
+
+    /**
+     * Getter for the characteristic.
+     * @return p.
+     */
+    uint64_t getChar() const
+    { return _p; }
+
+    /**
+     * Getter for the degree.
+     * @return l.
+     */
+    int getDegree() const
+    { return _l; }
+
+    /**
+     * Getter for the modulus.
+     * @return f - x^l, packed like an element.
+     */
+    uint64_t getModulus() const
+    { return _modulus; }
+
+    /**
+     * Whether the field multiplies by log tables, see the class comment.
+     * @return true if the order is at most GF_LOG_TABLE_ORDER and the extension is shared.
+     */
+    bool hasLogTables() const
+    { return _group != 0; }
+
+    /**
+     * Getter for the order.
+     * @return p^l.
+     */
+    uint64_t getOrder() const
+    { return _order; }
+
+    /**
+     * Converts a number to an element: a non negative number is read as the digits of its
+     * coefficients (modulo p^l), a negative one is the negation of the element of -n.
+     * @param n long number.
+     * @return the element.
+     */
+    uint64_t element(long n) const;
+
+    /**
+     * Adds two elements.
+     * @param a an element.
+     * @param b an element.
+     * @return a + b.
+     */
+    uint64_t add(uint64_t a , uint64_t b) const
+    { return _binary ? a ^ b : (_group != 0 ? _addZech(a , b) : _addDigits(a , b , false)); }
+
+    /**
+     * Subtracts two elements.
+     * @param a an element.
+     * @param b an element.
+     * @return a - b.
+     */
+    uint64_t sub(uint64_t a , uint64_t b) const
+    {
+        return _binary ? a ^ b :
+               (_group != 0 ? _addZech(a , _negLog(b)) : _addDigits(a , b , true));
+    }
+
+    /**
+     * Negates an element.
+     * @param a an element.
+     * @return -a.
+     */
+    uint64_t neg(uint64_t a) const
+    { return _binary ? a : (_group != 0 ? _negLog(a) : _addDigits(0 , a , true)); }
+
+    /**
+     * Multiplies two elements.
+     * @param a an element.
+     * @param b an element.
+     * @return a * b mod f.
+     */
+    uint64_t mul(uint64_t a , uint64_t b) const
+    { return (_group != 0) ? _mulLog(a , b) : _mulPolynomial(a , b); }
+
+    /**
+     * Square-and-multiply exponentiation (g^(log(a) exponent) with the log tables).
+     * @param a an element.
+     * @param exponent the exponent.
+     * @return a^exponent (1 for a zero exponent).
+     */
+    uint64_t pow(uint64_t a , uint64_t exponent) const;
+
+    /**
+     * The multiplicative inverse, a^(p^l - 2) (g^-log(a) with the log tables).
+     * @param a an element.
+     * @return the inverse of a, or 0 if a is 0.
+     */
+    uint64_t inverse(uint64_t a) const;
+
+    /**
+     * Multiply-accumulate over buffers, by the binary kernels for p = 2.
+     * @param a n elements.
+     * @param b n elements.
+     * @param accumulator n elements, accumulator[i] += a[i] * b[i] (may alias a or b).
+     * @param n the length of the buffers.
+     */
+    void mulAdd(const uint64_t *a , const uint64_t *b , uint64_t *accumulator , size_t n) const;
+
+    /**
+     * Scaled accumulate over a buffer, by the binary kernels for p = 2.
+     * @param scalar an element.
+     * @param a n elements.
+     * @param accumulator n elements, accumulator[i] += scalar * a[i] (may alias a).
+     * @param n the length of the buffers.
+     */
+    void scaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator , size_t n) const;
+
+    /**
+     * The name of the instruction set of the binary kernels in use ("pclmul" or "scalar").
+     * @return the name.
+     */
+    static const char *binaryKernelName();
+
+    /**
+     * Forces the binary kernels of the given instruction set, for tests and benchmarks.
+     * Not thread safe, call it before using the binary fields.
+     * @param name "pclmul", "scalar" or nullptr for the best one the cpu supports.
+     * @return false if the cpu does not support it (the kernels are left unchanged).
+     */
+    static bool selectBinaryKernels(const char *name);
+
+    /**
+     * Ben-Or's irreducibility test: f is irreducible when gcd(x^(p^i) - x, f) = 1 for every
+     * i up to l / 2.
+     * @param p a prime.
+     * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+     * @param modulus f - x^l, packed like an element.
+     * @return true if f is irreducible over GF(p).
+     */
+    static bool isIrreducible(uint64_t p , int l , uint64_t modulus);
+
+    /**
+     * The irreducible polynomial of degree l whose packed form is the smallest one
+     * (x^8 + x^4 + x^3 + x + 1 for GF(2^8), the modulus of AES).
+     * @param p a prime.
+     * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+     * @return f - x^l, packed like an element.
+     */
+    static uint64_t findIrreducible(uint64_t p , int l);
+
+    /**
+     * The shared extension of a modulus, built on first use (with its log tables when the
+     * order is at most GF_LOG_TABLE_ORDER). The modulus is checked by isIrreducible when the
+     * extension is built.
+     * @param p a prime.
+     * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+     * @param modulus f - x^l, packed like an element.
+     * @return the extension, valid until the end of the program, or nullptr if f is reducible.
+     */
+    static const GFExtension *get(uint64_t p , int l , uint64_t modulus);
+
+    /**
+     * The shared extension of the irreducible polynomial found by findIrreducible(), which
+     * is only searched once for every p and l.
+     * @param p a prime.
+     * @param l the degree, in [2, GF_MAX_DEGREE], with p^l below 2^63.
+     * @return the extension, valid until the end of the program.
+     */
+    static const GFExtension *get(uint64_t p , int l);
+};
+
+#endif //GFEXTENSION_H
@@ -1,11 +1,20 @@
 // GFNumber.cpp
 #include "GFNumber.h"
+#include "FactorizationCache.h"
+#include "FactorizationPipeline.h"
 #include "GField.h"
+#include "RandomSource.h"
 #include <cassert>
-#include <random>
-#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ThreadPool.h"
 
 #define FAILED_POLARD -1
+#define RHO_BATCH 128 /** steps between two gcds of the accumulated differences */
+#define RHO_ATTEMPTS 32 /** polynomial constants tried before giving up */
 
 // --------------------------------------------------------------------------------------
 // This file contains the implementation of the class GField.
@@ -30,11 +39,7 @@ void GFNumber::_checkValidityField(const GFNumber &other) const
  */
 long GFNumber::_convertNumberToField(long n) const
 {
-    if (n > 0)
-    {
-        return n % _field.getOrder();
-    }
-    return ((((n % _field.getOrder()) + _field.getOrder()) % _field.getOrder()));
+    return (long) _getField().element(n).getResidue();
 }
 
 // ------------- public --------------
@@ -45,33 +50,12 @@ long GFNumber::_convertNumberToField(long n) const
  * @param n A number.
  * @param field The field.
  */
-GFNumber::GFNumber(long n , GField field) : _field(field)
+GFNumber::GFNumber(long n , const GField &field) : _field(field.getId())
 {
     _n = _convertNumberToField(n);
 }
 
-// ------------- destructor ----------------
-/**
- * Destructor.
- */
-GFNumber::~GFNumber()
-{
-
-}
-
 // ------------ operators ------------
-/**
- * Assignment operator.
- * @param other another GFNumber.
- * @return The result GFNumber
- */
-GFNumber &GFNumber::operator=(const GFNumber &other)
-{
-    this->_n = other.getNumber();
-    this->_field = other._field;
-    return *this;
-}
-
 /**
  * Operator +
  * @param other another GFNumber.
@@ -80,7 +64,8 @@ GFNumber &GFNumber::operator=(const GFNumber &other)
 GFNumber GFNumber::operator+(const GFNumber &other) const
 {
     _checkValidityField(other);
-    return GFNumber(_convertNumberToField(other.getNumber() + this->_n) , this->_field);
+    long result = (long) _getField().add(getElement() , other.getElement()).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -90,8 +75,8 @@ GFNumber GFNumber::operator+(const GFNumber &other) const
  */
 GFNumber GFNumber::operator+(long rparam) const
 {
-    GFNumber gfNum(_convertNumberToField(this->_n + rparam) , this->_field);
-    return gfNum;
+    long result = (long) _getField().add(getElement() , _getField().element(rparam)).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -102,7 +87,7 @@ GFNumber GFNumber::operator+(long rparam) const
 GFNumber &GFNumber::operator+=(const GFNumber &other)
 {
     _checkValidityField(other);
-    this->_n = _convertNumberToField(_n + other.getNumber());
+    this->_n = (long) _getField().add(getElement() , other.getElement()).getResidue();
     return *this;
 }
 
@@ -113,7 +98,7 @@ GFNumber &GFNumber::operator+=(const GFNumber &other)
  */
 GFNumber &GFNumber::operator+=(long rparam)
 {
-    this->_n = _convertNumberToField(_n + rparam);
+    this->_n = (long) _getField().add(getElement() , _getField().element(rparam)).getResidue();
     return *this;
 }
 
@@ -124,7 +109,7 @@ GFNumber &GFNumber::operator+=(long rparam)
  */
 GFNumber &GFNumber::operator-=(long rparam)
 {
-    this->_n = _convertNumberToField(_n - rparam);
+    this->_n = (long) _getField().sub(getElement() , _getField().element(rparam)).getResidue();
     return *this;
 }
 
@@ -136,7 +121,7 @@ GFNumber &GFNumber::operator-=(long rparam)
 GFNumber &GFNumber::operator-=(const GFNumber &other)
 {
     _checkValidityField(other);
-    this->_n = _convertNumberToField(_n - other.getNumber());
+    this->_n = (long) _getField().sub(getElement() , other.getElement()).getResidue();
     return *this;
 }
 
@@ -148,8 +133,8 @@ GFNumber &GFNumber::operator-=(const GFNumber &other)
 GFNumber GFNumber::operator-(const GFNumber &other) const
 {
     _checkValidityField(other);
-    GFNumber gfNum(_convertNumberToField(this->_n - other.getNumber()) , this->_field);
-    return gfNum;
+    long result = (long) _getField().sub(getElement() , other.getElement()).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -159,8 +144,8 @@ GFNumber GFNumber::operator-(const GFNumber &other) const
  */
 GFNumber GFNumber::operator-(long rparam) const
 {
-    GFNumber gfNum(_convertNumberToField(_n - rparam) , this->_field);
-    return gfNum;
+    long result = (long) _getField().sub(getElement() , _getField().element(rparam)).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -171,7 +156,7 @@ GFNumber GFNumber::operator-(long rparam) const
 GFNumber &GFNumber::operator*=(const GFNumber &other)
 {
     _checkValidityField(other);
-    this->_n = _convertNumberToField(_n * other.getNumber());
+    this->_n = (long) _getField().mul(getElement() , other.getElement()).getResidue();
     return *this;
 }
 
@@ -182,7 +167,7 @@ GFNumber &GFNumber::operator*=(const GFNumber &other)
  */
 GFNumber &GFNumber::operator*=(long rparam)
 {
-    this->_n = _convertNumberToField(_n * rparam);
+    this->_n = (long) _getField().mul(getElement() , _getField().element(rparam)).getResidue();
     return *this;
 }
 
@@ -194,8 +179,8 @@ GFNumber &GFNumber::operator*=(long rparam)
 GFNumber GFNumber::operator*(const GFNumber &other) const
 {
     _checkValidityField(other);
-    GFNumber gfNum(_convertNumberToField(this->_n * other.getNumber()) , this->_field);
-    return gfNum;
+    long result = (long) _getField().mul(getElement() , other.getElement()).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -205,8 +190,8 @@ GFNumber GFNumber::operator*(const GFNumber &other) const
  */
 GFNumber GFNumber::operator*(long rparam) const
 {
-    GFNumber gfNum(_convertNumberToField(this->_n * rparam) , this->_field);
-    return gfNum;
+    long result = (long) _getField().mul(getElement() , _getField().element(rparam)).getResidue();
+    return GFNumber(result , _field , Reduced());
 }
 
 /**
@@ -240,7 +225,7 @@ GFNumber &GFNumber::operator%=(long rparam)
 GFNumber GFNumber::operator%(const GFNumber &other) const
 {
     _checkValidityField(other);
-    GFNumber gfNum(_convertNumberToField(this->_n % other.getNumber()) , this->_field);
+    GFNumber gfNum(_convertNumberToField(this->_n % other.getNumber()) , _getField());
     return gfNum;
 }
 
@@ -252,10 +237,119 @@ GFNumber GFNumber::operator%(const GFNumber &other) const
 GFNumber GFNumber::operator%(long rparam) const
 {
     assert(rparam != 0); // modulo 0 is undefined
-    GFNumber gfNum(this->_n % _convertNumberToField(rparam) , this->_field);
+    GFNumber gfNum(this->_n % _convertNumberToField(rparam) , _getField());
     return gfNum;
 }
 
+/**
+ * Operator /= on two gfNumbers (GFNumber /= GFNumber), multiplies by the inverse.
+ * @param other GFNumber instance, must be invertible.
+ * @return The result GFNumber
+ */
+GFNumber &GFNumber::operator/=(const GFNumber &other)
+{
+    _checkValidityField(other);
+    return *this *= other.inverse();
+}
+
+/**
+ * Operator /= on one long number and a gfNumber (GFNumber /= long).
+ * @param rparam long number, must be invertible in the field.
+ * @return The result GFNumber
+ */
+GFNumber &GFNumber::operator/=(long rparam)
+{
+    return *this *= GFNumber(_convertNumberToField(rparam) , _field , Reduced()).inverse();
+}
+
+/**
+ * Operator / on two gfNumbers (GFNumber / GFNumber), multiplies by the inverse.
+ * @param other GFNumber instance, must be invertible.
+ * @return The result GFNumber
+ */
+GFNumber GFNumber::operator/(const GFNumber &other) const
+{
+    _checkValidityField(other);
+    return *this * other.inverse();
+}
+
+/**
+ * Operator / on long number and gfNumber (GFNumber / long number).
+ * @param rparam long number, must be invertible in the field.
+ * @return The result GFNumber
+ */
+GFNumber GFNumber::operator/(long rparam) const
+{
+    return *this * GFNumber(_convertNumberToField(rparam) , _field , Reduced()).inverse();
+}
+
+/**
+ * Raises the number to the given power with square-and-multiply (sliding window for
+ * large exponents). A negative exponent raises the inverse.
+ * @param exponent long number.
+ * @return The result GFNumber
+ */
+GFNumber GFNumber::pow(long exponent) const
+{
+    if (exponent < 0)
+    {
+        return inverse().pow(-(exponent + 1)) * inverse();
+    }
+    long result = (long) _getField().pow(getElement() , (uint64_t) exponent).getResidue();
+    return GFNumber(result , _field , Reduced());
+}
+
+/**
+ * The multiplicative inverse, computed with the binary extended gcd (or as a^(p^l - 2) in
+ * a field with the polynomial arithmetic).
+ * The number must be coprime to the order of the field (non zero when l = 1 or with the
+ * polynomial arithmetic).
+ * @return The result GFNumber
+ */
+GFNumber GFNumber::inverse() const
+{
+    uint64_t result = _getField().inv(getElement()).getResidue();
+    assert(result != 0); // the number has no inverse in the field
+    return GFNumber((long) result , _field , Reduced());
+}
+
+/**
+ * Inverts count numbers of one field with Montgomery's simultaneous inversion trick:
+ * a single inverse and 3(count - 1) multiplications.
+ * @param numbers array of invertible GFNumbers of the same field.
+ * @param count the length of numbers.
+ * @param results array of length count, results[i] is set to the inverse of numbers[i]
+ * (may be numbers itself).
+ */
+void GFNumber::batchInverse(const GFNumber *numbers , size_t count , GFNumber *results)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    GFieldId field = numbers[0]._field;
+    const GField &gField = GFieldRegistry::get(field);
+    // prefix[i] = numbers[0] * ... * numbers[i]
+    std::vector<GFElement> prefix(count);
+    prefix[0] = numbers[0].getElement();
+    for (size_t i = 1; i < count; i++)
+    {
+        numbers[0]._checkValidityField(numbers[i]);
+        prefix[i] = gField.mul(prefix[i - 1] , numbers[i].getElement());
+    }
+    GFElement inverse = gField.inv(prefix[count - 1]);
+    assert(inverse.getResidue() != 0); // one of the numbers has no inverse in the field
+    for (size_t i = count - 1; i > 0; i--)
+    {
+        // inverse = (numbers[0] * ... * numbers[i])^-1
+        GFElement number = numbers[i].getElement();
+        results[i] = GFNumber((long) gField.mul(inverse , prefix[i - 1]).getResidue() , field ,
+                              Reduced());
+        inverse = gField.mul(inverse , number);
+    }
+    results[0] = GFNumber((long) inverse.getResidue() , field , Reduced());
+}
+
 /**
  * Equal operator overloading. checks if both GFNumbers are the same.
  * @param other , another GFNumber instance.
@@ -263,7 +357,8 @@ GFNumber GFNumber::operator%(long rparam) const
  */
 bool GFNumber::operator==(const GFNumber &other) const
 {
-    return (this->_n == other.getNumber() && this->_field.getChar() == other.getField().getChar());
+    return (this->_n == other.getNumber() &&
+            _getField().getChar() == other._getField().getChar());
 }
 
 /**
@@ -356,115 +451,169 @@ std::istream &operator>>(std::istream &in , GFNumber &number)
 // ------------ methods ------------
 
 /**
- * This method adds a prime number to the _primeFactors array.
- * it does all the job of allocating memory to the new array and assigning the values of the
- * old array to the new one and then deleting the old array.
+ * This method returns all the prime factors of the given GFNumber with their
+ * multiplicities, sorted by prime. Primes, 0 and 1 have no factors.
+ * A composite is looked up in FactorizationCache::global() first, and otherwise goes
+ * through the stages of FactorizationPipeline::global() and is added to the cache.
+ * @return The prime factorization of the GFNumber.
  */
-void GFNumber::_addPrime(long num)
+PrimeFactorization GFNumber::getPrimeFactors() const
 {
-    _primeFactorsLength += 1;
-    GFNumber *newPrimeArray = new GFNumber[_primeFactorsLength];
-    for (int i = 0; i < _primeFactorsLength - 1; i++)
-    {
-        newPrimeArray[i] = _primeFactors[i];
-    }
-    newPrimeArray[_primeFactorsLength - 1] = GFNumber(num , _field);
-    delete[] _primeFactors;
-    _primeFactors = newPrimeArray;
+    return _primeFactors(nullptr , &FactorizationCache::global());
 }
 
 /**
- * This method uses a brute force approach in order to get all the prime
- * factors of n, it uses a principal called "Trail Division"
- * @param n
+ * Same as getPrimeFactors(), but numbers of RHO_RACE_BITS bits or more are split by
+ * Pollard's Rho walks raced on the pool, which cuts the time of the hardest numbers.
+ * May be called from a task of the same pool.
+ * @param pool the pool to race the walks on.
+ * @return The prime factorization of the GFNumber.
  */
-void GFNumber::_directSearchFactorization(long n)
+PrimeFactorization GFNumber::getPrimeFactors(ThreadPool &pool) const
 {
-    long i = 2;
-    while (i <= floor(sqrt(n)))
-    {
-        if ((n % i) == 0)
-        {
-            _addPrime(i);
-            n = n / i;
-        }
-        else
-        {
-            i = i + 1;
-        }
-    }
-    if (n > 1)
+    return _primeFactors(&pool , &FactorizationCache::global());
+}
+
+/**
+ * Same as getPrimeFactors(), with a given cache instead of FactorizationCache::global().
+ * @param pool the pool to race the walks on (may be null).
+ * @param cache the cache to look the number up in and to add it to (may be null, the
+ * number is then always factored).
+ * @return The prime factorization of the GFNumber.
+ */
+PrimeFactorization GFNumber::getPrimeFactors(ThreadPool *pool , FactorizationCache *cache) const
+{
+    return _primeFactors(pool , cache);
+}
+
+/**
+ * Factors a number of up to 128 bits, which does not have to fit any field, with
+ * FactorizationPipeline::factorWide. Unlike getPrimeFactors(), a prime is its own factor.
+ * @param n the number.
+ * @return the prime factorization of n, sorted by prime (empty for 0 and 1).
+ */
+WideFactorization GFNumber::factorWide(UInt128 n)
+{
+    return _factorWide(n , nullptr);
+}
+
+/**
+ * Same as factorWide(), but the quadratic sieve runs on the threads of the pool along
+ * with the caller, and the Rho walks are raced as in getPrimeFactors(ThreadPool &).
+ * May be called from a task of the same pool.
+ * @param n the number.
+ * @param pool the pool to sieve on.
+ * @return the prime factorization of n, sorted by prime (empty for 0 and 1).
+ */
+WideFactorization GFNumber::factorWide(UInt128 n , ThreadPool &pool)
+{
+    return _factorWide(n , &pool);
+}
+
+/**
+ * Factors a number of up to 128 bits (see factorWide()).
+ * @param n the number.
+ * @param pool the pool to sieve and race the rho walks on (may be null).
+ * @return the prime factorization of n, sorted by prime.
+ */
+WideFactorization GFNumber::_factorWide(UInt128 n , ThreadPool *pool)
+{
+    WideFactorization factorization;
+    GFNumber walker;
+    FactorizationPipeline::global().factorWide(n , factorization , [&walker , pool](long m)
     {
-        _addPrime(n);
-    }
+        bool race = pool != nullptr && (m >> (RHO_RACE_BITS - 1)) != 0;
+        return race ? walker._racePollardRho(m , *pool) : walker._pollardRho(m);
+    } , pool);
+    factorization.sort();
+    return factorization;
 }
 
 /**
- * This method returns a list of longs of all the prime
- * factors of the given GFNumber.
- * @return An array of long representing all the prime factors of the GFNumber.
+ * The prime factorization of the number (see getPrimeFactors()).
+ * @param pool the pool to race the rho walks of large numbers on (may be null).
+ * @param cache the cache to look the number up in and to add it to (may be null).
+ * @return The prime factorization of the GFNumber.
  */
-GFNumber *GFNumber::getPrimeFactors(int *pointer)
+PrimeFactorization GFNumber::_primeFactors(ThreadPool *pool , FactorizationCache *cache) const
 {
+    PrimeFactorization factorization;
     // ------------------------ TRIVIAL -----------------------------
-    if (getIsPrime() || _n == 0) // if the number is prime just create an array of size 0
+    if (getIsPrime() || _n == 0) // if the number is prime there are no factors
     {
-        _primeFactors = new GFNumber[0];
-        *pointer = 0;
-        return _primeFactors;
+        return factorization;
     }
     // --------------------------------------------------------------
-    _primeFactors = new GFNumber[0];
-    _primeFactorsLength = 0;
-    // try to factor until the number is odd
-    long currentNumber = _n;
-    while (currentNumber % 2 == 0)
+    WideFactorization cached;
+    if (cache != nullptr && cache->lookup((UInt128) _n , cached))
     {
-        _addPrime(2); // adds 2 to the prime list
-        currentNumber /= 2;
+        // the number is composite, so every prime of it fits a long
+        for (const WidePrimeFactor &factor : cached)
+        {
+            factorization.addPrime((long) factor.prime , factor.exponent);
+        }
+        return factorization;
     }
-    // try using "Pollard's Rho" algorithm until it gives -1
-    long maybePrime = _pollardRho(currentNumber);
-    while (GField::isPrime(maybePrime) || maybePrime != -1)
+    // the composite cofactors which the cheaper stages leave are split by Pollard's Rho
+    FactorizationPipeline::global().factor(_n , factorization , [this , pool](long m)
     {
-        _addPrime(maybePrime);
-        currentNumber /= maybePrime;
-        maybePrime = _pollardRho(currentNumber);
-    }
-    if (currentNumber == 1)
+        bool race = pool != nullptr && (m >> (RHO_RACE_BITS - 1)) != 0;
+        return race ? _racePollardRho(m , *pool) : _pollardRho(m);
+    });
+    factorization.sort();
+    if (cache != nullptr)
     {
-        *pointer = _primeFactorsLength;
-        return _primeFactors;
+        cached.addAll(factorization);
+        cache->insert((UInt128) _n , cached);
     }
-    else // we need to use the iterative method
+    return factorization;
+}
+
+/**
+ * This method returns an array of all the prime factors of the given GFNumber, repeated
+ * by their multiplicities (the original interface, prefer getPrimeFactors()).
+ * The destruction of the returned array (with delete[]) is the responsibility of the user.
+ * @param pointer output, the length of the array.
+ * @return An array of GFNumbers (of this field) of all the prime factors.
+ */
+GFNumber *GFNumber::getPrimeFactors(int *pointer) const
+{
+    PrimeFactorization factorization = getPrimeFactors();
+    *pointer = factorization.countWithMultiplicity();
+    GFNumber *factors = new GFNumber[*pointer];
+    int i = 0;
+    for (const PrimeFactor &factor : factorization)
     {
-        _directSearchFactorization(currentNumber);
-        *pointer = _primeFactorsLength;
-        return _primeFactors;
+        for (int j = 0; j < factor.exponent; j++)
+        {
+            factors[i++] = GFNumber(factor.prime , _getField());
+        }
     }
+    return factors;
 }
 
 /**
  * Prints all the prime factors
  */
-void GFNumber::printFactors()
+void GFNumber::printFactors() const
+{
+    printFactors(std::cout);
+    std::cout.flush();
+}
+
+/**
+ * Prints all the prime factors to the given stream (same format as printFactors()).
+ * @param out ostream reference.
+ */
+void GFNumber::printFactors(std::ostream &out) const
 {
-    getPrimeFactors(&_primeFactorsLength);
-    if (_primeFactorsLength == 0)
+    PrimeFactorization factorization = getPrimeFactors();
+    out << this->getNumber() << "=";
+    if (factorization.empty())
     {
-        std::cout << (this->getNumber()) << "=" << (this->getNumber()) << "*1" << std::endl;
+        out << this->getNumber() << "*";
     }
-    else
-    {
-        std::cout << this->getNumber() << "=";
-        for (int i = 0; i < _primeFactorsLength - 1; i++)
-        {
-            std::cout << _primeFactors[i].getNumber() << "*";
-        }
-        std::cout << _primeFactors[_primeFactorsLength - 1].getNumber() << std::endl;
-    }
-    delete[] _primeFactors;
-    _primeFactors = nullptr;
+    out << factorization << '\n';
 }
 
 /**
@@ -477,89 +626,188 @@ bool GFNumber::getIsPrime() const
 }
 
 /**
- * This method generates a long random number in the range of [0,supremum]
+ * This method generates a long random number in the range of [1,supremum - 1], it draws
+ * from the thread's RandomSource, so runs can be replayed with GF_RANDOM_SEED.
  * @param supremum A long number.
  * @return Random number uniformly distributed.
  */
 long GFNumber::_generateRand(long supremum) const
 {
-    /* The seed of the random number */
-    std::random_device rd;
-    /* The random number generator */
-    std::default_random_engine generator(rd());
-    /* The generator will generate number uniformly distributed */
-    std::uniform_int_distribution<long> distribution(1 , supremum - 1);
-    return distribution(generator);
+    return (long) RandomSource::nextInRange(1 , (uint64_t) supremum - 1);
 }
 
 /**
- * Pollard's Rho Algorithm for factorizing a long number.
- * @param n the number to factorize
- * @return prime factor (or some number multiplying the prime), or -1 if fails
+ * Pollard's Rho Algorithm for factorizing a long number, with Brent's cycle detection.
+ * The differences are multiplied into an accumulator and a gcd is only taken every
+ * RHO_BATCH steps, a failed walk is retried with another polynomial constant.
+ * @param n the odd composite number to factorize
+ * @return a non trivial factor (not necessarily prime), or -1 if every walk fails
  */
 long GFNumber::_pollardRho(long currentNumber) const
 {
-    if (currentNumber == 1)
+    if (currentNumber <= 3 || currentNumber % 2 == 0)
     {
         return FAILED_POLARD;
     }
-    long x = _generateRand(currentNumber);
-    long y = x;
-    long p = 1;
-    while (p == 1)
-    {
-        x = _polynomialFunc(x , currentNumber);
-        y = _polynomialFunc(_polynomialFunc(y , currentNumber) , currentNumber);
-        p = _gcd(std::abs(x - y) , currentNumber);
-    }
-    if (p == currentNumber)
+    ModReducer reducer((uint64_t) currentNumber);
+    for (uint64_t c = 1; c <= RHO_ATTEMPTS; c++)
     {
-        return FAILED_POLARD; // Faild to find p with the chosen polynomial
+        uint64_t start = reducer.toMontgomery((uint64_t) _generateRand(currentNumber));
+        long p = _brentWalk(reducer , start , reducer.toMontgomery(c));
+        if (p != currentNumber)
+        {
+            return p;
+        }
     }
-    return p;
+    return FAILED_POLARD; // Failed to find p with all the chosen polynomials
 }
 
 /**
- * this is the polynomial func f(x) = x^2 + 1 mod n
- * @param x long
- * @param num long
- * @return GFNumber result
+ * The state shared by the walks of a race, owned by every walk so that a walk which only
+ * starts after the race is over can still read it.
  */
-long GFNumber::_polynomialFunc(long x , long num) const
+struct RhoRace
 {
-    return ((x * x) + 1) % num;
-}
+    ModReducer reducer; /** Montgomery context modulo the number. */
+    std::atomic<bool> cancelled; /** Set (release) when a walk finds a factor or the race ends. */
+    std::atomic<long> factor; /** The factor found by the winning walk. */
+    std::atomic<uint64_t> next; /** The next walk to claim. */
+    std::mutex mutex; /** Guards finished. */
+    std::condition_variable ended; /** Signaled when the last walk is finished or wins. */
+    uint64_t finished; /** The walks finished. */
+
+    explicit RhoRace(uint64_t n) : reducer(n) , cancelled(false) , factor(FAILED_POLARD) ,
+                                   next(0) , finished(0)
+    {}
+};
 
 /**
- * GCD CALCULATOR
- * @param num1 first long num
- * @param num2 second long num
- * @return the gcd of them.
+ * Pollard's Rho with one walk per worker of the pool and one on the calling thread, every
+ * walk with its own polynomial constants. The first walk to find a factor cancels the others.
+ * The calling thread claims the walks no worker has started, and when none of its walks
+ * found a factor waits for the walks of this race only, never for the pool, so it may be a
+ * worker of the same pool.
+ * @param n the odd composite number to factorize
+ * @param pool the pool the other walks run on.
+ * @return a non trivial factor (not necessarily prime), or -1 if every walk fails
  */
-long GFNumber::_gcd(long num1 , long num2) const
+long GFNumber::_racePollardRho(long currentNumber , ThreadPool &pool) const
 {
-    while (num1 >= 0 && num2 >= 0)
+    if (currentNumber <= 3 || currentNumber % 2 == 0)
+    {
+        return FAILED_POLARD;
+    }
+    std::shared_ptr<RhoRace> race = std::make_shared<RhoRace>((uint64_t) currentNumber);
+    const uint64_t walks = pool.size() + 1;
+    // walk w tries the constants w + 1, w + 1 + walks, ...
+    auto walk = [currentNumber , walks](const GFNumber &number , RhoRace &state , uint64_t w)
     {
-        if (num1 == 0)
+        for (uint64_t c = w + 1; c <= RHO_ATTEMPTS * walks; c += walks)
         {
-            return num2;
+            if (state.cancelled.load(std::memory_order_acquire))
+            {
+                return;
+            }
+            uint64_t start = state.reducer.toMontgomery(
+                    (uint64_t) number._generateRand(currentNumber));
+            long p = number._brentWalk(state.reducer , start , state.reducer.toMontgomery(c) ,
+                                       &state.cancelled);
+            if (p != currentNumber)
+            {
+                long expected = FAILED_POLARD;
+                state.factor.compare_exchange_strong(expected , p);
+                state.cancelled.store(true , std::memory_order_release);
+                return;
+            }
         }
-        if (num2 == 0)
+    };
+    auto run = [walk , walks](const GFNumber &number , RhoRace &state)
+    {
+        for (uint64_t w = state.next++; w < walks; w = state.next++)
         {
-            return num1;
+            walk(number , state , w);
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (++state.finished == walks || state.cancelled.load(std::memory_order_acquire))
+            {
+                state.ended.notify_all();
+            }
         }
-        if (num1 == num2)
+    };
+    for (uint64_t w = 1; w < walks; w++)
+    {
+        GFNumber number = *this;
+        pool.submit([run , number , race]()
+                    { run(number , *race); });
+    }
+    run(*this , *race);
+    if (!race->cancelled.load(std::memory_order_acquire))
+    {
+        // every constant of the walks run here failed, the workers may still find a factor
+        std::unique_lock<std::mutex> lock(race->mutex);
+        race->ended.wait(lock , [&race , walks]()
+        { return race->finished == walks || race->cancelled.load(std::memory_order_acquire); });
+    }
+    race->cancelled.store(true , std::memory_order_release);
+    return race->factor.load(std::memory_order_acquire);
+}
+
+/**
+ * One Brent walk of Pollard's Rho with the polynomial x^2 + c.
+ * @param reducer Montgomery context modulo the odd number to factorize.
+ * @param start the starting point of the walk (Montgomery form).
+ * @param c the constant of the polynomial (Montgomery form).
+ * @param cancelled checked every RHO_BATCH steps, the walk stops when it is set (may be null).
+ * @return a divisor of the number, which may be trivial (the number itself).
+ */
+long GFNumber::_brentWalk(const ModReducer &reducer , uint64_t start , uint64_t c ,
+                          const std::atomic<bool> *cancelled) const
+{
+    const uint64_t n = reducer.getModulus();
+    uint64_t x = start , y = start , saved = start;
+    uint64_t accumulator = reducer.toMontgomery(1);
+    uint64_t g = 1;
+    for (uint64_t r = 1; g == 1; r <<= 1)
+    {
+        x = y;
+        for (uint64_t i = 0; i < r; i++)
         {
-            return num1;
+            y = _polynomialFunc(y , c , reducer);
         }
-        if (num1 > num2)
+        for (uint64_t k = 0; k < r && g == 1; k += RHO_BATCH)
         {
-            num1 = (num1 - num2);
+            if (cancelled != nullptr && cancelled->load(std::memory_order_acquire))
+            {
+                return (long) n;
+            }
+            saved = y;
+            uint64_t steps = (r - k < RHO_BATCH) ? r - k : RHO_BATCH;
+            for (uint64_t i = 0; i < steps; i++)
+            {
+                y = _polynomialFunc(y , c , reducer);
+                accumulator = reducer.mulMontgomery(accumulator , (x > y) ? x - y : y - x);
+            }
+            g = GField::binaryGcd(accumulator , n);
         }
-        else
+    }
+    if (g == n)
+    {
+        // the batch collapsed, walk it again one step at a time
+        do
         {
-            num2 = (num2 - num1);
-        }
+            saved = _polynomialFunc(saved , c , reducer);
+            g = GField::binaryGcd((x > saved) ? x - saved : saved - x , n);
+        } while (g == 1);
     }
-    return 0;
+    return (long) g;
+}
+
+/**
+ * GCD CALCULATOR
+ * @param num1 first long num
+ * @param num2 second long num
+ * @return the gcd of them.
+ */
+long GFNumber::_gcd(long num1 , long num2) const
+{
+    return (long) GField::binaryGcd((uint64_t) std::labs(num1) , (uint64_t) std::labs(num2));
 }
\ No newline at end of file
@@ -5,8 +5,18 @@
 #define DEFAULT_INIT 0
 #define DEFAULT_P 2
 #define DEFAULT_L 1
+#define RHO_RACE_BITS 48 /** smaller numbers are split by a single rho walk */
 
+#include <atomic>
+#include <type_traits>
 #include "GField.h"
+#include "GFieldRegistry.h"
+#include "PrimeFactorization.h"
+#include "WideFactorization.h"
+
+class ThreadPool;
+
+class FactorizationCache;
 
 /**
  *  A GFNumber class.
@@ -18,11 +28,26 @@ private:
 
     long _n; /** Number representation of the field (after modulo). */
 
-    GField _field; /** The degree of the field. */
+    GFieldId _field; /** The id of the field of the number (see GFieldRegistry). */
+
+    /**
+     * Lookup of the field of the number.
+     * @return the field.
+     */
+    const GField &_getField() const { return GFieldRegistry::get(_field); }
+
+    /** Tag of the constructor which takes an already reduced number. */
+    struct Reduced {};
 
-    GFNumber* _primeFactors; /** array of all the prime factors*/
+    /**
+     * A constructor for an already reduced number, no conversion is done.
+     * @param n a number in [0, order).
+     * @param field the id of the field.
+     */
+    GFNumber(long n, GFieldId field, Reduced) : _n(n), _field(field) {};
 
-    int _primeFactorsLength = 0; /** The length of the prime factors array */
+    template<class E> friend class GFExpr;
+    friend class GFLeafExpr;
 
     /**
      * This private method converts any number to a number from the field.
@@ -39,40 +64,70 @@ private:
     void _checkValidityField(const GFNumber &other) const;
 
     /**
-     * Pollard's Rho Algorithm for factorizing a long number.
-     * @param n the number to factorize
-     * @return prime factor (or some number multiplying the prime), or -1 if fails
+     * Pollard's Rho Algorithm for factorizing a long number, with Brent's cycle detection.
+     * The differences are multiplied into an accumulator and a gcd is only taken every
+     * RHO_BATCH steps, a failed walk is retried with another polynomial constant.
+     * @param n the odd composite number to factorize
+     * @return a non trivial factor (not necessarily prime), or -1 if every walk fails
      */
     long _pollardRho(long n) const;
 
     /**
-     * This method generates a long random number in the range of [0,supremum]
-     * @param supremum A long number.
-     * @return Random number uniformly distributed.
+     * Pollard's Rho with one walk per worker of the pool and one on the calling thread, every
+     * walk with its own polynomial constants. The first walk to find a factor cancels the others.
+     * The calling thread claims the walks no worker has started, and when none of its walks
+     * found a factor waits for the walks of this race only, never for the pool, so it may be a
+     * worker of the same pool.
+     * @param n the odd composite number to factorize
+     * @param pool the pool the other walks run on.
+     * @return a non trivial factor (not necessarily prime), or -1 if every walk fails
      */
-    long _generateRand(long supremum) const;
+    long _racePollardRho(long n , ThreadPool &pool) const;
+
+    /**
+     * One Brent walk of Pollard's Rho with the polynomial x^2 + c.
+     * @param reducer Montgomery context modulo the odd number to factorize.
+     * @param start the starting point of the walk (Montgomery form).
+     * @param c the constant of the polynomial (Montgomery form).
+     * @param cancelled checked every RHO_BATCH steps, the walk stops when it is set (may be null).
+     * @return a divisor of the number, which may be trivial (the number itself).
+     */
+    long _brentWalk(const ModReducer &reducer , uint64_t start , uint64_t c ,
+                    const std::atomic<bool> *cancelled = nullptr) const;
+
+    /**
+     * The prime factorization of the number (see getPrimeFactors()).
+     * @param pool the pool to race the rho walks of large numbers on (may be null).
+     * @param cache the cache to look the number up in and to add it to (may be null).
+     * @return The prime factorization of the GFNumber.
+     */
+    PrimeFactorization _primeFactors(ThreadPool *pool , FactorizationCache *cache) const;
 
     /**
-     * This method adds a prime number to the _primeFactors array.
-     * it does all the job of allocating memory to the new array and assigning the values of the
-     * old array to the new one and then deleting the old array.
+     * Factors a number of up to 128 bits (see factorWide()).
+     * @param n the number.
+     * @param pool the pool to sieve and race the rho walks on (may be null).
+     * @return the prime factorization of n, sorted by prime.
      */
-    void _addPrime(long);
+    static WideFactorization _factorWide(UInt128 n , ThreadPool *pool);
 
     /**
-     * This method uses a brute force approach in order to get all the prime
-     * factors of n, it uses a principal called "Trail Division"
-     * @param n
+     * This method generates a long random number in the range of [1,supremum - 1], it draws
+     * from the thread's RandomSource, so runs can be replayed with GF_RANDOM_SEED.
+     * @param supremum A long number.
+     * @return Random number uniformly distributed.
      */
-    void _directSearchFactorization(long n);
+    long _generateRand(long supremum) const;
 
     /**
-     * this is the polynomial func f(x) = x^2 + 1 mod n
-     * @param x long
-     * @param num long
-     * @return GFNumber result
+     * this is the polynomial func f(x) = x^2 + c mod n, evaluated in the Montgomery domain
+     * @param x Montgomery form of x
+     * @param c Montgomery form of the constant
+     * @param reducer Montgomery context modulo n
+     * @return Montgomery form of the result
      */
-    long _polynomialFunc(long x, long num) const;
+    uint64_t _polynomialFunc(uint64_t x, uint64_t c, const ModReducer &reducer) const
+    { return reducer.addMod(reducer.mulMontgomery(x, x), c); }
 
     /**
      * GCD CALCULATOR
@@ -88,7 +143,7 @@ public:
      * A constructor.
      * Default ctor.
      */
-    GFNumber() : _n(DEFAULT_INIT), _field(DEFAULT_P, DEFAULT_L) {};
+    GFNumber() : _n(DEFAULT_INIT), _field(GField().getId()) {};
 
 
     /**
@@ -96,7 +151,7 @@ public:
      * @param n A number.
      * @param field The field.
      */
-    GFNumber(long n, GField field);
+    GFNumber(long n, const GField &field);
 
 
     /**
@@ -104,57 +159,96 @@ public:
      * ctor with default field.
      * @param n A number from the field.
      */
-    GFNumber(long n) : GFNumber(n, GField(DEFAULT_P, DEFAULT_L)) {};
+    GFNumber(long n) : GFNumber(n, GField()) {};
 
+    /**
+     * Gets the number from the specific field.
+     * @return _n the number.
+     */
+    long getNumber() const { return _n; }
 
     /**
-     * A constructor.
-     * Copy ctor.
-     * @param num GFNumber instance.
+     * Getter for the field of the number.
+     * @return The field of the number.
      */
-    GFNumber(const GFNumber &num) : GFNumber(num._n, num._field) {};
+    GField getField() const { return _getField(); }
 
     /**
-     * Destructor.
+     * Getter for the compact form of the number.
+     * @return the residue of the number as a GFElement of its field.
      */
-    ~GFNumber();
+    GFElement getElement() const { return GFElement((uint64_t) _n); }
 
     /**
-     * Gets the number from the specific field.
-     * @return _n the number.
+     * This method returns all the prime factors of the given GFNumber with their
+     * multiplicities, sorted by prime. Primes, 0 and 1 have no factors.
+     * A composite is looked up in FactorizationCache::global() first, and otherwise goes
+     * through the stages of FactorizationPipeline::global() and is added to the cache.
+     * @return The prime factorization of the GFNumber.
      */
-    long getNumber() const { return _n; }
+    PrimeFactorization getPrimeFactors() const;
 
     /**
-     * Getter for the field of the number.
-     * @return The field of the number.
+     * Same as getPrimeFactors(), but numbers of RHO_RACE_BITS bits or more are split by
+     * Pollard's Rho walks raced on the pool, which cuts the time of the hardest numbers.
+     * May be called from a task of the same pool.
+     * @param pool the pool to race the walks on.
+     * @return The prime factorization of the GFNumber.
+     */
+    PrimeFactorization getPrimeFactors(ThreadPool &pool) const;
+
+    /**
+     * Same as getPrimeFactors(), with a given cache instead of FactorizationCache::global().
+     * @param pool the pool to race the walks on (may be null).
+     * @param cache the cache to look the number up in and to add it to (may be null, the
+     * number is then always factored).
+     * @return The prime factorization of the GFNumber.
+     */
+    PrimeFactorization getPrimeFactors(ThreadPool *pool , FactorizationCache *cache) const;
+
+    /**
+     * Factors a number of up to 128 bits, which does not have to fit any field, with
+     * FactorizationPipeline::factorWide. Unlike getPrimeFactors(), a prime is its own factor.
+     * @param n the number.
+     * @return the prime factorization of n, sorted by prime (empty for 0 and 1).
      */
-    GField getField() const { return _field; }
+    static WideFactorization factorWide(UInt128 n);
 
     /**
-     * This method returns a list of longs of all the prime
-     * factors of the given GFNumber.
-     * @return An array of long representing all the prime factors of the GFNumber.
+     * Same as factorWide(), but the quadratic sieve runs on the threads of the pool along
+     * with the caller, and the Rho walks are raced as in getPrimeFactors(ThreadPool &).
+     * May be called from a task of the same pool.
+     * @param n the number.
+     * @param pool the pool to sieve on.
+     * @return the prime factorization of n, sorted by prime (empty for 0 and 1).
      */
-    GFNumber *getPrimeFactors(int *pointer);
+    static WideFactorization factorWide(UInt128 n , ThreadPool &pool);
+
+    /**
+     * This method returns an array of all the prime factors of the given GFNumber, repeated
+     * by their multiplicities (the original interface, prefer getPrimeFactors()).
+     * The destruction of the returned array (with delete[]) is the responsibility of the user.
+     * @param pointer output, the length of the array.
+     * @return An array of GFNumbers (of this field) of all the prime factors.
+     */
+    GFNumber *getPrimeFactors(int *pointer) const;
 
     /**
      * Prints all the prime factors
      */
-    void printFactors();
+    void printFactors() const;
 
     /**
-     * This method checks if the GFNumber is prime or not.
-     * @return True if prime, false otherwise.
+     * Prints all the prime factors to the given stream (same format as printFactors()).
+     * @param out ostream reference.
      */
-    bool getIsPrime() const;
+    void printFactors(std::ostream &out) const;
 
     /**
-     * Assignment operator.
-     * @param other another GFNumber.
-     * @return The result GFNumber
+     * This method checks if the GFNumber is prime or not.
+     * @return True if prime, false otherwise.
      */
-    GFNumber &operator=(const GFNumber &other);
+    bool getIsPrime() const;
 
     /**
      * Operator +
@@ -268,6 +362,59 @@ public:
      */
     GFNumber operator%(long rparam) const;
 
+    /**
+     * Operator /= on two gfNumbers (GFNumber /= GFNumber), multiplies by the inverse.
+     * @param other GFNumber instance, must be invertible.
+     * @return The result GFNumber
+     */
+    GFNumber &operator/=(const GFNumber &other);
+
+    /**
+     * Operator /= on one long number and a gfNumber (GFNumber /= long).
+     * @param rparam long number, must be invertible in the field.
+     * @return The result GFNumber
+     */
+    GFNumber &operator/=(long rparam);
+
+    /**
+     * Operator / on two gfNumbers (GFNumber / GFNumber), multiplies by the inverse.
+     * @param other GFNumber instance, must be invertible.
+     * @return The result GFNumber
+     */
+    GFNumber operator/(const GFNumber &other) const;
+
+    /**
+     * Operator / on long number and gfNumber (GFNumber / long number).
+     * @param rparam long number, must be invertible in the field.
+     * @return The result GFNumber
+     */
+    GFNumber operator/(long rparam) const;
+
+    /**
+     * Raises the number to the given power with square-and-multiply (sliding window for
+     * large exponents). A negative exponent raises the inverse.
+     * @param exponent long number.
+     * @return The result GFNumber
+     */
+    GFNumber pow(long exponent) const;
+
+    /**
+     * The multiplicative inverse, computed with the binary extended gcd.
+     * The number must be coprime to the order of the field (non zero when l = 1).
+     * @return The result GFNumber
+     */
+    GFNumber inverse() const;
+
+    /**
+     * Inverts count numbers of one field with Montgomery's simultaneous inversion trick:
+     * a single inverse and 3(count - 1) multiplications.
+     * @param numbers array of invertible GFNumbers of the same field.
+     * @param count the length of numbers.
+     * @param results array of length count, results[i] is set to the inverse of numbers[i]
+     * (may be numbers itself).
+     */
+    static void batchInverse(const GFNumber *numbers, size_t count, GFNumber *results);
+
     /**
      * Equal operator overloading. checks if both GFNumbers are the same.
      * @param other , another GFNumber instance.
@@ -333,4 +480,6 @@ public:
     friend std::istream &operator>>(std::istream &in, GFNumber &number);
 };
 
+static_assert(std::is_trivially_copyable<GFNumber>::value , "GFNumber must copy as plain bytes");
+
 #endif //GFNUMBER_H
\ No newline at end of file
@@ -0,0 +1,563 @@
+// GFNumberT.hpp
+//----------- include guards------------
+#ifndef GFNUMBERT_HPP
+#define GFNUMBERT_HPP
+//-------------- includes --------------
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include "GField.h"
+#include "GFNumber.h"
+
+//--------------------------------------
+
+/**
+ * A number from the field GF(P**L) when the field is known at compile time.
+ * The order and every reduction constant are constexpr, so the compiler turns the modulo
+ * into multiplications and numbers of different fields are different types: mixing them is
+ * a compile error instead of an assertion. The operators mirror the ones of GFNumber.
+ * @tparam P the char of the field, must be prime.
+ * @tparam L the degree of the field, the order P^L must fit in a long.
+ */
+template<long P , long L = 1>
+class GFNumberT
+{
+private:
+    /**
+     * Multiplication modulo m in 128 bits (only used to compute the constants).
+     */
+    static constexpr uint64_t _mulModSlow(uint64_t a , uint64_t b , uint64_t m)
+    { return (uint64_t) (((unsigned __int128) a * b) % m); }
+
+    /**
+     * Exponentiation modulo m (only used to compute the constants).
+     */
+    static constexpr uint64_t _powModSlow(uint64_t base , uint64_t exponent , uint64_t m)
+    {
+        uint64_t result = 1 % m;
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+            {
+                result = _mulModSlow(result , base , m);
+            }
+            base = _mulModSlow(base , base , m);
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    /**
+     * Compile time version of GField::isPrime (deterministic Miller-Rabin).
+     */
+    static constexpr bool _isPrime(uint64_t n)
+    {
+        if (n < 2)
+        {
+            return false;
+        }
+        const uint64_t smallPrimes[] = {2 , 3 , 5 , 7 , 11 , 13 , 17 , 19 , 23 , 29 , 31 , 37};
+        for (uint64_t prime : smallPrimes)
+        {
+            if (n % prime == 0)
+            {
+                return n == prime;
+            }
+        }
+        uint64_t d = n - 1;
+        int s = 0;
+        while ((d & 1) == 0)
+        {
+            d >>= 1;
+            s++;
+        }
+        for (uint64_t witness : smallPrimes) // deterministic below 3.3 * 10^24
+        {
+            uint64_t x = _powModSlow(witness , d , n);
+            bool composite = (x != 1 && x != n - 1);
+            for (int r = 1; r < s && composite; r++)
+            {
+                x = _mulModSlow(x , x , n);
+                composite = (x != n - 1);
+            }
+            if (composite)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * P^L, or 0 if it does not fit in a long.
+     */
+    static constexpr uint64_t _computeOrder()
+    {
+        unsigned __int128 order = 1;
+        for (long i = 0; i < L; i++)
+        {
+            order *= (uint64_t) P;
+            if (order > (uint64_t) INT64_MAX)
+            {
+                return 0;
+            }
+        }
+        return (uint64_t) order;
+    }
+
+    /**
+     * -m^-1 mod 2^64 for odd m, by Newton iteration.
+     */
+    static constexpr uint64_t _montgomeryInverse(uint64_t m)
+    {
+        uint64_t inv = m;
+        for (int i = 0; i < 5; i++)
+        {
+            inv *= 2 - m * inv;
+        }
+        return 0 - inv;
+    }
+
+public:
+    static_assert(P > 1 && L > 0 , "GF(P**L) needs P > 1 and L > 0");
+    static_assert(_isPrime((uint64_t) P) , "the char of the field must be prime");
+
+    /** The order of the field. */
+    static constexpr uint64_t ORDER = _computeOrder();
+
+    static_assert(ORDER != 0 , "the order of the field must fit in a long");
+
+private:
+    /** The order is a power of two, reducing is masking. */
+    static constexpr bool _IS_POW2 = (ORDER & (ORDER - 1)) == 0;
+    /** The order is 2^k - 1, reducing is folding the high bits onto the low ones. */
+    static constexpr bool _IS_MERSENNE = ((ORDER + 1) & ORDER) == 0;
+    /** Products of two residues fit in 64 bits. */
+    static constexpr bool _IS_SMALL = ORDER <= UINT32_MAX;
+    /** The number of bits of a Mersenne order. */
+    static constexpr int _MERSENNE_BITS = 64 - __builtin_clzll(ORDER);
+    /** Montgomery constants, used for the remaining (odd) orders. */
+    static constexpr uint64_t _M_INV = (ORDER & 1) ? _montgomeryInverse(ORDER) : 0;
+    static constexpr uint64_t _R2 = (ORDER & 1) ? _mulModSlow((0 - ORDER) % ORDER ,
+                                                             (0 - ORDER) % ORDER , ORDER) : 0;
+
+    uint64_t _n; /** Number representation of the field (after modulo). */
+
+    /**
+     * Montgomery reduction.
+     * @param t a number smaller than ORDER * 2^64.
+     * @return t * 2^-64 mod ORDER.
+     */
+    static constexpr uint64_t _redc(unsigned __int128 t)
+    {
+        uint64_t u = (uint64_t) t * _M_INV;
+        uint64_t r = (uint64_t) ((t + (unsigned __int128) u * ORDER) >> 64);
+        return (r >= ORDER) ? r - ORDER : r;
+    }
+
+    /**
+     * Reduces a signed number into the field.
+     * @param n long number.
+     * @return n mod ORDER, never negative.
+     */
+    static constexpr uint64_t _convertNumberToField(long n)
+    {
+        if (n >= 0)
+        {
+            return (uint64_t) n % ORDER;
+        }
+        uint64_t r = (0 - (uint64_t) n) % ORDER;
+        return (r == 0) ? 0 : ORDER - r;
+    }
+
+    /**
+     * Multiplies two residues, the branches are on constants so only one survives.
+     * @param a residue.
+     * @param b residue.
+     * @return a * b mod ORDER.
+     */
+    static constexpr uint64_t _mulMod(uint64_t a , uint64_t b)
+    {
+        if (_IS_POW2)
+        {
+            return (a * b) & (ORDER - 1);
+        }
+        if (_IS_SMALL)
+        {
+            return (a * b) % ORDER;
+        }
+        if (_IS_MERSENNE)
+        {
+            unsigned __int128 product = (unsigned __int128) a * b;
+            uint64_t folded = (uint64_t) (product & ORDER) + (uint64_t) (product >> _MERSENNE_BITS);
+            folded = (folded & ORDER) + (folded >> _MERSENNE_BITS);
+            return (folded >= ORDER) ? folded - ORDER : folded;
+        }
+        return _redc((unsigned __int128) _redc((unsigned __int128) a * b) * _R2);
+    }
+
+    /**
+     * Adds two residues.
+     * @param a residue.
+     * @param b residue.
+     * @return a + b mod ORDER.
+     */
+    static constexpr uint64_t _addMod(uint64_t a , uint64_t b)
+    {
+        uint64_t s = a + b;
+        return (s >= ORDER) ? s - ORDER : s;
+    }
+
+    /**
+     * Subtracts two residues.
+     * @param a residue.
+     * @param b residue.
+     * @return a - b mod ORDER.
+     */
+    static constexpr uint64_t _subMod(uint64_t a , uint64_t b)
+    { return (a >= b) ? a - b : a + (ORDER - b); }
+
+public:
+    /**
+     * A constructor.
+     * Default ctor, the zero of the field.
+     */
+    constexpr GFNumberT() : _n(0)
+    {};
+
+    /**
+     * A constructor.
+     * @param n A number, converted into the field.
+     */
+    constexpr GFNumberT(long n) : _n(_convertNumberToField(n))
+    {};
+
+    /**
+     * A constructor.
+     * Conversion from a runtime GFNumber, which must belong to GF(P**L).
+     * @param number GFNumber instance.
+     */
+    explicit GFNumberT(const GFNumber &number) : _n((uint64_t) number.getNumber())
+    {
+        assert(number.getField() == getField());
+    };
+
+    /**
+     * Conversion to a runtime GFNumber.
+     * @return the same number as a GFNumber of GF(P**L).
+     */
+    explicit operator GFNumber() const
+    { return GFNumber((long) _n , getField()); }
+
+    /**
+     * Getter for the field of the number (constructed once).
+     * @return GF(P**L).
+     */
+    static const GField &getField()
+    {
+        static const GField field(P , L);
+        return field;
+    }
+
+    /**
+     * Gets the number from the specific field.
+     * @return _n the number.
+     */
+    constexpr long getNumber() const
+    { return (long) _n; }
+
+    // ------------ operators ------------
+
+    /**
+     * Operator +
+     * @param other another GFNumberT.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator+(const GFNumberT &other) const
+    { return fromReduced(_addMod(_n , other._n)); }
+
+    /**
+     * Operator + on a number and a long (GFNumberT + long).
+     * @param rparam long number.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator+(long rparam) const
+    { return fromReduced(_addMod(_n , _convertNumberToField(rparam))); }
+
+    /**
+     * Operator -
+     * @param other another GFNumberT.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator-(const GFNumberT &other) const
+    { return fromReduced(_subMod(_n , other._n)); }
+
+    /**
+     * Operator - on a number and a long (GFNumberT - long).
+     * @param rparam long number.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator-(long rparam) const
+    { return fromReduced(_subMod(_n , _convertNumberToField(rparam))); }
+
+    /**
+     * Operator *
+     * @param other another GFNumberT.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator*(const GFNumberT &other) const
+    { return fromReduced(_mulMod(_n , other._n)); }
+
+    /**
+     * Operator * on a number and a long (GFNumberT * long).
+     * @param rparam long number.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator*(long rparam) const
+    { return fromReduced(_mulMod(_n , _convertNumberToField(rparam))); }
+
+    /**
+     * Operator % on two numbers, the remainder of the residues (like GFNumber).
+     * @param other GFNumberT, must not be zero.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator%(const GFNumberT &other) const
+    { return fromReduced(_n % other._n); }
+
+    /**
+     * Operator % on a number and a long (like GFNumber).
+     * @param rparam long number, must not be zero in the field.
+     * @return The result GFNumberT
+     */
+    constexpr GFNumberT operator%(long rparam) const
+    { return fromReduced(_n % _convertNumberToField(rparam)); }
+
+    /**
+     * Raises the number to the given power (square-and-multiply), a negative exponent raises
+     * the inverse.
+     * @param exponent long number.
+     * @return The result GFNumberT
+     */
+    GFNumberT pow(long exponent) const
+    {
+        uint64_t base = _n , result = 1;
+        if (exponent < 0)
+        {
+            base = inverse()._n;
+            result = base;
+            exponent = -(exponent + 1);
+        }
+        for (uint64_t e = (uint64_t) exponent; e > 0; e >>= 1)
+        {
+            if (e & 1)
+            {
+                result = _mulMod(result , base);
+            }
+            base = _mulMod(base , base);
+        }
+        return fromReduced(result);
+    }
+
+    /**
+     * The multiplicative inverse (binary extended gcd), the number must be coprime to ORDER.
+     * @return The result GFNumberT
+     */
+    GFNumberT inverse() const
+    {
+        uint64_t result = GField::modInverse(_n , ORDER);
+        assert(result != 0); // the number has no inverse in the field
+        return fromReduced(result);
+    }
+
+    /**
+     * Operator /, the product with the inverse of the other number.
+     * @param other another GFNumberT, must be invertible in the field.
+     * @return The result GFNumberT
+     */
+    GFNumberT operator/(const GFNumberT &other) const
+    { return *this * other.inverse(); }
+
+    /**
+     * Operator / on a number and a long (GFNumberT / long).
+     * @param rparam long number, must be invertible in the field.
+     * @return The result GFNumberT
+     */
+    GFNumberT operator/(long rparam) const
+    { return *this * GFNumberT(rparam).inverse(); }
+
+    /**
+     * Operator /=
+     * @param other another GFNumberT, must be invertible in the field.
+     * @return This GFNumberT
+     */
+    GFNumberT &operator/=(const GFNumberT &other)
+    { return *this = *this / other; }
+
+    /**
+     * Operator /= on a number and a long (GFNumberT /= long).
+     * @param rparam long number, must be invertible in the field.
+     * @return This GFNumberT
+     */
+    GFNumberT &operator/=(long rparam)
+    { return *this = *this / rparam; }
+
+    /**
+     * Operator +=
+     * @param other another GFNumberT.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator+=(const GFNumberT &other)
+    { return *this = *this + other; }
+
+    /**
+     * Operator += on a number and a long (GFNumberT += long).
+     * @param rparam long number.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator+=(long rparam)
+    { return *this = *this + rparam; }
+
+    /**
+     * Operator -=
+     * @param other another GFNumberT.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator-=(const GFNumberT &other)
+    { return *this = *this - other; }
+
+    /**
+     * Operator -= on a number and a long (GFNumberT -= long).
+     * @param rparam long number.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator-=(long rparam)
+    { return *this = *this - rparam; }
+
+    /**
+     * Operator *=
+     * @param other another GFNumberT.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator*=(const GFNumberT &other)
+    { return *this = *this * other; }
+
+    /**
+     * Operator *= on a number and a long (GFNumberT *= long).
+     * @param rparam long number.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator*=(long rparam)
+    { return *this = *this * rparam; }
+
+    /**
+     * Operator %=
+     * @param other another GFNumberT, must not be zero.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator%=(const GFNumberT &other)
+    { return *this = *this % other; }
+
+    /**
+     * Operator %= on a number and a long (GFNumberT %= long).
+     * @param rparam long number, must not be zero in the field.
+     * @return This GFNumberT
+     */
+    constexpr GFNumberT &operator%=(long rparam)
+    { return *this = *this % rparam; }
+
+    /**
+     * Equal operator overloading, checks if both numbers are the same.
+     * @param other another GFNumberT.
+     * @return true if they are the same, false otherwise.
+     */
+    constexpr bool operator==(const GFNumberT &other) const
+    { return _n == other._n; }
+
+    /**
+     * Not equal operator overloading.
+     * @param other another GFNumberT.
+     * @return true if they are not the same, false otherwise.
+     */
+    constexpr bool operator!=(const GFNumberT &other) const
+    { return _n != other._n; }
+
+    /**
+     * Greater equal operator overloading.
+     * @param other another GFNumberT.
+     * @return true if the n of this is greater or equal to the n of the other number.
+     */
+    constexpr bool operator>=(const GFNumberT &other) const
+    { return _n >= other._n; }
+
+    /**
+     * Greater operator overloading.
+     * @param other another GFNumberT.
+     * @return true if the n of this is greater than the n of the other number.
+     */
+    constexpr bool operator>(const GFNumberT &other) const
+    { return _n > other._n; }
+
+    /**
+     * Smaller equal operator overloading.
+     * @param other another GFNumberT.
+     * @return true if the n of this is smaller or equal to the n of the other number.
+     */
+    constexpr bool operator<=(const GFNumberT &other) const
+    { return _n <= other._n; }
+
+    /**
+     * Smaller operator overloading.
+     * @param other another GFNumberT.
+     * @return true if the n of this is smaller than the n of the other number.
+     */
+    constexpr bool operator<(const GFNumberT &other) const
+    { return _n < other._n; }
+
+    /**
+     * Creates a number from a residue which is already in [0, ORDER).
+     * @param residue the residue.
+     * @return the number.
+     */
+    static constexpr GFNumberT fromReduced(uint64_t residue)
+    {
+        GFNumberT number;
+        number._n = residue;
+        return number;
+    }
+
+    /**
+     * Operator overloading of "<<", same output as GFNumber.
+     * @param out ostream reference.
+     * @param number some GFNumberT reference.
+     * @return ostream reference with the desire output.
+     */
+    friend std::ostream &operator<<(std::ostream &out , const GFNumberT &number)
+    {
+        return (out << number.getNumber() << " GF(" << P << "**" << L << ")");
+    }
+
+    /**
+     * Operator overloading of ">>", same input as GFNumber: the number, the char and the
+     * degree, which must be the ones of GF(P**L).
+     * @param in some istream input.
+     * @param number GFNumberT reference.
+     * @return istream reference with the desire input.
+     */
+    friend std::istream &operator>>(std::istream &in , GFNumberT &number)
+    {
+        long n , p , l;
+        in >> n >> p >> l;
+        if (in)
+        {
+            assert(std::labs(p) == P && l == L); // the number must belong to GF(P**L)
+            number = GFNumberT(n);
+        }
+        return in;
+    }
+};
+
+template<long P , long L>
+constexpr uint64_t GFNumberT<P , L>::ORDER;
+
+#endif //GFNUMBERT_HPP
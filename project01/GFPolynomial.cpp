@@ -0,0 +1,668 @@
+// GFPolynomial.cpp
+
+#include "GFPolynomial.h"
+#include <algorithm>
+#include <utility>
+#include "NumberTheoreticTransform.h"
+#include "SubproductTree.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class GFPolynomial.
+// --------------------------------------------------------------------------------------
+
+// ------------------------------- coefficient arithmetic -------------------------------
+
+/**
+ * The coefficients of the integer arithmetic, the residues modulo the order.
+ */
+struct IntegerCoefficients
+{
+    const ModReducer &reducer;
+
+    uint64_t add(uint64_t a , uint64_t b) const
+    { return reducer.addMod(a , b); }
+
+    uint64_t sub(uint64_t a , uint64_t b) const
+    { return reducer.subMod(a , b); }
+
+    /** accumulator[i] += scalar * a[i]. */
+    void scaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator , size_t n) const
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            accumulator[i] = reducer.addMod(accumulator[i] , reducer.mulMod(scalar , a[i]));
+        }
+    }
+};
+
+/**
+ * The coefficients of the polynomial arithmetic, the elements of GF(p^l).
+ */
+struct ExtensionCoefficients
+{
+    const GFExtension &extension;
+
+    uint64_t add(uint64_t a , uint64_t b) const
+    { return extension.add(a , b); }
+
+    uint64_t sub(uint64_t a , uint64_t b) const
+    { return extension.sub(a , b); }
+
+    /** accumulator[i] += scalar * a[i], by the binary kernels for p = 2. */
+    void scaleAdd(uint64_t scalar , const uint64_t *a , uint64_t *accumulator , size_t n) const
+    { extension.scaleAdd(scalar , a , accumulator , n); }
+};
+
+// ------------------------------- multiplication -------------------------------
+
+/**
+ * Schoolbook multiplication, one scaled row of b per coefficient of a.
+ * @param product output, the n + m - 1 coefficients of a * b.
+ */
+template<typename Coefficients>
+static void schoolbook(const Coefficients &ring , const uint64_t *a , size_t n ,
+                       const uint64_t *b , size_t m , uint64_t *product)
+{
+    std::fill(product , product + n + m - 1 , 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (a[i] != 0)
+        {
+            ring.scaleAdd(a[i] , b , product + i , m);
+        }
+    }
+}
+
+/**
+ * Karatsuba multiplication of two factors of the same length: with a = a0 + x^k a1 and
+ * b = b0 + x^k b1, a * b = a0 b0 + x^k ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) + x^2k a1 b1.
+ * @param product output, the 2n - 1 coefficients of a * b.
+ * @param scratch 4n + 4 log2(n) residues of workspace.
+ */
+template<typename Coefficients>
+static void karatsuba(const Coefficients &ring , const uint64_t *a , const uint64_t *b , size_t n ,
+                      uint64_t *product , uint64_t *scratch)
+{
+    if (n < POLY_KARATSUBA_LENGTH)
+    {
+        schoolbook(ring , a , n , b , n , product);
+        return;
+    }
+    const size_t low = n / 2 , high = n - low;
+    uint64_t *aSum = scratch , *bSum = scratch + high , *middle = scratch + 2 * high;
+    for (size_t i = 0; i < high; i++)
+    {
+        aSum[i] = (i < low) ? ring.add(a[i] , a[low + i]) : a[low + i];
+        bSum[i] = (i < low) ? ring.add(b[i] , b[low + i]) : b[low + i];
+    }
+    karatsuba(ring , aSum , bSum , high , middle , scratch + 4 * high);
+    karatsuba(ring , a , b , low , product , scratch + 4 * high);
+    karatsuba(ring , a + low , b + low , high , product + 2 * low , scratch + 4 * high);
+    product[2 * low - 1] = 0;
+    for (size_t i = 0; i < 2 * low - 1; i++)
+    {
+        middle[i] = ring.sub(middle[i] , product[i]);
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++)
+    {
+        middle[i] = ring.sub(middle[i] , product[2 * low + i]);
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++)
+    {
+        product[low + i] = ring.add(product[low + i] , middle[i]);
+    }
+}
+
+/**
+ * Multiplies by the schoolbook method or by Karatsuba on chunks of the longer factor as long
+ * as the shorter one.
+ * @param product output, the n + m - 1 coefficients of a * b.
+ */
+template<typename Coefficients>
+static void multiplyCoefficients(const Coefficients &ring , const uint64_t *a , size_t n ,
+                                 const uint64_t *b , size_t m , uint64_t *product)
+{
+    if (n < m)
+    {
+        std::swap(a , b);
+        std::swap(n , m);
+    }
+    if (m < POLY_KARATSUBA_LENGTH)
+    {
+        schoolbook(ring , a , n , b , m , product);
+        return;
+    }
+    std::fill(product , product + n + m - 1 , 0);
+    std::vector<uint64_t> chunk(m) , chunkProduct(2 * m - 1) , scratch(4 * m + 256);
+    for (size_t start = 0; start < n; start += m)
+    {
+        const size_t length = std::min(m , n - start);
+        std::copy(a + start , a + start + length , chunk.begin());
+        std::fill(chunk.begin() + length , chunk.end() , 0);
+        karatsuba(ring , chunk.data() , b , m , chunkProduct.data() , scratch.data());
+        const size_t terms = std::min(2 * m - 1 , n + m - 1 - start);
+        for (size_t i = 0; i < terms; i++)
+        {
+            product[start + i] = ring.add(product[start + i] , chunkProduct[i]);
+        }
+    }
+}
+
+/**
+ * The product of two coefficient arrays, by the method described in the class comment.
+ * @param field the field of the coefficients.
+ * @param a n residues of the field.
+ * @param n the length of a.
+ * @param b m residues of the field.
+ * @param m the length of b.
+ * @param product output, the n + m - 1 coefficients of a * b (nothing if n or m is 0),
+ * must not overlap a or b.
+ */
+void GFPolynomial::multiply(const GField &field , const uint64_t *a , size_t n , const uint64_t *b ,
+                            size_t m , uint64_t *product)
+{
+    if (n == 0 || m == 0)
+    {
+        return;
+    }
+    if (field.getExtension() != nullptr)
+    {
+        const ExtensionCoefficients ring{*field.getExtension()};
+        multiplyCoefficients(ring , a , n , b , m , product);
+    }
+    else if (std::min(n , m) >= POLY_NTT_LENGTH)
+    {
+        NumberTheoreticTransform::multiply((uint64_t) field.getOrder() , a , n , b , m , product);
+    }
+    else
+    {
+        multiplyCoefficients(IntegerCoefficients{field.getReducer()} , a , n , b , m , product);
+    }
+}
+
+// ------------------------------- GFPolynomial -------------------------------
+
+/**
+ * A constructor.
+ * The zero polynomial (of GF(2) by default).
+ * @param field the field of the coefficients.
+ */
+GFPolynomial::GFPolynomial(const GField &field) : _field(field.getId())
+{
+}
+
+/**
+ * A constructor.
+ * @param field the field of the coefficients.
+ * @param coefficients long numbers, converted into the field, the constant first.
+ */
+GFPolynomial::GFPolynomial(const GField &field , const std::vector<long> &coefficients) :
+        _field(field.getId())
+{
+    _coefficients.reserve(coefficients.size());
+    for (long n : coefficients)
+    {
+        _coefficients.push_back(field.element(n).getResidue());
+    }
+    _trim();
+}
+
+/**
+ * Builds a polynomial from residues which are already elements of the field.
+ * @param field the field of the coefficients.
+ * @param residues elements of the field, the constant first.
+ * @return the polynomial.
+ */
+GFPolynomial GFPolynomial::fromResidues(const GField &field , std::vector<uint64_t> residues)
+{
+    GFPolynomial result(field);
+    result._coefficients = std::move(residues);
+    result._trim();
+    return result;
+}
+
+/**
+ * Removes the leading zero coefficients.
+ */
+void GFPolynomial::_trim()
+{
+    while (!_coefficients.empty() && _coefficients.back() == 0)
+    {
+        _coefficients.pop_back();
+    }
+}
+
+/**
+ * Getter for one coefficient.
+ * @param i any power of x.
+ * @return the coefficient of x^i (0 above the degree).
+ */
+GFNumber GFPolynomial::getCoefficient(size_t i) const
+{
+    return GFNumber((i < _coefficients.size()) ? (long) _coefficients[i] : 0 , getField());
+}
+
+/**
+ * Getter for the leading coefficient.
+ * @return the coefficient of x^degree(), 0 for the zero polynomial.
+ */
+GFNumber GFPolynomial::leadingCoefficient() const
+{
+    return GFNumber(_coefficients.empty() ? 0 : (long) _coefficients.back() , getField());
+}
+
+/**
+ * Evaluates the polynomial at a point with Horner's rule.
+ * @param x a GFNumber of the field of the polynomial.
+ * @return the value at x.
+ */
+GFNumber GFPolynomial::evaluate(const GFNumber &x) const
+{
+    assert(x.getField().getId() == _field); // a point of another field
+    const GField &field = _getField();
+    GFElement point = x.getElement() , value(0);
+    for (size_t i = _coefficients.size(); i-- > 0;)
+    {
+        value = field.add(field.mul(value , point) , GFElement(_coefficients[i]));
+    }
+    return GFNumber((long) value.getResidue() , getField());
+}
+
+/**
+ * Evaluates the polynomial at many points, by a SubproductTree.
+ * @param points a GFVector of the field of the polynomial.
+ * @param pool the pool running the nodes of the tree (may be null).
+ * @return the values, in the order of the points.
+ */
+GFVector GFPolynomial::evaluate(const GFVector &points , ThreadPool *pool) const
+{
+    assert(points.getField().getId() == _field); // points of another field
+    GFVector values(getField() , points.size());
+    if (points.size() == 0)
+    {
+        return values;
+    }
+    std::vector<uint64_t> residues(points.size());
+    SubproductTree(getField() , points.data() , points.size() , pool).evaluate(
+            data() , _coefficients.size() , residues.data() , pool);
+    for (size_t i = 0; i < residues.size(); i++)
+    {
+        values.set(i , (long) residues[i]);
+    }
+    return values;
+}
+
+/**
+ * The polynomial of degree below n through n points, by a SubproductTree.
+ * @param points n distinct numbers of a field (not the ring Z/p^l).
+ * @param values n numbers of the same field, the values at the points.
+ * @param pool the pool running the nodes of the tree (may be null).
+ * @return the polynomial.
+ */
+GFPolynomial GFPolynomial::interpolate(const GFVector &points , const GFVector &values ,
+                                       ThreadPool *pool)
+{
+    assert(points.getField() == values.getField() && points.size() == values.size());
+    if (points.size() == 0)
+    {
+        return GFPolynomial(points.getField());
+    }
+    std::vector<uint64_t> coefficients(points.size());
+    SubproductTree(points.getField() , points.data() , points.size() , pool).interpolate(
+            values.data() , coefficients.data() , pool);
+    return fromResidues(points.getField() , std::move(coefficients));
+}
+
+/**
+ * The formal derivative.
+ * @return the derivative, the sum of i * a_i * x^(i - 1).
+ */
+GFPolynomial GFPolynomial::derivative() const
+{
+    const GField &field = _getField();
+    std::vector<uint64_t> result(_coefficients.empty() ? 0 : _coefficients.size() - 1);
+    for (size_t i = 1; i < _coefficients.size(); i++)
+    {
+        // i is an integer: the constant i mod p of GF(p^l), i mod p^l of Z/p^l
+        long factor = (field.getExtension() != nullptr) ? (long) (i % field.getChar()) : (long) i;
+        result[i - 1] = field.mul(field.element(factor) ,
+                                  GFElement(_coefficients[i])).getResidue();
+    }
+    return fromResidues(field , std::move(result));
+}
+
+/**
+ * Divides by the leading coefficient.
+ * @return the monic polynomial, the zero polynomial stays zero.
+ */
+GFPolynomial GFPolynomial::monic() const
+{
+    if (_coefficients.empty())
+    {
+        return *this;
+    }
+    return *this * leadingCoefficient().inverse();
+}
+
+/**
+ * Schoolbook Euclidean division: every step removes the leading term of the remainder.
+ * @param remainder the dividend, overwritten by the remainder (m - 1 low coefficients).
+ * @param n the length of the dividend, at least m.
+ * @param divisor m coefficients.
+ * @param leadInverse the inverse of the leading coefficient of the divisor.
+ * @param quotient output, n - m + 1 coefficients.
+ */
+template<typename Coefficients>
+static void divideCoefficients(const Coefficients &ring , const GField &field ,
+                               uint64_t *remainder , size_t n , const uint64_t *divisor , size_t m ,
+                               GFElement leadInverse , uint64_t *quotient)
+{
+    for (size_t k = n - m + 1; k-- > 0;)
+    {
+        GFElement term = field.mul(GFElement(remainder[k + m - 1]) , leadInverse);
+        quotient[k] = term.getResidue();
+        if (quotient[k] != 0)
+        {
+            ring.scaleAdd(field.neg(term).getResidue() , divisor , remainder + k , m);
+        }
+    }
+}
+
+/**
+ * The inverse of a power series by Newton's iteration: if a * g = 1 mod x^k then
+ * g' = g + g * (1 - a * g) is the inverse modulo x^2k, and 1 - a * g has no term below x^k.
+ * @param field the field of the coefficients.
+ * @param a n coefficients, with an invertible constant.
+ * @param n the length of a.
+ * @param length the precision.
+ * @param inverse output, the length coefficients of a^-1 mod x^length.
+ */
+void GFPolynomial::inverseSeries(const GField &field , const uint64_t *a , size_t n ,
+                                 size_t length , uint64_t *inverse)
+{
+    assert(n > 0 && length > 0);
+    inverse[0] = field.inv(GFElement(a[0])).getResidue();
+    assert(inverse[0] != 0); // the constant is not invertible
+    std::vector<uint64_t> product(2 * length) , correction(2 * length);
+    for (size_t k = 1; k < length; k *= 2)
+    {
+        const size_t next = std::min(2 * k , length) , used = std::min(n , next);
+        // the terms [k, next) of a * g, the lower ones are 1, 0, ..., 0
+        std::fill(product.begin() , product.begin() + next , 0);
+        multiply(field , a , used , inverse , k , product.data());
+        multiply(field , inverse , k , product.data() + k , next - k , correction.data());
+        for (size_t i = 0; i < next - k; i++)
+        {
+            inverse[k + i] = field.neg(GFElement(correction[i])).getResidue();
+        }
+    }
+}
+
+/**
+ * Euclidean division of coefficient arrays. Below POLY_NEWTON_LENGTH it removes one
+ * leading term per step, above it reverses the polynomials, so the quotient is the product
+ * of the reversed dividend and the series inverse of the reversed divisor.
+ * @param field the field of the coefficients.
+ * @param a n coefficients.
+ * @param n the length of a, at least m.
+ * @param b m coefficients, with an invertible leading one.
+ * @param m the length of b, not 0.
+ * @param quotient output, n - m + 1 coefficients.
+ * @param remainder output, m - 1 coefficients.
+ */
+void GFPolynomial::divide(const GField &field , const uint64_t *a , size_t n , const uint64_t *b ,
+                          size_t m , uint64_t *quotient , uint64_t *remainder)
+{
+    assert(m > 0 && n >= m);
+    const size_t length = n - m + 1;
+    if (length < POLY_NEWTON_LENGTH || m < POLY_NEWTON_LENGTH)
+    {
+        GFElement leadInverse = field.inv(GFElement(b[m - 1]));
+        assert(leadInverse.getResidue() != 0); // the leading coefficient is not invertible
+        std::vector<uint64_t> rest(a , a + n);
+        if (field.getExtension() != nullptr)
+        {
+            divideCoefficients(ExtensionCoefficients{*field.getExtension()} , field , rest.data() ,
+                               n , b , m , leadInverse , quotient);
+        }
+        else
+        {
+            divideCoefficients(IntegerCoefficients{field.getReducer()} , field , rest.data() , n ,
+                               b , m , leadInverse , quotient);
+        }
+        std::copy(rest.begin() , rest.begin() + (m - 1) , remainder);
+        return;
+    }
+    std::vector<uint64_t> reversedA(length) , reversedB(std::min(m , length)) , inverse(length);
+    for (size_t i = 0; i < reversedB.size(); i++)
+    {
+        reversedB[i] = b[m - 1 - i];
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        reversedA[i] = a[n - 1 - i];
+    }
+    inverseSeries(field , reversedB.data() , reversedB.size() , length , inverse.data());
+    std::vector<uint64_t> product(n + length);
+    multiply(field , reversedA.data() , length , inverse.data() , length , product.data());
+    for (size_t i = 0; i < length; i++)
+    {
+        quotient[i] = product[length - 1 - i];
+    }
+    // only the terms below m - 1 of quotient * b are needed, so both are cut there
+    multiply(field , quotient , std::min(length , m - 1) , b , m - 1 , product.data());
+    for (size_t i = 0; i + 1 < m; i++)
+    {
+        remainder[i] = field.sub(GFElement(a[i]) , GFElement(product[i])).getResidue();
+    }
+}
+
+/**
+ * Euclidean division.
+ * @param divisor a non zero polynomial of the same field, with an invertible leading
+ * coefficient.
+ * @param quotient output, may be nullptr.
+ * @param remainder output, of degree below the one of divisor, may be nullptr.
+ */
+void GFPolynomial::divmod(const GFPolynomial &divisor , GFPolynomial *quotient ,
+                          GFPolynomial *remainder) const
+{
+    _checkCompatible(divisor);
+    assert(!divisor._coefficients.empty()); // division by zero
+    const GField &field = _getField();
+    const size_t n = _coefficients.size() , m = divisor._coefficients.size();
+    std::vector<uint64_t> rest(_coefficients) , result;
+    if (n >= m)
+    {
+        result.resize(n - m + 1);
+        rest.resize(m - 1);
+        divide(field , data() , n , divisor.data() , m , result.data() , rest.data());
+    }
+    else
+    {
+        assert(field.inv(GFElement(divisor._coefficients.back())).getResidue() != 0);
+    }
+    if (quotient != nullptr)
+    {
+        *quotient = fromResidues(field , std::move(result));
+    }
+    if (remainder != nullptr)
+    {
+        *remainder = fromResidues(field , std::move(rest));
+    }
+}
+
+/**
+ * The greatest common divisor by the Euclidean algorithm.
+ * @param a GFPolynomial instance over a field.
+ * @param b GFPolynomial instance of the same field.
+ * @return the monic gcd of a and b, zero if both are zero.
+ */
+GFPolynomial GFPolynomial::gcd(const GFPolynomial &a , const GFPolynomial &b)
+{
+    a._checkCompatible(b);
+    GFPolynomial x(a) , y(b);
+    while (y.degree() >= 0)
+    {
+        GFPolynomial rest(x.getField());
+        x.divmod(y , nullptr , &rest);
+        x = std::move(y);
+        y = std::move(rest);
+    }
+    return x.monic();
+}
+
+/**
+ * The sum of two polynomials of the same field.
+ * @param other GFPolynomial instance.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator+(const GFPolynomial &other) const
+{
+    GFPolynomial result(*this);
+    return result += other;
+}
+
+/**
+ * The difference of two polynomials of the same field.
+ * @param other GFPolynomial instance.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator-(const GFPolynomial &other) const
+{
+    GFPolynomial result(*this);
+    return result -= other;
+}
+
+/**
+ * The product of two polynomials of the same field (see multiply()).
+ * @param other GFPolynomial instance.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator*(const GFPolynomial &other) const
+{
+    GFPolynomial result(*this);
+    return result *= other;
+}
+
+/**
+ * Multiplies every coefficient by a scalar.
+ * @param scalar a GFNumber of the field of the polynomial.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator*(const GFNumber &scalar) const
+{
+    assert(scalar.getField().getId() == _field); // a scalar of another field
+    const GField &field = _getField();
+    std::vector<uint64_t> result(_coefficients);
+    for (uint64_t &coefficient : result)
+    {
+        coefficient = field.mul(GFElement(coefficient) , scalar.getElement()).getResidue();
+    }
+    return fromResidues(field , std::move(result));
+}
+
+/**
+ * The quotient of the Euclidean division.
+ * @param other the divisor.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator/(const GFPolynomial &other) const
+{
+    GFPolynomial quotient(getField());
+    divmod(other , &quotient , nullptr);
+    return quotient;
+}
+
+/**
+ * The remainder of the Euclidean division.
+ * @param other the divisor.
+ * @return The result GFPolynomial
+ */
+GFPolynomial GFPolynomial::operator%(const GFPolynomial &other) const
+{
+    GFPolynomial remainder(getField());
+    divmod(other , nullptr , &remainder);
+    return remainder;
+}
+
+/**
+ * plus-assignment operator, for two polynomials of the same field.
+ * @param other GFPolynomial instance.
+ * @return this.
+ */
+GFPolynomial &GFPolynomial::operator+=(const GFPolynomial &other)
+{
+    _checkCompatible(other);
+    const GField &field = _getField();
+    if (_coefficients.size() < other._coefficients.size())
+    {
+        _coefficients.resize(other._coefficients.size() , 0);
+    }
+    for (size_t i = 0; i < other._coefficients.size(); i++)
+    {
+        _coefficients[i] = field.add(GFElement(_coefficients[i]) ,
+                                     GFElement(other._coefficients[i])).getResidue();
+    }
+    _trim();
+    return *this;
+}
+
+/**
+ * minus-assignment operator, for two polynomials of the same field.
+ * @param other GFPolynomial instance.
+ * @return this.
+ */
+GFPolynomial &GFPolynomial::operator-=(const GFPolynomial &other)
+{
+    _checkCompatible(other);
+    const GField &field = _getField();
+    if (_coefficients.size() < other._coefficients.size())
+    {
+        _coefficients.resize(other._coefficients.size() , 0);
+    }
+    for (size_t i = 0; i < other._coefficients.size(); i++)
+    {
+        _coefficients[i] = field.sub(GFElement(_coefficients[i]) ,
+                                     GFElement(other._coefficients[i])).getResidue();
+    }
+    _trim();
+    return *this;
+}
+
+/**
+ * multiply-assignment operator, for two polynomials of the same field (see multiply()).
+ * @param other GFPolynomial instance.
+ * @return this.
+ */
+GFPolynomial &GFPolynomial::operator*=(const GFPolynomial &other)
+{
+    _checkCompatible(other);
+    if (_coefficients.empty() || other._coefficients.empty())
+    {
+        _coefficients.clear();
+        return *this;
+    }
+    std::vector<uint64_t> product(_coefficients.size() + other._coefficients.size() - 1);
+    multiply(_getField() , data() , _coefficients.size() , other.data() ,
+             other._coefficients.size() , product.data());
+    _coefficients = std::move(product);
+    _trim(); // zero divisors of Z/p^l
+    return *this;
+}
+
+/**
+ * Operator overloading of "<<", prints the coefficients from the constant up and the field.
+ * @param out ostream reference.
+ * @param polynomial reference to a GFPolynomial instance.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const GFPolynomial &polynomial)
+{
+    out << "[";
+    for (size_t i = 0; i < polynomial._coefficients.size(); i++)
+    {
+        out << ((i == 0) ? "" : " ") << polynomial._coefficients[i];
+    }
+    return (out << "] " << polynomial.getField());
+}
@@ -0,0 +1,303 @@
+// GFPolynomial.h
+//----------- include guards------------
+#ifndef GFPOLYNOMIAL_H
+#define GFPOLYNOMIAL_H
+//-------------- includes --------------
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFVector.h"
+
+#define POLY_KARATSUBA_LENGTH 32 /** products of shorter factors are schoolbook ones */
+#define POLY_NTT_LENGTH 128 /** products of factors this long use the transforms */
+#define POLY_NEWTON_LENGTH 1024 /** divisions with quotients and divisors this long use Newton */
+
+//--------------------------------------
+// forward declaration of the ThreadPool class:
+class ThreadPool;
+
+/**
+ *  A GFPolynomial class.
+ *  A polynomial with coefficients in one GField, stored as a contiguous array of residues,
+ *  the constant first and without leading zeros (the zero polynomial has no coefficients).
+ *  Products pick their method from the length of the shorter factor: the schoolbook method
+ *  below POLY_KARATSUBA_LENGTH coefficients, Karatsuba below POLY_NTT_LENGTH, and for the
+ *  integer arithmetic a number theoretic transform above (see NumberTheoreticTransform: a
+ *  single one when the order is a prime with enough roots of unity, three primes and the
+ *  CRT otherwise). The fields with the polynomial arithmetic stay on Karatsuba.
+ *  Long divisions cost a few products (Newton's iteration on the reversed polynomials).
+ *  Division needs an invertible leading coefficient, which every field has, but the ring
+ *  Z/p^l (the default arithmetic of l > 1) does not, so gcd() is only meant for fields.
+ */
+class GFPolynomial
+{
+private:
+    GFieldId _field; /** The id of the field of the coefficients. */
+    std::vector<uint64_t> _coefficients; /** The coefficients, the constant first. */
+
+    /**
+     * Removes the leading zero coefficients.
+     */
+    void _trim();
+
+    /**
+     * Checks that the other polynomial has the same field.
+     * @param other GFPolynomial instance.
+     */
+    void _checkCompatible(const GFPolynomial &other) const
+    {
+        assert(_field == other._field); // polynomials over different fields
+        (void) other;
+    }
+
+    /**
+     * Lookup of the field of the coefficients.
+     * @return the field.
+     */
+    const GField &_getField() const
+    { return GFieldRegistry::get(_field); }
+
+public:
+    /**
+     * A constructor.
+     * The zero polynomial (of GF(2) by default).
+     * @param field the field of the coefficients.
+     */
+    explicit GFPolynomial(const GField &field = GField());
+
+    /**
+     * A constructor.
+     * @param field the field of the coefficients.
+     * @param coefficients long numbers, converted into the field, the constant first.
+     */
+    GFPolynomial(const GField &field , const std::vector<long> &coefficients);
+
+    /**
+     * Builds a polynomial from residues which are already elements of the field.
+     * @param field the field of the coefficients.
+     * @param residues elements of the field, the constant first.
+     * @return the polynomial.
+     */
+    static GFPolynomial fromResidues(const GField &field , std::vector<uint64_t> residues);
+
+    /**
+     * Getter for the degree.
+     * @return the degree, -1 for the zero polynomial.
+     */
+    long degree() const
+    { return (long) _coefficients.size() - 1; }
+
+    /**
+     * Getter for the field of the coefficients.
+     * @return The field of the coefficients.
+     */
+    GField getField() const
+    { return _getField(); }
+
+    /**
+     * Getter for one coefficient.
+     * @param i any power of x.
+     * @return the coefficient of x^i (0 above the degree).
+     */
+    GFNumber getCoefficient(size_t i) const;
+
+    /**
+     * Getter for the coefficients.
+     * @return array of degree() + 1 residues, the constant first.
+     */
+    const uint64_t *data() const
+    { return _coefficients.data(); }
+
+    /**
+     * Getter for the leading coefficient.
+     * @return the coefficient of x^degree(), 0 for the zero polynomial.
+     */
+    GFNumber leadingCoefficient() const;
+
+    /**
+     * Evaluates the polynomial at a point with Horner's rule.
+     * @param x a GFNumber of the field of the polynomial.
+     * @return the value at x.
+     */
+    GFNumber evaluate(const GFNumber &x) const;
+
+    /**
+     * Evaluates the polynomial at many points, by a SubproductTree.
+     * @param points a GFVector of the field of the polynomial.
+     * @param pool the pool running the nodes of the tree (may be null).
+     * @return the values, in the order of the points.
+     */
+    GFVector evaluate(const GFVector &points , ThreadPool *pool = nullptr) const;
+
+    /**
+     * The polynomial of degree below n through n points, by a SubproductTree.
+     * @param points n distinct numbers of a field (not the ring Z/p^l).
+     * @param values n numbers of the same field, the values at the points.
+     * @param pool the pool running the nodes of the tree (may be null).
+     * @return the polynomial.
+     */
+    static GFPolynomial interpolate(const GFVector &points , const GFVector &values ,
+                                    ThreadPool *pool = nullptr);
+
+    /**
+     * The formal derivative.
+     * @return the derivative, the sum of i * a_i * x^(i - 1).
+     */
+    GFPolynomial derivative() const;
+
+    /**
+     * Divides by the leading coefficient.
+     * @return the monic polynomial, the zero polynomial stays zero.
+     */
+    GFPolynomial monic() const;
+
+    /**
+     * Euclidean division.
+     * @param divisor a non zero polynomial of the same field, with an invertible leading
+     * coefficient.
+     * @param quotient output, may be nullptr.
+     * @param remainder output, of degree below the one of divisor, may be nullptr.
+     */
+    void divmod(const GFPolynomial &divisor , GFPolynomial *quotient ,
+                GFPolynomial *remainder) const;
+
+    /**
+     * The greatest common divisor by the Euclidean algorithm.
+     * @param a GFPolynomial instance over a field.
+     * @param b GFPolynomial instance of the same field.
+     * @return the monic gcd of a and b, zero if both are zero.
+     */
+    static GFPolynomial gcd(const GFPolynomial &a , const GFPolynomial &b);
+
+    /**
+     * The product of two coefficient arrays, by the method described in the class comment.
+     * @param field the field of the coefficients.
+     * @param a n residues of the field.
+     * @param n the length of a.
+     * @param b m residues of the field.
+     * @param m the length of b.
+     * @param product output, the n + m - 1 coefficients of a * b (nothing if n or m is 0),
+     * must not overlap a or b.
+     */
+    static void multiply(const GField &field , const uint64_t *a , size_t n , const uint64_t *b ,
+                         size_t m , uint64_t *product);
+
+    /**
+     * The inverse of a power series by Newton's iteration, in a few products of every
+     * precision up to length.
+     * @param field the field of the coefficients.
+     * @param a n coefficients, with an invertible constant.
+     * @param n the length of a.
+     * @param length the precision.
+     * @param inverse output, the length coefficients of a^-1 mod x^length.
+     */
+    static void inverseSeries(const GField &field , const uint64_t *a , size_t n , size_t length ,
+                              uint64_t *inverse);
+
+    /**
+     * Euclidean division of coefficient arrays, by Newton's iteration on the reversed
+     * polynomials once both the quotient and the divisor have POLY_NEWTON_LENGTH coefficients.
+     * @param field the field of the coefficients.
+     * @param a n coefficients.
+     * @param n the length of a, at least m.
+     * @param b m coefficients, with an invertible leading one.
+     * @param m the length of b, not 0.
+     * @param quotient output, n - m + 1 coefficients.
+     * @param remainder output, m - 1 coefficients.
+     */
+    static void divide(const GField &field , const uint64_t *a , size_t n , const uint64_t *b ,
+                       size_t m , uint64_t *quotient , uint64_t *remainder);
+
+    /**
+     * The sum of two polynomials of the same field.
+     * @param other GFPolynomial instance.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator+(const GFPolynomial &other) const;
+
+    /**
+     * The difference of two polynomials of the same field.
+     * @param other GFPolynomial instance.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator-(const GFPolynomial &other) const;
+
+    /**
+     * The product of two polynomials of the same field (see multiply()).
+     * @param other GFPolynomial instance.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator*(const GFPolynomial &other) const;
+
+    /**
+     * Multiplies every coefficient by a scalar.
+     * @param scalar a GFNumber of the field of the polynomial.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator*(const GFNumber &scalar) const;
+
+    /**
+     * The quotient of the Euclidean division.
+     * @param other the divisor.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator/(const GFPolynomial &other) const;
+
+    /**
+     * The remainder of the Euclidean division.
+     * @param other the divisor.
+     * @return The result GFPolynomial
+     */
+    GFPolynomial operator%(const GFPolynomial &other) const;
+
+    /**
+     * plus-assignment operator, for two polynomials of the same field.
+     * @param other GFPolynomial instance.
+     * @return this.
+     */
+    GFPolynomial &operator+=(const GFPolynomial &other);
+
+    /**
+     * minus-assignment operator, for two polynomials of the same field.
+     * @param other GFPolynomial instance.
+     * @return this.
+     */
+    GFPolynomial &operator-=(const GFPolynomial &other);
+
+    /**
+     * multiply-assignment operator, for two polynomials of the same field (see multiply()).
+     * @param other GFPolynomial instance.
+     * @return this.
+     */
+    GFPolynomial &operator*=(const GFPolynomial &other);
+
+    /**
+     * Operator overloading of "==".
+     * @param other GFPolynomial instance.
+     * @return True if both have the same field and the same coefficients.
+     */
+    bool operator==(const GFPolynomial &other) const
+    { return _field == other._field && _coefficients == other._coefficients; }
+
+    /**
+     * Operator overloading of "!=".
+     * @param other GFPolynomial instance.
+     * @return True if the polynomials differ.
+     */
+    bool operator!=(const GFPolynomial &other) const
+    { return !(*this == other); }
+
+    /**
+     * Operator overloading of "<<", prints the coefficients from the constant up and the field.
+     * @param out ostream reference.
+     * @param polynomial reference to a GFPolynomial instance.
+     * @return ostream reference with the desire output.
+     */
+    friend std::ostream &operator<<(std::ostream &out , const GFPolynomial &polynomial);
+};
+
+#endif //GFPOLYNOMIAL_H
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFPolynomial.h"
+#include "NumberTheoreticTransform.h"
+#include "SubproductTree.h"
+#include "ThreadPool.h"
+
+/**
+ * Random residues of the field, including the extreme ones.
+ */
+static std::vector<uint64_t> randomResidues(const GField &field , size_t n ,
+                                            std::mt19937_64 &generator)
+{
+    std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+    std::vector<uint64_t> residues(n);
+    for (uint64_t &residue : residues)
+    {
+        residue = field.element(distribution(generator)).getResidue();
+    }
+    residues[0] = field.element(field.getOrder() - 1).getResidue();
+    residues[n - 1] = (n > 1) ? field.element(field.getOrder() - 1).getResidue() : residues[0];
+    return residues;
+}
+
+/**
+ * The product of two coefficient arrays by the definition, on the element operations.
+ */
+static std::vector<uint64_t> naiveProduct(const GField &field , const std::vector<uint64_t> &a ,
+                                          const std::vector<uint64_t> &b)
+{
+    std::vector<uint64_t> product(a.size() + b.size() - 1 , 0);
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        for (size_t j = 0; j < b.size(); j++)
+        {
+            GFElement term = field.mul(GFElement(a[i]) , GFElement(b[j]));
+            product[i + j] = field.add(GFElement(product[i + j]) , term).getResidue();
+        }
+    }
+    return product;
+}
+
+/** Fields on every multiplication path: a transform prime, one, two and three CRT primes, the
+ * ring Z/p^l, and the polynomial arithmetic with and without log tables. */
+static const GField polynomialFields[] = {GField(998244353) , GField(65537) , GField(1000003) ,
+                                          GField(4294967311) , GField(9223372036854775783) ,
+                                          GField(3 , 20) , GField(2 , 8 , POLYNOMIAL_ARITHMETIC) ,
+                                          GField(2 , 62 , POLYNOMIAL_ARITHMETIC) ,
+                                          GField(3 , 13 , POLYNOMIAL_ARITHMETIC)};
+
+TEST(GFPolynomialTest , MultiplyMatchesDefinition)
+{
+    // below and above both thresholds, balanced and unbalanced
+    const size_t sizes[][2] = {{1 , 1} , {5 , 3} , {31 , 31} , {32 , 32} , {33 , 47} ,
+                               {127 , 127} , {128 , 128} , {300 , 129} , {700 , 40} ,
+                               {400 , 400}};
+    std::mt19937_64 generator(67320);
+    for (const GField &field : polynomialFields)
+    {
+        for (const size_t *size : sizes)
+        {
+            std::vector<uint64_t> a = randomResidues(field , size[0] , generator);
+            std::vector<uint64_t> b = randomResidues(field , size[1] , generator);
+            std::vector<uint64_t> product(a.size() + b.size() - 1);
+            GFPolynomial::multiply(field , a.data() , a.size() , b.data() , b.size() ,
+                                   product.data());
+            ASSERT_EQ(product , naiveProduct(field , a , b)) << field << " " << size[0] << "x"
+                                                             << size[1];
+        }
+    }
+}
+
+TEST(GFPolynomialTest , TransformRoundTrip)
+{
+    // forward then inverse is the multiplication by the size, across the block boundary
+    std::mt19937_64 generator(67320);
+    for (uint64_t p : {998244353ull , 4611615649683210241ull})
+    {
+        for (int logSize : {0 , 1 , 5 , 11 , 12 , 14})
+        {
+            const NumberTheoreticTransform *transform = NumberTheoreticTransform::get(p , logSize);
+            ASSERT_GE(transform->getLogSize() , logSize);
+            std::vector<uint64_t> a((size_t) 1 << logSize) , b;
+            for (uint64_t &residue : a)
+            {
+                residue = generator() % p;
+            }
+            b = a;
+            transform->forward(b.data() , logSize);
+            transform->inverse(b.data() , logSize);
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                ASSERT_EQ(b[i] , (uint64_t) (((unsigned __int128) a[i] << logSize) % p)) << p;
+            }
+        }
+    }
+    EXPECT_EQ(NumberTheoreticTransform::maxLogSize(998244353) , 23);
+    EXPECT_EQ(NumberTheoreticTransform::maxLogSize(1000003) , 1);
+    EXPECT_EQ(NumberTheoreticTransform::maxLogSize(1 << 20) , 0);
+}
+
+TEST(GFPolynomialTest , DivmodAndGcd)
+{
+    std::mt19937_64 generator(67320);
+    for (const GField &field : polynomialFields)
+    {
+        if (field.getDegree() > 1 && field.getExtension() == nullptr)
+        {
+            continue; // Z/p^l is not a field
+        }
+        for (size_t n : {1 , 20 , 150})
+        {
+            GFPolynomial a = GFPolynomial::fromResidues(field , randomResidues(field , 2 * n + 7 ,
+                                                                                generator));
+            GFPolynomial b = GFPolynomial::fromResidues(field , randomResidues(field , n ,
+                                                                                generator));
+            GFPolynomial quotient(field) , remainder(field);
+            a.divmod(b , &quotient , &remainder);
+            EXPECT_LT(remainder.degree() , b.degree()) << field;
+            EXPECT_EQ(quotient * b + remainder , a) << field;
+            EXPECT_EQ(a / b , quotient);
+            EXPECT_EQ(a % b , remainder);
+            // (x + 1) and (x + 2) are coprime, so the gcd is the common factor
+            GFPolynomial common = b * a , xPlus1(field , {1 , 1}) , xPlus2(field , {2 , 1});
+            EXPECT_EQ(GFPolynomial::gcd(common * xPlus1 , common * xPlus2) , common.monic())
+                            << field;
+        }
+        GFPolynomial zero(field) , one(field , {1});
+        EXPECT_EQ(GFPolynomial::gcd(zero , zero) , zero);
+        EXPECT_EQ(GFPolynomial::gcd(one , zero) , one);
+    }
+}
+
+TEST(GFPolynomialTest , EvaluateAndDerivative)
+{
+    std::mt19937_64 generator(67320);
+    for (const GField &field : polynomialFields)
+    {
+        GFPolynomial f = GFPolynomial::fromResidues(field , randomResidues(field , 40 , generator));
+        GFPolynomial g = GFPolynomial::fromResidues(field , randomResidues(field , 25 , generator));
+        GFNumber x((long) randomResidues(field , 1 , generator)[0] , field);
+        GFNumber value(0 , field) , power(1 , field);
+        for (long i = 0; i <= f.degree(); i++)
+        {
+            value = value + f.getCoefficient((size_t) i) * power;
+            power = power * x;
+        }
+        EXPECT_EQ(f.evaluate(x) , value) << field;
+        EXPECT_EQ((f * g).evaluate(x) , f.evaluate(x) * g.evaluate(x)) << field;
+        EXPECT_EQ((f + g).evaluate(x) , f.evaluate(x) + g.evaluate(x)) << field;
+        EXPECT_EQ((f * g).derivative() , f.derivative() * g + f * g.derivative()) << field;
+        if (f.degree() % field.getChar() != 0)
+        {
+            EXPECT_EQ(f.derivative().degree() , f.degree() - 1);
+        }
+    }
+    // d/dx x^p = p x^(p - 1) = 0 in characteristic p
+    GField aes(2 , 8 , POLYNOMIAL_ARITHMETIC);
+    EXPECT_EQ(GFPolynomial(aes , {5 , 0 , 1}).derivative() , GFPolynomial(aes));
+    GField seven(7);
+    EXPECT_EQ(GFPolynomial(seven , {1 , 2 , 3 , 4}).derivative() ,
+              GFPolynomial(seven , {2 , 6 , 5}));
+    std::ostringstream printed;
+    printed << GFPolynomial(seven , {1 , -1 , 0 , 14 , 0}); // 14 = 0 is not the leading term
+    EXPECT_EQ(printed.str().substr(0 , 6) , "[1 6] ");
+}
+
+TEST(GFPolynomialTest , NewtonDivision)
+{
+    // quotients and divisors above POLY_NEWTON_LENGTH, and a series inverse checked directly
+    std::mt19937_64 generator(67320);
+    for (const GField &field : polynomialFields)
+    {
+        if (field.getDegree() > 1 && field.getExtension() == nullptr)
+        {
+            continue; // Z/p^l is not a field
+        }
+        for (size_t n : {300 , 1100})
+        {
+            if (n > 1000 && field.getExtension() != nullptr && field.getChar() != 2)
+            {
+                continue; // products on generic extension elements are slow
+            }
+            GFPolynomial a = GFPolynomial::fromResidues(field , randomResidues(field , 3 * n ,
+                                                                                generator));
+            GFPolynomial b = GFPolynomial::fromResidues(field , randomResidues(field , n ,
+                                                                                generator));
+            GFPolynomial quotient(field) , remainder(field);
+            a.divmod(b , &quotient , &remainder);
+            EXPECT_LT(remainder.degree() , b.degree()) << field;
+            EXPECT_EQ(quotient * b + remainder , a) << field;
+            std::vector<uint64_t> inverse(n + 100);
+            GFPolynomial::inverseSeries(field , b.data() , n , inverse.size() , inverse.data());
+            GFPolynomial product = b * GFPolynomial::fromResidues(field , inverse);
+            for (size_t i = 0; i < inverse.size(); i++)
+            {
+                ASSERT_EQ(product.getCoefficient(i).getNumber() , (i == 0) ? 1 : 0) << field;
+            }
+        }
+    }
+}
+
+/**
+ * n distinct points of a field, the first one the extreme residue (the multiplier is prime to
+ * every order of polynomialFields).
+ */
+static std::vector<long> distinctPoints(const GField &field , size_t n)
+{
+    const uint64_t order = (uint64_t) field.getOrder();
+    std::vector<long> points(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        points[i] = (long) (order - 1 - (uint64_t) (((unsigned __int128) i * 0x9E3779B97F4A7C15ull)
+                                                    % order));
+    }
+    return points;
+}
+
+TEST(GFPolynomialTest , MultipointEvaluationAndInterpolation)
+{
+    // the leaves alone, one level, an unbalanced tree, and a pool running the levels (the
+    // large trees are checked at every 37th point, Horner on GFNumbers is slow)
+    ThreadPool pool(3);
+    std::mt19937_64 generator(67320);
+    for (const GField &field : polynomialFields)
+    {
+        for (size_t n : {1 , 32 , 33 , 100 , 1500})
+        {
+            if (n > (size_t) field.getOrder() ||
+                (n > 100 && field.getExtension() != nullptr && field.getChar() != 2))
+            {
+                continue; // too few points, or products on generic extension elements (slow)
+            }
+            GFVector points(field , distinctPoints(field , n));
+            for (size_t length : {n / 2 , n , 3 * n + 5})
+            {
+                if (length == 0)
+                {
+                    continue;
+                }
+                GFPolynomial f = GFPolynomial::fromResidues(field , randomResidues(field , length ,
+                                                                                    generator));
+                GFVector values = f.evaluate(points , (n % 2 == 0) ? &pool : nullptr);
+                for (size_t i = 0; i < n; i += (n > 100) ? 37 : 1)
+                {
+                    ASSERT_EQ(values.get(i) , f.evaluate(points.get(i))) << field << " " << n;
+                }
+            }
+            if (field.getDegree() > 1 && field.getExtension() == nullptr)
+            {
+                continue; // Z/p^l is not a field
+            }
+            std::vector<uint64_t> random = randomResidues(field , n , generator);
+            GFVector values(field , std::vector<long>(random.begin() , random.end()));
+            GFPolynomial f = GFPolynomial::interpolate(points , values ,
+                                                       (n > 100) ? &pool : nullptr);
+            EXPECT_LT(f.degree() , (long) n);
+            for (size_t i = 0; i < n; i += (n > 100) ? 37 : 1)
+            {
+                ASSERT_EQ(f.evaluate(points.get(i)) , values.get(i)) << field << " " << n;
+            }
+            // the tree keeps its weights, a second interpolation reuses them
+            SubproductTree tree(field , points.data() , n);
+            std::vector<uint64_t> coefficients(n) , again(n);
+            tree.interpolate(values.data() , coefficients.data());
+            tree.interpolate(values.data() , again.data() , &pool);
+            EXPECT_EQ(GFPolynomial::fromResidues(field , coefficients) , f);
+            EXPECT_EQ(coefficients , again);
+        }
+    }
+}
+
+TEST(GFPolynomialTest , SubproductTreeFromPoolTasks)
+{
+    // every worker busy with a tree of its own, which must not wait for the whole pool
+    ThreadPool pool(2);
+    GField field(998244353);
+    std::vector<long> points = distinctPoints(field , 3000);
+    GFVector vector(field , points);
+    std::mt19937_64 generator(67320);
+    GFPolynomial f = GFPolynomial::fromResidues(field , randomResidues(field , 3000 , generator));
+    GFVector expected = f.evaluate(vector);
+    std::vector<std::future<bool>> results;
+    for (int task = 0; task < 4; task++)
+    {
+        auto promise = std::make_shared<std::promise<bool>>();
+        results.push_back(promise->get_future());
+        pool.submit([promise , &pool , &vector , &f , &expected]()
+                    {
+                        GFVector values = f.evaluate(vector , &pool);
+                        GFPolynomial g = GFPolynomial::interpolate(vector , values , &pool);
+                        promise->set_value(std::equal(values.data() , values.data() + 3000 ,
+                                                      expected.data()) && g == f);
+                    });
+    }
+    for (std::future<bool> &result : results)
+    {
+        ASSERT_EQ(result.wait_for(std::chrono::minutes(2)) , std::future_status::ready);
+        EXPECT_TRUE(result.get());
+    }
+}
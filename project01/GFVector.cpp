@@ -0,0 +1,469 @@
+// GFVector.cpp
+
+#include "GFVector.h"
+#include <cassert>
+#include <cstring>
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class GFVector.
+// --------------------------------------------------------------------------------------
+
+// ------------------------------- scalar kernels -------------------------------
+
+/**
+ * out[i] = a[i] + b[i] mod q.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out the sums, in [0, q), may alias a or b.
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+static void scalarAdd(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                      const LaneModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + b[i] , m);
+    }
+}
+
+/**
+ * out[i] = a[i] - b[i] mod q, computed as a[i] + q - b[i] so it never wraps.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out the differences, in [0, q), may alias a or b.
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+static void scalarSub(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                      const LaneModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + m.q - b[i] , m);
+    }
+}
+
+/**
+ * out[i] = a[i] * b[i] mod q, two Montgomery reductions (the second one multiplies
+ * by 2^64 mod q and cancels the 2^-32 of the first), so the residues are plain, not in
+ * Montgomery form.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out the products, in [0, q), may alias a or b.
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+static void scalarMul(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                      const LaneModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = laneMul(a[i] , b[i] , m);
+    }
+}
+
+/**
+ * out[i] = a[i] * b[i] + c[i] mod q, the product reduced like the mul kernel.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param c residues below q.
+ * @param out the results, in [0, q), may alias any input.
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+static void scalarFma(const uint64_t *a , const uint64_t *b , const uint64_t *c , uint64_t *out ,
+                      size_t n , const LaneModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = laneReduce(laneMul(a[i] , b[i] , m) + c[i] , m);
+    }
+}
+
+/**
+ * out[i] = a[i] * s mod q, with a single Montgomery reduction because the scalar is
+ * already in Montgomery form.
+ * @param a residues below q.
+ * @param scalar s * 2^32 mod q, in [0, q) (GFVector::operator*= converts s).
+ * @param out the products, in [0, q), may alias a.
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+static void scalarScale(const uint64_t *a , uint64_t scalar , uint64_t *out , size_t n ,
+                        const LaneModulus &m)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = laneRedc(a[i] * scalar , m);
+    }
+}
+
+/**
+ * The sum of a[i] * b[i] * 2^-32 mod q, every term reduced once but the sum left
+ * unreduced: GFVector::dot reduces it mod q and multiplies by 2^32 mod q to cancel the 2^-32.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param n the number of residues, below 2^32 so the sum of terms below q < 2^31 fits.
+ * @param m the modulus.
+ * @return the unreduced sum, below n * q.
+ */
+static uint64_t scalarDot(const uint64_t *a , const uint64_t *b , size_t n , const LaneModulus &m)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        total += laneRedc(a[i] * b[i] , m);
+    }
+    return total;
+}
+
+/**
+ * The portable kernels.
+ * @return the table.
+ */
+const GFVectorKernels *scalarKernels()
+{
+    static const GFVectorKernels kernels = {"scalar" , scalarAdd , scalarSub , scalarMul ,
+                                            scalarFma , scalarScale , scalarDot};
+    return &kernels;
+}
+
+// ------------------------------- dispatch -------------------------------
+
+/**
+ * Looks up the kernels of an instruction set.
+ * @param name "avx2", "sse4.1", "scalar" or nullptr for the best one the cpu supports.
+ * @return the kernels, or nullptr if the cpu does not support them.
+ */
+static const GFVectorKernels *findKernels(const char *name)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool hasAvx2 = __builtin_cpu_supports("avx2") && avx2Kernels() != nullptr;
+    bool hasSse41 = __builtin_cpu_supports("sse4.1") && sse41Kernels() != nullptr;
+#else
+    bool hasAvx2 = false , hasSse41 = false;
+#endif
+    if (name == nullptr)
+    {
+        return hasAvx2 ? avx2Kernels() : (hasSse41 ? sse41Kernels() : scalarKernels());
+    }
+    if (strcmp(name , "avx2") == 0)
+    {
+        return hasAvx2 ? avx2Kernels() : nullptr;
+    }
+    if (strcmp(name , "sse4.1") == 0)
+    {
+        return hasSse41 ? sse41Kernels() : nullptr;
+    }
+    return (strcmp(name , "scalar") == 0) ? scalarKernels() : nullptr;
+}
+
+/**
+ * The kernels in use, the best ones the cpu supports unless selectKernels was called (a
+ * function so that vectors built during static initialization find them).
+ * @return a reference to the kernels.
+ */
+static const GFVectorKernels *&activeKernels()
+{
+    static const GFVectorKernels *kernels = findKernels(nullptr);
+    return kernels;
+}
+
+/**
+ * The name of the instruction set of the kernels in use ("avx2", "sse4.1" or "scalar").
+ * @return the name.
+ */
+const char *GFVector::kernelName()
+{
+    return activeKernels()->name;
+}
+
+/**
+ * Forces the kernels of the given instruction set, for tests and benchmarks.
+ * Not thread safe, call it before using GFVectors.
+ * @param name "avx2", "sse4.1", "scalar" or nullptr for the best one the cpu supports.
+ * @return false if the cpu does not support it (the kernels are left unchanged).
+ */
+bool GFVector::selectKernels(const char *name)
+{
+    const GFVectorKernels *kernels = findKernels(name);
+    if (kernels == nullptr)
+    {
+        return false;
+    }
+    activeKernels() = kernels;
+    return true;
+}
+
+// ------------------------------- GFVector -------------------------------
+
+/**
+ * A constructor.
+ * @param field the field of the numbers.
+ * @param size the number of numbers, all zero.
+ */
+GFVector::GFVector(const GField &field , size_t size) : _field(field.getId()) , _residues(size , 0)
+{
+    _initLanes();
+}
+
+/**
+ * A constructor.
+ * @param field the field of the numbers.
+ * @param numbers long numbers, converted into the field.
+ */
+GFVector::GFVector(const GField &field , const std::vector<long> &numbers) : _field(field.getId())
+{
+    _residues.reserve(numbers.size());
+    for (long n : numbers)
+    {
+        _residues.push_back(field.element(n).getResidue());
+    }
+    _initLanes();
+}
+
+/**
+ * Computes the lane constants of the field.
+ */
+void GFVector::_initLanes()
+{
+    uint64_t q = (uint64_t) _getField().getOrder();
+    _lanes = LaneModulus{0 , 0 , 0 , 0};
+    if (q >= (uint64_t) LANE_ORDER_LIMIT || (q & 1) == 0 || _getField().getExtension() != nullptr)
+    {
+        return;
+    }
+    // Newton iteration, every step doubles the number of correct low bits
+    uint32_t inv = (uint32_t) q;
+    for (int i = 0; i < 4; i++)
+    {
+        inv *= 2 - (uint32_t) q * inv;
+    }
+    _lanes.q = q;
+    _lanes.qInv = (uint32_t) (0 - inv);
+    _lanes.r = (1ul << 32) % q;
+    _lanes.r2 = (_lanes.r * _lanes.r) % q;
+}
+
+/**
+ * Checks that the other vector has the same field and size.
+ * @param other GFVector instance.
+ */
+void GFVector::_checkCompatible(const GFVector &other) const
+{
+    assert(_field == other._field); // numbers from different fields
+    assert(_residues.size() == other._residues.size()); // vectors of different sizes
+}
+
+/**
+ * Getter for one number.
+ * @param i index smaller than size().
+ * @return the number as a GFNumber.
+ */
+GFNumber GFVector::get(size_t i) const
+{
+    assert(i < _residues.size());
+    return GFNumber((long) _residues[i] , getField());
+}
+
+/**
+ * Setter for one number.
+ * @param i index smaller than size().
+ * @param n long number, converted into the field.
+ */
+void GFVector::set(size_t i , long n)
+{
+    assert(i < _residues.size());
+    _residues[i] = _getField().element(n).getResidue();
+}
+
+/**
+ * Elementwise + of two vectors of the same field and size.
+ * @param other GFVector instance.
+ * @return The result GFVector
+ */
+GFVector GFVector::operator+(const GFVector &other) const
+{
+    GFVector result(*this);
+    return result += other;
+}
+
+/**
+ * Elementwise - of two vectors of the same field and size.
+ * @param other GFVector instance.
+ * @return The result GFVector
+ */
+GFVector GFVector::operator-(const GFVector &other) const
+{
+    GFVector result(*this);
+    return result -= other;
+}
+
+/**
+ * Elementwise * of two vectors of the same field and size.
+ * @param other GFVector instance.
+ * @return The result GFVector
+ */
+GFVector GFVector::operator*(const GFVector &other) const
+{
+    GFVector result(*this);
+    return result *= other;
+}
+
+/**
+ * Multiplies every number by a scalar.
+ * @param scalar long number.
+ * @return The result GFVector
+ */
+GFVector GFVector::operator*(long scalar) const
+{
+    GFVector result(*this);
+    return result *= scalar;
+}
+
+/**
+ * Elementwise plus-assignment, for a vector of the same field and size.
+ * @param other GFVector instance.
+ * @return this.
+ */
+GFVector &GFVector::operator+=(const GFVector &other)
+{
+    _checkCompatible(other);
+    uint64_t *a = _residues.data();
+    if (_lanes.q != 0)
+    {
+        activeKernels()->add(a , other.data() , a , size() , _lanes);
+        return *this;
+    }
+    const GField &field = _getField();
+    for (size_t i = 0; i < size(); i++)
+    {
+        a[i] = field.add(GFElement(a[i]) , GFElement(other._residues[i])).getResidue();
+    }
+    return *this;
+}
+
+/**
+ * Elementwise minus-assignment, for a vector of the same field and size.
+ * @param other GFVector instance.
+ * @return this.
+ */
+GFVector &GFVector::operator-=(const GFVector &other)
+{
+    _checkCompatible(other);
+    uint64_t *a = _residues.data();
+    if (_lanes.q != 0)
+    {
+        activeKernels()->sub(a , other.data() , a , size() , _lanes);
+        return *this;
+    }
+    const GField &field = _getField();
+    for (size_t i = 0; i < size(); i++)
+    {
+        a[i] = field.sub(GFElement(a[i]) , GFElement(other._residues[i])).getResidue();
+    }
+    return *this;
+}
+
+/**
+ * Elementwise multiply-assignment, for a vector of the same field and size.
+ * @param other GFVector instance.
+ * @return this.
+ */
+GFVector &GFVector::operator*=(const GFVector &other)
+{
+    _checkCompatible(other);
+    uint64_t *a = _residues.data();
+    if (_lanes.q != 0)
+    {
+        activeKernels()->mul(a , other.data() , a , size() , _lanes);
+        return *this;
+    }
+    const GField &field = _getField();
+    for (size_t i = 0; i < size(); i++)
+    {
+        a[i] = field.mul(GFElement(a[i]) , GFElement(other._residues[i])).getResidue();
+    }
+    return *this;
+}
+
+/**
+ * Multiplies every number by a scalar, in place.
+ * @param scalar long number, converted into the field.
+ * @return this.
+ */
+GFVector &GFVector::operator*=(long scalar)
+{
+    const GField &field = _getField();
+    uint64_t s = field.element(scalar).getResidue();
+    uint64_t *a = _residues.data();
+    if (_lanes.q != 0)
+    {
+        activeKernels()->scale(a , (s * _lanes.r) % _lanes.q , a , size() , _lanes);
+        return *this;
+    }
+    for (size_t i = 0; i < size(); i++)
+    {
+        a[i] = field.mul(GFElement(a[i]) , GFElement(s)).getResidue();
+    }
+    return *this;
+}
+
+/**
+ * Fused multiply-add: this[i] = a[i] * b[i] + this[i], in a single pass.
+ * @param a GFVector instance.
+ * @param b GFVector instance.
+ * @return this.
+ */
+GFVector &GFVector::fma(const GFVector &a , const GFVector &b)
+{
+    _checkCompatible(a);
+    _checkCompatible(b);
+    uint64_t *c = _residues.data();
+    if (_lanes.q != 0)
+    {
+        activeKernels()->fma(a.data() , b.data() , c , c , size() , _lanes);
+        return *this;
+    }
+    const GField &field = _getField();
+    if (field.getExtension() != nullptr)
+    {
+        field.getExtension()->mulAdd(a.data() , b.data() , c , size());
+        return *this;
+    }
+    for (size_t i = 0; i < size(); i++)
+    {
+        GFElement product = field.mul(GFElement(a._residues[i]) , GFElement(b._residues[i]));
+        c[i] = field.add(product , GFElement(c[i])).getResidue();
+    }
+    return *this;
+}
+
+/**
+ * The dot product of two vectors of the same field and size.
+ * @param other GFVector instance.
+ * @return the sum of this[i] * other[i].
+ */
+GFNumber GFVector::dot(const GFVector &other) const
+{
+    _checkCompatible(other);
+    const GField &field = _getField();
+    uint64_t result = 0;
+    if (_lanes.q != 0)
+    {
+        // the kernel sums a[i] * b[i] * 2^-32, multiplying by 2^32 once cancels it
+        uint64_t total = activeKernels()->dot(data() , other.data() , size() , _lanes);
+        result = ((total % _lanes.q) * _lanes.r) % _lanes.q;
+    }
+    else
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            GFElement product = field.mul(GFElement(_residues[i]) , GFElement(other._residues[i]));
+            result = field.add(GFElement(result) , product).getResidue();
+        }
+    }
+    return GFNumber((long) result , getField());
+}
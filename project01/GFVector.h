@@ -0,0 +1,185 @@
+// GFVector.h
+//----------- include guards------------
+#ifndef GFVECTOR_H
+#define GFVECTOR_H
+//-------------- includes --------------
+#include <cstdint>
+#include <vector>
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFVectorKernels.h"
+
+#define LANE_ORDER_LIMIT (1l << 31) /** orders below it (and odd) use the SIMD lanes */
+
+//--------------------------------------
+
+/**
+ *  A GFVector class.
+ *  A vector of numbers of one GField, stored as a contiguous array of residues. The
+ *  arithmetic is elementwise and checks the field once per call instead of once per number.
+ *  Odd orders below 2^31 run 32 bit Montgomery kernels on SIMD lanes (AVX2 or SSE4.1, chosen
+ *  at runtime from the cpu), every other field (and every field with the polynomial
+ *  arithmetic) falls back to a scalar loop on the element operations of its GField.
+ */
+class GFVector
+{
+private:
+    GFieldId _field; /** The id of the field of the numbers. */
+    std::vector<uint64_t> _residues; /** The numbers, reduced into [0, order). */
+    LaneModulus _lanes; /** The lane constants, _lanes.q is 0 if the field has no lanes. */
+
+    /**
+     * Computes the lane constants of the field.
+     */
+    void _initLanes();
+
+    /**
+     * Checks that the other vector has the same field and size.
+     * @param other GFVector instance.
+     */
+    void _checkCompatible(const GFVector &other) const;
+
+    /**
+     * Lookup of the field of the numbers (scalar fallback).
+     * @return the field.
+     */
+    const GField &_getField() const
+    { return GFieldRegistry::get(_field); }
+
+public:
+    /**
+     * A constructor.
+     * @param field the field of the numbers.
+     * @param size the number of numbers, all zero.
+     */
+    GFVector(const GField &field , size_t size);
+
+    /**
+     * A constructor.
+     * @param field the field of the numbers.
+     * @param numbers long numbers, converted into the field.
+     */
+    GFVector(const GField &field , const std::vector<long> &numbers);
+
+    /**
+     * Getter for the size.
+     * @return the number of numbers.
+     */
+    size_t size() const
+    { return _residues.size(); }
+
+    /**
+     * Getter for the field of the numbers.
+     * @return The field of the numbers.
+     */
+    GField getField() const
+    { return GFieldRegistry::get(_field); }
+
+    /**
+     * Getter for one number.
+     * @param i index smaller than size().
+     * @return the number as a GFNumber.
+     */
+    GFNumber get(size_t i) const;
+
+    /**
+     * Setter for one number.
+     * @param i index smaller than size().
+     * @param n long number, converted into the field.
+     */
+    void set(size_t i , long n);
+
+    /**
+     * Getter for the residues.
+     * @return array of size() residues.
+     */
+    const uint64_t *data() const
+    { return _residues.data(); }
+
+    /**
+     * Elementwise + of two vectors of the same field and size.
+     * @param other GFVector instance.
+     * @return The result GFVector
+     */
+    GFVector operator+(const GFVector &other) const;
+
+    /**
+     * Elementwise - of two vectors of the same field and size.
+     * @param other GFVector instance.
+     * @return The result GFVector
+     */
+    GFVector operator-(const GFVector &other) const;
+
+    /**
+     * Elementwise * of two vectors of the same field and size.
+     * @param other GFVector instance.
+     * @return The result GFVector
+     */
+    GFVector operator*(const GFVector &other) const;
+
+    /**
+     * Multiplies every number by a scalar.
+     * @param scalar long number.
+     * @return The result GFVector
+     */
+    GFVector operator*(long scalar) const;
+
+    /**
+     * Elementwise plus-assignment, for a vector of the same field and size.
+     * @param other GFVector instance.
+     * @return this.
+     */
+    GFVector &operator+=(const GFVector &other);
+
+    /**
+     * Elementwise minus-assignment, for a vector of the same field and size.
+     * @param other GFVector instance.
+     * @return this.
+     */
+    GFVector &operator-=(const GFVector &other);
+
+    /**
+     * Elementwise multiply-assignment, for a vector of the same field and size.
+     * @param other GFVector instance.
+     * @return this.
+     */
+    GFVector &operator*=(const GFVector &other);
+
+    /**
+     * Multiplies every number by a scalar, in place.
+     * @param scalar long number, converted into the field.
+     * @return this.
+     */
+    GFVector &operator*=(long scalar);
+
+    /**
+     * Fused multiply-add: this[i] = a[i] * b[i] + this[i], in a single pass.
+     * @param a GFVector instance.
+     * @param b GFVector instance.
+     * @return this.
+     */
+    GFVector &fma(const GFVector &a , const GFVector &b);
+
+    /**
+     * The dot product of two vectors of the same field and size.
+     * @param other GFVector instance.
+     * @return the sum of this[i] * other[i].
+     */
+    GFNumber dot(const GFVector &other) const;
+
+    /**
+     * The name of the instruction set of the kernels in use ("avx2", "sse4.1" or "scalar").
+     * @return the name.
+     */
+    static const char *kernelName();
+
+    /**
+     * Forces the kernels of the given instruction set, for tests and benchmarks.
+     * Not thread safe, call it before using GFVectors.
+     * @param name "avx2", "sse4.1", "scalar" or nullptr for the best one the cpu supports.
+     * @return false if the cpu does not support it (the kernels are left unchanged).
+     */
+    static bool selectKernels(const char *name);
+};
+
+#endif //GFVECTOR_H
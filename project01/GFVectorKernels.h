@@ -0,0 +1,99 @@
+// GFVectorKernels.h
+//----------- include guards------------
+#ifndef GFVECTORKERNELS_H
+#define GFVECTORKERNELS_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+
+//--------------------------------------
+
+/**
+ * The constants of 32 bit Montgomery arithmetic (R = 2^32) modulo an odd q < 2^31.
+ * Every residue lives in a 64 bit lane, so a 32x32 bit product and its reduction fit the
+ * lane and a reduced value stays below 2^32.
+ */
+struct LaneModulus
+{
+    uint64_t q; /** The modulus. */
+    uint64_t qInv; /** -q^-1 mod 2^32. */
+    uint64_t r; /** 2^32 mod q. */
+    uint64_t r2; /** 2^64 mod q. */
+};
+
+/**
+ * The elementwise kernels of GFVector, every instruction set fills one table.
+ * All arrays hold residues below q, out may alias any input.
+ */
+struct GFVectorKernels
+{
+    const char *name; /** The instruction set of the table. */
+
+    /** out[i] = a[i] + b[i] mod q. */
+    void (*add)(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                const LaneModulus &m);
+
+    /** out[i] = a[i] - b[i] mod q. */
+    void (*sub)(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                const LaneModulus &m);
+
+    /** out[i] = a[i] * b[i] mod q. */
+    void (*mul)(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                const LaneModulus &m);
+
+    /** out[i] = a[i] * b[i] + c[i] mod q. */
+    void (*fma)(const uint64_t *a , const uint64_t *b , const uint64_t *c , uint64_t *out ,
+                size_t n , const LaneModulus &m);
+
+    /** out[i] = a[i] * s mod q, where scalar is the Montgomery form s * 2^32 mod q. */
+    void (*scale)(const uint64_t *a , uint64_t scalar , uint64_t *out , size_t n ,
+                  const LaneModulus &m);
+
+    /** The sum of a[i] * b[i] * 2^-32 mod q, not reduced (fits as long as n < 2^32). */
+    uint64_t (*dot)(const uint64_t *a , const uint64_t *b , size_t n , const LaneModulus &m);
+};
+
+/**
+ * The portable kernels.
+ * @return the table.
+ */
+const GFVectorKernels *scalarKernels();
+
+/**
+ * The SSE4.1 kernels.
+ * @return the table, or nullptr if they are not compiled for this architecture.
+ */
+const GFVectorKernels *sse41Kernels();
+
+/**
+ * The AVX2 kernels.
+ * @return the table, or nullptr if they are not compiled for this architecture.
+ */
+const GFVectorKernels *avx2Kernels();
+
+// ---------- scalar lane arithmetic, shared by the tails of the SIMD kernels ----------
+
+/**
+ * Brings a value in [0, 2q) into [0, q).
+ */
+inline uint64_t laneReduce(uint64_t x , const LaneModulus &m)
+{ return (x >= m.q) ? x - m.q : x; }
+
+/**
+ * Montgomery reduction.
+ * @param t a number smaller than q * 2^32.
+ * @return t * 2^-32 mod q.
+ */
+inline uint64_t laneRedc(uint64_t t , const LaneModulus &m)
+{
+    uint64_t u = ((t & UINT32_MAX) * m.qInv) & UINT32_MAX;
+    return laneReduce((t + u * m.q) >> 32 , m);
+}
+
+/**
+ * Multiplies two residues (two reductions, the second one cancels the 2^-32).
+ */
+inline uint64_t laneMul(uint64_t a , uint64_t b , const LaneModulus &m)
+{ return laneRedc(laneRedc(a * b , m) * m.r2 , m); }
+
+#endif //GFVECTORKERNELS_H
@@ -0,0 +1,435 @@
+// GFVectorSimd.cpp
+
+#include "GFVectorKernels.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the SSE4.1 and AVX2 kernels of GFVector. They are compiled with
+// target attributes, so the rest of the project keeps the baseline instruction set and
+// GFVector only calls them after checking the cpu.
+// A lane holds a residue below 2^31 in 64 bits: _mul_epu32 gives the exact 32x32 bit product
+// and the reduction of a value x in [0, 2q) is min_epu32(x, x - q), because when x < q the
+// difference wraps to a larger 32 bit value and its high half is not zero.
+// --------------------------------------------------------------------------------------
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+// ------------------------------------- SSE4.1 -------------------------------------
+
+/**
+ * Brings every lane in [0, 2q) into [0, q).
+ */
+SSE41 static inline __m128i sseReduce(__m128i x , __m128i q)
+{ return _mm_min_epu32(x , _mm_sub_epi64(x , q)); }
+
+/**
+ * Montgomery reduction of every lane (t < q * 2^32).
+ */
+SSE41 static inline __m128i sseRedc(__m128i t , __m128i q , __m128i qInv)
+{
+    __m128i u = _mm_mul_epu32(t , qInv);
+    return sseReduce(_mm_srli_epi64(_mm_add_epi64(t , _mm_mul_epu32(u , q)) , 32) , q);
+}
+
+/**
+ * Multiplies every lane.
+ */
+SSE41 static inline __m128i sseMul(__m128i a , __m128i b , __m128i q , __m128i qInv , __m128i r2)
+{ return sseRedc(_mm_mul_epu32(sseRedc(_mm_mul_epu32(a , b) , q , qInv) , r2) , q , qInv); }
+
+/**
+ * The SSE4.1 add, 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out a[i] + b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+SSE41 static void sseAdd(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                         const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        _mm_storeu_si128((__m128i *) (out + i) , sseReduce(_mm_add_epi64(x , y) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + b[i] , m);
+    }
+}
+
+/**
+ * The SSE4.1 sub, 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out a[i] - b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+SSE41 static void sseSub(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                         const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        _mm_storeu_si128((__m128i *) (out + i) ,
+                         sseReduce(_mm_sub_epi64(_mm_add_epi64(x , q) , y) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + m.q - b[i] , m);
+    }
+}
+
+/**
+ * The SSE4.1 mul (two reductions, like laneMul), 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q, not in Montgomery form.
+ * @param b residues below q, not in Montgomery form.
+ * @param out a[i] * b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+SSE41 static void sseMulKernel(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                               const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    const __m128i qInv = _mm_set1_epi64x((long long) m.qInv);
+    const __m128i r2 = _mm_set1_epi64x((long long) m.r2);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        _mm_storeu_si128((__m128i *) (out + i) , sseMul(x , y , q , qInv , r2));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneMul(a[i] , b[i] , m);
+    }
+}
+
+/**
+ * The SSE4.1 fma, 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param c residues below q.
+ * @param out a[i] * b[i] + c[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+SSE41 static void sseFma(const uint64_t *a , const uint64_t *b , const uint64_t *c , uint64_t *out ,
+                         size_t n , const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    const __m128i qInv = _mm_set1_epi64x((long long) m.qInv);
+    const __m128i r2 = _mm_set1_epi64x((long long) m.r2);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        __m128i z = _mm_loadu_si128((const __m128i *) (c + i));
+        _mm_storeu_si128((__m128i *) (out + i) ,
+                         sseReduce(_mm_add_epi64(sseMul(x , y , q , qInv , r2) , z) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(laneMul(a[i] , b[i] , m) + c[i] , m);
+    }
+}
+
+/**
+ * The SSE4.1 scale (one reduction), 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param scalar the Montgomery form s * 2^32 mod q of the scalar s.
+ * @param out a[i] * s mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+SSE41 static void sseScale(const uint64_t *a , uint64_t scalar , uint64_t *out , size_t n ,
+                           const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    const __m128i qInv = _mm_set1_epi64x((long long) m.qInv);
+    const __m128i s = _mm_set1_epi64x((long long) scalar);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        _mm_storeu_si128((__m128i *) (out + i) , sseRedc(_mm_mul_epu32(x , s) , q , qInv));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneRedc(a[i] * scalar , m);
+    }
+}
+
+/**
+ * The SSE4.1 dot product, 2 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param n the number of residues, below 2^32.
+ * @param m the modulus.
+ * @return the sum of a[i] * b[i] * 2^-32 mod q, not reduced (below n * q).
+ */
+SSE41 static uint64_t sseDot(const uint64_t *a , const uint64_t *b , size_t n , const LaneModulus &m)
+{
+    const __m128i q = _mm_set1_epi64x((long long) m.q);
+    const __m128i qInv = _mm_set1_epi64x((long long) m.qInv);
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        sum = _mm_add_epi64(sum , sseRedc(_mm_mul_epu32(x , y) , q , qInv));
+    }
+    uint64_t total = (uint64_t) _mm_extract_epi64(sum , 0) + (uint64_t) _mm_extract_epi64(sum , 1);
+    for (; i < n; i++)
+    {
+        total += laneRedc(a[i] * b[i] , m);
+    }
+    return total;
+}
+
+// ------------------------------------- AVX2 -------------------------------------
+
+/**
+ * Brings every lane in [0, 2q) into [0, q).
+ */
+AVX2 static inline __m256i avxReduce(__m256i x , __m256i q)
+{ return _mm256_min_epu32(x , _mm256_sub_epi64(x , q)); }
+
+/**
+ * Montgomery reduction of every lane (t < q * 2^32).
+ */
+AVX2 static inline __m256i avxRedc(__m256i t , __m256i q , __m256i qInv)
+{
+    __m256i u = _mm256_mul_epu32(t , qInv);
+    return avxReduce(_mm256_srli_epi64(_mm256_add_epi64(t , _mm256_mul_epu32(u , q)) , 32) , q);
+}
+
+/**
+ * Multiplies every lane.
+ */
+AVX2 static inline __m256i avxMul(__m256i a , __m256i b , __m256i q , __m256i qInv , __m256i r2)
+{ return avxRedc(_mm256_mul_epu32(avxRedc(_mm256_mul_epu32(a , b) , q , qInv) , r2) , q , qInv); }
+
+/**
+ * The AVX2 add, 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out a[i] + b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+AVX2 static void avxAdd(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                        const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        _mm256_storeu_si256((__m256i *) (out + i) , avxReduce(_mm256_add_epi64(x , y) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + b[i] , m);
+    }
+}
+
+/**
+ * The AVX2 sub, 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param out a[i] - b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+AVX2 static void avxSub(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                        const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        _mm256_storeu_si256((__m256i *) (out + i) ,
+                            avxReduce(_mm256_sub_epi64(_mm256_add_epi64(x , q) , y) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(a[i] + m.q - b[i] , m);
+    }
+}
+
+/**
+ * The AVX2 mul (two reductions, like laneMul), 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q, not in Montgomery form.
+ * @param b residues below q, not in Montgomery form.
+ * @param out a[i] * b[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+AVX2 static void avxMulKernel(const uint64_t *a , const uint64_t *b , uint64_t *out , size_t n ,
+                              const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    const __m256i qInv = _mm256_set1_epi64x((long long) m.qInv);
+    const __m256i r2 = _mm256_set1_epi64x((long long) m.r2);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        _mm256_storeu_si256((__m256i *) (out + i) , avxMul(x , y , q , qInv , r2));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneMul(a[i] , b[i] , m);
+    }
+}
+
+/**
+ * The AVX2 fma, 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param c residues below q.
+ * @param out a[i] * b[i] + c[i] mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+AVX2 static void avxFma(const uint64_t *a , const uint64_t *b , const uint64_t *c , uint64_t *out ,
+                        size_t n , const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    const __m256i qInv = _mm256_set1_epi64x((long long) m.qInv);
+    const __m256i r2 = _mm256_set1_epi64x((long long) m.r2);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        __m256i z = _mm256_loadu_si256((const __m256i *) (c + i));
+        _mm256_storeu_si256((__m256i *) (out + i) ,
+                            avxReduce(_mm256_add_epi64(avxMul(x , y , q , qInv , r2) , z) , q));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneReduce(laneMul(a[i] , b[i] , m) + c[i] , m);
+    }
+}
+
+/**
+ * The AVX2 scale (one reduction), 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param scalar the Montgomery form s * 2^32 mod q of the scalar s.
+ * @param out a[i] * s mod q, in [0, q).
+ * @param n the number of residues.
+ * @param m the modulus.
+ */
+AVX2 static void avxScale(const uint64_t *a , uint64_t scalar , uint64_t *out , size_t n ,
+                          const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    const __m256i qInv = _mm256_set1_epi64x((long long) m.qInv);
+    const __m256i s = _mm256_set1_epi64x((long long) scalar);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        _mm256_storeu_si256((__m256i *) (out + i) , avxRedc(_mm256_mul_epu32(x , s) , q , qInv));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = laneRedc(a[i] * scalar , m);
+    }
+}
+
+/**
+ * The AVX2 dot product, 4 lanes per step and the scalar lane
+ * arithmetic for the tail.
+ * @param a residues below q.
+ * @param b residues below q.
+ * @param n the number of residues, below 2^32.
+ * @param m the modulus.
+ * @return the sum of a[i] * b[i] * 2^-32 mod q, not reduced (below n * q).
+ */
+AVX2 static uint64_t avxDot(const uint64_t *a , const uint64_t *b , size_t n , const LaneModulus &m)
+{
+    const __m256i q = _mm256_set1_epi64x((long long) m.q);
+    const __m256i qInv = _mm256_set1_epi64x((long long) m.qInv);
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        sum = _mm256_add_epi64(sum , avxRedc(_mm256_mul_epu32(x , y) , q , qInv));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes , sum);
+    uint64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++)
+    {
+        total += laneRedc(a[i] * b[i] , m);
+    }
+    return total;
+}
+
+/**
+ * The SSE4.1 kernels.
+ * @return the table.
+ */
+const GFVectorKernels *sse41Kernels()
+{
+    static const GFVectorKernels kernels = {"sse4.1" , sseAdd , sseSub , sseMulKernel , sseFma ,
+                                            sseScale , sseDot};
+    return &kernels;
+}
+
+/**
+ * The AVX2 kernels.
+ * @return the table.
+ */
+const GFVectorKernels *avx2Kernels()
+{
+    static const GFVectorKernels kernels = {"avx2" , avxAdd , avxSub , avxMulKernel , avxFma ,
+                                            avxScale , avxDot};
+    return &kernels;
+}
+
+#else
+
+const GFVectorKernels *sse41Kernels()
+{ return nullptr; }
+
+const GFVectorKernels *avx2Kernels()
+{ return nullptr; }
+
+#endif
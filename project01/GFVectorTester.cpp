@@ -0,0 +1,84 @@
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "GField.h"
+#include "GFNumber.h"
+#include "GFVector.h"
+
+#define VECTOR_SIZE 1003 /** not a multiple of the lane count, so the tails run too */
+
+/**
+ * Random numbers of the field, including the extreme residues.
+ */
+static std::vector<long> randomNumbers(const GField &field , unsigned seed)
+{
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<long> distribution(0 , field.getOrder() - 1);
+    std::vector<long> numbers(VECTOR_SIZE);
+    for (long &n : numbers)
+    {
+        n = distribution(generator);
+    }
+    numbers[0] = 0;
+    numbers[1] = field.getOrder() - 1;
+    return numbers;
+}
+
+/**
+ * Checks every GFVector operation against a loop over GFNumber, with the current kernels.
+ */
+static void expectMatchesGFNumber(const GField &field)
+{
+    std::vector<long> x = randomNumbers(field , 1) , y = randomNumbers(field , 2) ,
+            z = randomNumbers(field , 3);
+    GFVector a(field , x) , b(field , y) , c(field , z);
+    GFVector sum = a + b , difference = a - b , product = a * b , scaled = a * -12345 , fused(c);
+    fused.fma(a , b);
+    GFNumber dot(0 , field);
+    for (size_t i = 0; i < VECTOR_SIZE; i++)
+    {
+        GFNumber u(x[i] , field) , v(y[i] , field) , w(z[i] , field);
+        ASSERT_EQ(sum.get(i).getNumber() , (u + v).getNumber()) << field << " " << i;
+        ASSERT_EQ(difference.get(i).getNumber() , (u - v).getNumber()) << field << " " << i;
+        ASSERT_EQ(product.get(i).getNumber() , (u * v).getNumber()) << field << " " << i;
+        ASSERT_EQ(scaled.get(i).getNumber() , (u * -12345).getNumber()) << field << " " << i;
+        ASSERT_EQ(fused.get(i).getNumber() , (u * v + w).getNumber()) << field << " " << i;
+        dot += u * v;
+    }
+    EXPECT_EQ(a.dot(b).getNumber() , dot.getNumber()) << field;
+}
+
+TEST(GFVectorTest , MatchesGFNumberOnEveryKernel)
+{
+    // lanes (odd orders below 2^31) and the scalar fallback (even and wide orders)
+    GField fields[] = {GField(3) , GField(1000003) , GField(2147483647) , GField(3 , 19) ,
+                       GField(2 , 20) , GField(2147483659) , GField(3 , 39)};
+    const char *kernels[] = {"scalar" , "sse4.1" , "avx2"};
+    for (const char *kernel : kernels)
+    {
+        if (!GFVector::selectKernels(kernel))
+        {
+            continue; // not supported by this cpu
+        }
+        EXPECT_STREQ(GFVector::kernelName() , kernel);
+        for (const GField &field : fields)
+        {
+            expectMatchesGFNumber(field);
+        }
+    }
+    EXPECT_TRUE(GFVector::selectKernels(nullptr));
+    EXPECT_FALSE(GFVector::selectKernels("neon"));
+}
+
+TEST(GFVectorTest , ElementAccess)
+{
+    GField field(7 , 2);
+    GFVector vector(field , 3);
+    vector.set(0 , -1);
+    vector.set(2 , 100);
+    EXPECT_EQ(vector.size() , 3u);
+    EXPECT_EQ(vector.get(0).getNumber() , 48);
+    EXPECT_EQ(vector.get(1).getNumber() , 0);
+    EXPECT_EQ(vector.get(2).getNumber() , 2);
+    EXPECT_EQ(vector.getField() , field);
+}
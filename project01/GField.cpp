@@ -2,10 +2,24 @@
 
 #include "GField.h"
 #include "GFNumber.h"
+#include "GFieldRegistry.h"
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
+#define SMALL_PRIMES_COUNT 18
+#define SMALL_PRIMES_BOUND (67 * 67) /** below it, no small factor means prime */
+#define WITNESSES_COUNT 7
+
+/** The primes used by the trial division prefilter of isPrime. */
+static const uint64_t SMALL_PRIMES[SMALL_PRIMES_COUNT] = {2 , 3 , 5 , 7 , 11 , 13 , 17 , 19 , 23 ,
+                                                          29 , 31 , 37 , 41 , 43 , 47 , 53 , 59 ,
+                                                          61};
+
+/** Miller-Rabin bases which are deterministic for every n < 2^64 (Jim Sinclair). */
+static const uint64_t WITNESSES[WITNESSES_COUNT] = {2 , 325 , 9375 , 28178 , 450775 , 9780504 ,
+                                                    1795265022};
 // --------------------------------------------------------------------------------------
 // This file contains the implementation of the class GField.
 // --------------------------------------------------------------------------------------
@@ -18,10 +32,13 @@
  */
 GField::GField(long p)
 {
-    p = abs(p);
+    p = std::labs(p);
     assert(p > 1 && isPrime(p));
     this->_p = p;
     this->_l = 1;
+    this->_extension = nullptr;
+    _initOrder();
+    this->_id = GFieldRegistry::intern(*this);
 }
 
 /**
@@ -32,10 +49,75 @@ GField::GField(long p)
  */
 GField::GField(long p , long l)
 {
-    p = abs(p);
+    p = std::labs(p);
+    assert((isPrime(p)) && (l > 0));
+    this->_p = p;
+    this->_l = l;
+    this->_extension = nullptr;
+    _initOrder();
+    this->_id = GFieldRegistry::intern(*this);
+}
+
+/**
+ * A constructor.
+ * ctor with p, l and the arithmetic of the elements, a polynomial field of degree l > 1
+ * uses the irreducible polynomial found by GFExtension::findIrreducible.
+ * @param p the char of the field.
+ * @param l the degree of the field.
+ * @param arithmetic the arithmetic of the elements (a field of degree 1 is always integer).
+ */
+GField::GField(long p , long l , GFieldArithmetic arithmetic)
+{
+    p = std::labs(p);
     assert((isPrime(p)) && (l > 0));
     this->_p = p;
     this->_l = l;
+    _initOrder();
+    this->_extension = (arithmetic == POLYNOMIAL_ARITHMETIC && l > 1) ?
+                       GFExtension::get((uint64_t) p , (int) l) : nullptr;
+    this->_id = GFieldRegistry::intern(*this);
+}
+
+/**
+ * A constructor.
+ * ctor with p, l and the irreducible polynomial of the polynomial arithmetic.
+ * @param p the char of the field.
+ * @param l the degree of the field, greater than 1.
+ * @param modulus f - x^l for a monic irreducible f of degree l over GF(p), packed like an
+ * element (0x1B is x^8 + x^4 + x^3 + x + 1 for GF(2**8)). A reducible f aborts the program.
+ */
+GField::GField(long p , long l , uint64_t modulus)
+{
+    p = std::labs(p);
+    assert((isPrime(p)) && (l > 1));
+    this->_p = p;
+    this->_l = l;
+    _initOrder();
+    this->_extension = GFExtension::get((uint64_t) p , (int) l , modulus);
+    if (this->_extension == nullptr)
+    {
+        std::cerr << "GField: the modulus " << modulus << " is reducible over GF(" << p << ")"
+                  << std::endl;
+        std::abort();
+    }
+    this->_id = GFieldRegistry::intern(*this);
+}
+
+/**
+ * Computes the order p^l exactly in integers and caches it along with its reducer.
+ * The order must fit in a long.
+ */
+void GField::_initOrder()
+{
+    long order = 1;
+    for (long i = 0; i < _l; i++)
+    {
+        bool overflow = __builtin_mul_overflow(order , _p , &order);
+        assert(!overflow && "the order of the field must fit in a long");
+        (void) overflow;
+    }
+    _order = order;
+    _reducer = ModReducer((uint64_t) order);
 }
 
 /**
@@ -45,14 +127,71 @@ GField::GField(long p , long l)
  */
 bool GField::isPrime(long p)
 {
-    p = abs(p);
-    if (p <= 1)
+    uint64_t n = (p < 0) ? 0 - (uint64_t) p : (uint64_t) p;
+    if (n <= 1)
     {
         return false;
     }
-    for (int i = 2; i <= sqrt(p); i++)
+    for (uint64_t prime : SMALL_PRIMES)
+    {
+        if ((n % prime) == 0)
+        {
+            return n == prime;
+        }
+    }
+    if (n < SMALL_PRIMES_BOUND)
+    {
+        return true;
+    }
+    return _millerRabin(n);
+}
+
+/**
+ * Batch version of isPrime.
+ * @param numbers array of long numbers.
+ * @param count the length of numbers.
+ * @param results array of length count, results[i] is set to isPrime(numbers[i]).
+ */
+void GField::isPrime(const long *numbers , size_t count , bool *results)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = isPrime(numbers[i]);
+    }
+}
+
+/**
+ * Deterministic Miller-Rabin test, correct for every 64 bit number.
+ * @param n odd number with no prime factor below 67.
+ * @return True if n is a prime number, false otherwise.
+ */
+bool GField::_millerRabin(uint64_t n)
+{
+    ModReducer reducer(n);
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    const uint64_t one = reducer.toMontgomery(1);
+    const uint64_t minusOne = reducer.toMontgomery(n - 1);
+    for (uint64_t witness : WITNESSES)
     {
-        if ((p % i) == 0)
+        witness %= n;
+        if (witness == 0)
+        {
+            continue;
+        }
+        uint64_t x = reducer.powMontgomery(reducer.toMontgomery(witness) , d);
+        if (x == one || x == minusOne)
+        {
+            continue;
+        }
+        bool composite = true;
+        for (int r = 1; r < s && composite; r++)
+        {
+            x = reducer.mulMontgomery(x , x);
+            composite = (x != minusOne);
+        }
+        if (composite)
         {
             return false;
         }
@@ -69,30 +208,171 @@ bool GField::isPrime(long p)
 GFNumber GField::gcd(GFNumber a , GFNumber b) const
 {
     assert(a.getField() == b.getField() && a.getField() == *this && b.getField() == *this);
-    while (a.getNumber() >= 0 && b.getNumber() >= 0)
+    uint64_t divisor = binaryGcd((uint64_t) a.getNumber() , (uint64_t) b.getNumber());
+    return GFNumber((long) divisor , *this);
+}
+
+/**
+ * Stein's binary gcd, it only shifts and subtracts.
+ * @param a unsigned number.
+ * @param b unsigned number.
+ * @return the gcd of a and b (gcd(0, b) is b).
+ */
+uint64_t GField::binaryGcd(uint64_t a , uint64_t b)
+{
+    if (a == 0 || b == 0)
     {
-        if (a.getNumber() == 0)
+        return a | b;
+    }
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b != 0)
+    {
+        b >>= __builtin_ctzll(b);
+        if (a > b)
         {
-            return b;
+            uint64_t temp = a;
+            a = b;
+            b = temp;
         }
-        if (b.getNumber() == 0)
+        b -= a;
+    }
+    return a << shift;
+}
+
+/**
+ * Binary extended gcd, finds x and y such that a * x + b * y = gcd(a, b).
+ * (Algorithm 14.61 of the Handbook of Applied Cryptography, the coefficients stay
+ * bounded by a and b so they fit in 128 bits).
+ * @param a positive number.
+ * @param b positive number.
+ * @param x output, the coefficient of a.
+ * @param y output, the coefficient of b.
+ * @return the gcd of a and b.
+ */
+uint64_t GField::extendedBinaryGcd(uint64_t a , uint64_t b , __int128 *x , __int128 *y)
+{
+    assert(a > 0 && b > 0);
+    int shift = __builtin_ctzll(a | b);
+    a >>= shift;
+    b >>= shift;
+    uint64_t u = a , v = b;
+    __int128 coefA = 1 , coefB = 0 , coefC = 0 , coefD = 1;
+    while (u != 0)
+    {
+        while ((u & 1) == 0)
         {
-            return a;
+            u >>= 1;
+            if ((coefA & 1) == 0 && (coefB & 1) == 0)
+            {
+                coefA /= 2;
+                coefB /= 2;
+            }
+            else
+            {
+                coefA = (coefA + b) / 2;
+                coefB = (coefB - a) / 2;
+            }
         }
-        if (a.getNumber() == b.getNumber())
+        while ((v & 1) == 0)
         {
-            return a;
+            v >>= 1;
+            if ((coefC & 1) == 0 && (coefD & 1) == 0)
+            {
+                coefC /= 2;
+                coefD /= 2;
+            }
+            else
+            {
+                coefC = (coefC + b) / 2;
+                coefD = (coefD - a) / 2;
+            }
         }
-        if (a.getNumber() > b.getNumber())
+        if (u >= v)
         {
-            a = a - b;
+            u -= v;
+            coefA -= coefC;
+            coefB -= coefD;
         }
         else
         {
-            b = b - a;
+            v -= u;
+            coefC -= coefA;
+            coefD -= coefB;
         }
     }
-    return a;
+    *x = coefC;
+    *y = coefD;
+    return v << shift;
+}
+
+/**
+ * Calculates the inverse of a modulo m with the binary extended gcd.
+ * @param a unsigned number.
+ * @param m the modulus, greater than 1.
+ * @return the inverse of a in [1, m), or 0 if a is not invertible modulo m.
+ */
+uint64_t GField::modInverse(uint64_t a , uint64_t m)
+{
+    assert(m > 1);
+    a %= m;
+    if (a == 0)
+    {
+        return 0;
+    }
+    __int128 x , y;
+    if (extendedBinaryGcd(a , m , &x , &y) != 1)
+    {
+        return 0;
+    }
+    x %= (__int128) m;
+    return (uint64_t) ((x < 0) ? x + m : x);
+}
+
+/**
+ * Calculates a square root of a modulo an odd prime with Tonelli-Shanks.
+ * @param a unsigned number.
+ * @param p an odd prime.
+ * @return a root r in [0, p) with r * r = a mod p, or 0 if a is 0 or not a square mod p.
+ */
+uint64_t GField::modSqrt(uint64_t a , uint64_t p)
+{
+    assert(p > 2 && (p & 1) == 1);
+    ModReducer reducer(p);
+    a = reducer.reduce(a);
+    // Euler's criterion
+    if (a == 0 || reducer.powMod(a , (p - 1) / 2) != 1)
+    {
+        return 0;
+    }
+    // p - 1 = q * 2^s with q odd, z is any non residue
+    int s = __builtin_ctzll(p - 1);
+    uint64_t q = (p - 1) >> s , z = 2;
+    while (reducer.powMod(z , (p - 1) / 2) == 1)
+    {
+        z++;
+    }
+    uint64_t c = reducer.powMod(z , q) , t = reducer.powMod(a , q);
+    uint64_t root = reducer.powMod(a , (q + 1) / 2);
+    // invariant: root^2 = a * t, and t has order 2^i for some i < s
+    while (t != 1)
+    {
+        int i = 0;
+        for (uint64_t square = t; square != 1; square = reducer.mulMod(square , square))
+        {
+            i++;
+        }
+        uint64_t b = c;
+        for (int j = 0; j < s - i - 1; j++)
+        {
+            b = reducer.mulMod(b , b);
+        }
+        s = i;
+        c = reducer.mulMod(b , b);
+        t = reducer.mulMod(t , c);
+        root = reducer.mulMod(root , b);
+    }
+    return root;
 }
 
 /**
@@ -106,18 +386,6 @@ GFNumber GField::createNumber(long k) const
     return gfNumber;
 }
 
-/**
- * Operator overloading of "=".
- * @param other GField instance.
- * @return GField instace
- */
-GField &GField::operator=(const GField &other)
-{
-    this->_p = other._p;
-    this->_l = other._l;
-    return *this;
-}
-
 /**
  * Operator overloading of "<<".
  * @param out ostream reference.
@@ -142,36 +410,33 @@ std::istream &operator>>(std::istream &in , GField &field)
     assert(ch > 1 && GField::isPrime(ch) && degree > 0);
     field._p = ch;
     field._l = degree;
+    field._extension = nullptr;
+    field._initOrder();
+    field._id = GFieldRegistry::intern(field);
     return in;
 }
 
 
 /**
- * Operator overloading of "==".
+ * Operator overloading of "!=".
  * @param other GField instance.
- * @return True if the objects are equal, false otherwise.
- * note that instances are equal if the have the same order.
+ * @return True if the objects are not equal, false otherwise.
+ * note that instances are equal if they are the same interned field (same order and
+ * arithmetic).
  */
 const bool GField::operator!=(const GField &other) const
 {
-    return (this->getOrder() != other.getOrder());
+    return (this->_id != other._id);
 }
 
 /**
  * Operator overloading of "==".
  * @param other GField instance.
  * @return True if the objects are equal, false otherwise.
- * note that instances are equal if the have the same order.
+ * note that instances are equal if they are the same interned field (same order and
+ * arithmetic).
  */
 const bool GField::operator==(const GField &other) const
 {
-    return (this->getOrder() == other.getOrder());
-}
-
-/**
- * Destructor
- */
-GField::~GField()
-{
-    // empty destructor
+    return (this->_id == other._id);
 }
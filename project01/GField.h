@@ -4,27 +4,68 @@
 #define GFIELD_H
 //-------------- includes --------------
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
+#include "GFElement.h"
+#include "GFExtension.h"
+#include "ModReducer.h"
+
+#define MAX_FIELDS 65536 /** the number of distinct fields a program can construct */
 
 //--------------------------------------
 // forward declaration of the GFNumber class:
 class GFNumber;
 
+/** The id of an interned field (see GFieldRegistry). */
+typedef uint16_t GFieldId;
+
+/** How the elements of a field of degree l > 1 are multiplied. */
+enum GFieldArithmetic
+{
+    INTEGER_ARITHMETIC , /** the integers modulo p^l (the ring Z/p^l, the default) */
+    POLYNOMIAL_ARITHMETIC /** the polynomials over GF(p) modulo an irreducible one, GF(p^l) */
+};
+
 /**
  *  A GField class.
  *  This class represents a galois field.
+ *  By default the elements of a field of degree l > 1 are the integers modulo p^l. A field
+ *  built with POLYNOMIAL_ARITHMETIC or with an irreducible modulus is the true GF(p^l): an
+ *  element is a polynomial of degree below l over GF(p), packed into the same integer range
+ *  (see GFExtension), and the element operations and every GFNumber operator use it.
  */
 class GField
 {
 private:
     long _p; /** The char of the field. */
     long _l; /** The degree of the field. */
+    long _order; /** The order of the field (p^l), computed once. */
+    ModReducer _reducer; /** Precomputed reduction context modulo the order. */
+    const GFExtension *_extension; /** The polynomial arithmetic, nullptr for the integer one. */
+    GFieldId _id; /** The id of the field in the GFieldRegistry. */
+
+    friend class GFieldRegistry;
+
+    /**
+     * Computes the order p^l exactly in integers and caches it along with its reducer.
+     * The order must fit in a long.
+     */
+    void _initOrder();
+
+    /**
+     * Deterministic Miller-Rabin test, correct for every 64 bit number.
+     * @param n odd number with no prime factor below 67.
+     * @return True if n is a prime number, false otherwise.
+     */
+    static bool _millerRabin(uint64_t n);
 public:
     /**
      * A constructor.
      * Default ctor.
      */
-    GField() : _p(2) , _l(1) {};
+    constexpr GField() : _p(2) , _l(1) , _order(2) , _reducer() , _extension(nullptr) , _id(0) {};
 
     /**
      * A constructor.
@@ -43,16 +84,23 @@ public:
 
     /**
      * A constructor.
-     * copy ctor.
-     * @param field gets GField.
+     * ctor with p, l and the arithmetic of the elements, a polynomial field of degree l > 1
+     * uses the irreducible polynomial found by GFExtension::findIrreducible.
+     * @param p the char of the field.
+     * @param l the degree of the field.
+     * @param arithmetic the arithmetic of the elements (a field of degree 1 is always integer).
      */
-    GField(const GField &field) : GField(field._p , field._l)
-    {};
+    GField(long p , long l , GFieldArithmetic arithmetic);
 
     /**
-     * Destructor
+     * A constructor.
+     * ctor with p, l and the irreducible polynomial of the polynomial arithmetic.
+     * @param p the char of the field.
+     * @param l the degree of the field, greater than 1.
+     * @param modulus f - x^l for a monic irreducible f of degree l over GF(p), packed like an
+     * element (0x1B is x^8 + x^4 + x^3 + x + 1 for GF(2**8)). A reducible f aborts the program.
      */
-    ~GField();
+    GField(long p , long l , uint64_t modulus);
 
     /**
      * Getter for the char of the field.
@@ -73,15 +121,143 @@ public:
      * @return  the order of the field (long).
      */
     long getOrder() const
-    { return ceil(pow(_p , _l)); }
+    { return _order; }
+
+    /**
+     * Getter for the reduction context modulo the order of the field.
+     * @return the reducer of the field.
+     */
+    const ModReducer &getReducer() const
+    { return _reducer; }
+
+    /**
+     * Getter for the arithmetic of the elements.
+     * @return POLYNOMIAL_ARITHMETIC for GF(p^l), INTEGER_ARITHMETIC otherwise.
+     */
+    GFieldArithmetic getArithmetic() const
+    { return (_extension == nullptr) ? INTEGER_ARITHMETIC : POLYNOMIAL_ARITHMETIC; }
+
+    /**
+     * Getter for the irreducible polynomial of the polynomial arithmetic.
+     * @return f - x^l packed like an element, 0 for the integer arithmetic.
+     */
+    uint64_t getModulus() const
+    { return (_extension == nullptr) ? 0 : _extension->getModulus(); }
+
+    /**
+     * Getter for the polynomial arithmetic.
+     * @return the extension, nullptr for the integer arithmetic.
+     */
+    const GFExtension *getExtension() const
+    { return _extension; }
+
+    /**
+     * Getter for the id of the field, equal ids mean equal fields.
+     * @return the id of the field in the GFieldRegistry.
+     */
+    GFieldId getId() const
+    { return _id; }
+
+    /**
+     * Creates the compact element of a number.
+     * @param k long number.
+     * @return k as an element of the field.
+     */
+    GFElement element(long k) const
+    {
+        return GFElement((_extension == nullptr) ? _reducer.reduceSigned(k) :
+                         _extension->element(k));
+    }
+
+    /**
+     * Adds two elements of the field.
+     * @param a GFElement of this field.
+     * @param b GFElement of this field.
+     * @return a + b.
+     */
+    GFElement add(GFElement a , GFElement b) const
+    {
+        return (_extension == nullptr) ?
+               GFElement(_reducer.addMod(a.getResidue() , b.getResidue())) :
+               GFElement(_extension->add(a.getResidue() , b.getResidue()));
+    }
+
+    /**
+     * Subtracts two elements of the field.
+     * @param a GFElement of this field.
+     * @param b GFElement of this field.
+     * @return a - b.
+     */
+    GFElement sub(GFElement a , GFElement b) const
+    {
+        return (_extension == nullptr) ?
+               GFElement(_reducer.subMod(a.getResidue() , b.getResidue())) :
+               GFElement(_extension->sub(a.getResidue() , b.getResidue()));
+    }
+
+    /**
+     * Multiplies two elements of the field.
+     * @param a GFElement of this field.
+     * @param b GFElement of this field.
+     * @return a * b.
+     */
+    GFElement mul(GFElement a , GFElement b) const
+    {
+        return (_extension == nullptr) ?
+               GFElement(_reducer.mulMod(a.getResidue() , b.getResidue())) :
+               GFElement(_extension->mul(a.getResidue() , b.getResidue()));
+    }
+
+    /**
+     * Negates an element of the field.
+     * @param a GFElement of this field.
+     * @return -a.
+     */
+    GFElement neg(GFElement a) const
+    {
+        return GFElement((_extension == nullptr) ? _reducer.subMod(0 , a.getResidue()) :
+                         _extension->neg(a.getResidue()));
+    }
+
+    /**
+     * Raises an element of the field to a power.
+     * @param a GFElement of this field.
+     * @param exponent the exponent.
+     * @return a^exponent (1 for a zero exponent).
+     */
+    GFElement pow(GFElement a , uint64_t exponent) const
+    {
+        return GFElement((_extension == nullptr) ? _reducer.powMod(a.getResidue() , exponent) :
+                         _extension->pow(a.getResidue() , exponent));
+    }
+
+    /**
+     * The multiplicative inverse of an element of the field.
+     * @param a GFElement of this field.
+     * @return the inverse of a, or 0 if a is not invertible.
+     */
+    GFElement inv(GFElement a) const
+    {
+        return GFElement((_extension == nullptr) ? modInverse(a.getResidue() , (uint64_t) _order) :
+                         _extension->inverse(a.getResidue()));
+    }
 
     /**
      * This static method verifies that the number p is prime.
+     * Small primes are tried by division, everything else by a deterministic Miller-Rabin.
      * @param p is a long number.
      * @return True if p is a prime number, false otherwise.
      */
     static bool isPrime(long p);
 
+    /**
+     * Batch version of isPrime.
+     * @param numbers array of long numbers.
+     * @param count the length of numbers.
+     * @param results array of length count, results[i] is set to isPrime(numbers[i]).
+     */
+    static void isPrime(const long *numbers , size_t count , bool *results);
+
     /**
      * This method calculates the gcd of two given numbers.
      * @param a GFNumber instance.
@@ -90,6 +266,40 @@ public:
      */
     GFNumber gcd(GFNumber a , GFNumber b) const;
 
+    /**
+     * Stein's binary gcd, it only shifts and subtracts.
+     * @param a unsigned number.
+     * @param b unsigned number.
+     * @return the gcd of a and b (gcd(0, b) is b).
+     */
+    static uint64_t binaryGcd(uint64_t a , uint64_t b);
+
+    /**
+     * Binary extended gcd, finds x and y such that a * x + b * y = gcd(a, b).
+     * @param a positive number.
+     * @param b positive number.
+     * @param x output, the coefficient of a.
+     * @param y output, the coefficient of b.
+     * @return the gcd of a and b.
+     */
+    static uint64_t extendedBinaryGcd(uint64_t a , uint64_t b , __int128 *x , __int128 *y);
+
+    /**
+     * Calculates the inverse of a modulo m with the binary extended gcd.
+     * @param a unsigned number.
+     * @param m the modulus, greater than 1.
+     * @return the inverse of a in [1, m), or 0 if a is not invertible modulo m.
+     */
+    static uint64_t modInverse(uint64_t a , uint64_t m);
+
+    /**
+     * Calculates a square root of a modulo an odd prime with Tonelli-Shanks.
+     * @param a unsigned number.
+     * @param p an odd prime.
+     * @return a root r in [0, p) with r * r = a mod p, or 0 if a is 0 or not a square mod p.
+     */
+    static uint64_t modSqrt(uint64_t a , uint64_t p);
+
     /**
      * This method creates a GFNumber from the GField.
      * @param k long number.
@@ -97,26 +307,21 @@ public:
      */
     GFNumber createNumber(long k) const;
 
-    /**
-     * Operator overloading of "=".
-     * @param other GField instance.
-     * @return GField instace
-     */
-    GField &operator=(const GField &other);
-
     /**
      * Operator overloading of "==".
      * @param other GField instance.
      * @return True if the objects are equal, false otherwise.
-     * note that instances are equal if the have the same order.
+     * note that instances are equal if they are the same interned field (same order and
+     * arithmetic).
      */
     const bool operator==(const GField &other) const;
 
     /**
-     * Operator overloading of "==".
+     * Operator overloading of "!=".
      * @param other GField instance.
-     * @return True if the objects are equal, false otherwise.
-     * note that instances are equal if the have the same order.
+     * @return True if the objects are not equal, false otherwise.
+     * note that instances are equal if they are the same interned field (same order and
+     * arithmetic).
      */
     const bool operator!=(const GField &other) const;
 
@@ -137,4 +342,6 @@ public:
     friend std::istream &operator>>(std::istream &in , GField &field);
 };
 
+static_assert(std::is_trivially_copyable<GField>::value , "GField must copy as plain bytes");
+
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+// GFieldRegistry.cpp
+
+#include "GFieldRegistry.h"
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class GFieldRegistry.
+// --------------------------------------------------------------------------------------
+
+#define REGISTRY_SLOTS (2 * MAX_FIELDS) /** slots of the lock free id table, a power of 2 */
+
+/** The first chunk is static (and constant initialized), its slot 0 is GF(2**1). */
+static GField firstChunk[REGISTRY_CHUNK_SIZE];
+
+/** The key of a field: its char, its degree and the modulus of its polynomial arithmetic or 0. */
+typedef std::tuple<long , long , uint64_t> FieldKey;
+
+/** Guards interning. */
+static std::mutex registryMutex;
+
+/**
+ * @return the ids of the interned fields by key, the default field included.
+ */
+static std::map<FieldKey , GFieldId> &fieldIds()
+{
+    static std::map<FieldKey , GFieldId> ids{{FieldKey(2 , 1 , 0) , 0}};
+    return ids;
+}
+
+/**
+ * Lock free table of the interned ids by key, open addressed: a slot holds 0 or an id plus 1.
+ * Slots are only written with the registry mutex held, after their field is published.
+ */
+static std::atomic<uint32_t> idSlots[REGISTRY_SLOTS];
+
+std::atomic<GField *> GFieldRegistry::_chunks[REGISTRY_CHUNKS] = {{firstChunk}};
+
+/**
+ * @param key a field key.
+ * @return the first slot to probe for the key.
+ */
+static size_t firstSlot(const FieldKey &key)
+{
+    uint64_t hash = (uint64_t) std::get<0>(key) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (uint64_t) std::get<1>(key)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ std::get<2>(key)) * 0x94D049BB133111EBULL;
+    return (size_t) (hash >> 32) & (REGISTRY_SLOTS - 1);
+}
+
+/**
+ * Finds an interned field in the lock free table.
+ * @param key a field key.
+ * @param id set to the id of the field when it is found.
+ * @return the slot of the field when it is found, otherwise the empty slot ending the probe.
+ */
+static size_t findSlot(const FieldKey &key , GFieldId &id)
+{
+    for (size_t slot = firstSlot(key); ; slot = (slot + 1) & (REGISTRY_SLOTS - 1))
+    {
+        uint32_t entry = idSlots[slot].load(std::memory_order_acquire);
+        if (entry == 0)
+        {
+            return slot;
+        }
+        const GField &field = GFieldRegistry::get((GFieldId) (entry - 1));
+        if (FieldKey(field.getChar() , field.getDegree() , field.getModulus()) == key)
+        {
+            id = (GFieldId) (entry - 1);
+            return slot;
+        }
+    }
+}
+
+/**
+ * Interns a field.
+ * @param field a valid field (its id is ignored).
+ * @return the id of the field, the same for every field with the same char, degree and
+ * arithmetic.
+ */
+GFieldId GFieldRegistry::intern(const GField &field)
+{
+    FieldKey key(field.getChar() , field.getDegree() , field.getModulus());
+    GFieldId id = 0;
+    size_t slot = findSlot(key , id);
+    if (idSlots[slot].load(std::memory_order_relaxed) != 0)
+    {
+        return id;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    // another thread may have interned the field since the lookup
+    slot = findSlot(key , id);
+    if (idSlots[slot].load(std::memory_order_relaxed) != 0)
+    {
+        return id;
+    }
+    std::map<FieldKey , GFieldId> &ids = fieldIds();
+    auto found = ids.find(key);
+    if (found != ids.end())
+    {
+        // the default field is interned without a slot
+        idSlots[slot].store(found->second + 1u , std::memory_order_release);
+        return found->second;
+    }
+    if (ids.size() >= MAX_FIELDS)
+    {
+        std::cerr << "GFieldRegistry: more than " << MAX_FIELDS << " distinct fields"
+                  << std::endl;
+        std::abort();
+    }
+    id = (GFieldId) ids.size();
+    GField *chunk = _chunks[id >> REGISTRY_CHUNK_BITS].load(std::memory_order_relaxed);
+    if (chunk == nullptr)
+    {
+        chunk = new GField[REGISTRY_CHUNK_SIZE];
+    }
+    chunk[id & (REGISTRY_CHUNK_SIZE - 1)] = field;
+    chunk[id & (REGISTRY_CHUNK_SIZE - 1)]._id = id;
+    _chunks[id >> REGISTRY_CHUNK_BITS].store(chunk , std::memory_order_release);
+    ids[key] = id;
+    idSlots[slot].store(id + 1u , std::memory_order_release);
+    return id;
+}
+
+/**
+ * @return the number of interned fields.
+ */
+size_t GFieldRegistry::size()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return fieldIds().size();
+}
@@ -0,0 +1,55 @@
+// GFieldRegistry.h
+//----------- include guards------------
+#ifndef GFIELDREGISTRY_H
+#define GFIELDREGISTRY_H
+//-------------- includes --------------
+#include <atomic>
+#include "GField.h"
+
+#define REGISTRY_CHUNK_BITS 8
+#define REGISTRY_CHUNK_SIZE (1 << REGISTRY_CHUNK_BITS) /** fields per chunk */
+#define REGISTRY_CHUNKS (MAX_FIELDS / REGISTRY_CHUNK_SIZE)
+
+//--------------------------------------
+
+/**
+ *  A GFieldRegistry class.
+ *  Interns every field the program constructs and hands out a 16 bit id for it, so field
+ *  elements can refer to their field with an id instead of a full GField copy.
+ *  Ids are never reused, the fields live until the end of the program. Lookups, and interning
+ *  a field already interned, are lock free; interning a new field takes a lock and aborts the
+ *  program past MAX_FIELDS distinct fields. Id 0 is always GF(2**1), the default field.
+ */
+class GFieldRegistry
+{
+private:
+    /** The interned fields, in chunks of REGISTRY_CHUNK_SIZE allocated on demand. */
+    static std::atomic<GField *> _chunks[REGISTRY_CHUNKS];
+
+public:
+    /**
+     * Interns a field.
+     * @param field a valid field (its id is ignored).
+     * @return the id of the field, the same for every field with the same char, degree and
+     * arithmetic.
+     */
+    static GFieldId intern(const GField &field);
+
+    /**
+     * Lookup of an interned field.
+     * @param id an id returned by intern.
+     * @return the field.
+     */
+    static const GField &get(GFieldId id)
+    {
+        return _chunks[id >> REGISTRY_CHUNK_BITS].load(std::memory_order_acquire)
+        [id & (REGISTRY_CHUNK_SIZE - 1)];
+    }
+
+    /**
+     * @return the number of interned fields.
+     */
+    static size_t size();
+};
+
+#endif //GFIELDREGISTRY_H
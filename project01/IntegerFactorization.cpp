@@ -1,19 +1,77 @@
 // IntegerFactorization.cpp
 
 #include <iostream>
+#include <fstream>
 #include <random>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include "BatchFactorizer.h"
+#include "FactorizationCache.h"
+#include "FactorizationPipeline.h"
 #include "GField.h"
 #include "GFNumber.h"
+#include "ThreadPool.h"
 #define FAILED 1
+#define BATCH_FLAG "--batch"
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/**
+ * Batch mode: factors every number of the file (or stdin) on all the cores and prints one
+ * line per number, in input order. The statistics (and those of every stage of the
+ * factorization pipeline and of the cache) go to stderr. When GF_FACTOR_CACHE names a file,
+ * the cache is loaded from it first and saved to it at the end, so a restarted run is warm.
+ * @param path the input file, nullptr or "-" for stdin.
+ * @return 0 for successful run and 1 otherwise.
+ */
+static int runBatch(const char *path)
+{
+    std::ifstream file;
+    if (path != nullptr && strcmp(path , "-") != 0)
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "cannot open " << path << std::endl;
+            return FAILED;
+        }
+    }
+    static char buffer[OUTPUT_BUFFER_SIZE];
+    std::ios::sync_with_stdio(false);
+    std::cout.rdbuf()->pubsetbuf(buffer , sizeof(buffer));
+
+    FactorizationCache &cache = FactorizationCache::global();
+    const char *cachePath = std::getenv(CACHE_FILE_ENV);
+    bool persistent = cachePath != nullptr && *cachePath != '\0';
+    if (persistent && std::ifstream(cachePath).good() && !cache.load(cachePath))
+    {
+        std::cerr << "ignoring the cache file " << cachePath << std::endl;
+    }
+    ThreadPool pool;
+    BatchFactorizer factorizer(pool , &cache);
+    BatchReport report = factorizer.run(file.is_open() ? file : std::cin , std::cout);
+    std::cerr << report << " on " << pool.size() << " threads" << std::endl
+              << FactorizationPipeline::global() << cache.getStatistics() << std::endl;
+    if (persistent && !cache.save(cachePath))
+    {
+        std::cerr << "cannot write " << cachePath << std::endl;
+        return FAILED;
+    }
+    return 0;
+}
 
 /**
  * Main function, gets some user input and creates a GField
  * and a GFNumber and do some math operations on this.
+ * With --batch [file] it factors a whole stream of numbers instead.
  * @return 0 for successful run and 1 otherwise.
  */
-int main()
+int main(int argc , char *argv[])
 {
+    if (argc > 1 && strcmp(argv[1] , BATCH_FLAG) == 0)
+    {
+        return runBatch((argc > 2) ? argv[2] : nullptr);
+    }
     GFNumber num1, num2;
     std::cin >> num1 >> num2;
     // Check if the user input is valid
@@ -25,4 +83,4 @@ int main()
     num1.printFactors();
     num2.printFactors();
     return 0;
-}
\ No newline at end of file
+}
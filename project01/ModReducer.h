@@ -0,0 +1,312 @@
+// ModReducer.h
+//----------- include guards------------
+#ifndef MODREDUCER_H
+#define MODREDUCER_H
+//-------------- includes --------------
+#include <cassert>
+#include <cstdint>
+
+#define POW_WINDOW_BITS 4
+#define POW_WINDOW_THRESHOLD 32
+
+//--------------------------------------
+
+/**
+ *  A ModReducer class.
+ *  This class holds the precomputed Barrett constant of a fixed modulus, so reducing a number
+ *  modulo it becomes a multiply-and-shift instead of a hardware division.
+ *  Products of two residues are computed in 128 bits, so it is correct for any modulus
+ *  below 2^63: small moduli reduce the 64 bit product with Barrett, powers of two mask it
+ *  and other odd moduli go through Montgomery reduction.
+ */
+class ModReducer
+{
+private:
+    uint64_t _m; /** The modulus. */
+    uint64_t _mu; /** The Barrett constant floor((2^64 - 1) / m). */
+    uint64_t _mInv; /** -m^-1 mod 2^64 (Montgomery constant), 0 if m is even. */
+    uint64_t _r2; /** 2^128 mod m (Montgomery constant), 0 if m is even. */
+    uint64_t _r; /** 2^64 mod m. */
+
+    /**
+     * Montgomery reduction.
+     * @param t a number smaller than m * 2^64.
+     * @return t * 2^-64 mod m.
+     */
+    uint64_t _redc(unsigned __int128 t) const
+    {
+        uint64_t u = (uint64_t) t * _mInv;
+        uint64_t r = (uint64_t) ((t + (unsigned __int128) u * _m) >> 64);
+        return (r >= _m) ? r - _m : r;
+    }
+
+    /**
+     * Multiplies two residues whose product may not fit in 64 bits.
+     * @param a residue.
+     * @param b residue.
+     * @return a * b mod m.
+     */
+    uint64_t _mulModWide(uint64_t a , uint64_t b) const
+    {
+        if (_mInv != 0)
+        {
+            return _redc((unsigned __int128) _redc((unsigned __int128) a * b) * _r2);
+        }
+        if ((_m & (_m - 1)) == 0)
+        {
+            return (a * b) & (_m - 1);
+        }
+        return (uint64_t) (((unsigned __int128) a * b) % _m);
+    }
+
+    /**
+     * Left-to-right sliding window exponentiation: the odd powers base^1..base^(2^w - 1) are
+     * precomputed, so a run of w exponent bits costs w squarings and a single multiplication.
+     * @param base residue (in whatever domain mul works in).
+     * @param exponent the exponent, not 0.
+     * @param one the unit of the domain.
+     * @param mul the multiplication of the domain.
+     * @return base^exponent.
+     */
+    template<typename Multiply>
+    static uint64_t _slidingWindowPow(uint64_t base , uint64_t exponent , uint64_t one ,
+                                      Multiply mul)
+    {
+        uint64_t oddPowers[1 << (POW_WINDOW_BITS - 1)];
+        oddPowers[0] = base;
+        uint64_t square = mul(base , base);
+        for (int i = 1; i < (1 << (POW_WINDOW_BITS - 1)); i++)
+        {
+            oddPowers[i] = mul(oddPowers[i - 1] , square);
+        }
+        uint64_t result = one;
+        int bit = 63 - __builtin_clzll(exponent);
+        while (bit >= 0)
+        {
+            if (((exponent >> bit) & 1) == 0)
+            {
+                result = mul(result , result);
+                bit--;
+                continue;
+            }
+            int low = (bit >= POW_WINDOW_BITS) ? bit - POW_WINDOW_BITS + 1 : 0;
+            while (((exponent >> low) & 1) == 0)
+            {
+                low++;
+            }
+            for (int i = low; i <= bit; i++)
+            {
+                result = mul(result , result);
+            }
+            uint64_t window = (exponent >> low) & ((1ul << (bit - low + 1)) - 1);
+            result = mul(result , oddPowers[window >> 1]);
+            bit = low - 1;
+        }
+        return result;
+    }
+
+public:
+    /**
+     * A constructor.
+     * Default ctor, reduces modulo 2.
+     */
+    constexpr ModReducer() : _m(2) , _mu(UINT64_MAX / 2) , _mInv(0) , _r2(0) , _r(0)
+    {};
+
+    /**
+     * A constructor.
+     * @param m the modulus, must be greater than 1.
+     */
+    explicit ModReducer(uint64_t m) : _m(m) , _mu(UINT64_MAX / m) , _mInv(0) , _r2(0) ,
+                                      _r((0 - m) % m)
+    {
+        assert(m > 1 && m <= (uint64_t) INT64_MAX);
+        if ((m & 1) == 1)
+        {
+            // Newton iteration, every step doubles the number of correct low bits
+            uint64_t inv = m;
+            for (int i = 0; i < 5; i++)
+            {
+                inv *= 2 - m * inv;
+            }
+            _mInv = 0 - inv;
+            _r2 = (uint64_t) (((unsigned __int128) _r * _r) % m);
+        }
+    };
+
+    /**
+     * Getter for the modulus.
+     * @return the modulus.
+     */
+    uint64_t getModulus() const
+    { return _m; }
+
+    /**
+     * Reduces a non negative number modulo m.
+     * The estimated quotient is at most 2 below the real one, so two conditional
+     * subtractions are enough to land in [0, m).
+     * @param x the number to reduce.
+     * @return x mod m.
+     */
+    uint64_t reduce(uint64_t x) const
+    {
+        uint64_t q = (uint64_t) (((unsigned __int128) x * _mu) >> 64);
+        uint64_t r = x - q * _m;
+        r = (r >= _m) ? r - _m : r;
+        return (r >= _m) ? r - _m : r;
+    }
+
+    /**
+     * Reduces a signed number to its representative in [0, m).
+     * @param n the number to reduce.
+     * @return n mod m (never negative).
+     */
+    uint64_t reduceSigned(long n) const
+    {
+        if (n >= 0)
+        {
+            return reduce((uint64_t) n);
+        }
+        uint64_t r = reduce(0 - (uint64_t) n);
+        return (r == 0) ? 0 : _m - r;
+    }
+
+    /**
+     * Reduces a 128 bit number modulo m, as (hi * 2^64 + lo) mod m.
+     * @param t the number to reduce.
+     * @return t mod m.
+     */
+    uint64_t reduceWide(unsigned __int128 t) const
+    {
+        return addMod(mulMod(reduce((uint64_t) (t >> 64)) , _r) , reduce((uint64_t) t));
+    }
+
+    /**
+     * Adds two residues.
+     * @param a residue.
+     * @param b residue.
+     * @return a + b mod m.
+     */
+    uint64_t addMod(uint64_t a , uint64_t b) const
+    {
+        uint64_t s = a + b;
+        return (s >= _m) ? s - _m : s;
+    }
+
+    /**
+     * Subtracts two residues.
+     * @param a residue.
+     * @param b residue.
+     * @return a - b mod m.
+     */
+    uint64_t subMod(uint64_t a , uint64_t b) const
+    {
+        return (a >= b) ? a - b : a + (_m - b);
+    }
+
+    /**
+     * Multiplies two residues, the product never overflows.
+     * @param a residue.
+     * @param b residue.
+     * @return a * b mod m.
+     */
+    uint64_t mulMod(uint64_t a , uint64_t b) const
+    {
+        if (_m <= UINT32_MAX)
+        {
+            return reduce(a * b);
+        }
+        return _mulModWide(a , b);
+    }
+
+    /**
+     * Square-and-multiply exponentiation, with a sliding window once the exponent is larger
+     * than POW_WINDOW_THRESHOLD bits. Odd moduli stay in the Montgomery domain for the
+     * whole loop, so every step costs a single reduction.
+     * @param base residue.
+     * @param exponent the exponent.
+     * @return base^exponent mod m.
+     */
+    uint64_t powMod(uint64_t base , uint64_t exponent) const
+    {
+        if (_mInv != 0)
+        {
+            return fromMontgomery(powMontgomery(toMontgomery(base) , exponent));
+        }
+        if ((exponent >> POW_WINDOW_THRESHOLD) != 0)
+        {
+            return _slidingWindowPow(base , exponent , 1 % _m , [this](uint64_t a , uint64_t b)
+            {
+                return mulMod(a , b);
+            });
+        }
+        uint64_t result = 1 % _m;
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+            {
+                result = mulMod(result , base);
+            }
+            base = mulMod(base , base);
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    // ---------- Montgomery domain, only valid for odd moduli ----------
+
+    /**
+     * Converts a residue to its Montgomery form.
+     * @param a residue.
+     * @return a * 2^64 mod m.
+     */
+    uint64_t toMontgomery(uint64_t a) const
+    { return _redc((unsigned __int128) a * _r2); }
+
+    /**
+     * Converts a Montgomery form back to a residue.
+     * @param a Montgomery form.
+     * @return a * 2^-64 mod m.
+     */
+    uint64_t fromMontgomery(uint64_t a) const
+    { return _redc(a); }
+
+    /**
+     * Multiplies two Montgomery forms.
+     * @param a Montgomery form.
+     * @param b Montgomery form.
+     * @return the Montgomery form of the product.
+     */
+    uint64_t mulMontgomery(uint64_t a , uint64_t b) const
+    { return _redc((unsigned __int128) a * b); }
+
+    /**
+     * Square-and-multiply on a Montgomery form (sliding window for large exponents).
+     * @param base Montgomery form.
+     * @param exponent the exponent.
+     * @return the Montgomery form of base^exponent.
+     */
+    uint64_t powMontgomery(uint64_t base , uint64_t exponent) const
+    {
+        uint64_t result = _redc(_r2); // 1 in Montgomery form
+        if ((exponent >> POW_WINDOW_THRESHOLD) != 0)
+        {
+            return _slidingWindowPow(base , exponent , result , [this](uint64_t a , uint64_t b)
+            {
+                return mulMontgomery(a , b);
+            });
+        }
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+            {
+                result = mulMontgomery(result , base);
+            }
+            base = mulMontgomery(base , base);
+            exponent >>= 1;
+        }
+        return result;
+    }
+};
+
+#endif //MODREDUCER_H
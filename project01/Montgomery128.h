@@ -0,0 +1,301 @@
+// Montgomery128.h
+//----------- include guards------------
+#ifndef MONTGOMERY128_H
+#define MONTGOMERY128_H
+//-------------- includes --------------
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+/** An unsigned 128 bit number. */
+typedef unsigned __int128 UInt128;
+
+//--------------------------------------
+
+/**
+ * @param x a number.
+ * @return the number of trailing zero bits of x, which is not 0.
+ */
+inline int ctz128(UInt128 x)
+{
+    uint64_t low = (uint64_t) x;
+    return (low != 0) ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t) (x >> 64));
+}
+
+/**
+ * Stein's binary gcd on 128 bit numbers.
+ * @param a unsigned number.
+ * @param b unsigned number.
+ * @return the gcd of a and b (gcd(0, b) is b).
+ */
+inline UInt128 gcd128(UInt128 a , UInt128 b)
+{
+    if (a == 0 || b == 0)
+    {
+        return a | b;
+    }
+    int shift = ctz128(a | b);
+    a >>= ctz128(a);
+    while (b != 0)
+    {
+        b >>= ctz128(b);
+        if (a > b)
+        {
+            UInt128 t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+/**
+ * The integer square root.
+ * @param n a number below 2^128.
+ * @return floor(sqrt(n)).
+ */
+inline UInt128 integerSqrt128(UInt128 n)
+{
+    UInt128 root = (UInt128) sqrtl((long double) n);
+    while ((root >> 64) != 0 || root * root > n)
+    {
+        root--;
+    }
+    while (((root + 1) >> 64) == 0 && (root + 1) * (root + 1) <= n)
+    {
+        root++;
+    }
+    return root;
+}
+
+/**
+ * The Jacobi symbol by the binary algorithm, the Legendre symbol when m is prime.
+ * @param a a number.
+ * @param m odd number.
+ * @return (a / m), -1, 0 or 1.
+ */
+inline int jacobi128(UInt128 a , UInt128 m)
+{
+    a %= m;
+    int result = 1;
+    while (a != 0)
+    {
+        int twos = ctz128(a);
+        a >>= twos;
+        // (2 / m) = -1 exactly when m = 3 or 5 mod 8
+        if ((twos & 1) && ((m & 7) == 3 || (m & 7) == 5))
+        {
+            result = -result;
+        }
+        // quadratic reciprocity
+        if ((a & 3) == 3 && (m & 3) == 3)
+        {
+            result = -result;
+        }
+        UInt128 t = a;
+        a = m % a;
+        m = t;
+    }
+    return (m == 1) ? result : 0;
+}
+
+/**
+ * The decimal representation of a 128 bit number.
+ * @param n the number.
+ * @return its digits.
+ */
+inline std::string toString(UInt128 n)
+{
+    char digits[40];
+    int i = sizeof(digits);
+    do
+    {
+        digits[--i] = (char) ('0' + (int) (n % 10));
+        n /= 10;
+    } while (n != 0);
+    return std::string(digits + i , sizeof(digits) - i);
+}
+
+/**
+ * Parses the decimal representation of a 128 bit number.
+ * @param text the digits.
+ * @param n output, the number.
+ * @return false if the text is empty, is not only digits or overflows 128 bits.
+ */
+inline bool parseUInt128(const std::string &text , UInt128 &n)
+{
+    const UInt128 limit = ~(UInt128) 0;
+    n = 0;
+    for (char c : text)
+    {
+        if (c < '0' || c > '9' || n > (limit - (UInt128) (c - '0')) / 10)
+        {
+            return false;
+        }
+        n = n * 10 + (UInt128) (c - '0');
+    }
+    return !text.empty();
+}
+
+/**
+ *  A Montgomery128 class.
+ *  Montgomery arithmetic modulo an odd number below 2^128, with R = 2^128. A product of two
+ *  residues is computed as 256 bits from four 64 bit multiplications and reduced without any
+ *  division. Residues are kept in [0, n), the carries out of 128 bits are tracked, so the
+ *  whole range of n is supported.
+ */
+class Montgomery128
+{
+private:
+    UInt128 _n; /** The modulus, odd. */
+    UInt128 _nInv; /** -n^-1 mod 2^128. */
+    UInt128 _one; /** 2^128 mod n, 1 in Montgomery form. */
+    UInt128 _r2; /** 2^256 mod n. */
+
+    /**
+     * The full product of two 128 bit numbers.
+     * @param a number.
+     * @param b number.
+     * @param high output, the high 128 bits.
+     * @return the low 128 bits.
+     */
+    static UInt128 _mulFull(UInt128 a , UInt128 b , UInt128 &high)
+    {
+        uint64_t a0 = (uint64_t) a , a1 = (uint64_t) (a >> 64);
+        uint64_t b0 = (uint64_t) b , b1 = (uint64_t) (b >> 64);
+        UInt128 p00 = (UInt128) a0 * b0 , p01 = (UInt128) a0 * b1;
+        UInt128 p10 = (UInt128) a1 * b0 , p11 = (UInt128) a1 * b1;
+        UInt128 middle = (p00 >> 64) + (uint64_t) p01 + (uint64_t) p10;
+        high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+        return (middle << 64) | (uint64_t) p00;
+    }
+
+    /**
+     * Montgomery reduction.
+     * @param high the high 128 bits of a number smaller than n * 2^128.
+     * @param low the low 128 bits.
+     * @return the number * 2^-128 mod n.
+     */
+    UInt128 _redc(UInt128 high , UInt128 low) const
+    {
+        UInt128 m = low * _nInv , mnHigh;
+        _mulFull(m , _n , mnHigh);
+        // low + low(m * n) is 0 mod 2^128, it carries exactly when low is not 0
+        UInt128 r = high + mnHigh;
+        bool carry = r < high;
+        UInt128 s = r + (low != 0);
+        carry |= s < r;
+        return (carry || s >= _n) ? s - _n : s;
+    }
+
+public:
+    /**
+     * A constructor.
+     * @param n the modulus, odd and greater than 1.
+     */
+    explicit Montgomery128(UInt128 n) : _n(n) , _nInv(0) , _one((0 - n) % n) , _r2(0)
+    {
+        assert(n > 1 && (n & 1) == 1);
+        // Newton iteration, every step doubles the number of correct low bits
+        UInt128 inv = n;
+        for (int i = 0; i < 6; i++)
+        {
+            inv *= 2 - n * inv;
+        }
+        _nInv = 0 - inv;
+        _r2 = _one;
+        for (int i = 0; i < 128; i++)
+        {
+            _r2 = addMod(_r2 , _r2);
+        }
+    }
+
+    /**
+     * Getter for the modulus.
+     * @return the modulus.
+     */
+    UInt128 getModulus() const
+    { return _n; }
+
+    /**
+     * @return 1 in Montgomery form.
+     */
+    UInt128 one() const
+    { return _one; }
+
+    /**
+     * Adds two residues (or Montgomery forms).
+     * @param a residue.
+     * @param b residue.
+     * @return a + b mod n.
+     */
+    UInt128 addMod(UInt128 a , UInt128 b) const
+    {
+        UInt128 s = a + b;
+        return (s < a || s >= _n) ? s - _n : s;
+    }
+
+    /**
+     * Subtracts two residues (or Montgomery forms).
+     * @param a residue.
+     * @param b residue.
+     * @return a - b mod n.
+     */
+    UInt128 subMod(UInt128 a , UInt128 b) const
+    {
+        return (a >= b) ? a - b : a + (_n - b);
+    }
+
+    /**
+     * Converts a number to its Montgomery form.
+     * @param a a number.
+     * @return a * 2^128 mod n.
+     */
+    UInt128 toMontgomery(UInt128 a) const
+    { return mul(a % _n , _r2); }
+
+    /**
+     * Converts a Montgomery form back to a residue.
+     * @param a Montgomery form.
+     * @return a * 2^-128 mod n.
+     */
+    UInt128 fromMontgomery(UInt128 a) const
+    { return _redc(0 , a); }
+
+    /**
+     * Multiplies two Montgomery forms.
+     * @param a Montgomery form.
+     * @param b Montgomery form.
+     * @return the Montgomery form of the product.
+     */
+    UInt128 mul(UInt128 a , UInt128 b) const
+    {
+        UInt128 high , low = _mulFull(a , b , high);
+        return _redc(high , low);
+    }
+
+    /**
+     * Square-and-multiply on a Montgomery form.
+     * @param base Montgomery form.
+     * @param exponent the exponent.
+     * @return the Montgomery form of base^exponent.
+     */
+    UInt128 pow(UInt128 base , UInt128 exponent) const
+    {
+        UInt128 result = _one;
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+            {
+                result = mul(result , base);
+            }
+            base = mul(base , base);
+            exponent >>= 1;
+        }
+        return result;
+    }
+};
+
+#endif //MONTGOMERY128_H
@@ -0,0 +1,308 @@
+// NumberTheoreticTransform.cpp
+
+#include "NumberTheoreticTransform.h"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "GField.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class NumberTheoreticTransform.
+// --------------------------------------------------------------------------------------
+
+/** The CRT primes, c * 2^k + 1 just below 2^62 with k = 46, 47 and 48. */
+static const uint64_t crtPrimes[NTT_CRT_PRIMES] = {4611615649683210241ull ,
+                                                   4605071356474687489ull ,
+                                                   4585508845593296897ull};
+
+/** The bits of every CRT prime above 2^61, a product of k of them is above 2^(61k). */
+#define CRT_PRIME_BITS 61
+
+/** Guards the shared transforms. */
+static std::mutex transformsMutex;
+
+/**
+ * The shared transforms (a function so that static initializers can use them).
+ * @return the largest transform of every prime built so far.
+ */
+static std::map<uint64_t , const NumberTheoreticTransform *> &transforms()
+{
+    static std::map<uint64_t , const NumberTheoreticTransform *> shared;
+    return shared;
+}
+
+/**
+ * The log of the smallest power of two of at least a size.
+ * @param n a positive size.
+ * @return ceil(log2(n)).
+ */
+static int ceilLog2(size_t n)
+{
+    return (n <= 1) ? 0 : 64 - __builtin_clzll((unsigned long long) (n - 1));
+}
+
+/**
+ * A constructor, computes the twiddles.
+ * @param p a prime with 2^logSize dividing p - 1.
+ * @param logSize the log of the largest size.
+ */
+NumberTheoreticTransform::NumberTheoreticTransform(uint64_t p , int logSize) :
+        _reducer(p) , _logSize(logSize) , _roots((size_t) 1 << logSize)
+{
+    assert(maxLogSize(p) >= logSize);
+    if (logSize == 0)
+    {
+        return;
+    }
+    // a non residue z generates the 2-part of the group, z^((p - 1) / n) has order n
+    uint64_t z = 2;
+    while (_reducer.powMod(z , (p - 1) / 2) != p - 1)
+    {
+        z++;
+    }
+    const size_t n = _roots.size() , half = n / 2;
+    const uint64_t w = _reducer.powMod(z , (p - 1) >> logSize);
+    uint64_t power = 1;
+    for (size_t j = 0; j < half; j++)
+    {
+        _roots[half + j] = _reducer.toMontgomery(power);
+        power = _reducer.mulMod(power , w);
+    }
+    // the root of order 2h is the square of the root of order 4h
+    for (size_t h = half / 2; h >= 1; h /= 2)
+    {
+        for (size_t j = 0; j < h; j++)
+        {
+            _roots[h + j] = _roots[2 * h + 2 * j];
+        }
+    }
+}
+
+/**
+ * One forward stage: every butterfly of span h of an array.
+ * @param a the residues.
+ * @param n the length of a, a multiple of 2h.
+ * @param h the span of the butterflies.
+ */
+void NumberTheoreticTransform::_forwardStage(uint64_t *a , size_t n , size_t h) const
+{
+    const uint64_t *roots = _roots.data() + h;
+    for (size_t start = 0; start < n; start += 2 * h)
+    {
+        uint64_t *low = a + start , *high = low + h;
+        for (size_t j = 0; j < h; j++)
+        {
+            uint64_t u = low[j] , v = high[j];
+            low[j] = _reducer.addMod(u , v);
+            high[j] = _reducer.mulMontgomery(_reducer.subMod(u , v) , roots[j]);
+        }
+    }
+}
+
+/**
+ * One inverse stage: every butterfly of span h of an array.
+ * @param a the residues.
+ * @param n the length of a, a multiple of 2h.
+ * @param h the span of the butterflies.
+ */
+void NumberTheoreticTransform::_inverseStage(uint64_t *a , size_t n , size_t h) const
+{
+    // w^-j = -w^(h - j), which is entry 2h - j of the table
+    const uint64_t *roots = _roots.data() + 2 * h;
+    for (size_t start = 0; start < n; start += 2 * h)
+    {
+        uint64_t *low = a + start , *high = low + h;
+        uint64_t u = low[0] , v = high[0];
+        low[0] = _reducer.addMod(u , v);
+        high[0] = _reducer.subMod(u , v);
+        for (size_t j = 1; j < h; j++)
+        {
+            u = low[j];
+            v = _reducer.mulMontgomery(high[j] , roots[-(ptrdiff_t) j]);
+            low[j] = _reducer.subMod(u , v);
+            high[j] = _reducer.addMod(u , v);
+        }
+    }
+}
+
+/**
+ * The forward transform, from natural to bit reversed order.
+ * @param a 2^logSize residues modulo the prime, transformed in place.
+ * @param logSize the log of the size, at most getLogSize().
+ */
+void NumberTheoreticTransform::forward(uint64_t *a , int logSize) const
+{
+    assert(logSize <= _logSize);
+    const size_t n = (size_t) 1 << logSize , block = std::min(n , (size_t) NTT_BLOCK_SIZE);
+    size_t h = n / 2;
+    for (; 2 * h > block; h /= 2)
+    {
+        _forwardStage(a , n , h);
+    }
+    for (size_t start = 0; start < n; start += block)
+    {
+        for (size_t span = h; span >= 1; span /= 2)
+        {
+            _forwardStage(a + start , block , span);
+        }
+    }
+}
+
+/**
+ * The inverse transform, from bit reversed to natural order, without the division by
+ * the size.
+ * @param a 2^logSize residues modulo the prime, transformed in place.
+ * @param logSize the log of the size, at most getLogSize().
+ */
+void NumberTheoreticTransform::inverse(uint64_t *a , int logSize) const
+{
+    assert(logSize <= _logSize);
+    const size_t n = (size_t) 1 << logSize , block = std::min(n , (size_t) NTT_BLOCK_SIZE);
+    for (size_t start = 0; start < n; start += block)
+    {
+        for (size_t span = 1; 2 * span <= block; span *= 2)
+        {
+            _inverseStage(a + start , block , span);
+        }
+    }
+    for (size_t h = block; h < n; h *= 2)
+    {
+        _inverseStage(a , n , h);
+    }
+}
+
+/**
+ * The product of two polynomials modulo the prime.
+ * @param a n coefficients, any 64 bit numbers (reduced first).
+ * @param n the length of a.
+ * @param b m coefficients, any 64 bit numbers (reduced first).
+ * @param m the length of b.
+ * @param product output, the n + m - 1 coefficients of a * b modulo the prime.
+ */
+void NumberTheoreticTransform::convolve(const uint64_t *a , size_t n , const uint64_t *b ,
+                                        size_t m , uint64_t *product) const
+{
+    const int logSize = ceilLog2(n + m - 1);
+    const size_t size = (size_t) 1 << logSize;
+    std::vector<uint64_t> left(size , 0) , right;
+    for (size_t i = 0; i < n; i++)
+    {
+        left[i] = _reducer.reduce(a[i]);
+    }
+    forward(left.data() , logSize);
+    const bool square = (a == b && n == m);
+    if (!square)
+    {
+        right.assign(size , 0);
+        for (size_t i = 0; i < m; i++)
+        {
+            right[i] = _reducer.reduce(b[i]);
+        }
+        forward(right.data() , logSize);
+    }
+    const uint64_t *other = square ? left.data() : right.data();
+    // a * b * 2^-64 * (2^128 / size) * 2^-64 = a * b / size
+    const uint64_t scale = _reducer.toMontgomery(_reducer.toMontgomery(
+            _reducer.powMod(size % getPrime() , getPrime() - 2)));
+    for (size_t i = 0; i < size; i++)
+    {
+        left[i] = _reducer.mulMontgomery(_reducer.mulMontgomery(left[i] , other[i]) , scale);
+    }
+    inverse(left.data() , logSize);
+    std::copy(left.begin() , left.begin() + (n + m - 1) , product);
+}
+
+/**
+ * The largest transform of a modulus.
+ * @param p a number.
+ * @return k if p is a prime below NTT_MAX_PRIME and 2^k is the largest power of two
+ * dividing p - 1, 0 otherwise.
+ */
+int NumberTheoreticTransform::maxLogSize(uint64_t p)
+{
+    if (p < 3 || p >= NTT_MAX_PRIME || !GField::isPrime((long) p))
+    {
+        return 0;
+    }
+    return __builtin_ctzll(p - 1);
+}
+
+/**
+ * The shared transform of a prime, built on first use and rebuilt larger when a larger
+ * size is asked for (the smaller tables stay valid, they are never freed).
+ * @param p a prime with maxLogSize(p) >= logSize.
+ * @param logSize the log of the largest size needed.
+ * @return the transform, valid until the end of the program.
+ */
+const NumberTheoreticTransform *NumberTheoreticTransform::get(uint64_t p , int logSize)
+{
+    std::lock_guard<std::mutex> lock(transformsMutex);
+    const NumberTheoreticTransform *&transform = transforms()[p];
+    if (transform == nullptr || transform->_logSize < logSize)
+    {
+        transform = new NumberTheoreticTransform(p , logSize);
+    }
+    return transform;
+}
+
+/**
+ * The product of two polynomials modulo any number below 2^63: one transform if it is a
+ * prime with a large enough power of two in p - 1, otherwise one per CRT prime, as few as
+ * the size of the exact coefficients needs (at most NTT_CRT_PRIMES).
+ * @param modulus the modulus, in [2, 2^63).
+ * @param a n residues.
+ * @param n the length of a, not 0.
+ * @param b m residues.
+ * @param m the length of b, not 0.
+ * @param product output, the n + m - 1 coefficients of a * b modulo modulus.
+ */
+void NumberTheoreticTransform::multiply(uint64_t modulus , const uint64_t *a , size_t n ,
+                                        const uint64_t *b , size_t m , uint64_t *product)
+{
+    assert(n > 0 && m > 0);
+    const int logSize = ceilLog2(n + m - 1);
+    if (maxLogSize(modulus) >= logSize)
+    {
+        get(modulus , logSize)->convolve(a , n , b , m , product);
+        return;
+    }
+    // the exact coefficients are below min(n, m) * (modulus - 1)^2 < 2^bits
+    const int bits = 2 * (64 - __builtin_clzll(modulus - 1)) +
+                     (64 - __builtin_clzll((unsigned long long) std::min(n , m)));
+    const int primes = (bits + CRT_PRIME_BITS - 1) / CRT_PRIME_BITS;
+    assert(primes <= NTT_CRT_PRIMES && logSize <= maxLogSize(crtPrimes[0]));
+    const size_t length = n + m - 1;
+    std::vector<uint64_t> residues[NTT_CRT_PRIMES];
+    for (int i = 0; i < primes; i++)
+    {
+        residues[i].resize(length);
+        get(crtPrimes[i] , logSize)->convolve(a , n , b , m , residues[i].data());
+    }
+    // Garner: x = x0 + p0 * (x1 + p1 * x2), every digit xi is in [0, pi)
+    const ModReducer target(modulus) , p1(crtPrimes[1]) , p2(crtPrimes[2]);
+    const uint64_t p0InverseMod1 = GField::modInverse(crtPrimes[0] % crtPrimes[1] , crtPrimes[1]);
+    const uint64_t p0Mod2 = p2.reduce(crtPrimes[0]);
+    const uint64_t p0p1Mod2 = p2.mulMod(p0Mod2 , p2.reduce(crtPrimes[1]));
+    const uint64_t p0p1InverseMod2 = GField::modInverse(p0p1Mod2 , crtPrimes[2]);
+    const uint64_t p0ModTarget = target.reduce(crtPrimes[0]);
+    const uint64_t p0p1ModTarget = target.mulMod(p0ModTarget , target.reduce(crtPrimes[1]));
+    for (size_t k = 0; k < length; k++)
+    {
+        uint64_t x0 = residues[0][k];
+        uint64_t result = target.reduce(x0);
+        if (primes >= 2)
+        {
+            uint64_t x1 = p1.mulMod(p1.subMod(residues[1][k] , p1.reduce(x0)) , p0InverseMod1);
+            result = target.addMod(result , target.mulMod(target.reduce(x1) , p0ModTarget));
+            if (primes == 3)
+            {
+                uint64_t known = p2.addMod(p2.reduce(x0) , p2.mulMod(p2.reduce(x1) , p0Mod2));
+                uint64_t x2 = p2.mulMod(p2.subMod(residues[2][k] , known) , p0p1InverseMod2);
+                result = target.addMod(result , target.mulMod(target.reduce(x2) , p0p1ModTarget));
+            }
+        }
+        product[k] = result;
+    }
+}
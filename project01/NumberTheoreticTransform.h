@@ -0,0 +1,139 @@
+// NumberTheoreticTransform.h
+//----------- include guards------------
+#ifndef NUMBERTHEORETICTRANSFORM_H
+#define NUMBERTHEORETICTRANSFORM_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModReducer.h"
+
+#define NTT_BLOCK_SIZE 2048 /** the stages of shorter butterflies run per block of 16KB (L1) */
+#define NTT_MAX_PRIME (1ul << 62) /** transform primes are below it, so a + b never overflows */
+#define NTT_CRT_PRIMES 3 /** the transform primes of the convolutions of other moduli */
+
+//--------------------------------------
+
+/**
+ *  A NumberTheoreticTransform class.
+ *  The discrete Fourier transform over GF(p) for a prime p = c * 2^k + 1, of every power of two
+ *  size up to 2^k. The transforms are iterative and in place: forward() is a decimation in
+ *  frequency that leaves its output in bit reversed order and inverse() a decimation in time
+ *  that takes it back, so a convolution never permutes. The stages whose butterflies span more
+ *  than NTT_BLOCK_SIZE residues stream over the whole array, the remaining ones are finished
+ *  block by block while the block is in L1.
+ *  The twiddles are precomputed once per prime (see get()) in Montgomery form, so a twiddle
+ *  multiplication is a single Montgomery reduction: entries [h, 2h) of the table are w^j for
+ *  a root of unity w of order 2h, so one table serves every size up to its own and the
+ *  inverse transform reads w^-j = -w^(h - j) from it too.
+ *  Convolutions modulo any other number below 2^63 run on NTT_CRT_PRIMES primes of 62 bits and
+ *  are recombined by the Chinese remainder theorem (Garner), see multiply().
+ */
+class NumberTheoreticTransform
+{
+private:
+    ModReducer _reducer; /** Reduction modulo the prime. */
+    int _logSize; /** The log of the largest size. */
+    std::vector<uint64_t> _roots; /** The twiddles, see the class comment. */
+
+    /**
+     * A constructor, computes the twiddles.
+     * @param p a prime with 2^logSize dividing p - 1.
+     * @param logSize the log of the largest size.
+     */
+    NumberTheoreticTransform(uint64_t p , int logSize);
+
+    /**
+     * One forward stage: every butterfly of span h of an array.
+     * @param a the residues.
+     * @param n the length of a, a multiple of 2h.
+     * @param h the span of the butterflies.
+     */
+    void _forwardStage(uint64_t *a , size_t n , size_t h) const;
+
+    /**
+     * One inverse stage: every butterfly of span h of an array.
+     * @param a the residues.
+     * @param n the length of a, a multiple of 2h.
+     * @param h the span of the butterflies.
+     */
+    void _inverseStage(uint64_t *a , size_t n , size_t h) const;
+
+public:
+    NumberTheoreticTransform(const NumberTheoreticTransform &) = delete;
+
+    NumberTheoreticTransform &operator=(const NumberTheoreticTransform &) = delete;
+
+    /**
+     * Getter for the prime.
+     * @return p.
+     */
+    uint64_t getPrime() const
+    { return _reducer.getModulus(); }
+
+    /**
+     * Getter for the size of the twiddle table.
+     * @return the log of the largest size.
+     */
+    int getLogSize() const
+    { return _logSize; }
+
+    /**
+     * The forward transform, from natural to bit reversed order.
+     * @param a 2^logSize residues modulo the prime, transformed in place.
+     * @param logSize the log of the size, at most getLogSize().
+     */
+    void forward(uint64_t *a , int logSize) const;
+
+    /**
+     * The inverse transform, from bit reversed to natural order, without the division by
+     * the size.
+     * @param a 2^logSize residues modulo the prime, transformed in place.
+     * @param logSize the log of the size, at most getLogSize().
+     */
+    void inverse(uint64_t *a , int logSize) const;
+
+    /**
+     * The product of two polynomials modulo the prime.
+     * @param a n coefficients, any 64 bit numbers (reduced first).
+     * @param n the length of a.
+     * @param b m coefficients, any 64 bit numbers (reduced first).
+     * @param m the length of b.
+     * @param product output, the n + m - 1 coefficients of a * b modulo the prime.
+     */
+    void convolve(const uint64_t *a , size_t n , const uint64_t *b , size_t m ,
+                  uint64_t *product) const;
+
+    /**
+     * The largest transform of a modulus.
+     * @param p a number.
+     * @return k if p is a prime below NTT_MAX_PRIME and 2^k is the largest power of two
+     * dividing p - 1, 0 otherwise.
+     */
+    static int maxLogSize(uint64_t p);
+
+    /**
+     * The shared transform of a prime, built on first use and rebuilt larger when a larger
+     * size is asked for (the smaller tables stay valid, they are never freed).
+     * @param p a prime with maxLogSize(p) >= logSize.
+     * @param logSize the log of the largest size needed.
+     * @return the transform, valid until the end of the program.
+     */
+    static const NumberTheoreticTransform *get(uint64_t p , int logSize);
+
+    /**
+     * The product of two polynomials modulo any number below 2^63: one transform if it is a
+     * prime with a large enough power of two in p - 1, otherwise one per CRT prime, as few as
+     * the size of the exact coefficients needs (at most NTT_CRT_PRIMES).
+     * @param modulus the modulus, in [2, 2^63).
+     * @param a n residues.
+     * @param n the length of a, not 0.
+     * @param b m residues.
+     * @param m the length of b, not 0.
+     * @param product output, the n + m - 1 coefficients of a * b modulo modulus.
+     */
+    static void multiply(uint64_t modulus , const uint64_t *a , size_t n , const uint64_t *b ,
+                         size_t m , uint64_t *product);
+};
+
+#endif //NUMBERTHEORETICTRANSFORM_H
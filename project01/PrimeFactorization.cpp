@@ -0,0 +1,75 @@
+// PrimeFactorization.cpp
+
+#include "PrimeFactorization.h"
+#include <algorithm>
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class PrimeFactorization.
+// --------------------------------------------------------------------------------------
+
+/**
+ * Adds a prime factor, merging it with an existing entry of the same prime.
+ * @param prime the prime.
+ * @param exponent the multiplicity to add.
+ */
+void PrimeFactorization::addPrime(long prime , int exponent)
+{
+    for (PrimeFactor &factor : _factors)
+    {
+        if (factor.prime == prime)
+        {
+            factor.exponent += exponent;
+            return;
+        }
+    }
+    _factors.push_back(PrimeFactor{prime , exponent});
+}
+
+/**
+ * Sorts the factors by increasing prime.
+ */
+void PrimeFactorization::sort()
+{
+    std::sort(_factors.begin() , _factors.end() , [](const PrimeFactor &a , const PrimeFactor &b)
+    {
+        return a.prime < b.prime;
+    });
+}
+
+/**
+ * @return the number of prime factors counted with multiplicity.
+ */
+int PrimeFactorization::countWithMultiplicity() const
+{
+    int count = 0;
+    for (const PrimeFactor &factor : _factors)
+    {
+        count += factor.exponent;
+    }
+    return count;
+}
+
+/**
+ * Operator overloading of "<<", prints the factors with multiplicity,
+ * e.g. "2*2*3", or "1" if there are none.
+ * @param out ostream reference.
+ * @param factorization the factorization.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const PrimeFactorization &factorization)
+{
+    if (factorization.empty())
+    {
+        return (out << 1);
+    }
+    const char *separator = "";
+    for (const PrimeFactor &factor : factorization)
+    {
+        for (int i = 0; i < factor.exponent; i++)
+        {
+            out << separator << factor.prime;
+            separator = "*";
+        }
+    }
+    return out;
+}
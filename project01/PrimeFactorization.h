@@ -0,0 +1,85 @@
+// PrimeFactorization.h
+//----------- include guards------------
+#ifndef PRIMEFACTORIZATION_H
+#define PRIMEFACTORIZATION_H
+//-------------- includes --------------
+#include <iostream>
+#include "SmallVector.hpp"
+
+#define INLINE_FACTORS 16 /** a long has at most 15 distinct prime factors */
+
+//--------------------------------------
+
+/**
+ * A prime factor together with its multiplicity.
+ */
+struct PrimeFactor
+{
+    long prime; /** The prime. */
+    int exponent; /** The multiplicity of the prime. */
+};
+
+/**
+ *  A PrimeFactorization class.
+ *  The value returned by GFNumber::getPrimeFactors, the distinct primes of a number with their
+ *  exponents. The factors live inline, so building it never touches the heap.
+ */
+class PrimeFactorization
+{
+private:
+    SmallVector<PrimeFactor , INLINE_FACTORS> _factors; /** The distinct prime factors. */
+
+public:
+    /**
+     * Adds a prime factor, merging it with an existing entry of the same prime.
+     * @param prime the prime.
+     * @param exponent the multiplicity to add.
+     */
+    void addPrime(long prime , int exponent = 1);
+
+    /**
+     * Sorts the factors by increasing prime.
+     */
+    void sort();
+
+    /**
+     * @return the number of distinct prime factors.
+     */
+    size_t size() const
+    { return _factors.size(); }
+
+    /**
+     * @return true if there are no prime factors.
+     */
+    bool empty() const
+    { return _factors.empty(); }
+
+    /**
+     * @return the number of prime factors counted with multiplicity.
+     */
+    int countWithMultiplicity() const;
+
+    /**
+     * @param i index of a distinct prime factor.
+     * @return the i-th factor.
+     */
+    const PrimeFactor &operator[](size_t i) const
+    { return _factors[i]; }
+
+    const PrimeFactor *begin() const
+    { return _factors.begin(); }
+
+    const PrimeFactor *end() const
+    { return _factors.end(); }
+
+    /**
+     * Operator overloading of "<<", prints the factors with multiplicity,
+     * e.g. "2*2*3", or "1" if there are none.
+     * @param out ostream reference.
+     * @param factorization the factorization.
+     * @return ostream reference with the desire output.
+     */
+    friend std::ostream &operator<<(std::ostream &out , const PrimeFactorization &factorization);
+};
+
+#endif //PRIMEFACTORIZATION_H
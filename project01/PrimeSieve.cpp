@@ -0,0 +1,190 @@
+// PrimeSieve.cpp
+
+#include "PrimeSieve.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+/**
+ * The flags of the odd numbers of one wheel turn: the flag of x (odd) is
+ * pattern[(x mod 210) / 2], set when x is divisible by 3, 5 or 7.
+ * @return the pattern.
+ */
+static const uint8_t *wheelPattern()
+{
+    static const struct Pattern
+    {
+        uint8_t flags[WHEEL_MODULUS / 2];
+
+        Pattern() : flags()
+        {
+            for (int i = 0; i < WHEEL_MODULUS / 2; i++)
+            {
+                int x = 2 * i + 1;
+                flags[i] = (x % 3 == 0 || x % 5 == 0 || x % 7 == 0);
+            }
+        }
+    } pattern;
+    return pattern.flags;
+}
+
+/**
+ * The shared trial division table: every odd prime from 11 to TRIAL_PRIME_LIMIT, with
+ * its reciprocal. Built on first use, thread safe.
+ * @return the table, sorted by prime.
+ */
+const std::vector<TrialPrime> &PrimeSieve::trialPrimes()
+{
+    static const std::vector<TrialPrime> table = []()
+    {
+        // a plain sieve of Eratosthenes, the table is what seeds the segmented one
+        std::vector<uint8_t> isComposite(TRIAL_PRIME_LIMIT + 1 , 0);
+        std::vector<TrialPrime> primes;
+        for (uint64_t p = 3; p <= TRIAL_PRIME_LIMIT; p += 2)
+        {
+            if (isComposite[p])
+            {
+                continue;
+            }
+            for (uint64_t multiple = p * p; multiple <= TRIAL_PRIME_LIMIT; multiple += 2 * p)
+            {
+                isComposite[multiple] = 1;
+            }
+            if (p < 11)
+            {
+                continue; // the wheel primes
+            }
+            // Newton iteration, every step doubles the number of correct low bits
+            uint64_t inverse = p;
+            for (int i = 0; i < 5; i++)
+            {
+                inverse *= 2 - p * inverse;
+            }
+            primes.push_back(TrialPrime{p , inverse , UINT64_MAX / p});
+        }
+        return primes;
+    }();
+    return table;
+}
+
+/**
+ * A constructor.
+ * @param start the first number to consider, next() returns the primes from it on.
+ */
+PrimeSieve::PrimeSieve(uint64_t start) : _low(start & ~(uint64_t) 1) ,
+                                         _isComposite(SIEVE_SEGMENT_SIZE / 2) ,
+                                         _index(0) , _start(start)
+{
+    if (start < SIEVE_SEGMENT_SIZE)
+    {
+        _low = 0; // the first segment, where 3, 5 and 7 are not crossed off
+    }
+    _sieveSegment();
+}
+
+/**
+ * Crosses off the odd multiples of a prime in the current segment.
+ * @param prime an odd prime.
+ * @param next the next odd multiple of prime to cross, updated past the segment.
+ */
+void PrimeSieve::_crossOff(uint64_t prime , uint64_t &next)
+{
+    uint64_t high = _low + SIEVE_SEGMENT_SIZE;
+    if (next < _low)
+    {
+        // the first odd multiple inside the segment
+        uint64_t multiple = (_low + prime - 1) / prime * prime;
+        next = (multiple & 1) ? multiple : multiple + prime;
+    }
+    uint8_t *flags = _isComposite.data();
+    for (; next < high; next += 2 * prime)
+    {
+        flags[(next - _low) >> 1] = 1;
+    }
+}
+
+/**
+ * Sieves the segment starting at _low.
+ */
+void PrimeSieve::_sieveSegment()
+{
+    assert(_low <= (uint64_t) INT64_MAX);
+    uint64_t high = _low + SIEVE_SEGMENT_SIZE;
+    // copy the 2*3*5*7 wheel instead of crossing off 3, 5 and 7
+    const uint8_t *pattern = wheelPattern();
+    size_t offset = ((_low + 1) % WHEEL_MODULUS) / 2 , size = _isComposite.size();
+    for (size_t i = 0; i < size;)
+    {
+        size_t count = std::min(size - i , (size_t) WHEEL_MODULUS / 2 - offset);
+        memcpy(_isComposite.data() + i , pattern + offset , count);
+        i += count;
+        offset = 0;
+    }
+    if (_low == 0)
+    {
+        _isComposite[0] = 1; // 1
+        _isComposite[1] = _isComposite[2] = _isComposite[3] = 0; // 3, 5, 7
+    }
+
+    // primes from the shared table, their first multiple to cross is p^2
+    for (const TrialPrime &trial : trialPrimes())
+    {
+        uint64_t p = trial.prime;
+        if (p * p >= high)
+        {
+            break;
+        }
+        uint64_t next = std::max(p * p , _low);
+        next = (next + p - 1) / p * p;
+        next = (next & 1) ? next : next + p;
+        _crossOff(p , next);
+    }
+    // primes beyond the table (segments above 2^32), generated by a nested sieve
+    if (high > (uint64_t) TRIAL_PRIME_LIMIT * TRIAL_PRIME_LIMIT)
+    {
+        if (_baseSource == nullptr)
+        {
+            _baseSource.reset(new PrimeSieve(TRIAL_PRIME_LIMIT + 1));
+        }
+        while (_basePrimes.empty() || _basePrimes.back() * _basePrimes.back() < high)
+        {
+            uint64_t p = _baseSource->next();
+            _basePrimes.push_back(p);
+            _nextMultiples.push_back(p * p);
+        }
+        for (size_t i = 0; i < _basePrimes.size(); i++)
+        {
+            _crossOff(_basePrimes[i] , _nextMultiples[i]);
+        }
+    }
+    _index = 0;
+}
+
+/**
+ * Generates the next prime.
+ * @return the smallest prime not returned yet which is >= start (must stay below 2^63).
+ */
+uint64_t PrimeSieve::next()
+{
+    if (_start <= 2)
+    {
+        _start = 3;
+        return 2;
+    }
+    while (true)
+    {
+        size_t size = _isComposite.size();
+        const uint8_t *flags = _isComposite.data();
+        while (_index < size)
+        {
+            size_t i = _index++;
+            uint64_t number = _low + 2 * i + 1;
+            if (!flags[i] && number >= _start)
+            {
+                return number;
+            }
+        }
+        _low += SIEVE_SEGMENT_SIZE;
+        _sieveSegment();
+    }
+}
@@ -0,0 +1,79 @@
+// PrimeSieve.h
+//----------- include guards------------
+#ifndef PRIMESIEVE_H
+#define PRIMESIEVE_H
+//-------------- includes --------------
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define SIEVE_SEGMENT_SIZE 65536 /** numbers per segment, the odd ones take 32KB of flags */
+#define WHEEL_MODULUS 210 /** 2 * 3 * 5 * 7 */
+#define TRIAL_PRIME_LIMIT 65536 /** the shared table holds the primes below it */
+
+//--------------------------------------
+
+/**
+ * A prime of the trial division table with its precomputed reciprocal:
+ * p divides n exactly when n * inverse mod 2^64 <= limit, and then n / p = n * inverse.
+ */
+struct TrialPrime
+{
+    uint64_t prime; /** The prime, odd. */
+    uint64_t inverse; /** prime^-1 mod 2^64. */
+    uint64_t limit; /** floor((2^64 - 1) / prime). */
+};
+
+/**
+ *  A PrimeSieve class.
+ *  A streaming generator of primes: a segmented sieve of Eratosthenes which keeps one
+ *  cache sized segment of odd numbers at a time. Every segment starts from a copy of the
+ *  2*3*5*7 wheel pattern, so only primes from 11 on are crossed off.
+ *  The sieving primes come from the shared trial division table (primes below 2^16, built
+ *  once per process), and from a nested sieve beyond it.
+ */
+class PrimeSieve
+{
+private:
+    uint64_t _low; /** The first number of the current segment (even). */
+    std::vector<uint8_t> _isComposite; /** Flags of the odd numbers of the segment. */
+    size_t _index; /** The next flag to scan. */
+    uint64_t _start; /** The primes below it are skipped. */
+    std::vector<uint64_t> _basePrimes; /** The sieving primes beyond the shared table. */
+    std::vector<uint64_t> _nextMultiples; /** The next odd multiple of every sieving prime. */
+    std::unique_ptr<PrimeSieve> _baseSource; /** Generates the sieving primes beyond the table. */
+
+    /**
+     * Sieves the segment starting at _low.
+     */
+    void _sieveSegment();
+
+    /**
+     * Crosses off the odd multiples of a prime in the current segment.
+     * @param prime an odd prime.
+     * @param next the next odd multiple of prime to cross, updated past the segment.
+     */
+    void _crossOff(uint64_t prime , uint64_t &next);
+
+public:
+    /**
+     * A constructor.
+     * @param start the first number to consider, next() returns the primes from it on.
+     */
+    explicit PrimeSieve(uint64_t start = 2);
+
+    /**
+     * Generates the next prime.
+     * @return the smallest prime not returned yet which is >= start (must stay below 2^63).
+     */
+    uint64_t next();
+
+    /**
+     * The shared trial division table: every odd prime from 11 to TRIAL_PRIME_LIMIT, with
+     * its reciprocal. Built on first use, thread safe.
+     * @return the table, sorted by prime.
+     */
+    static const std::vector<TrialPrime> &trialPrimes();
+};
+
+#endif //PRIMESIEVE_H
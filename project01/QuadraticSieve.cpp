@@ -0,0 +1,951 @@
+// QuadraticSieve.cpp
+
+#include "QuadraticSieve.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "GField.h"
+#include "PrimeSieve.h"
+#include "RandomSource.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class QuadraticSieve.
+// --------------------------------------------------------------------------------------
+
+/**
+ * The parameters for one size of kn, the ones in between are interpolated.
+ */
+struct SiqsParameters
+{
+    int bits; /** The size of kn. */
+    uint32_t factorBase; /** The primes in the factor base. */
+    uint32_t blocks; /** The blocks of the interval [-M, M). */
+    uint32_t largePrimeMultiplier; /** The large prime bound over the largest prime. */
+};
+
+/** The parameters, by the size of kn. */
+static const SiqsParameters SIQS_PARAMETERS[] = {{60 , 80 , 1 , 20} , {80 , 150 , 1 , 30} ,
+                                                 {96 , 250 , 2 , 40} , {112 , 450 , 2 , 50} ,
+                                                 {128 , 800 , 4 , 60}};
+
+/** The square free multipliers tried by the Knuth-Schroeppel function. */
+static const uint32_t SIQS_MULTIPLIERS[] = {1 , 3 , 5 , 7 , 11 , 13 , 15 , 17 , 19 , 21 , 23 ,
+                                            29 , 31 , 33 , 35 , 37 , 39 , 41 , 43 , 47 , 51 , 53 ,
+                                            55 , 57 , 59 , 61 , 65 , 67 , 69 , 71 , 73};
+
+/** The primes scored by the Knuth-Schroeppel function. */
+#define SIQS_SCORED_PRIMES 300
+
+/** The size of the primes of a. */
+#define SIQS_A_PRIME 2000
+
+/** The failed draws of a in a row after which a thread gives up (every a is taken). */
+#define SIQS_A_DRAWS 10000
+
+/** Ones in the top bit of every byte of a word. */
+#define SIQS_TOP_BITS 0x8080808080808080ull
+
+/**
+ * A relation Y^2 = product of the factors (times largePrime^2) mod n.
+ */
+struct SiqsRelation
+{
+    UInt128 y; /** Y mod n. */
+    std::vector<uint32_t> factors; /** The factor base indices, repeated by multiplicity. */
+    UInt128 largePrime; /** The square root of the part outside the factor base, 1 if none. */
+};
+
+/**
+ * Everything the sieving threads share: the factor base, which is immutable, and the
+ * relations found so far.
+ */
+struct SiqsContext
+{
+    UInt128 n; /** The number to factor. */
+    UInt128 kn; /** The multiplier times n. */
+    uint32_t multiplier; /** The Knuth-Schroeppel multiplier. */
+    Montgomery128 reducer; /** Montgomery context modulo n. */
+    uint32_t interval; /** The length 2M of the interval. */
+    uint8_t sieveStart; /** The initial byte of the sieve, 128 - the threshold. */
+    uint64_t largePrimeBound; /** The largest cofactor kept as a large prime. */
+    std::vector<uint32_t> primes; /** The factor base, primes[0] = 1 stands for -1. */
+    std::vector<uint32_t> roots; /** sqrt(kn) mod p. */
+    std::vector<uint8_t> logs; /** The rounded base 2 logarithms of the primes. */
+    size_t firstSieved; /** The index of the first prime sieved. */
+    int aPrimes; /** The number s of primes in a. */
+    size_t aLow; /** The first index the primes of a are drawn from. */
+    size_t aHigh; /** One past the last index the primes of a are drawn from. */
+    long double aTarget; /** The ideal a, sqrt(2kn) / M. */
+
+    std::mutex mutex; /** Guards everything below. */
+    std::vector<SiqsRelation> relations; /** The full and the combined relations. */
+    std::unordered_map<uint64_t , SiqsRelation> partials; /** The partials by large prime. */
+    std::set<UInt128> usedA; /** The values of a already taken by a thread. */
+    size_t needed; /** The relations to collect. */
+    uint64_t partialCount; /** The partial relations found. */
+    uint64_t combinedCount; /** The partial relations combined into full ones. */
+
+    std::atomic<bool> done; /** Set when there are enough relations (or no new a is left). */
+    std::atomic<bool> exhausted; /** Set when the threads ran out of values of a. */
+    std::atomic<uint64_t> polynomials; /** The polynomials sieved. */
+
+    explicit SiqsContext(UInt128 number) : n(number) , kn(number) , multiplier(1) ,
+                                           reducer(number) , interval(0) , sieveStart(0) ,
+                                           largePrimeBound(0) , firstSieved(0) , aPrimes(0) ,
+                                           aLow(0) , aHigh(0) , aTarget(0) , needed(0) ,
+                                           partialCount(0) , combinedCount(0) , done(false) ,
+                                           exhausted(false) , polynomials(0)
+    {}
+};
+
+/**
+ * @param n a number.
+ * @return log2(n).
+ */
+static double log2Wide(UInt128 n)
+{
+    return (double) log2l((long double) n);
+}
+
+/**
+ * @param a a signed number.
+ * @param p the modulus.
+ * @return a mod p, in [0, p).
+ */
+static uint32_t signedMod(__int128 a , uint32_t p)
+{
+    __int128 r = a % p;
+    return (uint32_t) ((r < 0) ? r + p : r);
+}
+
+/**
+ * The primes scored by the Knuth-Schroeppel function, with what does not depend on n.
+ */
+struct ScoredPrimes
+{
+    std::vector<uint32_t> primes; /** The odd primes. */
+    std::vector<double> logs; /** Their natural logarithms. */
+    std::vector<std::vector<int>> multiplierSymbols; /** (k / p) for every multiplier k. */
+};
+
+/**
+ * Builds the scored primes.
+ * @return the primes with their logarithms and the symbols of the multipliers.
+ */
+static ScoredPrimes buildScoredPrimes()
+{
+    ScoredPrimes scored;
+    PrimeSieve sieve;
+    sieve.next();
+    while (scored.primes.size() < SIQS_SCORED_PRIMES)
+    {
+        uint32_t p = (uint32_t) sieve.next();
+        scored.primes.push_back(p);
+        scored.logs.push_back(log((double) p));
+    }
+    for (uint32_t k : SIQS_MULTIPLIERS)
+    {
+        std::vector<int> symbols;
+        for (uint32_t p : scored.primes)
+        {
+            symbols.push_back(jacobi128(k , p));
+        }
+        scored.multiplierSymbols.push_back(symbols);
+    }
+    return scored;
+}
+
+/**
+ * The Knuth-Schroeppel function: the multiplier k for which the primes up to a bound divide
+ * the values of x^2 - kn the most often on average, penalized by log(k) / 2 for the larger
+ * values. Only the multipliers with kn below 2^128 are considered.
+ * @param n odd number.
+ * @return the multiplier.
+ */
+static uint32_t chooseMultiplier(UInt128 n)
+{
+    static const ScoredPrimes scored = buildScoredPrimes();
+    const std::vector<uint32_t> &primes = scored.primes;
+    // (kn / p) = (k / p) (n / p)
+    std::vector<int> symbols;
+    for (uint32_t p : primes)
+    {
+        symbols.push_back(jacobi128(n % p , p));
+    }
+    uint32_t best = 1;
+    double bestScore = -1e9;
+    for (size_t multiplier = 0; multiplier < scored.multiplierSymbols.size(); multiplier++)
+    {
+        const uint32_t k = SIQS_MULTIPLIERS[multiplier];
+        if (k > 1 && n > ~(UInt128) 0 / k)
+        {
+            break;
+        }
+        double score = -0.5 * log((double) k);
+        switch ((int) (n * k % 8))
+        {
+            case 1:
+                score += 2 * log(2.0);
+                break;
+            case 5:
+                score += log(2.0);
+                break;
+            default:
+                score += 0.5 * log(2.0);
+        }
+        const std::vector<int> &multiplierSymbols = scored.multiplierSymbols[multiplier];
+        for (size_t i = 0; i < primes.size(); i++)
+        {
+            int symbol = multiplierSymbols[i] * symbols[i];
+            if (symbol == 0)
+            {
+                score += scored.logs[i] / primes[i];
+            }
+            else if (symbol == 1)
+            {
+                score += 2 * scored.logs[i] / (primes[i] - 1);
+            }
+        }
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = k;
+        }
+    }
+    return best;
+}
+
+/**
+ * The parameters for a size of kn, interpolated between the rows of the table.
+ * @param bits the size of kn.
+ * @return the parameters.
+ */
+static SiqsParameters parametersFor(double bits)
+{
+    const size_t rows = sizeof(SIQS_PARAMETERS) / sizeof(SIQS_PARAMETERS[0]);
+    if (bits <= SIQS_PARAMETERS[0].bits)
+    {
+        return SIQS_PARAMETERS[0];
+    }
+    for (size_t i = 1; i < rows; i++)
+    {
+        const SiqsParameters &low = SIQS_PARAMETERS[i - 1] , &high = SIQS_PARAMETERS[i];
+        if (bits <= high.bits)
+        {
+            double t = (bits - low.bits) / (high.bits - low.bits);
+            return SiqsParameters{(int) bits ,
+                                  (uint32_t) (low.factorBase + t * (high.factorBase -
+                                                                    low.factorBase)) ,
+                                  (t < 0.5) ? low.blocks : high.blocks ,
+                                  (uint32_t) (low.largePrimeMultiplier +
+                                              t * (high.largePrimeMultiplier -
+                                                   low.largePrimeMultiplier))};
+        }
+    }
+    return SIQS_PARAMETERS[rows - 1];
+}
+
+/**
+ * The buffers of one sieving thread, and the polynomial it currently sieves.
+ */
+class PolynomialSieve
+{
+private:
+    SiqsContext &_context; /** The shared context. */
+    std::vector<uint64_t> _sieve; /** One block of the sieve, as words for the scan. */
+    std::vector<uint32_t> _root1; /** The first root of every prime, as an index of the interval. */
+    std::vector<uint32_t> _root2; /** The second root of every prime. */
+    std::vector<uint32_t> _next1; /** The next offset of the first root in the current block. */
+    std::vector<uint32_t> _next2; /** The next offset of the second root in the current block. */
+    std::vector<uint32_t> _ainv; /** a^-1 mod p. */
+    std::vector<std::vector<uint32_t>> _bainv2; /** 2 * B_l * a^-1 mod p, for every l. */
+    std::vector<uint8_t> _dividesA; /** Whether the prime is one of the primes of a. */
+    std::vector<size_t> _aIndices; /** The indices of the primes of a. */
+    std::vector<UInt128> _bTerms; /** The B_l, b is their sum with some signs. */
+    UInt128 _a; /** The current a. */
+    __int128 _b; /** The current b. */
+    __int128 _c; /** (b^2 - kn) / a. */
+    std::vector<SiqsRelation> _fulls; /** The full relations of the current polynomial. */
+    std::vector<SiqsRelation> _partials; /** The partial relations of the current polynomial. */
+    std::vector<uint32_t> _factors; /** Scratch space of the trial division. */
+
+    /**
+     * Draws the primes of a new value of a, which no thread has taken yet.
+     * @return false if the draw failed (the caller draws again).
+     */
+    bool _chooseA();
+
+    /**
+     * Computes the B_l, the first b, and the roots and the increments of every prime.
+     */
+    void _initializeA();
+
+    /**
+     * Switches to the next b in Gray code order and updates the roots.
+     * @param i the index of the new b, from 1 to 2^(s-1) - 1.
+     */
+    void _nextB(uint32_t i);
+
+    /**
+     * Sieves the interval block by block and divides the candidates.
+     */
+    void _sievePolynomial();
+
+    /**
+     * Divides Q(x) / a over the factor base and keeps the relation if it is smooth enough.
+     * @param j the index of x in the interval, x = j - M.
+     */
+    void _trialDivide(uint32_t j);
+
+    /**
+     * Hands the relations of the polynomial to the context.
+     */
+    void _publish();
+
+public:
+    explicit PolynomialSieve(SiqsContext &context);
+
+    /**
+     * Sieves new polynomials until the context has enough relations.
+     */
+    void run();
+};
+
+/**
+ * A constructor, allocates the buffers.
+ * @param context the shared context.
+ */
+PolynomialSieve::PolynomialSieve(SiqsContext &context) :
+        _context(context) , _sieve(SIQS_BLOCK / sizeof(uint64_t)) ,
+        _root1(context.primes.size()) , _root2(context.primes.size()) ,
+        _next1(context.primes.size()) , _next2(context.primes.size()) ,
+        _ainv(context.primes.size()) ,
+        _bainv2(context.aPrimes , std::vector<uint32_t>(context.primes.size())) ,
+        _dividesA(context.primes.size()) , _a(0) , _b(0) , _c(0)
+{}
+
+/**
+ * Draws the primes of a new value of a, which no thread has taken yet: s - 1 random primes
+ * around the ideal size, and the last one chosen to bring a closest to the target.
+ * @return false if the draw failed (the caller draws again).
+ */
+bool PolynomialSieve::_chooseA()
+{
+    const SiqsContext &context = _context;
+    _aIndices.clear();
+    long double product = 1;
+    for (int l = 0; l + 1 < context.aPrimes; l++)
+    {
+        size_t index = RandomSource::nextInRange(context.aLow , context.aHigh - 1);
+        if (std::find(_aIndices.begin() , _aIndices.end() , index) != _aIndices.end())
+        {
+            return false;
+        }
+        _aIndices.push_back(index);
+        product *= context.primes[index];
+    }
+    long double last = context.aTarget / product;
+    auto begin = context.primes.begin() + context.firstSieved;
+    auto closest = std::lower_bound(begin , context.primes.end() , (uint32_t) std::min(
+            last , (long double) UINT32_MAX));
+    if (closest == context.primes.end() || *closest > 2 * last)
+    {
+        return false;
+    }
+    if (closest != begin && last - *(closest - 1) < *closest - last)
+    {
+        closest--;
+    }
+    size_t index = closest - context.primes.begin();
+    if (context.roots[index] == 0 ||
+        std::find(_aIndices.begin() , _aIndices.end() , index) != _aIndices.end())
+    {
+        return false;
+    }
+    _aIndices.push_back(index);
+    _a = 1;
+    for (size_t i : _aIndices)
+    {
+        _a *= context.primes[i];
+    }
+    std::lock_guard<std::mutex> lock(_context.mutex);
+    return _context.usedA.insert(_a).second;
+}
+
+/**
+ * Computes the B_l, the first b, and the roots and the increments of every prime.
+ * For every q_l of a, B_l = (a / q_l) * gamma with gamma = sqrt(kn) * (a / q_l)^-1 mod q_l,
+ * so B_l^2 = kn mod q_l and B_l = 0 mod q_j for j != l, and b = B_1 + ... + B_s is a square
+ * root of kn mod a.
+ */
+void PolynomialSieve::_initializeA()
+{
+    const SiqsContext &context = _context;
+    const size_t size = context.primes.size();
+    std::fill(_dividesA.begin() , _dividesA.end() , 0);
+    _bTerms.clear();
+    _b = 0;
+    for (size_t index : _aIndices)
+    {
+        uint32_t q = context.primes[index];
+        UInt128 cofactor = _a / q;
+        uint64_t gamma = (uint64_t) context.roots[index] *
+                         GField::modInverse((uint64_t) (cofactor % q) , q) % q;
+        gamma = (gamma > q / 2) ? q - gamma : gamma;
+        _bTerms.push_back(cofactor * gamma);
+        _b += (__int128) _bTerms.back();
+        _dividesA[index] = 1;
+    }
+    UInt128 square = (UInt128) (_b * _b);
+    assert(square < context.kn && (context.kn - square) % _a == 0);
+    _c = -(__int128) ((context.kn - square) / _a);
+
+    const uint32_t half = context.interval / 2;
+    for (size_t i = 2; i < size; i++)
+    {
+        if (_dividesA[i])
+        {
+            continue;
+        }
+        uint32_t p = context.primes[i];
+        uint64_t ainv = GField::modInverse((uint64_t) (_a % p) , p);
+        _ainv[i] = (uint32_t) ainv;
+        for (int l = 0; l < context.aPrimes; l++)
+        {
+            _bainv2[l][i] = (uint32_t) (2 * ((uint64_t) (_bTerms[l] % p) * ainv % p) % p);
+        }
+        // x = a^-1 (+-t - b) mod p, shifted by M to index the interval
+        uint64_t b = signedMod(_b , p) , shift = half % p , t = context.roots[i];
+        _root1[i] = (uint32_t) ((ainv * ((t + p - b) % p) + shift) % p);
+        _root2[i] = (uint32_t) ((ainv * ((2 * p - t - b) % p) + shift) % p);
+    }
+}
+
+/**
+ * Switches to the next b in Gray code order and updates the roots. The new b differs from
+ * the old one by 2 * B_v with v the lowest set bit of i, which moves every root by the
+ * precomputed 2 * B_v * a^-1 mod p.
+ * @param i the index of the new b, from 1 to 2^(s-1) - 1.
+ */
+void PolynomialSieve::_nextB(uint32_t i)
+{
+    const SiqsContext &context = _context;
+    int v = __builtin_ctz(i);
+    // b_new = b + 2 e B_v with e = (-1)^ceil(i / 2^(v+1)), every root moves by -e 2 B_v / a
+    bool subtract = (((i >> (v + 1)) + 1) & 1) == 1;
+    _b += subtract ? -2 * (__int128) _bTerms[v] : 2 * (__int128) _bTerms[v];
+    UInt128 square = (UInt128) (_b * _b);
+    assert(square < context.kn && (context.kn - square) % _a == 0);
+    _c = -(__int128) ((context.kn - square) / _a);
+    const std::vector<uint32_t> &delta = _bainv2[v];
+    for (size_t j = 2; j < context.primes.size(); j++)
+    {
+        uint32_t p = context.primes[j];
+        if (subtract)
+        {
+            _root1[j] = (_root1[j] + delta[j] >= p) ? _root1[j] + delta[j] - p :
+                        _root1[j] + delta[j];
+            _root2[j] = (_root2[j] + delta[j] >= p) ? _root2[j] + delta[j] - p :
+                        _root2[j] + delta[j];
+        }
+        else
+        {
+            _root1[j] = (_root1[j] >= delta[j]) ? _root1[j] - delta[j] : _root1[j] + p - delta[j];
+            _root2[j] = (_root2[j] >= delta[j]) ? _root2[j] - delta[j] : _root2[j] + p - delta[j];
+        }
+    }
+}
+
+/**
+ * Sieves the interval block by block and divides the candidates. Each block starts at
+ * 128 - threshold, so a byte reaches the threshold exactly when its top bit is set and the
+ * scan tests eight bytes at once.
+ */
+void PolynomialSieve::_sievePolynomial()
+{
+    const SiqsContext &context = _context;
+    const size_t size = context.primes.size();
+    for (size_t i = context.firstSieved; i < size; i++)
+    {
+        _next1[i] = _root1[i];
+        // a prime of the multiplier has a single root
+        _next2[i] = (_root2[i] == _root1[i]) ? UINT32_MAX / 2 : _root2[i];
+    }
+    uint8_t *sieve = (uint8_t *) _sieve.data();
+    for (uint32_t start = 0; start < context.interval; start += SIQS_BLOCK)
+    {
+        memset(sieve , context.sieveStart , SIQS_BLOCK);
+        for (size_t i = context.firstSieved; i < size; i++)
+        {
+            if (_dividesA[i])
+            {
+                continue;
+            }
+            const uint32_t p = context.primes[i];
+            const uint8_t log = context.logs[i];
+            uint32_t offset = _next1[i];
+            for (; offset < SIQS_BLOCK; offset += p)
+            {
+                sieve[offset] += log;
+            }
+            _next1[i] = offset - SIQS_BLOCK;
+            offset = _next2[i];
+            for (; offset < SIQS_BLOCK; offset += p)
+            {
+                sieve[offset] += log;
+            }
+            _next2[i] = offset - SIQS_BLOCK;
+        }
+        for (size_t word = 0; word < _sieve.size(); word++)
+        {
+            if ((_sieve[word] & SIQS_TOP_BITS) == 0)
+            {
+                continue;
+            }
+            for (uint32_t byte = 0; byte < sizeof(uint64_t); byte++)
+            {
+                uint32_t offset = (uint32_t) (word * sizeof(uint64_t) + byte);
+                if (sieve[offset] & 0x80)
+                {
+                    _trialDivide(start + offset);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Divides Q(x) / a = a x^2 + 2 b x + c over the factor base and keeps the relation if it is
+ * smooth enough. Only the primes whose roots x hits are divided, a prime of a is divided
+ * with a remainder since its roots are not tracked.
+ * @param j the index of x in the interval, x = j - M.
+ */
+void PolynomialSieve::_trialDivide(uint32_t j)
+{
+    const SiqsContext &context = _context;
+    const __int128 x = (__int128) j - context.interval / 2;
+    const __int128 value = ((__int128) _a * x + 2 * _b) * x + _c;
+    if (value == 0)
+    {
+        return;
+    }
+    _factors.clear();
+    _factors.insert(_factors.end() , _aIndices.begin() , _aIndices.end());
+    if (value < 0)
+    {
+        _factors.push_back(0);
+    }
+    UInt128 cofactor = (UInt128) ((value < 0) ? -value : value);
+    int twos = ctz128(cofactor);
+    cofactor >>= twos;
+    _factors.insert(_factors.end() , (size_t) twos , 1);
+    for (size_t i = 2; i < context.primes.size(); i++)
+    {
+        const uint32_t p = context.primes[i];
+        if (_dividesA[i])
+        {
+            if (cofactor % p != 0)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            uint32_t position = j % p;
+            if (position != _root1[i] && position != _root2[i])
+            {
+                continue;
+            }
+        }
+        do
+        {
+            cofactor /= p;
+            _factors.push_back((uint32_t) i);
+        } while (cofactor % p == 0);
+    }
+    if (cofactor > context.largePrimeBound)
+    {
+        return;
+    }
+    // Y = ax + b mod n
+    __int128 y = (__int128) _a * x + _b;
+    UInt128 residue = (UInt128) ((y < 0) ? -y : y) % context.n;
+    residue = (y < 0 && residue != 0) ? context.n - residue : residue;
+    std::vector<SiqsRelation> &target = (cofactor == 1) ? _fulls : _partials;
+    target.push_back(SiqsRelation{residue , _factors , cofactor});
+}
+
+/**
+ * Hands the relations of the polynomial to the context. A partial relation whose large
+ * prime L was seen before is multiplied with the earlier one, the product has L^2.
+ */
+void PolynomialSieve::_publish()
+{
+    SiqsContext &context = _context;
+    std::lock_guard<std::mutex> lock(context.mutex);
+    for (SiqsRelation &relation : _fulls)
+    {
+        context.relations.push_back(std::move(relation));
+    }
+    for (SiqsRelation &relation : _partials)
+    {
+        context.partialCount++;
+        auto found = context.partials.find((uint64_t) relation.largePrime);
+        if (found == context.partials.end())
+        {
+            uint64_t key = (uint64_t) relation.largePrime;
+            context.partials.emplace(key , std::move(relation));
+            continue;
+        }
+        const SiqsRelation &other = found->second;
+        if (other.y == relation.y)
+        {
+            continue;
+        }
+        relation.y = context.reducer.mul(context.reducer.toMontgomery(relation.y) , other.y);
+        relation.factors.insert(relation.factors.end() , other.factors.begin() ,
+                                other.factors.end());
+        context.relations.push_back(std::move(relation));
+        context.combinedCount++;
+    }
+    _fulls.clear();
+    _partials.clear();
+    if (context.relations.size() >= context.needed)
+    {
+        context.done = true;
+    }
+}
+
+/**
+ * Sieves new polynomials until the context has enough relations.
+ */
+void PolynomialSieve::run()
+{
+    int failures = 0;
+    while (!_context.done.load(std::memory_order_relaxed))
+    {
+        if (!_chooseA())
+        {
+            if (++failures == SIQS_A_DRAWS)
+            {
+                _context.exhausted = true;
+                _context.done = true;
+            }
+            continue;
+        }
+        failures = 0;
+        _initializeA();
+        const uint32_t polynomials = 1u << (_context.aPrimes - 1);
+        for (uint32_t i = 0; i < polynomials && !_context.done.load(std::memory_order_relaxed);
+             i++)
+        {
+            if (i > 0)
+            {
+                _nextB(i);
+            }
+            _sievePolynomial();
+            _publish();
+            _context.polynomials++;
+        }
+    }
+}
+
+/**
+ * A constructor, chooses the multiplier and the parameters and builds the factor base.
+ * @param n odd composite number.
+ */
+QuadraticSieve::QuadraticSieve(UInt128 n) : _context(std::make_shared<SiqsContext>(n)) ,
+                                            _statistics()
+{
+    SiqsContext &context = *_context;
+    context.multiplier = chooseMultiplier(n);
+    context.kn = n * context.multiplier;
+    const double bits = log2Wide(context.kn);
+    const SiqsParameters parameters = parametersFor(bits);
+
+    // -1, 2 and the odd primes p for which kn is a square mod p (or p divides k)
+    context.primes = {1 , 2};
+    context.roots = {0 , 1};
+    PrimeSieve sieve;
+    sieve.next();
+    while (context.primes.size() < parameters.factorBase)
+    {
+        uint32_t p = (uint32_t) sieve.next();
+        uint64_t residue = (uint64_t) (context.kn % p);
+        uint64_t root = (residue == 0) ? 0 : GField::modSqrt(residue , p);
+        if (residue == 0 || root != 0)
+        {
+            context.primes.push_back(p);
+            context.roots.push_back((uint32_t) root);
+        }
+    }
+    for (uint32_t p : context.primes)
+    {
+        context.logs.push_back((uint8_t) lround(log2((double) p)));
+    }
+    context.firstSieved = (size_t) (std::lower_bound(context.primes.begin() ,
+                                                     context.primes.end() ,
+                                                     (uint32_t) SIQS_MIN_SIEVE_PRIME) -
+                                    context.primes.begin());
+
+    context.interval = parameters.blocks * SIQS_BLOCK;
+    const uint32_t half = context.interval / 2;
+    context.largePrimeBound = (uint64_t) context.primes.back() * parameters.largePrimeMultiplier;
+    // Q(x) / a is about M sqrt(kn / 2) at the ends of the interval
+    double threshold = log2((double) half) + bits / 2 - 0.5 -
+                       log2((double) context.largePrimeBound);
+    context.sieveStart = (uint8_t) (128 - std::max(1L , lround(threshold)));
+
+    // a is the product of s primes near SIQS_A_PRIME (or the largest ones of a small base)
+    context.aTarget = sqrtl(2 * (long double) context.kn) / half;
+    const size_t size = context.primes.size();
+    size_t middle = (size_t) (std::lower_bound(context.primes.begin() , context.primes.end() ,
+                                               (uint32_t) SIQS_A_PRIME) -
+                              context.primes.begin());
+    middle = std::min(middle , size - size / 4);
+    double logTarget = log2((double) context.aTarget);
+    context.aPrimes = std::max(1 , (int) ceil(logTarget / log2((double) context.primes[middle])));
+    uint32_t aPrime = (uint32_t) exp2(logTarget / context.aPrimes);
+    middle = (size_t) (std::lower_bound(context.primes.begin() , context.primes.end() , aPrime) -
+                       context.primes.begin());
+    middle = std::max(context.firstSieved + 2 * context.aPrimes , std::min(middle , size - 1));
+    context.aLow = std::max(context.firstSieved , middle - std::min(middle , (size_t) 40));
+    context.aHigh = std::min(size , middle + 40);
+    context.needed = size + SIQS_EXTRA_RELATIONS;
+}
+
+/**
+ * Getter for the Knuth-Schroeppel multiplier.
+ * @return k.
+ */
+uint32_t QuadraticSieve::getMultiplier() const
+{
+    return _context->multiplier;
+}
+
+/**
+ * Getter for the size of the factor base (with -1 and 2).
+ * @return the number of primes.
+ */
+size_t QuadraticSieve::getFactorBaseSize() const
+{
+    return _context->primes.size();
+}
+
+/**
+ * Sieves until there are enough relations and finds a factor. The pool threads run until the
+ * relations are complete and then leave, they own a reference to the context so the caller
+ * may return before they notice.
+ * @param pool the pool whose threads sieve along with the caller (may be null), the
+ * caller never waits on it.
+ * @return a non trivial factor, or 0 if the sieve failed (n is a prime power, or too small
+ * for the factor base to give enough values of a).
+ */
+UInt128 QuadraticSieve::factor(ThreadPool *pool)
+{
+    std::shared_ptr<SiqsContext> context = _context;
+    UInt128 root = integerSqrt128(context->n);
+    if (root * root == context->n)
+    {
+        return root;
+    }
+    for (int round = 0; round < SIQS_ROUNDS; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t helper = 0; pool != nullptr && helper < pool->size(); helper++)
+        {
+            pool->submit([context]()
+                         {
+                             PolynomialSieve(*context).run();
+                         });
+        }
+        PolynomialSieve(*context).run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        _statistics.sieveSeconds += elapsed.count();
+
+        start = std::chrono::steady_clock::now();
+        UInt128 factor = _solve();
+        elapsed = std::chrono::steady_clock::now() - start;
+        _statistics.solveSeconds += elapsed.count();
+        if (factor != 0 || context->exhausted)
+        {
+            return factor;
+        }
+        std::lock_guard<std::mutex> lock(context->mutex);
+        context->needed = context->relations.size() + SIQS_EXTRA_RELATIONS;
+        context->done = false;
+    }
+    return 0;
+}
+
+/**
+ * Finds a factor from the relations collected so far. The relations with a prime of odd
+ * exponent which no other relation has (a singleton) cannot be in any dependency and are
+ * dropped until there are none, the rest are reduced by Gaussian elimination, each row
+ * carrying the set of relations it is the sum of.
+ * @return a non trivial factor, or 0 if every dependency gave a trivial one.
+ */
+UInt128 QuadraticSieve::_solve()
+{
+    SiqsContext &context = *_context;
+    std::vector<SiqsRelation> relations;
+    {
+        std::lock_guard<std::mutex> lock(context.mutex);
+        relations = context.relations;
+        _statistics.polynomials = context.polynomials;
+        _statistics.combinedRelations = context.combinedCount;
+        _statistics.fullRelations = context.relations.size() - context.combinedCount;
+        _statistics.partialRelations = context.partialCount;
+    }
+    const size_t columns = context.primes.size();
+
+    // the primes of odd exponent of every relation
+    std::vector<std::vector<uint32_t>> odd(relations.size());
+    for (size_t r = 0; r < relations.size(); r++)
+    {
+        std::vector<uint32_t> factors = relations[r].factors;
+        std::sort(factors.begin() , factors.end());
+        for (size_t i = 0; i < factors.size();)
+        {
+            size_t end = i;
+            while (end < factors.size() && factors[end] == factors[i])
+            {
+                end++;
+            }
+            if ((end - i) % 2 == 1)
+            {
+                odd[r].push_back(factors[i]);
+            }
+            i = end;
+        }
+    }
+    std::vector<uint8_t> alive(relations.size() , 1);
+    std::vector<uint32_t> counts(columns);
+    bool removed = true;
+    while (removed)
+    {
+        std::fill(counts.begin() , counts.end() , 0);
+        for (size_t r = 0; r < relations.size(); r++)
+        {
+            for (uint32_t column : odd[r])
+            {
+                counts[column] += alive[r];
+            }
+        }
+        removed = false;
+        for (size_t r = 0; r < relations.size(); r++)
+        {
+            for (uint32_t column : odd[r])
+            {
+                if (alive[r] && counts[column] == 1)
+                {
+                    alive[r] = 0;
+                    removed = true;
+                }
+            }
+        }
+    }
+    std::vector<uint32_t> compact(columns , UINT32_MAX);
+    size_t used = 0;
+    for (size_t column = 0; column < columns; column++)
+    {
+        compact[column] = (counts[column] > 0) ? (uint32_t) used++ : UINT32_MAX;
+    }
+    std::vector<size_t> rows;
+    for (size_t r = 0; r < relations.size(); r++)
+    {
+        if (alive[r])
+        {
+            rows.push_back(r);
+        }
+    }
+
+    // every row holds the exponents mod 2, then one bit per relation
+    const size_t matrixWords = (used + 63) / 64 , words = matrixWords + (rows.size() + 63) / 64;
+    std::vector<uint64_t> matrix(rows.size() * words);
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        uint64_t *row = &matrix[i * words];
+        for (uint32_t column : odd[rows[i]])
+        {
+            row[compact[column] / 64] |= 1ull << (compact[column] % 64);
+        }
+        row[matrixWords + i / 64] |= 1ull << (i % 64);
+    }
+    size_t rank = 0;
+    for (size_t column = 0; column < used && rank < rows.size(); column++)
+    {
+        const size_t word = column / 64;
+        const uint64_t bit = 1ull << (column % 64);
+        size_t pivot = rank;
+        while (pivot < rows.size() && (matrix[pivot * words + word] & bit) == 0)
+        {
+            pivot++;
+        }
+        if (pivot == rows.size())
+        {
+            continue;
+        }
+        std::swap_ranges(&matrix[pivot * words] , &matrix[pivot * words] + words ,
+                         &matrix[rank * words]);
+        const uint64_t *pivotRow = &matrix[rank * words];
+        for (size_t i = rank + 1; i < rows.size(); i++)
+        {
+            uint64_t *row = &matrix[i * words];
+            if (row[word] & bit)
+            {
+                for (size_t w = word; w < words; w++)
+                {
+                    row[w] ^= pivotRow[w];
+                }
+            }
+        }
+        rank++;
+    }
+
+    // the rows below the rank are dependencies: X^2 = Y^2 mod n
+    const Montgomery128 &reducer = context.reducer;
+    std::vector<uint32_t> exponents(columns);
+    for (size_t dependency = rank; dependency < rows.size(); dependency++)
+    {
+        const uint64_t *history = &matrix[dependency * words + matrixWords];
+        std::fill(exponents.begin() , exponents.end() , 0);
+        UInt128 x = reducer.one() , y = reducer.one();
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            if ((history[i / 64] >> (i % 64)) & 1)
+            {
+                const SiqsRelation &relation = relations[rows[i]];
+                x = reducer.mul(x , reducer.toMontgomery(relation.y));
+                y = reducer.mul(y , reducer.toMontgomery(relation.largePrime));
+                for (uint32_t factor : relation.factors)
+                {
+                    exponents[factor]++;
+                }
+            }
+        }
+        for (size_t column = 1; column < columns; column++)
+        {
+            assert(exponents[column] % 2 == 0);
+            if (exponents[column] > 0)
+            {
+                y = reducer.mul(y , reducer.pow(reducer.toMontgomery(context.primes[column]) ,
+                                                exponents[column] / 2));
+            }
+        }
+        UInt128 g = gcd128(reducer.fromMontgomery(reducer.subMod(x , y)) , context.n);
+        if (g != 1 && g != context.n)
+        {
+            return g;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// QuadraticSieve.h
+//----------- include guards------------
+#ifndef QUADRATICSIEVE_H
+#define QUADRATICSIEVE_H
+//-------------- includes --------------
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Montgomery128.h"
+
+class ThreadPool;
+
+struct SiqsContext;
+
+#define SIQS_BLOCK 32768 /** the bytes sieved at once, the size of the L1 data cache */
+#define SIQS_MIN_SIEVE_PRIME 30 /** the primes below it are not sieved, only divided out */
+#define SIQS_EXTRA_RELATIONS 64 /** the relations collected beyond the size of the factor base */
+#define SIQS_ROUNDS 3 /** the sieving rounds before giving up (each adds the extra relations) */
+
+//--------------------------------------
+
+/**
+ * The counters of one run of the quadratic sieve.
+ */
+struct SiqsStatistics
+{
+    uint64_t polynomials; /** The polynomials sieved. */
+    uint64_t fullRelations; /** The relations which factor over the factor base. */
+    uint64_t combinedRelations; /** The pairs of partial relations with the same large prime. */
+    uint64_t partialRelations; /** The relations with one large prime. */
+    double sieveSeconds; /** The wall time of the sieving. */
+    double solveSeconds; /** The wall time of the linear algebra and the square roots. */
+};
+
+/**
+ *  A QuadraticSieve class.
+ *  The self initializing quadratic sieve, for odd composites of about 60 to 128 bits whose
+ *  factors are too large for the elliptic curve method. A multiplier k is chosen by the
+ *  Knuth-Schroeppel function and the factor base holds the primes p for which kn is a square
+ *  mod p. Every polynomial Q(x) = (ax + b)^2 - kn has a = q1 * ... * qs, a product of factor
+ *  base primes close to sqrt(2kn) / M, and the 2^(s-1) values of b for one a are visited in
+ *  Gray code order, so switching b updates each root with a single addition. The interval
+ *  [-M, M) is sieved with rounded base 2 logarithms one cache sized block at a time, the
+ *  candidates are divided by the primes whose roots they hit, and a cofactor below the large
+ *  prime bound is kept until a second relation with the same large prime shows up.
+ *  The dependencies of the exponent vectors are found by Gaussian elimination over GF(2)
+ *  after the singletons are removed, each one gives X^2 = Y^2 mod n and gcd(X - Y, n).
+ *  The polynomials are independent, so every thread of a pool sieves its own values of a.
+ */
+class QuadraticSieve
+{
+private:
+    std::shared_ptr<SiqsContext> _context; /** Shared with the helper threads. */
+    SiqsStatistics _statistics; /** The counters of the last run. */
+
+    /**
+     * Finds a factor from the relations collected so far.
+     * @return a non trivial factor, or 0 if every dependency gave a trivial one.
+     */
+    UInt128 _solve();
+
+public:
+    /**
+     * A constructor, chooses the multiplier and the parameters and builds the factor base.
+     * @param n odd composite number.
+     */
+    explicit QuadraticSieve(UInt128 n);
+
+    /**
+     * Sieves until there are enough relations and finds a factor.
+     * @param pool the pool whose threads sieve along with the caller (may be null), the
+     * caller never waits on it.
+     * @return a non trivial factor, or 0 if the sieve failed (n is a prime power, or too
+     * small for the factor base to give enough values of a).
+     */
+    UInt128 factor(ThreadPool *pool = nullptr);
+
+    /**
+     * Getter for the Knuth-Schroeppel multiplier.
+     * @return k.
+     */
+    uint32_t getMultiplier() const;
+
+    /**
+     * Getter for the size of the factor base (with -1 and 2).
+     * @return the number of primes.
+     */
+    size_t getFactorBaseSize() const;
+
+    /**
+     * Getter for the counters of the last run.
+     * @return the counters.
+     */
+    const SiqsStatistics &getStatistics() const
+    { return _statistics; }
+};
+
+#endif //QUADRATICSIEVE_H
@@ -0,0 +1,160 @@
+// RandomSource.cpp
+
+#include "RandomSource.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class RandomSource.
+// --------------------------------------------------------------------------------------
+
+/** Guards the lazy initialization of the process seed. */
+static std::once_flag seedInitialized;
+/** The process seed. */
+static std::atomic<uint64_t> processSeed(0);
+/** Incremented on every setSeed, so the threads know they should reseed. */
+static std::atomic<uint64_t> seedGeneration(1);
+/** Counts the threads which derived a state from the current seed. */
+static std::atomic<uint64_t> threadCounter(0);
+/** The user supplied generator, if any. */
+static std::atomic<RandomSource::RandomFunction> randomFunction(nullptr);
+
+/**
+ * Reads the process seed from the environment, or from the system entropy.
+ */
+static void initializeSeed()
+{
+    const char *environmentSeed = std::getenv(RANDOM_SEED_ENV);
+    if (environmentSeed != nullptr && *environmentSeed != '\0')
+    {
+        processSeed = std::strtoull(environmentSeed , nullptr , 0);
+    }
+    else
+    {
+        std::random_device rd;
+        processSeed = ((uint64_t) rd() << 32) | rd();
+    }
+}
+
+/**
+ * The splitmix64 mixing step, used to expand seeds.
+ * @param state the splitmix64 state, advanced by the call.
+ * @return the next 64 mixed bits.
+ */
+uint64_t RandomSource::splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Derives the state of the generator of the current thread from the process seed.
+ */
+void RandomSource::_reseed()
+{
+    std::call_once(seedInitialized , initializeSeed);
+    _seedGeneration = seedGeneration.load();
+    uint64_t threadIndex = threadCounter++;
+    uint64_t mix = processSeed.load() + threadIndex * 0x9E3779B97F4A7C15ull;
+    for (uint64_t &word : _state)
+    {
+        word = splitMix64(mix);
+    }
+}
+
+/**
+ * The xoshiro256** step.
+ * @return the next 64 random bits.
+ */
+uint64_t RandomSource::_next()
+{
+    uint64_t result = _state[1] * 5;
+    result = ((result << 7) | (result >> 57)) * 9;
+    uint64_t t = _state[1] << 17;
+    _state[2] ^= _state[0];
+    _state[3] ^= _state[1];
+    _state[1] ^= _state[2];
+    _state[0] ^= _state[3];
+    _state[2] ^= t;
+    _state[3] = (_state[3] << 45) | (_state[3] >> 19);
+    return result;
+}
+
+/**
+ * @return the generator of the calling thread.
+ */
+RandomSource &RandomSource::_threadLocal()
+{
+    thread_local RandomSource source;
+    return source;
+}
+
+/**
+ * @return the next 64 random bits of the calling thread's generator.
+ */
+uint64_t RandomSource::next()
+{
+    RandomFunction function = randomFunction.load(std::memory_order_relaxed);
+    if (function != nullptr)
+    {
+        return function();
+    }
+    RandomSource &source = _threadLocal();
+    if (source._seedGeneration != seedGeneration.load(std::memory_order_relaxed))
+    {
+        source._reseed();
+    }
+    return source._next();
+}
+
+/**
+ * Generates a number uniformly distributed (up to a negligible bias) in [low, high].
+ * @param low the lower bound.
+ * @param high the upper bound, at least low.
+ * @return a random number.
+ */
+uint64_t RandomSource::nextInRange(uint64_t low , uint64_t high)
+{
+    uint64_t span = high - low + 1;
+    if (span == 0) // the whole 64 bit range
+    {
+        return next();
+    }
+    return low + (uint64_t) (((unsigned __int128) next() * span) >> 64);
+}
+
+/**
+ * Sets the process seed, every thread (including the calling one) restarts its
+ * sequence from it on its next draw.
+ * @param seed the seed.
+ */
+void RandomSource::setSeed(uint64_t seed)
+{
+    std::call_once(seedInitialized , initializeSeed);
+    processSeed = seed;
+    threadCounter = 0;
+    seedGeneration++;
+}
+
+/**
+ * Getter for the process seed.
+ * @return the process seed.
+ */
+uint64_t RandomSource::getSeed()
+{
+    std::call_once(seedInitialized , initializeSeed);
+    return processSeed.load();
+}
+
+/**
+ * Replaces the generator of every thread.
+ * @param function the generator, or nullptr to go back to xoshiro256**.
+ */
+void RandomSource::setRandomFunction(RandomFunction function)
+{
+    randomFunction = function;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+// RandomSource.h
+//----------- include guards------------
+#ifndef RANDOMSOURCE_H
+#define RANDOMSOURCE_H
+//-------------- includes --------------
+#include <cstdint>
+
+#define RANDOM_SEED_ENV "GF_RANDOM_SEED" /** environment variable holding the seed */
+
+//--------------------------------------
+
+/**
+ *  A RandomSource class.
+ *  A seedable xoshiro256** generator, one per thread, used by the factorization algorithms.
+ *  Every thread derives its state from the process seed (taken from GF_RANDOM_SEED, setSeed,
+ *  or the system entropy once per process) and the order in which it first drew a number,
+ *  so a single threaded run can be replayed exactly.
+ */
+class RandomSource
+{
+public:
+    /** A user supplied generator which replaces xoshiro256** for every thread. */
+    typedef uint64_t (*RandomFunction)();
+
+private:
+    uint64_t _state[4]; /** The xoshiro256** state. */
+    uint64_t _seedGeneration; /** The process seed generation the state was derived from. */
+
+    /**
+     * A constructor, the state is derived on first use.
+     */
+    RandomSource() : _state{0 , 0 , 0 , 0} , _seedGeneration(0)
+    {};
+
+    /**
+     * Derives the state of the generator of the current thread from the process seed.
+     */
+    void _reseed();
+
+    /**
+     * The xoshiro256** step.
+     * @return the next 64 random bits.
+     */
+    uint64_t _next();
+
+    /**
+     * @return the generator of the calling thread.
+     */
+    static RandomSource &_threadLocal();
+
+public:
+    /**
+     * @return the next 64 random bits of the calling thread's generator.
+     */
+    static uint64_t next();
+
+    /**
+     * Generates a number uniformly distributed (up to a negligible bias) in [low, high].
+     * @param low the lower bound.
+     * @param high the upper bound, at least low.
+     * @return a random number.
+     */
+    static uint64_t nextInRange(uint64_t low , uint64_t high);
+
+    /**
+     * Sets the process seed, every thread (including the calling one) restarts its
+     * sequence from it on its next draw.
+     * @param seed the seed.
+     */
+    static void setSeed(uint64_t seed);
+
+    /**
+     * Getter for the process seed.
+     * @return the process seed.
+     */
+    static uint64_t getSeed();
+
+    /**
+     * Replaces the generator of every thread.
+     * @param function the generator, or nullptr to go back to xoshiro256**.
+     */
+    static void setRandomFunction(RandomFunction function);
+
+    /**
+     * The splitmix64 mixing step, used to expand seeds.
+     * @param state the splitmix64 state, advanced by the call.
+     * @return the next 64 mixed bits.
+     */
+    static uint64_t splitMix64(uint64_t &state);
+};
+
+#endif //RANDOMSOURCE_H
@@ -0,0 +1,221 @@
+// SmallVector.hpp
+//----------- include guards------------
+#ifndef SMALLVECTOR_HPP
+#define SMALLVECTOR_HPP
+//-------------- includes --------------
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+//--------------------------------------
+
+/**
+ * A vector which keeps its first N elements inline, it only allocates memory once it grows
+ * beyond them.
+ * @tparam T a trivially copyable element type.
+ * @tparam N the number of inline slots.
+ */
+template<class T , size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value , "SmallVector holds plain values");
+
+private:
+    T _inline[N]; /** The inline storage. */
+    T *_data; /** The storage in use, _inline or a heap array. */
+    size_t _size; /** The number of elements. */
+    size_t _capacity; /** The number of elements _data can hold. */
+
+    /**
+     * Moves the elements to a heap array of the given capacity.
+     * @param capacity the new capacity, larger than the current one.
+     */
+    void _grow(size_t capacity);
+
+    /**
+     * Releases the heap array, if any.
+     */
+    void _release()
+    {
+        if (_data != _inline)
+        {
+            delete[] _data;
+        }
+    }
+
+public:
+    /**
+     * Default ctor, an empty vector using the inline storage.
+     */
+    SmallVector() : _data(_inline) , _size(0) , _capacity(N)
+    {}
+
+    /**
+     * Copy ctor.
+     * @param other SmallVector.
+     */
+    SmallVector(const SmallVector &other) : SmallVector()
+    {
+        *this = other;
+    }
+
+    /**
+     * Move ctor, steals the heap array of other if it has one.
+     * @param other SmallVector.
+     */
+    SmallVector(SmallVector &&other) noexcept : SmallVector()
+    {
+        *this = std::move(other);
+    }
+
+    /**
+     * Destructor.
+     */
+    ~SmallVector()
+    {
+        _release();
+    }
+
+    /**
+     * Copy assignment.
+     * @param other SmallVector.
+     * @return this.
+     */
+    SmallVector &operator=(const SmallVector &other);
+
+    /**
+     * Move assignment.
+     * @param other SmallVector.
+     * @return this.
+     */
+    SmallVector &operator=(SmallVector &&other) noexcept;
+
+    /**
+     * Appends an element.
+     * @param value the element.
+     */
+    void push_back(const T &value)
+    {
+        if (_size == _capacity)
+        {
+            _grow(2 * _capacity);
+        }
+        _data[_size++] = value;
+    }
+
+    /**
+     * Removes all the elements, the storage is kept.
+     */
+    void clear()
+    { _size = 0; }
+
+    /**
+     * @return the number of elements.
+     */
+    size_t size() const
+    { return _size; }
+
+    /**
+     * @return true if there are no elements.
+     */
+    bool empty() const
+    { return _size == 0; }
+
+    /**
+     * @return true if the elements are stored inline.
+     */
+    bool isInline() const
+    { return _data == _inline; }
+
+    T &operator[](size_t i)
+    { return _data[i]; }
+
+    const T &operator[](size_t i) const
+    { return _data[i]; }
+
+    T *begin()
+    { return _data; }
+
+    T *end()
+    { return _data + _size; }
+
+    const T *begin() const
+    { return _data; }
+
+    const T *end() const
+    { return _data + _size; }
+};
+
+// ------------------------ implementation ------------------------
+
+/**
+ * Moves the elements to a heap array of the given capacity.
+ * @param capacity the new capacity, larger than the current one.
+ */
+template<class T , size_t N>
+void SmallVector<T , N>::_grow(size_t capacity)
+{
+    assert(capacity > _capacity);
+    T *data = new T[capacity];
+    std::copy(begin() , end() , data);
+    _release();
+    _data = data;
+    _capacity = capacity;
+}
+
+/**
+ * Copy assignment.
+ * @param other SmallVector.
+ * @return this.
+ */
+template<class T , size_t N>
+SmallVector<T , N> &SmallVector<T , N>::operator=(const SmallVector &other)
+{
+    if (this != &other)
+    {
+        _size = 0;
+        if (other._size > _capacity)
+        {
+            _grow(other._size);
+        }
+        std::copy(other.begin() , other.end() , _data);
+        _size = other._size;
+    }
+    return *this;
+}
+
+/**
+ * Move assignment.
+ * @param other SmallVector.
+ * @return this.
+ */
+template<class T , size_t N>
+SmallVector<T , N> &SmallVector<T , N>::operator=(SmallVector &&other) noexcept
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    if (other.isInline())
+    {
+        // the inline elements have to be copied anyway
+        _size = 0;
+        std::copy(other.begin() , other.end() , _data); // N fits in any capacity
+        _size = other._size;
+    }
+    else
+    {
+        _release();
+        _data = other._data;
+        _size = other._size;
+        _capacity = other._capacity;
+        other._data = other._inline;
+        other._capacity = N;
+    }
+    other._size = 0;
+    return *this;
+}
+
+#endif //SMALLVECTOR_HPP
@@ -0,0 +1,273 @@
+// SubproductTree.cpp
+
+#include "SubproductTree.h"
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include "GFPolynomial.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class SubproductTree.
+// --------------------------------------------------------------------------------------
+
+/**
+ * The chunks of one level, owned by every task so that a task which only starts after the
+ * level is done can still read it.
+ */
+struct NodeChunks
+{
+    std::atomic<size_t> next; /** The next chunk to claim. */
+    std::mutex mutex; /** Guards finished. */
+    std::condition_variable allFinished; /** Signaled when the last chunk is finished. */
+    size_t finished; /** The chunks finished. */
+
+    NodeChunks() : next(0) , finished(0)
+    {}
+};
+
+/**
+ * Runs body(k) for the nodes of one level, split into chunks of about SUBPRODUCT_TASK_LENGTH
+ * coefficients when there is a pool. The calling thread claims chunks too and then waits for
+ * the chunks of this level only, never for the pool, so it may be a worker of the same pool.
+ * @param nodes the number of nodes.
+ * @param span the coefficients of one node.
+ * @param pool the pool (may be null).
+ * @param body the work of one node, gets its index.
+ */
+template<typename Body>
+static void forEachNode(size_t nodes , size_t span , ThreadPool *pool , const Body &body)
+{
+    const size_t perTask = std::max((size_t) 1 , (size_t) SUBPRODUCT_TASK_LENGTH / span);
+    if (pool == nullptr || nodes <= perTask)
+    {
+        for (size_t k = 0; k < nodes; k++)
+        {
+            body(k);
+        }
+        return;
+    }
+    const size_t chunks = (nodes + perTask - 1) / perTask;
+    std::shared_ptr<NodeChunks> state = std::make_shared<NodeChunks>();
+    // body is only touched by a claimed chunk, which the caller waits for
+    auto run = [&body , nodes , perTask , chunks](NodeChunks &shared)
+    {
+        for (size_t chunk = shared.next++; chunk < chunks; chunk = shared.next++)
+        {
+            for (size_t k = chunk * perTask; k < std::min(nodes , (chunk + 1) * perTask); k++)
+            {
+                body(k);
+            }
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            if (++shared.finished == chunks)
+            {
+                shared.allFinished.notify_all();
+            }
+        }
+    };
+    for (size_t task = 1; task < std::min(chunks , pool->size() + 1); task++)
+    {
+        pool->submit([run , state]()
+                     { run(*state); });
+    }
+    run(*state);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->allFinished.wait(lock , [&state , chunks]()
+    { return state->finished == chunks; });
+}
+
+/**
+ * A constructor, builds the tree.
+ * @param field the field of the points.
+ * @param points n residues of the field.
+ * @param n the number of points, not 0.
+ * @param pool the pool running the nodes of every level (may be null).
+ */
+SubproductTree::SubproductTree(const GField &field , const uint64_t *points , size_t n ,
+                               ThreadPool *pool) :
+        _field(field.getId()) , _points(points , points + n)
+{
+    assert(n > 0);
+    // the leaves, multiplied by one x - x_i at a time
+    _levels.emplace_back(_nodes(0) * (_span(0) + 1) , 0);
+    forEachNode(_nodes(0) , _span(0) , pool , [this , &field](size_t k)
+    {
+        uint64_t *node = _levels[0].data() + k * (_span(0) + 1);
+        const uint64_t *x = _points.data() + k * _span(0);
+        node[0] = field.element(1).getResidue();
+        for (size_t t = 0; t < _degree(0 , k); t++)
+        {
+            GFElement root = field.neg(GFElement(x[t]));
+            node[t + 1] = node[t];
+            for (size_t i = t; i >= 1; i--)
+            {
+                node[i] = field.add(GFElement(node[i - 1]) ,
+                                    field.mul(root , GFElement(node[i]))).getResidue();
+            }
+            node[0] = field.mul(root , GFElement(node[0])).getResidue();
+        }
+    });
+    for (size_t level = 1; _nodes(level - 1) > 1; level++)
+    {
+        _levels.emplace_back(_nodes(level) * (_span(level) + 1) , 0);
+        forEachNode(_nodes(level) , _span(level) , pool , [this , &field , level](size_t k)
+        {
+            uint64_t *node = _levels[level].data() + k * (_span(level) + 1);
+            const size_t left = 2 * k , right = 2 * k + 1;
+            const uint64_t *leftNode = _node(level - 1 , left);
+            if (right == _nodes(level - 1))
+            {
+                std::copy(leftNode , leftNode + _degree(level - 1 , left) + 1 , node);
+                return;
+            }
+            GFPolynomial::multiply(field , leftNode , _degree(level - 1 , left) + 1 ,
+                                   _node(level - 1 , right) , _degree(level - 1 , right) + 1 ,
+                                   node);
+        });
+    }
+}
+
+/**
+ * Evaluates a polynomial at every point.
+ * @param coefficients length residues of the field, the constant first.
+ * @param length the number of coefficients.
+ * @param values output, the size() values, in the order of the points.
+ * @param pool the pool running the nodes of every level (may be null).
+ */
+void SubproductTree::evaluate(const uint64_t *coefficients , size_t length , uint64_t *values ,
+                              ThreadPool *pool) const
+{
+    const GField &field = _getField();
+    const size_t n = _points.size() , top = _levels.size() - 1;
+    // the remainders of a level are stored every _span(level) residues
+    std::vector<uint64_t> parent(n , 0) , child(n , 0);
+    if (length > n)
+    {
+        std::vector<uint64_t> quotient(length - n);
+        GFPolynomial::divide(field , coefficients , length , root() , n + 1 , quotient.data() ,
+                             parent.data());
+    }
+    else
+    {
+        std::copy(coefficients , coefficients + length , parent.begin());
+    }
+    for (size_t level = top; level-- > 0;)
+    {
+        forEachNode(_nodes(level) , _span(level) , pool , [&](size_t k)
+        {
+            const size_t degree = _degree(level , k) , parentDegree = _degree(level + 1 , k / 2);
+            const uint64_t *rest = parent.data() + (k / 2) * _span(level + 1);
+            uint64_t *result = child.data() + k * _span(level);
+            if (parentDegree <= degree)
+            {
+                std::copy(rest , rest + degree , result);
+                return;
+            }
+            std::vector<uint64_t> quotient(parentDegree - degree);
+            GFPolynomial::divide(field , rest , parentDegree , _node(level , k) , degree + 1 ,
+                                 quotient.data() , result);
+        });
+        parent.swap(child);
+    }
+    // the leaves, by Horner's rule
+    forEachNode(_nodes(0) , _span(0) , pool , [&](size_t k)
+    {
+        const size_t degree = _degree(0 , k) , start = k * _span(0);
+        for (size_t i = start; i < start + degree; i++)
+        {
+            GFElement value(0);
+            for (size_t j = degree; j-- > 0;)
+            {
+                value = field.add(field.mul(value , GFElement(_points[i])) ,
+                                  GFElement(parent[start + j]));
+            }
+            values[i] = value.getResidue();
+        }
+    });
+}
+
+/**
+ * Computes the weights 1 / M'(x_i) of the interpolation, the points must be distinct.
+ * @param pool the pool running the nodes (may be null).
+ */
+void SubproductTree::_computeWeights(ThreadPool *pool) const
+{
+    const GField &field = _getField();
+    const size_t n = _points.size();
+    GFPolynomial derivative = GFPolynomial::fromResidues(field , std::vector<uint64_t>(
+            root() , root() + n + 1)).derivative();
+    std::vector<uint64_t> padded(derivative.data() , derivative.data() + derivative.degree() + 1);
+    padded.resize(n , 0);
+    _weights.resize(n);
+    evaluate(padded.data() , n , _weights.data() , pool);
+    for (uint64_t &weight : _weights)
+    {
+        weight = field.inv(GFElement(weight)).getResidue();
+        assert(weight != 0); // two equal points, or a ring
+    }
+}
+
+/**
+ * The polynomial of degree below size() through the points, which must be distinct and
+ * their field a field (not the ring Z/p^l).
+ * @param values size() residues of the field, the values at the points.
+ * @param coefficients output, size() residues, the constant first.
+ * @param pool the pool running the nodes of every level (may be null).
+ */
+void SubproductTree::interpolate(const uint64_t *values , uint64_t *coefficients ,
+                                 ThreadPool *pool) const
+{
+    std::call_once(_weightsOnce , [this , pool]()
+    {
+        _computeWeights(pool);
+    });
+    const GField &field = _getField();
+    const size_t n = _points.size();
+    // the results of a level are stored every _span(level) residues
+    std::vector<uint64_t> below(n , 0) , above(n , 0);
+    // a leaf sums w_i y_i N / (x - x_i), N / (x - x_i) by synthetic division
+    forEachNode(_nodes(0) , _span(0) , pool , [&](size_t k)
+    {
+        const size_t degree = _degree(0 , k) , start = k * _span(0);
+        const uint64_t *node = _node(0 , k);
+        uint64_t *result = below.data() + start;
+        for (size_t i = start; i < start + degree; i++)
+        {
+            GFElement scale = field.mul(GFElement(values[i]) , GFElement(_weights[i]));
+            GFElement term(node[degree]);
+            for (size_t j = degree; j-- > 0;)
+            {
+                result[j] = field.add(GFElement(result[j]) , field.mul(scale , term)).getResidue();
+                term = field.add(GFElement(node[j]) , field.mul(GFElement(_points[i]) , term));
+            }
+        }
+    });
+    for (size_t level = 1; level < _levels.size(); level++)
+    {
+        forEachNode(_nodes(level) , _span(level) , pool , [&](size_t k)
+        {
+            const size_t left = 2 * k , right = 2 * k + 1 , span = _span(level - 1);
+            const size_t leftDegree = _degree(level - 1 , left);
+            uint64_t *result = above.data() + k * _span(level);
+            if (right == _nodes(level - 1))
+            {
+                std::copy(below.data() + left * span , below.data() + left * span + leftDegree ,
+                          result);
+                return;
+            }
+            const size_t rightDegree = _degree(level - 1 , right);
+            std::vector<uint64_t> other(leftDegree + rightDegree);
+            GFPolynomial::multiply(field , below.data() + left * span , leftDegree ,
+                                   _node(level - 1 , right) , rightDegree + 1 , result);
+            GFPolynomial::multiply(field , below.data() + right * span , rightDegree ,
+                                   _node(level - 1 , left) , leftDegree + 1 , other.data());
+            for (size_t i = 0; i < other.size(); i++)
+            {
+                result[i] = field.add(GFElement(result[i]) , GFElement(other[i])).getResidue();
+            }
+        });
+        below.swap(above);
+    }
+    std::copy(below.begin() , below.end() , coefficients);
+}
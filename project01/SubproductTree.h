@@ -0,0 +1,143 @@
+// SubproductTree.h
+//----------- include guards------------
+#ifndef SUBPRODUCTTREE_H
+#define SUBPRODUCTTREE_H
+//-------------- includes --------------
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "GField.h"
+#include "GFieldRegistry.h"
+
+#define SUBPRODUCT_LEAF_BITS 5 /** the leaves hold 2^5 points, handled by quadratic loops */
+#define SUBPRODUCT_TASK_LENGTH 4096 /** the coefficients of the nodes of one pool task */
+
+//--------------------------------------
+// forward declaration of the ThreadPool class:
+class ThreadPool;
+
+/**
+ *  A SubproductTree class.
+ *  The products of x - x_i over the halves, quarters, ... of a set of points of a GField, for
+ *  evaluating a polynomial at all of them and interpolating through them in O(M(n) log n)
+ *  (M the cost of a product, see GFPolynomial::multiply). Level 0 holds the leaves, the
+ *  products over 2^SUBPRODUCT_LEAF_BITS consecutive points, and every level above holds the
+ *  products of pairs of nodes below, up to the single root.
+ *  Evaluation reduces the polynomial modulo the root, then every remainder modulo the two
+ *  children, down to the leaves whose points are evaluated by Horner's rule. Interpolation
+ *  (Lagrange) weighs every value by 1 / M'(x_i), M the root, and goes back up: a node sums
+ *  its left result times the right product and its right result times the left product.
+ *  The nodes of a level are independent, so with a ThreadPool they are split into chunks of
+ *  about SUBPRODUCT_TASK_LENGTH coefficients, claimed by the pool and by the calling thread,
+ *  which waits for its own chunks only and so may itself be a task of the pool.
+ *  The API works on flat arrays of residues of the field, see GFPolynomial for GFVectors.
+ */
+class SubproductTree
+{
+private:
+    GFieldId _field; /** The id of the field of the points. */
+    std::vector<uint64_t> _points; /** The points, as residues. */
+    std::vector<std::vector<uint64_t>> _levels; /** The monic nodes, see _node(). */
+    mutable std::once_flag _weightsOnce; /** Guards the computation of the weights. */
+    mutable std::vector<uint64_t> _weights; /** 1 / M'(x_i), computed by the first interpolation. */
+
+    /**
+     * Lookup of the field of the points.
+     * @return the field.
+     */
+    const GField &_getField() const
+    { return GFieldRegistry::get(_field); }
+
+    /**
+     * The number of points under the nodes of a level.
+     * @param level the level, 0 for the leaves.
+     * @return 2^(SUBPRODUCT_LEAF_BITS + level) (less for the last node).
+     */
+    static size_t _span(size_t level)
+    { return (size_t) 1 << (SUBPRODUCT_LEAF_BITS + level); }
+
+    /**
+     * The number of nodes of a level.
+     * @param level the level, 0 for the leaves.
+     * @return the number of nodes.
+     */
+    size_t _nodes(size_t level) const
+    { return (_points.size() + _span(level) - 1) / _span(level); }
+
+    /**
+     * The number of points under a node.
+     * @param level the level, 0 for the leaves.
+     * @param k the index of the node in its level.
+     * @return the degree of the node.
+     */
+    size_t _degree(size_t level , size_t k) const
+    { return std::min(_span(level) , _points.size() - k * _span(level)); }
+
+    /**
+     * The coefficients of a node, the nodes of level j are stored every 2^(5 + j) + 1 residues.
+     * @param level the level, 0 for the leaves.
+     * @param k the index of the node in its level.
+     * @return the _degree(level, k) + 1 coefficients of the product over its points.
+     */
+    const uint64_t *_node(size_t level , size_t k) const
+    { return _levels[level].data() + k * (_span(level) + 1); }
+
+    /**
+     * Computes the weights 1 / M'(x_i) of the interpolation, the points must be distinct.
+     * @param pool the pool running the nodes (may be null).
+     */
+    void _computeWeights(ThreadPool *pool) const;
+
+public:
+    /**
+     * A constructor, builds the tree.
+     * @param field the field of the points.
+     * @param points n residues of the field.
+     * @param n the number of points, not 0.
+     * @param pool the pool running the nodes of every level (may be null).
+     */
+    SubproductTree(const GField &field , const uint64_t *points , size_t n ,
+                   ThreadPool *pool = nullptr);
+
+    SubproductTree(const SubproductTree &) = delete;
+
+    SubproductTree &operator=(const SubproductTree &) = delete;
+
+    /**
+     * Getter for the number of points.
+     * @return n.
+     */
+    size_t size() const
+    { return _points.size(); }
+
+    /**
+     * Getter for the product of x - x_i over all the points.
+     * @return the size() + 1 coefficients of the root, the constant first.
+     */
+    const uint64_t *root() const
+    { return _node(_levels.size() - 1 , 0); }
+
+    /**
+     * Evaluates a polynomial at every point.
+     * @param coefficients length residues of the field, the constant first.
+     * @param length the number of coefficients.
+     * @param values output, the size() values, in the order of the points.
+     * @param pool the pool running the nodes of every level (may be null).
+     */
+    void evaluate(const uint64_t *coefficients , size_t length , uint64_t *values ,
+                  ThreadPool *pool = nullptr) const;
+
+    /**
+     * The polynomial of degree below size() through the points, which must be distinct and
+     * their field a field (not the ring Z/p^l).
+     * @param values size() residues of the field, the values at the points.
+     * @param coefficients output, size() residues, the constant first.
+     * @param pool the pool running the nodes of every level (may be null).
+     */
+    void interpolate(const uint64_t *values , uint64_t *coefficients ,
+                     ThreadPool *pool = nullptr) const;
+};
+
+#endif //SUBPRODUCTTREE_H
@@ -0,0 +1,137 @@
+// ThreadPool.cpp
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+/** The pool the current thread works for, and its index there. */
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local size_t currentIndex = 0;
+
+/**
+ * A constructor.
+ * @param threads the number of workers, 0 for one per hardware thread.
+ */
+ThreadPool::ThreadPool(size_t threads) : _queued(0) , _pending(0) , _nextWorker(0) ,
+                                         _stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u , std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        _workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        _threads.emplace_back(&ThreadPool::_run , this , i);
+    }
+}
+
+/**
+ * Destructor, runs the queued tasks and joins the workers.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (std::thread &thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * Queues a task.
+ * @param task the task.
+ */
+void ThreadPool::submit(Task task)
+{
+    size_t index = (currentPool == this) ? currentIndex : _nextWorker++ % _workers.size();
+    _pending++;
+    {
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued++;
+    }
+    _wake.notify_one();
+}
+
+/**
+ * Blocks until every submitted task has finished. Must not be called from a task.
+ */
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock , [this]()
+    { return _pending == 0; });
+}
+
+/**
+ * Takes a task for a worker: the newest of its own deque, or the oldest of another one.
+ * @param index the index of the worker.
+ * @param task output, the task.
+ * @return false if every deque is empty.
+ */
+bool ThreadPool::_take(size_t index , Task &task)
+{
+    for (size_t i = 0; i < _workers.size(); i++)
+    {
+        Worker &worker = *_workers[(index + i) % _workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty())
+        {
+            continue;
+        }
+        if (i == 0)
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        _queued--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * The loop of a worker thread.
+ * @param index the index of the worker.
+ */
+void ThreadPool::_run(size_t index)
+{
+    currentPool = this;
+    currentIndex = index;
+    while (true)
+    {
+        Task task;
+        if (_take(index , task))
+        {
+            task();
+            if (--_pending == 0)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock , [this]()
+        { return _queued > 0 || _stopping; });
+        if (_stopping && _queued <= 0)
+        {
+            return;
+        }
+    }
+}
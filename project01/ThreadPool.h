@@ -0,0 +1,97 @@
+// ThreadPool.h
+//----------- include guards------------
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+//-------------- includes --------------
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//--------------------------------------
+
+/**
+ *  A ThreadPool class.
+ *  A fixed set of worker threads with one task deque each. A worker runs the newest task of
+ *  its own deque and, when it runs dry, steals the oldest task of another worker, so uneven
+ *  tasks (a hard number to factor next to easy ones) do not leave cores idle.
+ *  Tasks submitted by a worker go to its own deque, others are spread round robin.
+ */
+class ThreadPool
+{
+public:
+    /** A unit of work. */
+    typedef std::function<void()> Task;
+
+private:
+    /** The deque of one worker. */
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers; /** The deques, one per thread. */
+    std::vector<std::thread> _threads; /** The worker threads. */
+    std::mutex _mutex; /** Guards the sleeping and the waiting. */
+    std::condition_variable _wake; /** Signaled when a task is queued or the pool stops. */
+    std::condition_variable _idle; /** Signaled when the last pending task finishes. */
+    std::atomic<long> _queued; /** Tasks in the deques. */
+    std::atomic<long> _pending; /** Tasks submitted and not finished yet. */
+    std::atomic<size_t> _nextWorker; /** The deque of the next task submitted from outside. */
+    bool _stopping; /** Set by the destructor. */
+
+    /**
+     * Takes a task for a worker: the newest of its own deque, or the oldest of another one.
+     * @param index the index of the worker.
+     * @param task output, the task.
+     * @return false if every deque is empty.
+     */
+    bool _take(size_t index , Task &task);
+
+    /**
+     * The loop of a worker thread.
+     * @param index the index of the worker.
+     */
+    void _run(size_t index);
+
+public:
+    /**
+     * A constructor.
+     * @param threads the number of workers, 0 for one per hardware thread.
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * Destructor, runs the queued tasks and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Queues a task.
+     * @param task the task.
+     */
+    void submit(Task task);
+
+    /**
+     * Blocks until every submitted task has finished. Must not be called from a task.
+     */
+    void wait();
+
+    /**
+     * Getter for the number of workers.
+     * @return the number of workers.
+     */
+    size_t size() const
+    { return _threads.size(); }
+};
+
+#endif //THREADPOOL_H
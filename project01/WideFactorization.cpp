@@ -0,0 +1,89 @@
+// WideFactorization.cpp
+
+#include "WideFactorization.h"
+#include <algorithm>
+
+// --------------------------------------------------------------------------------------
+// This file contains the implementation of the class WideFactorization.
+// --------------------------------------------------------------------------------------
+
+/**
+ * Adds a prime factor, merging it with an existing entry of the same prime.
+ * @param prime the prime.
+ * @param exponent the multiplicity to add.
+ */
+void WideFactorization::addPrime(UInt128 prime , int exponent)
+{
+    for (WidePrimeFactor &factor : _factors)
+    {
+        if (factor.prime == prime)
+        {
+            factor.exponent += exponent;
+            return;
+        }
+    }
+    _factors.push_back(WidePrimeFactor{prime , exponent});
+}
+
+/**
+ * Adds every factor of a factorization of a long.
+ * @param factorization the factorization.
+ */
+void WideFactorization::addAll(const PrimeFactorization &factorization)
+{
+    for (const PrimeFactor &factor : factorization)
+    {
+        addPrime((UInt128) factor.prime , factor.exponent);
+    }
+}
+
+/**
+ * Sorts the factors by increasing prime.
+ */
+void WideFactorization::sort()
+{
+    std::sort(_factors.begin() , _factors.end() ,
+              [](const WidePrimeFactor &a , const WidePrimeFactor &b)
+              {
+                  return a.prime < b.prime;
+              });
+}
+
+/**
+ * @return the number of prime factors counted with multiplicity.
+ */
+int WideFactorization::countWithMultiplicity() const
+{
+    int count = 0;
+    for (const WidePrimeFactor &factor : _factors)
+    {
+        count += factor.exponent;
+    }
+    return count;
+}
+
+/**
+ * Operator overloading of "<<", prints the factors with multiplicity,
+ * e.g. "2*2*3", or "1" if there are none.
+ * @param out ostream reference.
+ * @param factorization the factorization.
+ * @return ostream reference with the desire output.
+ */
+std::ostream &operator<<(std::ostream &out , const WideFactorization &factorization)
+{
+    if (factorization.empty())
+    {
+        return (out << 1);
+    }
+    const char *separator = "";
+    for (const WidePrimeFactor &factor : factorization)
+    {
+        std::string prime = toString(factor.prime);
+        for (int i = 0; i < factor.exponent; i++)
+        {
+            out << separator << prime;
+            separator = "*";
+        }
+    }
+    return out;
+}
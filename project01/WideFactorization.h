@@ -0,0 +1,91 @@
+// WideFactorization.h
+//----------- include guards------------
+#ifndef WIDEFACTORIZATION_H
+#define WIDEFACTORIZATION_H
+//-------------- includes --------------
+#include <iostream>
+#include "Montgomery128.h"
+#include "PrimeFactorization.h"
+#include "SmallVector.hpp"
+
+//--------------------------------------
+
+/**
+ * A prime factor of a 128 bit number together with its multiplicity.
+ */
+struct WidePrimeFactor
+{
+    UInt128 prime; /** The prime. */
+    int exponent; /** The multiplicity of the prime. */
+};
+
+/**
+ *  A WideFactorization class.
+ *  The prime factorization of a number of up to 128 bits (see
+ *  FactorizationPipeline::factorWide), the distinct primes with their exponents.
+ */
+class WideFactorization
+{
+private:
+    SmallVector<WidePrimeFactor , INLINE_FACTORS> _factors; /** The distinct prime factors. */
+
+public:
+    /**
+     * Adds a prime factor, merging it with an existing entry of the same prime.
+     * @param prime the prime.
+     * @param exponent the multiplicity to add.
+     */
+    void addPrime(UInt128 prime , int exponent = 1);
+
+    /**
+     * Adds every factor of a factorization of a long.
+     * @param factorization the factorization.
+     */
+    void addAll(const PrimeFactorization &factorization);
+
+    /**
+     * Sorts the factors by increasing prime.
+     */
+    void sort();
+
+    /**
+     * @return the number of distinct prime factors.
+     */
+    size_t size() const
+    { return _factors.size(); }
+
+    /**
+     * @return true if there are no prime factors.
+     */
+    bool empty() const
+    { return _factors.empty(); }
+
+    /**
+     * @return the number of prime factors counted with multiplicity.
+     */
+    int countWithMultiplicity() const;
+
+    /**
+     * @param i index of a distinct prime factor.
+     * @return the i-th factor.
+     */
+    const WidePrimeFactor &operator[](size_t i) const
+    { return _factors[i]; }
+
+    const WidePrimeFactor *begin() const
+    { return _factors.begin(); }
+
+    const WidePrimeFactor *end() const
+    { return _factors.end(); }
+
+    /**
+     * Operator overloading of "<<", prints the factors with multiplicity,
+     * e.g. "2*2*3", or "1" if there are none.
+     * @param out ostream reference.
+     * @param factorization the factorization.
+     * @return ostream reference with the desire output.
+     */
+    friend std::ostream &operator<<(std::ostream &out , const WideFactorization &factorization);
+};
+
+#endif //WIDEFACTORIZATION_H